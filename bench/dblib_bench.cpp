@@ -0,0 +1,642 @@
+/*
+
+Copyright (c) 2015-2022 Artyomov Denis (denis.artyomov@gmail.com)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+/* Microbenchmarks of hot paths of library. SQLite :memory: database is used
+   for statements so results don't depend on disk or network. mock/ benchmarks
+   use driver without database to measure overhead of library itself.
+
+   Usage: dblib_bench [--filter=text] [--repetitions=N] [--out=file.json]
+
+   Every benchmark is run once for warming up and then N times. Results are
+   written in JSON (stdout by default) as min, median and max nanoseconds
+   per operation and number of heap allocations per operation (counted by
+   replaced global operator new) */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "../src/dblib_stmt_tools.hpp"
+#include "../tests/dblib_alloc_counter.hpp"
+
+#include "../include/dblib/dblib.hpp"
+#include "../include/dblib/dblib_sqlite.hpp"
+#include "../include/dblib/dblib_postgresql.hpp"
+#include "../include/dblib/dblib_cvt_utils.hpp"
+#include "../include/dblib/dblib_result_set.hpp"
+#include "../include/dblib/dblib_mock.hpp"
+#include "../include/dblib/dblib_tracer.hpp"
+
+using namespace dblib;
+
+static volatile int64_t sink = 0;
+
+
+/* class BenchRunner */
+
+struct BenchResult
+{
+	std::string name;
+	size_t ops = 0; // operations in one repetition
+	double ns_per_op_min = 0;
+	double ns_per_op_median = 0;
+	double ns_per_op_max = 0;
+	double allocs_per_op = 0;
+};
+
+class BenchRunner
+{
+public:
+	BenchRunner(const std::string &filter, size_t repetitions);
+
+	// fun performs ops operations
+	void run(const std::string &name, size_t ops, const std::function<void()> &fun);
+
+	void write_json(FILE *file) const;
+
+private:
+	std::string filter_;
+	size_t repetitions_;
+	std::vector<BenchResult> results_;
+};
+
+BenchRunner::BenchRunner(const std::string &filter, size_t repetitions) :
+	filter_(filter),
+	repetitions_(repetitions)
+{}
+
+void BenchRunner::run(const std::string &name, size_t ops, const std::function<void()> &fun)
+{
+	if (!filter_.empty() && name.find(filter_) == std::string::npos)
+		return;
+
+	fun();
+
+	std::vector<double> times;
+	size_t allocations = 0;
+	for (size_t i = 0; i < repetitions_; i++)
+	{
+		AllocationsCounter counter;
+		auto begin = std::chrono::steady_clock::now();
+		fun();
+		auto end = std::chrono::steady_clock::now();
+		allocations += counter.get();
+
+		auto ns = std::chrono::duration<double, std::nano>(end - begin).count();
+		times.push_back(ns / ops);
+	}
+
+	std::sort(times.begin(), times.end());
+
+	auto &result = results_.emplace_back();
+	result.name = name;
+	result.ops = ops;
+	result.ns_per_op_min = times.front();
+	result.ns_per_op_median = times[times.size() / 2];
+	result.ns_per_op_max = times.back();
+	result.allocs_per_op = (double)allocations / (repetitions_ * ops);
+
+	fprintf(stderr, "%-40s %12.1f ns/op %10.2f allocs/op\n", name.c_str(), result.ns_per_op_median, result.allocs_per_op);
+}
+
+void BenchRunner::write_json(FILE *file) const
+{
+#if defined(__clang__)
+	const char *compiler = "clang " __clang_version__;
+#elif defined(__GNUC__)
+	const char *compiler = "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+	const char *compiler = "msvc";
+#else
+	const char *compiler = "unknown";
+#endif
+
+#if defined(NDEBUG)
+	const char *build_type = "release";
+#else
+	const char *build_type = "debug";
+#endif
+
+	fprintf(file, "{\n");
+	fprintf(file, "  \"context\": {\n");
+	fprintf(file, "    \"compiler\": \"%s\",\n", compiler);
+	fprintf(file, "    \"build_type\": \"%s\",\n", build_type);
+	fprintf(file, "    \"repetitions\": %zu\n", repetitions_);
+	fprintf(file, "  },\n");
+	fprintf(file, "  \"benchmarks\": [");
+
+	for (size_t i = 0; i < results_.size(); i++)
+	{
+		auto &result = results_[i];
+		fprintf(file, "%s\n    {", (i == 0) ? "" : ",");
+		fprintf(file, "\"name\": \"%s\", ", result.name.c_str());
+		fprintf(file, "\"ops\": %zu, ", result.ops);
+		fprintf(file, "\"ns_per_op_min\": %.2f, ", result.ns_per_op_min);
+		fprintf(file, "\"ns_per_op_median\": %.2f, ", result.ns_per_op_median);
+		fprintf(file, "\"ns_per_op_max\": %.2f, ", result.ns_per_op_max);
+		fprintf(file, "\"allocs_per_op\": %.2f}", result.allocs_per_op);
+	}
+
+	fprintf(file, "\n  ]\n}\n");
+}
+
+
+/* Statements */
+
+static const size_t RowsCount = 10000;
+
+static void fill_types_table(Connection &conn)
+{
+	conn.direct_execute(
+		"create table bench_types ("
+			"int_fld integer, "
+			"bigint_fld bigint, "
+			"dbl_fld double precision, "
+			"str_fld varchar(64), "
+			"date_fld date, "
+			"ts_fld timestamp, "
+			"blob_fld blob"
+		")"
+	);
+
+	auto tran = conn.create_transaction();
+	auto st = tran->create_statement();
+	st->prepare("insert into bench_types values (?1, ?2, ?3, ?4, ?5, ?6, ?7)");
+
+	char blob[64] = {};
+	for (size_t i = 0; i < RowsCount; i++)
+	{
+		st->set_int32(1, (int32_t)i);
+		st->set_int64(2, (int64_t)i * 1000000007);
+		st->set_double(3, i * 1.5);
+		st->set_u8str(4, "text value number " + std::to_string(i));
+		st->set_date(5, Date(2000 + (int)i % 20, 1 + (int)i % 12, 1 + (int)i % 28));
+		st->set_timestamp(6, TimeStamp(Date(2020, 1 + (int)i % 12, 1 + (int)i % 28), Time((int)i % 24, (int)i % 60, 0)));
+		st->set_blob(7, blob, sizeof(blob));
+		st->execute();
+	}
+
+	tran->commit();
+}
+
+static void bench_statements(BenchRunner &runner, Connection &conn)
+{
+	auto tran = conn.create_transaction();
+	auto st = tran->create_statement();
+
+	// prepare
+
+	runner.run("prepare/select_2_params", 1000, [&]
+	{
+		for (size_t i = 0; i < 1000; i++)
+			st->prepare("select ?1 + ?2");
+	});
+
+	runner.run("prepare/select_all_columns", 1000, [&]
+	{
+		for (size_t i = 0; i < 1000; i++)
+			st->prepare("select int_fld, bigint_fld, dbl_fld, str_fld, date_fld, ts_fld, blob_fld from bench_types where int_fld = ?1");
+	});
+
+	// create, prepare and release statement with and without pool
+
+	for (size_t pool_size : { 0, 16 })
+	{
+		conn.set_statements_pool_size(pool_size);
+		runner.run(pool_size ? "create_statement/pool" : "create_statement/no_pool", 1000, [&]
+		{
+			for (size_t i = 0; i < 1000; i++)
+				tran->create_statement()->prepare("select ?1 + ?2");
+		});
+	}
+	conn.set_statements_pool_size(0);
+
+	// execute with N parameters
+
+	for (size_t params_count : { 1, 8, 32 })
+	{
+		std::string sql = "select ";
+		for (size_t i = 1; i <= params_count; i++)
+		{
+			if (i != 1) sql.append(", ");
+			sql.append("?" + std::to_string(i));
+		}
+
+		runner.run("execute/params_" + std::to_string(params_count), 1000, [&]
+		{
+			st->prepare(sql);
+			for (size_t i = 0; i < 1000; i++)
+			{
+				for (size_t p = 1; p <= params_count; p++)
+					st->set_int64(p, (int64_t)(i + p));
+				st->execute();
+			}
+		});
+	}
+
+	// fetch and decode of every type
+
+	auto bench_fetch = [&](const std::string &name, const char *column, const std::function<void()> &get)
+	{
+		auto sql = std::string("select ") + column + " from bench_types";
+		runner.run("fetch/" + name, RowsCount, [&]
+		{
+			st->execute(sql);
+			while (st->fetch()) get();
+		});
+	};
+
+	bench_fetch("int32", "int_fld", [&] { sink += st->get_int32(1); });
+	bench_fetch("int64", "bigint_fld", [&] { sink += st->get_int64(1); });
+	bench_fetch("double", "dbl_fld", [&] { sink += (int64_t)st->get_double(1); });
+	bench_fetch("str_utf8", "str_fld", [&] { sink += st->get_str_utf8(1).size(); });
+	bench_fetch("wstr", "str_fld", [&] { sink += st->get_wstr(1).size(); });
+	bench_fetch("date", "date_fld", [&] { sink += st->get_date(1).day; });
+	bench_fetch("timestamp", "ts_fld", [&] { sink += st->get_timestamp(1).time.min; });
+
+	char blob[64];
+	bench_fetch("blob", "blob_fld", [&]
+	{
+		size_t size = st->get_blob_size(1);
+		st->get_blob_data(1, blob, std::min(size, sizeof(blob)));
+		sink += blob[0];
+	});
+
+	ResultSet result;
+	runner.run("fetch/columnar", RowsCount, [&]
+	{
+		st->execute("select int_fld, bigint_fld, dbl_fld, str_fld, date_fld, ts_fld from bench_types");
+		st->fetch_columnar(result);
+		sink += result.get_rows_count();
+	});
+
+	// access to columns by index and by name
+
+	const char *access_sql = "select int_fld, bigint_fld, dbl_fld, str_fld from bench_types";
+
+	runner.run("column_access/by_index", RowsCount, [&]
+	{
+		st->execute(access_sql);
+		while (st->fetch())
+			sink += st->get_int32(1) + st->get_int64(2) + (int64_t)st->get_double(3);
+	});
+
+	runner.run("column_access/by_name", RowsCount, [&]
+	{
+		st->execute(access_sql);
+		while (st->fetch())
+			sink += st->get_int32("int_fld") + st->get_int64("bigint_fld") + (int64_t)st->get_double("dbl_fld");
+	});
+
+	tran->commit();
+}
+
+
+/* SqliteFastStatement. Same operations as execute/params_8 and
+   column_access/by_index but without virtual calls */
+
+static void bench_sqlite_fast(BenchRunner &runner, SqliteConnection &conn)
+{
+	auto tran = conn.create_sqlite_transaction({});
+	SqliteFastStatement st(tran);
+
+	runner.run("sqlite_fast/execute_params_8", 1000, [&]
+	{
+		st.prepare("select ?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8");
+		for (int i = 0; i < 1000; i++)
+		{
+			for (int p = 1; p <= 8; p++)
+				st.set_int64(p, (int64_t)(i + p));
+			st.execute();
+		}
+	});
+
+	runner.run("sqlite_fast/column_access", RowsCount, [&]
+	{
+		st.prepare("select int_fld, bigint_fld, dbl_fld, str_fld from bench_types");
+		st.execute();
+		while (st.fetch())
+			sink += st.get_int32(1) + st.get_int64(2) + (int64_t)st.get_double(3) + st.get_str_utf8(4).size();
+	});
+
+	tran->commit();
+}
+
+
+/* Mock driver */
+
+static void bench_mock(BenchRunner &runner)
+{
+	MockResult select_result;
+	select_result.rows = make_mock_rows(
+		{ ValueType::Integer, ValueType::BigInt, ValueType::Double, ValueType::Varchar, ValueType::Date, ValueType::Timestamp },
+		RowsCount
+	);
+
+	MockConfig config;
+	config.result_fun = [&](std::string_view sql) { return &select_result; };
+
+	auto conn = create_mock_connection(config);
+	conn->connect();
+
+	auto tran = conn->create_transaction();
+	auto st = tran->create_statement();
+
+	runner.run("mock/execute_params_8", 10000, [&]
+	{
+		st->prepare("insert into tbl values (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8)");
+		for (size_t i = 0; i < 10000; i++)
+		{
+			for (size_t p = 1; p <= 8; p++)
+				st->set_int64(p, (int64_t)(i + p));
+			st->execute();
+		}
+	});
+
+	st->prepare("select * from tbl");
+
+	auto bench_fetch = [&](const std::string &name, const std::function<void()> &get)
+	{
+		runner.run("mock/" + name, RowsCount, [&]
+		{
+			st->execute();
+			while (st->fetch()) get();
+		});
+	};
+
+	bench_fetch("fetch_only", [&] {});
+	bench_fetch("fetch_int32", [&] { sink += st->get_int32(1); });
+	bench_fetch("fetch_int64", [&] { sink += st->get_int64(2); });
+	bench_fetch("fetch_double", [&] { sink += (int64_t)st->get_double(3); });
+	bench_fetch("fetch_str_utf8", [&] { sink += st->get_str_utf8(4).size(); });
+	bench_fetch("fetch_date", [&] { sink += st->get_date(5).day; });
+	bench_fetch("fetch_timestamp", [&] { sink += st->get_timestamp(6).time.min; });
+	bench_fetch("fetch_int32_by_name", [&] { sink += st->get_int32("col1"); });
+	bench_fetch("fetch_int32_opt", [&] { sink += st->get_int32_opt(1).value_or(0); });
+
+	ResultSet result;
+	runner.run("mock/fetch_columnar", RowsCount, [&]
+	{
+		st->execute();
+		result.clear();
+		st->fetch_columnar(result);
+		sink += result.get_rows_count();
+	});
+
+	// overhead of tracing: fetch_only without tracer is the baseline
+	struct NullTracer : public Tracer
+	{
+		void begin(TraceEvent &event) override { sink += (int64_t)event.operation; }
+		void end(TraceEvent &event) override { sink += event.bytes_count; }
+	};
+
+	conn->set_tracer(std::make_shared<NullTracer>());
+	st->prepare("select * from tbl");
+	bench_fetch("fetch_only_traced", [&] {});
+	conn->set_tracer(nullptr);
+
+	tran->commit();
+}
+
+
+/* SqlPreprocessor */
+
+class BenchSqlPreprocessorActions : public SqlPreprocessorActions
+{
+public:
+	void append_index_param_to_sql(const std::string& parameter, int param_index, std::string& sql) const override
+	{
+		sql.push_back('$');
+		sql.append(std::to_string(param_index));
+	}
+
+	void append_named_param_to_sql(const std::string& parameter, int param_index, std::string& sql) const override
+	{
+		sql.push_back('$');
+		sql.append(std::to_string(param_index));
+	}
+
+	void append_if_seq_data(const std::string& data, const std::string& other, std::string& sql) const override
+	{
+		sql.append(data);
+		sql.append(other);
+	}
+
+	void append_seq_generator(const std::string& seq_name, const std::string& other, std::string& sql) const override
+	{
+		sql.append("nextval('");
+		sql.append(seq_name);
+		sql.append("')");
+		sql.append(other);
+	}
+};
+
+static void bench_preprocessor(BenchRunner &runner)
+{
+	BenchSqlPreprocessorActions actions;
+	SqlPreprocessor preprocessor;
+
+	const char *indexed_sql =
+		"insert into tbl (id, a, b, c, d, e, f, g, h, i) "
+		"values (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, 'text with ?1 inside')";
+
+	const char *named_sql =
+		"insert into tbl ({if_seq id,} a, b, c, d) "
+		"values ({next tbl_seq,} @a, @b, @c, @d) returning @a";
+
+	runner.run("preprocessor/indexed_params", 10000, [&]
+	{
+		for (size_t i = 0; i < 10000; i++)
+		{
+			preprocessor.preprocess(indexed_sql, false, true, actions);
+			sink += preprocessor.get_preprocessed_sql().size();
+		}
+	});
+
+	runner.run("preprocessor/named_params_and_seq", 10000, [&]
+	{
+		for (size_t i = 0; i < 10000; i++)
+		{
+			preprocessor.preprocess(named_sql, false, false, actions);
+			sink += preprocessor.get_preprocessed_sql().size();
+		}
+	});
+}
+
+
+/* Conversions */
+
+static void bench_conversions(BenchRunner &runner)
+{
+	const std::string utf8_text = u8"Text of 64 bytes with cyrillic: Съешь же ещё этих булок";
+	const std::wstring wide_text = utf8_to_utf16(utf8_text);
+
+	std::wstring wide_result;
+	runner.run("utf/utf8_to_utf16", 100000, [&]
+	{
+		for (size_t i = 0; i < 100000; i++)
+		{
+			utf8_to_utf16(utf8_text, wide_result);
+			sink += wide_result.size();
+		}
+	});
+
+	std::string utf8_result;
+	runner.run("utf/utf16_to_utf8", 100000, [&]
+	{
+		for (size_t i = 0; i < 100000; i++)
+		{
+			utf16_to_utf8(wide_text, utf8_result);
+			sink += utf8_result.size();
+		}
+	});
+
+	runner.run("date/date_to_julianday", 100000, [&]
+	{
+		for (size_t i = 0; i < 100000; i++)
+			sink += (int64_t)date_to_julianday(1900 + (int)(i % 200), 1 + (int)(i % 12), 1 + (int)(i % 28));
+	});
+
+	runner.run("date/julianday_to_date", 100000, [&]
+	{
+		for (size_t i = 0; i < 100000; i++)
+			sink += julianday_to_date(2415021.0 + (double)i).day;
+	});
+
+	runner.run("date/timestamp_to_julianday", 100000, [&]
+	{
+		for (size_t i = 0; i < 100000; i++)
+			sink += (int64_t)timestamp_to_julianday(2020, 1 + (int)(i % 12), 1 + (int)(i % 28), (int)(i % 24), (int)(i % 60), 0, 0);
+	});
+
+	runner.run("date/julianday_to_timestamp", 100000, [&]
+	{
+		for (size_t i = 0; i < 100000; i++)
+			sink += julianday_to_timestamp(2458850.0 + (double)i / 1000.0).time.min;
+	});
+}
+
+
+/* PgBuffer */
+
+static void bench_pg_buffer(BenchRunner &runner)
+{
+	PgBuffer buffer;
+
+	const std::string text = "text value of pg buffer";
+	const Date date(2020, 5, 17);
+	const TimeStamp ts(date, Time(12, 30, 15, 500));
+
+	runner.run("pg_buffer/tuple_6_columns", 100000, [&]
+	{
+		buffer.clear();
+		for (size_t i = 0; i < 100000; i++)
+		{
+			buffer.begin_tuple();
+			buffer.write_int32_opt((int32_t)i);
+			buffer.write_int64_opt((int64_t)i * 3);
+			buffer.write_double_opt(i * 0.5);
+			buffer.write_u8str_opt(text);
+			buffer.write_date_opt(date);
+			buffer.write_timestamp_opt(ts);
+			buffer.end_tuple();
+		}
+		sink += buffer.get_size();
+	});
+}
+
+
+int main(int argc, char *argv[])
+{
+	std::string filter;
+	size_t repetitions = 5;
+	std::string out_file_name;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		auto value = arg.substr(arg.find('=') + 1);
+
+		if (arg.rfind("--filter=", 0) == 0)
+			filter = value;
+		else if (arg.rfind("--repetitions=", 0) == 0)
+			repetitions = std::max(atoi(value.c_str()), 1);
+		else if (arg.rfind("--out=", 0) == 0)
+			out_file_name = value;
+		else
+		{
+			fprintf(stderr, "Usage: dblib_bench [--filter=text] [--repetitions=N] [--out=file.json]\n");
+			return 1;
+		}
+	}
+
+	try
+	{
+		BenchRunner runner(filter, repetitions);
+
+		auto sqlite_lib = create_sqlite_lib();
+		sqlite_lib->load();
+
+		auto conn = sqlite_lib->create_connection(":memory:", {});
+		conn->connect();
+		fill_types_table(*conn);
+
+		bench_statements(runner, *conn);
+		bench_sqlite_fast(runner, *conn);
+		bench_mock(runner);
+		bench_preprocessor(runner);
+		bench_conversions(runner);
+		bench_pg_buffer(runner);
+
+		FILE *out_file = stdout;
+		if (!out_file_name.empty())
+		{
+			out_file = fopen(out_file_name.c_str(), "wb");
+			if (!out_file)
+			{
+				fprintf(stderr, "Can't create file %s\n", out_file_name.c_str());
+				return 1;
+			}
+		}
+
+		runner.write_json(out_file);
+
+		if (out_file != stdout)
+			fclose(out_file);
+	}
+	catch (const std::exception &e)
+	{
+		fprintf(stderr, "%s\n", e.what());
+		return 1;
+	}
+
+	return 0;
+}
@@ -26,8 +26,10 @@ THE SOFTWARE.
 
 #include <stdint.h>
 
+#include <array>
 #include <memory>
 #include <string>
+#include <vector>
 #include <string_view>
 #include <variant>
 #include <optional>
@@ -39,9 +41,13 @@ namespace dblib {
 
 // fwd.
 class Exception;
+class ExceptionEx;
 class Connection;
 class Transaction; typedef std::shared_ptr<Transaction> TransactionPtr;
 class Statement; typedef std::shared_ptr<Statement> StatementPtr;
+class ResultSet;
+class SchemaCatalog;
+class Tracer; typedef std::shared_ptr<Tracer> TracerPtr;
 
 constexpr TransactionLevel DefaultTransactionLevel = TransactionLevel::Default;
 
@@ -62,6 +68,112 @@ public:
 };
 
 
+/* struct ConnectionStats
+
+   Counters of requests to server and calls of client library */
+
+enum class NativeCallType
+{
+	Connect,
+	Transaction,
+	Prepare,
+	Execute,
+	Fetch,
+	Info,
+	Blob,
+	Copy
+};
+
+constexpr size_t NativeCallTypesCount = (size_t)NativeCallType::Copy + 1;
+
+struct DBLIB_API ConnectionStats
+{
+	uint64_t round_trips = 0;  // requests waiting for answer of server
+	uint64_t sent_bytes = 0;   // text of SQL, values of parameters and COPY data
+	uint64_t result_bytes = 0; // values of received rows
+	std::array<uint64_t, NativeCallTypesCount> native_calls {}; // index is NativeCallType
+
+	uint64_t get_native_calls(NativeCallType type) const;
+	uint64_t get_native_calls_total() const;
+};
+
+
+/* struct StatementsPoolStats */
+
+struct DBLIB_API StatementsPoolStats
+{
+	size_t max_size = 0;
+	size_t size = 0;      // released statements waiting for reuse
+	uint64_t created = 0; // statements created while pool is on
+	uint64_t reused = 0;  // statements taken from pool
+};
+
+
+/* class Status
+
+   Result of non throwing try_* methods. Contains classified error of
+   database or "no data" mark of try_fetch. Text of error is formatted
+   only by get_message() */
+
+enum class StatusType
+{
+	Ok,
+	NoData,
+	Error
+};
+
+class DBLIB_API Status
+{
+public:
+	Status() = default;
+
+	// fun_name and code_expl must be static strings
+	Status(
+		ErrorType        error_type,
+		int              code,
+		int              ext_code,
+		const char       *fun_name,
+		const char       *code_expl,
+		std::string_view sql_state,
+		std::string_view driver_message
+	);
+
+	static Status make_no_data();
+	static Status make_from_exception(const ExceptionEx &exception);
+
+	StatusType get_type() const;
+	bool is_ok() const;
+	bool is_no_data() const;
+	bool is_error() const;
+
+	ErrorType get_error_type() const;
+
+	// lock conflict, deadlock or serialization failure
+	bool is_lock_error() const;
+
+	int get_code() const;
+	int get_ext_code() const;
+	std::string_view get_sql_state() const;
+	const std::string& get_driver_message() const;
+
+	// text of error in the same format as text of exception
+	std::string get_message() const;
+
+	// throws the same exception as throwing methods. Does nothing if there is no error
+	void throw_if_error() const;
+
+private:
+	StatusType type_ = StatusType::Ok;
+	ErrorType error_type_ = ErrorType::Normal;
+	int code_ = 0;
+	int ext_code_ = 0;
+	const char *fun_name_ = nullptr;
+	const char *code_expl_ = nullptr;
+	char sql_state_[6] = {};
+	std::string driver_message_;
+};
+
+
 class DBLIB_API Connection
 {
 public:
@@ -84,8 +196,36 @@ public:
 	void set_default_transaction_lock_timeout(int value_is_seconds);
 	int get_default_transaction_lock_timeout() const;
 
+	// Metadata of tables (dblib_schema.hpp). Loaded by first call and cached
+	const SchemaCatalog& get_schema_catalog();
+
+	// Loaded from cache_file if it is saved for the same version. Otherwise
+	// loaded from database and saved into cache_file
+	const SchemaCatalog& get_schema_catalog(const FileName &cache_file, std::string_view version);
+
+	// call after changes of database scheme
+	void reset_schema_catalog();
+
+	// Counted by PostgreSQL and Firebird drivers. Other drivers return zeros
+	virtual ConnectionStats get_connection_stats() const;
+	virtual void reset_connection_stats();
+
+	// Statements released by user are kept in pool (up to max_size) together
+	// with their buffers and are reused by create_statement of any transaction
+	// of connection. 0 - pool is off (default). Supported by SQLite,
+	// PostgreSQL and Firebird drivers, other drivers ignore it
+	virtual void set_statements_pool_size(size_t max_size);
+	virtual StatementsPoolStats get_statements_pool_stats() const;
+
+	// Tracer (dblib_tracer.hpp) for transactions and statements created after this call.
+	// nullptr - no tracing
+	void set_tracer(const TracerPtr &tracer);
+	const TracerPtr& get_tracer() const;
+
 private:
 	int default_transaction_lock_timeout_ = -1;
+	std::shared_ptr<SchemaCatalog> schema_catalog_;
+	TracerPtr tracer_;
 };
 
 typedef std::shared_ptr<Connection> ConnectionPtr;
@@ -104,6 +244,11 @@ public:
 	virtual void rollback();
 	virtual void rollback_and_start();
 
+	// Commit which returns lock and serialization errors in status instead of
+	// exception. Transaction stays started if commit fails so it has to be
+	// rolled back or committed again
+	Status try_commit();
+
 	TransactionState get_state() const;
 
 protected:
@@ -111,6 +256,10 @@ protected:
 	virtual void internal_commit() = 0;
 	virtual void internal_rollback() = 0;
 
+	// calls internal_commit and converts exception into status if it
+	// is not overridden by driver
+	virtual Status internal_try_commit();
+
 	void check_not_started();
 	void check_started();
 
@@ -198,6 +347,21 @@ using DateOpt        = std::optional<Date>;
 using TimeOpt        = std::optional<Time>;
 using TimeStampOpt   = std::optional<TimeStamp>;
 
+// std::monostate is null
+using ParamValue = std::variant<
+	std::monostate,
+	int32_t,
+	int64_t,
+	float,
+	double,
+	std::string,
+	Date,
+	Time,
+	TimeStamp
+>;
+
+using ParamValues = std::vector<ParamValue>;
+
 class DBLIB_API Statement
 {
 public:
@@ -224,6 +388,13 @@ public:
 
 	virtual bool fetch() = 0;
 
+	// Variants of execute() and fetch() which return errors of database
+	// (lock conflicts, serialization failures) in status instead of exception.
+	// try_fetch returns StatusType::NoData after last row. Wrong call sequence
+	// and errors of type conversion are still reported by exceptions
+	virtual Status try_execute();
+	virtual Status try_fetch();
+
 	// parameters
 
 	virtual size_t get_params_count() const = 0;
@@ -278,6 +449,13 @@ public:
 
 	virtual void set_blob(const IndexOrName& param, const char *blob_data, size_t blob_size) = 0;
 
+	// sets values of parameters 1, 2, 3 ...
+	void set_params(const ParamValues& values);
+
+	// values of parameters 1, 2, 3 ... which are set now.
+	// Throws FunctionalityNotSupported if driver can't read them back
+	virtual ParamValues get_param_values();
+
 	// results
 
 	virtual size_t get_columns_count() = 0;
@@ -325,6 +503,11 @@ public:
 	virtual void get_blob_data(const IndexOrName& column, char* dst, size_t size) = 0;
 	virtual size_t get_blob_size(const IndexOrName& column) = 0;
 
+	// fetches up to max_rows rows (0 - all rows) into columnar result set.
+	// Columns are added from statement if result is empty.
+	// Returns count of fetched rows
+	virtual size_t fetch_columnar(ResultSet& result, size_t max_rows = 0);
+
 	// transactions
 
 	virtual TransactionPtr get_transaction() = 0;
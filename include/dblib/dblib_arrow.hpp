@@ -0,0 +1,98 @@
+/*
+
+Copyright (c) 2015-2022 Artyomov Denis (denis.artyomov@gmail.com)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <vector>
+#include <functional>
+
+#include "dblib_conf.hpp"
+#include "dblib.hpp"
+#include "dblib_result_set.hpp"
+
+namespace dblib {
+
+struct DBLIB_API ArrowWriterParams
+{
+	size_t batch_size = 64 * 1024; // rows in one record batch
+};
+
+using ArrowOutputFun = std::function<void(const char *data, size_t size)>;
+
+/* class ArrowStreamWriter
+
+   Writes query results in Apache Arrow IPC stream format (schema message,
+   record batches and end of stream marker). Types are mapped as
+
+     Short              -> Int16
+     Integer            -> Int32
+     BigInt             -> Int64
+     Float              -> FloatingPoint(SINGLE)
+     Double             -> FloatingPoint(DOUBLE)
+     Boolean            -> Bool
+     Char, Varchar      -> Utf8
+     Blob               -> Binary
+     Date               -> Date32(DAY)
+     Time               -> Time64(MICROSECOND)
+     Timestamp          -> Timestamp(MICROSECOND) without time zone
+
+   Schema is defined by the first batch. Columns with unknown type (all
+   values are null) are written as Utf8 and following values of these
+   columns are converted into strings. */
+
+class DBLIB_API ArrowStreamWriter
+{
+public:
+	ArrowStreamWriter(const ArrowOutputFun &output, const ArrowWriterParams &params = {});
+	ArrowStreamWriter(const FileName &file_name, const ArrowWriterParams &params = {});
+	~ArrowStreamWriter();
+
+	// writes all remaining rows of executed statement. Returns count of rows
+	size_t write(Statement &stmt);
+
+	// writes result set as one record batch
+	void write_batch(const ResultSet &result);
+
+	// writes end of stream marker
+	void finish();
+
+private:
+	ArrowOutputFun output_;
+	ArrowWriterParams params_;
+	FILE *file_ = nullptr;
+	bool schema_written_ = false;
+	bool finished_ = false;
+	std::vector<ValueType> schema_types_;
+	std::vector<char> metadata_;
+	std::vector<char> body_;
+
+	void write_schema(const ResultSet &result);
+	void write_message();
+	void check_schema(const ResultSet &result) const;
+};
+
+} // namespace dblib
@@ -91,6 +91,15 @@ enum class TransactionState
 	Rollbacked
 };
 
+enum class ErrorType
+{
+	Normal,
+	Transaction,
+	Lock,
+	Connection,
+	LostConnection
+};
+
 DBLIB_API std::string field_type_to_string(const ValueType &field_type);
 
 DBLIB_API std::string get_transaction_level_string(TransactionLevel level);
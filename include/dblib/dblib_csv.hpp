@@ -0,0 +1,203 @@
+/*
+
+Copyright (c) 2015-2022 Artyomov Denis (denis.artyomov@gmail.com)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <stdio.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+
+#include "dblib_conf.hpp"
+#include "dblib.hpp"
+#include "dblib_result_set.hpp"
+
+namespace dblib {
+
+class PgStatement;
+
+struct DBLIB_API CsvFormat
+{
+	char delimiter = ',';
+	char quote = '"';
+	bool header = true;     // first record contains names of columns
+	std::string null_text;  // not quoted field equal to null_text is null
+	std::string line_end = "\n";
+
+	static CsvFormat tsv();
+};
+
+// returns count of bytes placed into buffer. 0 - end of data
+using CsvInputFun = std::function<size_t(char *buffer, size_t size)>;
+
+using CsvOutputFun = std::function<void(const char *data, size_t size)>;
+
+
+/* class CsvReader
+
+   Streaming reader of CSV data. Fields are scanned directly in input buffer,
+   only quoted fields with escaped quotes are copied. Text of fields is valid
+   until next call of read_record().
+
+   Text values are converted into ValueType as
+     Integer types: decimal integer
+     Float, Double: decimal or scientific notation
+     Boolean:       1, 0, true, false, t, f
+     Date:          YYYY-MM-DD
+     Time:          HH:MM:SS[.ffffff]
+     Timestamp:     YYYY-MM-DD HH:MM:SS[.ffffff] (or T as separator)
+     Blob:          \xHEX or raw text */
+
+class DBLIB_API CsvReader
+{
+public:
+	CsvReader(const CsvInputFun &input, const CsvFormat &format = {});
+	CsvReader(const FileName &file_name, const CsvFormat &format = {});
+	~CsvReader();
+
+	// names from first record if CsvFormat::header is set
+	const std::vector<std::string>& get_header();
+
+	// reads next record. Returns false at the end of data
+	bool read_record();
+
+	size_t get_fields_count() const;
+
+	// fields are counted from 1 as columns in Statement
+	bool is_null(size_t index) const;
+	std::string_view get_field(size_t index) const;
+
+	// number of last read record (header is counted too)
+	size_t get_record_number() const;
+
+	// reads up to max_rows records (0 - all records) into result set.
+	// Columns are added if result is empty (types is empty - all columns are Varchar).
+	// Returns count of read records
+	size_t read_columnar(ResultSet &result, const std::vector<ValueType> &types = {}, size_t max_rows = 0);
+
+private:
+	struct Field
+	{
+		size_t begin;
+		size_t size;
+		bool in_storage;
+		bool is_null;
+	};
+
+	CsvInputFun input_;
+	CsvFormat format_;
+	FILE *file_ = nullptr;
+	std::vector<char> buffer_;
+	size_t buffer_begin_ = 0;
+	size_t buffer_end_ = 0;
+	bool eof_ = false;
+	bool header_read_ = false;
+	std::vector<std::string> header_;
+	std::vector<Field> fields_;
+	std::string storage_;
+	std::vector<char> blob_buffer_;
+	size_t record_number_ = 0;
+	bool is_special_[256] = {};
+
+	void init();
+	bool read_more_data();
+	bool parse_record(size_t &pos);
+	bool next_record();
+	void check_field_index(size_t index) const;
+	void read_header();
+	void add_columns(ResultSet &result, const std::vector<ValueType> &types, size_t count);
+};
+
+
+/* class CsvWriter
+
+   Buffered writer of CSV data. Numbers are formatted by std::to_chars,
+   dates and times are formatted as in CsvReader. Blobs are written as \xHEX */
+
+class DBLIB_API CsvWriter
+{
+public:
+	CsvWriter(const CsvOutputFun &output, const CsvFormat &format = {});
+	CsvWriter(const FileName &file_name, const CsvFormat &format = {});
+	~CsvWriter();
+
+	// writes all remaining rows of executed statement. Header is written
+	// if CsvFormat::header is set. Returns count of rows
+	size_t write(Statement &stmt, size_t batch_size = 64 * 1024);
+
+	void write_header(const ResultSet &result);
+	void write_rows(const ResultSet &result);
+
+	void write_null();
+	void write_int64(int64_t value);
+	void write_float(float value);
+	void write_double(double value);
+	void write_str(std::string_view text);
+	void write_blob(const char *data, size_t size);
+	void write_date(const Date &date);
+	void write_time(const Time &time);
+	void write_timestamp(const TimeStamp &ts);
+	void end_record();
+
+	void flush();
+
+private:
+	CsvOutputFun output_;
+	CsvFormat format_;
+	FILE *file_ = nullptr;
+	std::string buffer_;
+	bool is_first_field_ = true;
+	bool is_special_[256] = {};
+
+	void init();
+	void begin_field();
+	void write_value(const ResultColumn &column, size_t row);
+};
+
+
+// Imports CSV records into prepared statement (for example insert) with
+// parameters 1 ... N. Text of field is converted into type from types
+// (types is empty - all values are set as strings). Returns count of records
+DBLIB_API size_t import_csv(CsvReader &reader, Statement &stmt, const std::vector<ValueType> &types = {});
+
+// Imports CSV records into PostgreSQL table by binary COPY. copy_sql is
+// "COPY table (columns) FROM STDIN (format binary)". COPY is executed for every
+// rows_per_copy records. Returns count of records
+DBLIB_API size_t import_csv(
+	CsvReader                    &reader,
+	PgStatement                  &stmt,
+	std::string_view             copy_sql,
+	const std::vector<ValueType> &types,
+	size_t                       rows_per_copy = 64 * 1024
+);
+
+// Parsing of date and time values in CSV format
+
+DBLIB_API bool parse_csv_date(std::string_view text, Date &date);
+DBLIB_API bool parse_csv_time(std::string_view text, Time &time);
+DBLIB_API bool parse_csv_timestamp(std::string_view text, TimeStamp &ts);
+
+} // namespace dblib
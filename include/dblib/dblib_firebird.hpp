@@ -143,6 +143,9 @@ class DBLIB_API FbStatement : public Statement
 {
 public:
 	virtual isc_stmt_handle& get_handle() = 0;
+
+	// plan of prepared statement (isc_info_sql_get_plan)
+	virtual std::string get_plan() = 0;
 };
 
 DBLIB_API FbLibPtr create_fb_lib();
@@ -0,0 +1,111 @@
+/*
+
+Copyright (c) 2015-2022 Artyomov Denis (denis.artyomov@gmail.com)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <future>
+
+#include "dblib_conf.hpp"
+#include "dblib.hpp"
+#include "dblib_result_set.hpp"
+
+namespace dblib {
+
+struct DBLIB_API KeysetScannerParams
+{
+	size_t page_size = 10000;
+	bool prefetch = false; // read next page in background while current page is processed
+};
+
+
+/* class KeysetScanner
+
+   Reads result of query by pages without OFFSET. Every next page is selected
+   by condition "key > last key of previous page" so reading of page doesn't
+   depend on count of already read rows:
+
+     PostgreSQL, SQLite: where (k1, k2) > (?1, ?2) order by k1, k2 limit N
+     Firebird:           where (k1 > ?1) or (k1 = ?1 and k2 > ?2) order by k1, k2 rows N
+
+   Key columns must be unique, not null and present in select list of base
+   query. Base query must not contain ORDER BY or LIMIT.
+
+   Statement must not be used by other code while scanner is alive. With
+   prefetch the statement is used in background thread during processing
+   of current page, so its connection must not be used by other code too */
+
+class DBLIB_API KeysetScanner
+{
+public:
+	KeysetScanner(
+		Statement                      &stmt,
+		std::string_view               base_sql,
+		const std::vector<std::string> &key_columns,
+		const KeysetScannerParams      &params = {}
+	);
+
+	~KeysetScanner();
+
+	// reads next page. Returns false at the end of data
+	bool fetch_page();
+
+	// moves to next row. Next page is read if required
+	bool fetch();
+
+	const ResultSet& get_page() const;
+
+	// index of current row in page (after fetch)
+	size_t get_row() const;
+
+	size_t get_pages_count() const;
+
+	const std::string& get_first_page_sql() const;
+	const std::string& get_next_page_sql() const;
+
+private:
+	Statement &stmt_;
+	KeysetScannerParams params_;
+	std::vector<std::string> key_columns_;
+	std::string first_page_sql_;
+	std::string next_page_sql_;
+	bool next_page_prepared_ = false;
+	ResultSet page_;
+	ResultSet next_page_;
+	std::future<void> next_page_future_;
+	bool started_ = false;
+	bool finished_ = false;
+	size_t row_ = 0;
+	bool row_is_valid_ = false;
+	size_t pages_count_ = 0;
+
+	void build_sql(std::string_view base_sql);
+	ParamValues get_last_key() const;
+	void read_page(ResultSet &page, const ParamValues &last_key);
+	void start_reading_next_page();
+};
+
+} // namespace dblib
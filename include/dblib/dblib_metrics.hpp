@@ -0,0 +1,125 @@
+/*
+
+Copyright (c) 2015-2022 Artyomov Denis (denis.artyomov@gmail.com)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "dblib_conf.hpp"
+#include "dblib_tracer.hpp"
+
+namespace dblib {
+
+
+// Upper bounds of buckets of latency histogram in nanoseconds. Last bucket is +Inf
+constexpr size_t LatencyBucketsCount = 17;
+constexpr std::array<uint64_t, LatencyBucketsCount-1> LatencyBucketBoundsNs = {
+	10000, 25000, 50000, 100000, 250000, 500000,
+	1000000, 2500000, 5000000, 10000000, 25000000, 50000000,
+	100000000, 250000000, 1000000000, 5000000000
+};
+
+constexpr size_t TraceOperationsCount = (size_t)TraceOperation::Rollback + 1;
+constexpr size_t ErrorTypesCount = (size_t)ErrorType::LostConnection + 1;
+
+struct DBLIB_API OperationMetrics
+{
+	uint64_t count = 0;
+	uint64_t total_ns = 0;
+	uint64_t max_ns = 0;
+	std::array<uint64_t, LatencyBucketsCount> buckets {}; // not cumulative
+	std::array<uint64_t, ErrorTypesCount> errors {};       // index is ErrorType
+
+	uint64_t get_errors_count() const;
+
+	// upper bound of bucket which contains quantile (0..1). 0 if count == 0
+	uint64_t get_quantile_ns(double quantile) const;
+};
+
+struct DBLIB_API StatementMetrics
+{
+	std::string fingerprint;
+	std::array<OperationMetrics, TraceOperationsCount> operations; // index is TraceOperation
+	uint64_t rows_fetched = 0;
+	uint64_t rows_changed = 0;
+	uint64_t bytes = 0;
+	uint64_t round_trips = 0;
+
+	const OperationMetrics& get(TraceOperation operation) const;
+	uint64_t get_total_ns() const;
+	uint64_t get_total_count() const;
+};
+
+// Normalized text of SQL: literals are replaced with ?, lists of literals
+// are collapsed into one ?, spaces and comments are removed, text is
+// converted to lower case. Commit and rollback have fingerprints "commit"
+// and "rollback"
+DBLIB_API std::string sql_fingerprint(std::string_view sql);
+
+
+/* class MetricsRegistry
+
+   Tracer which aggregates statistics per SQL fingerprint. Every thread
+   writes into its own shard without locks (mutex of shard is locked only
+   for first event of new SQL text and by snapshot). Use it as tracer:
+   connection->set_tracer(registry) */
+
+class DBLIB_API MetricsRegistry : public Tracer
+{
+public:
+	MetricsRegistry();
+	~MetricsRegistry();
+
+	void begin(TraceEvent &event) override;
+	void end(TraceEvent &event) override;
+
+	// Merged metrics of all threads. Sorted by total time (slowest first)
+	std::vector<StatementMetrics> snapshot() const;
+
+	// Snapshot in Prometheus text exposition format
+	std::string to_prometheus(std::string_view prefix = "dblib") const;
+
+private:
+	struct Counters;
+	struct Shard;
+	using ShardPtr = std::shared_ptr<Shard>;
+
+	const uint64_t id_;
+	mutable std::mutex mutex_;
+	std::vector<ShardPtr> shards_;
+
+	Shard& get_thread_shard();
+	Counters& get_counters(Shard &shard, std::string_view sql, TraceOperation operation);
+};
+
+typedef std::shared_ptr<MetricsRegistry> MetricsRegistryPtr;
+
+} // namespace dblib
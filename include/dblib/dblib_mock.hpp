@@ -0,0 +1,91 @@
+/*
+
+Copyright (c) 2015-2022 Artyomov Denis (denis.artyomov@gmail.com)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "dblib_conf.hpp"
+#include "dblib.hpp"
+#include "dblib_result_set.hpp"
+
+namespace dblib {
+
+
+// fwd.
+class MockConnection; typedef std::shared_ptr<MockConnection> MockConnectionPtr;
+
+struct DBLIB_API MockResult
+{
+	ResultSet rows;          // columns and values of rows of select
+	size_t repeat_count = 1; // rows are returned repeat_count times
+	size_t changes_count = 0;
+};
+
+// returns result of executed SQL (text after preprocessing). nullptr - no rows
+using MockResultFun = std::function<const MockResult*(std::string_view sql)>;
+
+// receives values of parameters at every execute
+using MockParamsSink = std::function<void(std::string_view sql, const ParamValues &params)>;
+
+struct DBLIB_API MockConfig
+{
+	MockResultFun result_fun;
+	MockParamsSink params_sink;
+	bool supports_sequences = true;
+};
+
+struct DBLIB_API MockStats
+{
+	size_t transactions_count = 0;
+	size_t prepares_count = 0;
+	size_t executes_count = 0;
+	size_t fetched_rows_count = 0;
+};
+
+
+/* class MockConnection
+
+   In-process driver without any I/O. Result of select is taken from
+   MockConfig::result_fun and values of parameters are passed into
+   MockConfig::params_sink. Is used to measure overhead of library itself.
+   Parameters are ?1, ?2 ... or named. Driver name is "mock" */
+
+class DBLIB_API MockConnection : public Connection
+{
+public:
+	virtual const MockStats& get_stats() const = 0;
+	virtual void reset_stats() = 0;
+};
+
+DBLIB_API MockConnectionPtr create_mock_connection(const MockConfig &config = {});
+
+// Result set with rows_count rows of synthetic not null values of types.
+// Names of columns are col1, col2 ...
+DBLIB_API ResultSet make_mock_rows(const std::vector<ValueType> &types, size_t rows_count);
+
+} // namespace dblib
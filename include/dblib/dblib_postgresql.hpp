@@ -25,7 +25,9 @@ THE SOFTWARE.
 #pragma once
 
 #include <map>
+#include <array>
 #include <string>
+#include <functional>
 
 #include "dblib_conf.hpp"
 #include "dblib.hpp"
@@ -36,12 +38,15 @@ namespace dblib {
 class PgConnection; typedef std::shared_ptr<PgConnection> PgConnectionPtr;
 class PgTransaction; typedef std::shared_ptr<PgTransaction> PgTransactionPtr;
 class PgStatement; typedef std::shared_ptr<PgStatement> PgStatementPtr;
+class PgNotificationListener; typedef std::shared_ptr<PgNotificationListener> PgNotificationListenerPtr;
+class ResultColumn;
 
 struct DBLIB_API PgApi
 {
 	decltype(PQconnectdbParams)           *f_PQconnectdbParams = nullptr;
 	decltype(PQfinish)                    *f_PQfinish = nullptr;
 	decltype(PQstatus)                    *f_PQstatus = nullptr;
+	decltype(PQtransactionStatus)         *f_PQtransactionStatus = nullptr;
 	decltype(PQerrorMessage)              *f_PQerrorMessage = nullptr;
 	decltype(PQexec)                      *f_PQexec = nullptr;
 	decltype(PQprepare)                   *f_PQprepare = nullptr;
@@ -70,6 +75,19 @@ struct DBLIB_API PgApi
 	decltype(PQclear)                     *f_PQclear = nullptr;
 	decltype(PQputCopyData)               *f_PQputCopyData = nullptr;
 	decltype(PQputCopyEnd)                *f_PQputCopyEnd = nullptr;
+	decltype(PQnotifies)                  *f_PQnotifies = nullptr;
+	decltype(PQconsumeInput)              *f_PQconsumeInput = nullptr;
+	decltype(PQsocket)                    *f_PQsocket = nullptr;
+	decltype(PQfreemem)                   *f_PQfreemem = nullptr;
+	decltype(PQsendPrepare)               *f_PQsendPrepare = nullptr;
+	decltype(PQsendDescribePrepared)      *f_PQsendDescribePrepared = nullptr;
+
+	// pipeline mode (libpq 14+). Pointers are null for older libpq
+	int (*f_PQenterPipelineMode)(PGconn *conn) = nullptr;
+	int (*f_PQexitPipelineMode)(PGconn *conn) = nullptr;
+	int (*f_PQpipelineSync)(PGconn *conn) = nullptr;
+
+	bool supports_pipeline_mode() const;
 
 };
 
@@ -108,6 +126,7 @@ public:
 
 	void begin_tuple();
 
+	void write_int16_opt(std::optional<int16_t> value);
 	void write_int32_opt(Int32Opt value);
 	void write_int64_opt(Int64Opt value);
 	void write_float_opt(FloatOpt value);
@@ -117,6 +136,13 @@ public:
 	void write_date_opt(const DateOpt& date);
 	void write_time_opt(const TimeOpt& time);
 	void write_timestamp_opt(const TimeStampOpt& ts);
+	void write_bool_opt(std::optional<bool> value);
+	void write_blob_opt(const char* data, size_t size); // data == nullptr - null
+
+	// writes value of column converted into type of destination column
+	// (Short, Integer, BigInt, Float, Double, Char, Varchar, Blob, Date, Time, Timestamp).
+	// Text and julian day (as SQLite keeps them) are converted into date and time
+	void write_column_value(const ResultColumn &column, size_t row, ValueType dst_type);
 
 	void end_tuple();
 
@@ -132,6 +158,7 @@ private:
 	char be_buffer_[BeBuffSize] = {};
 	uint16_t col_count_ = 0;
 	std::string utf8_buffer_;
+	std::string text_buffer_;
 
 	void add_header();
 	void add_footer() const;
@@ -146,12 +173,59 @@ private:
 	void write_len(uint32_t len);
 };
 
+struct DBLIB_API PgListenerParams
+{
+	bool coalesce = true;       // equal notifications received together are dispatched once
+	bool auto_reconnect = true; // connect again and repeat LISTEN if connection is lost
+};
+
 class DBLIB_API PgConnection : public Connection
 {
 public:
 	virtual PGconn* get_connection() = 0;
 
 	virtual PgTransactionPtr create_pg_transaction(const TransactionParams& transaction_params) = 0;
+
+	// Connection must be connected and is used only by listener after this call
+	virtual PgNotificationListenerPtr create_notification_listener(const PgListenerParams &params = {}) = 0;
+};
+
+struct DBLIB_API PgNotification
+{
+	std::string channel;
+	std::string payload;
+	int backend_pid = 0; // process of server which sent notification
+};
+
+using PgNotificationHandler = std::function<void(const PgNotification &notification)>;
+
+/* class PgNotificationListener
+
+   Receives messages of NOTIFY on dedicated connection. wait() sleeps on
+   socket of connection without queries to server and calls handlers of
+   channels in thread of caller. Notifications sent while connection
+   was lost are not received so reconnect handler should treat all data
+   as changed */
+
+class DBLIB_API PgNotificationListener
+{
+public:
+	virtual ~PgNotificationListener();
+
+	// name of channel is case sensitive (it is quoted in LISTEN)
+	virtual void listen(std::string_view channel, const PgNotificationHandler &handler) = 0;
+	virtual void unlisten(std::string_view channel) = 0;
+
+	virtual void set_reconnect_handler(const std::function<void()> &handler) = 0;
+
+	// Waits for notifications not longer than timeout_ms (-1 - without timeout)
+	// and dispatches them. Returns number of dispatched notifications
+	virtual size_t wait(int timeout_ms) = 0;
+
+	// Dispatches already received notifications without waiting
+	virtual size_t dispatch() = 0;
+
+	virtual size_t get_reconnects_count() const = 0;
 };
 
 class DBLIB_API PgTransaction : public Transaction
@@ -160,11 +234,53 @@ public:
 	virtual PgStatementPtr create_pg_statement() = 0;
 };
 
+using PgUuid = std::array<uint8_t, 16>;
+
+struct DBLIB_API PgCursorParams
+{
+	size_t fetch_size = 10000; // rows in one FETCH FORWARD
+	bool with_hold = false;    // cursor is available after commit of transaction
+};
+
 class DBLIB_API PgStatement : public Statement
 {
 public:
 	virtual void put_copy_data(const char *data, int data_len) = 0;
 	virtual void put_buffer(const PgBuffer &buffer) = 0;
+
+	// Server side cursor mode. Query of next prepare or execute is declared
+	// as cursor and rows are fetched by batches of PgCursorParams::fetch_size
+	// rows instead of one result per row. Only for queries returning rows
+	virtual void set_cursor_mode(const PgCursorParams &params) = 0;
+	virtual void reset_cursor_mode() = 0;
+	virtual bool is_cursor_mode() const = 0;
+
+	// Prepare with declared types of parameters (as oids or ValueType). Types
+	// are passed to server instead of inference and setters of the same type
+	// bind values without conversion. Oid 0 or ValueType::Any means type
+	// inferred by server.
+	// If types of all parameters are declared statement is not described
+	// by server so types and names of columns are available only after
+	// execute. Such statement is prepared once for connection: repeated
+	// prepare of the same SQL with the same types doesn't access server
+	// and server reuses plan of statement
+	virtual void prepare_with_types(std::string_view sql, const std::vector<Oid> &param_types, bool use_native_parameters_syntax = false) = 0;
+	virtual void prepare_with_value_types(std::string_view sql, const std::vector<ValueType> &param_types, bool use_native_parameters_syntax = false) = 0;
+
+	// Values of boolean, uuid, json and jsonb columns and parameters in binary
+	// format. Other types (numeric, timestamptz, bytea) are accessed by methods
+	// of Statement: numeric is converted into text, timestamptz is in UTC
+
+	virtual std::optional<bool> get_bool_opt(const IndexOrName &column) = 0;
+	virtual void set_bool_opt(const IndexOrName &param, std::optional<bool> value) = 0;
+
+	virtual std::optional<PgUuid> get_uuid_opt(const IndexOrName &column) = 0;
+	virtual void set_uuid_opt(const IndexOrName &param, const std::optional<PgUuid> &value) = 0;
+
+	// text of json or jsonb value without copying (empty for null).
+	// View is valid until next fetch
+	virtual std::string_view get_json_view(const IndexOrName &column) = 0;
+	virtual void set_json(const IndexOrName &param, std::string_view json) = 0;
 };
 
 // Date, time and timestamp conversions in or from internal PG format
@@ -181,6 +297,17 @@ DBLIB_API Time pg_time_to_dblib_time(int64_t pg_time, int32_t *date_rest = nullp
 
 DBLIB_API TimeStamp pg_ts_to_dblib_ts(int64_t pg_ts);
 
+// Numeric and uuid conversions in or from binary PG format. Functions
+// str_to_* return false if text has format which is not supported
+
+DBLIB_API std::string pg_numeric_to_str(const char *data, size_t size);
+
+DBLIB_API bool str_to_pg_numeric(std::string_view text, std::vector<char> &result);
+
+DBLIB_API std::string pg_uuid_to_str(const PgUuid &uuid);
+
+DBLIB_API bool str_to_pg_uuid(std::string_view text, PgUuid &result);
+
 
 DBLIB_API PgLibPtr create_pg_lib();
 
@@ -0,0 +1,160 @@
+/*
+
+Copyright (c) 2015-2022 Artyomov Denis (denis.artyomov@gmail.com)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <chrono>
+
+#include "dblib_conf.hpp"
+#include "dblib.hpp"
+#include "dblib_result_set.hpp"
+
+namespace dblib {
+
+using ResultSetPtr = std::shared_ptr<const ResultSet>;
+
+struct DBLIB_API QueryCacheParams
+{
+	std::chrono::milliseconds ttl = std::chrono::seconds(60);
+	size_t max_memory_size = 64 * 1024 * 1024;
+};
+
+struct DBLIB_API QueryCacheStats
+{
+	size_t hits = 0;
+	size_t misses = 0;
+	size_t evictions = 0;
+	size_t invalidations = 0;
+};
+
+/* class QueryCache
+
+   Opt-in cache of materialized query results. Key of cached item is SQL text
+   and values of parameters. Each item remembers tables from FROM and JOIN
+   clauses of query and is removed when one of these tables is invalidated.
+   Items are also removed after TTL and in least recently used order when
+   memory size exceeds max_memory_size.
+
+   Invalidation sources:
+     - execute() of DML statements through the cache
+     - commit() of transaction through the cache
+     - explicit invalidate_table() / invalidate_by_sql() (for example from
+       PostgreSQL notifications)
+
+   execute() invalidates changed table at once and remembers it for the
+   transaction of statement. Other transactions still read and may put
+   previous data until commit, so the table is invalidated again by
+   commit(). query() inside transaction with not committed changes
+   neither reads nor puts results. Transactions with execute() have to be
+   finished by commit() or rollback() of cache */
+
+class DBLIB_API QueryCache
+{
+public:
+	QueryCache(const QueryCacheParams &params = {});
+
+	// returns cached result or nullptr
+	ResultSetPtr get(std::string_view sql, const ParamValues &params = {});
+
+	void put(std::string_view sql, const ParamValues &params, const ResultSetPtr &result);
+
+	// returns cached result or executes query and stores its result
+	ResultSetPtr query(Statement &stmt, std::string_view sql, const ParamValues &params = {});
+
+	// executes DML statement and invalidates changed table
+	void execute(Statement &stmt, std::string_view sql, const ParamValues &params = {});
+
+	// commits transaction and invalidates tables changed by execute() in it
+	void commit(Transaction &tran);
+
+	// rolls back transaction and forgets tables changed by execute() in it
+	void rollback(Transaction &tran);
+
+	void invalidate_table(std::string_view table_name);
+	void invalidate_by_sql(std::string_view sql);
+	void invalidate_all();
+
+	size_t get_items_count() const;
+	size_t get_memory_size() const;
+	QueryCacheStats get_stats() const;
+
+private:
+	using Clock = std::chrono::steady_clock;
+	struct Item;
+	using Items = std::list<Item>; // most recently used item is first
+	using ItemsByKey = std::unordered_map<std::string_view, Items::iterator>;
+
+	struct Item
+	{
+		std::string key;
+		std::vector<std::string> tables;
+		ResultSetPtr result;
+		Clock::time_point expire_time;
+		size_t memory_size = 0;
+	};
+
+	struct PendingInvalidation
+	{
+		std::vector<std::string> tables;
+		bool all = false;
+	};
+
+	QueryCacheParams params_;
+	mutable std::mutex mutex_;
+	Items items_;
+	ItemsByKey items_by_key_;
+	size_t memory_size_ = 0;
+	QueryCacheStats stats_;
+	uint64_t invalidations_count_ = 0;
+	std::string key_buffer_;
+	std::unordered_map<const Transaction*, PendingInvalidation> pending_invalidations_;
+
+	void make_key(std::string_view sql, const ParamValues &params, std::string &key) const;
+	void put_impl(std::string_view sql, const ParamValues &params, const ResultSetPtr &result, uint64_t invalidations_count);
+	void erase_item(Items::iterator it);
+	void evict_items();
+	bool has_pending_invalidations(const Transaction *tran) const;
+};
+
+using QueryCachePtr = std::shared_ptr<QueryCache>;
+
+
+// returns lowercase names of tables from FROM and JOIN clauses
+DBLIB_API std::vector<std::string> get_sql_source_tables(std::string_view sql);
+
+// returns lowercase name of table changed by INSERT, UPDATE, DELETE, MERGE,
+// UPDATE OR INSERT, REPLACE, TRUNCATE, ALTER TABLE or DROP TABLE statement.
+// Returns empty string for other statements
+DBLIB_API std::string get_sql_target_table(std::string_view sql);
+
+} // namespace dblib
@@ -0,0 +1,198 @@
+/*
+
+Copyright (c) 2015-2022 Artyomov Denis (denis.artyomov@gmail.com)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <variant>
+
+#include "dblib_conf.hpp"
+#include "dblib.hpp"
+
+namespace dblib {
+
+/* class ResultColumn
+
+   One column of materialized result. Values are stored in one contiguous
+   vector of column type:
+
+     Short              -> int16_t
+     Integer, Boolean   -> int32_t
+     BigInt             -> int64_t
+     Float              -> float
+     Double             -> double
+     Date               -> Date
+     Time               -> Time
+     Timestamp          -> TimeStamp
+     Char, Varchar      -> string arena
+     Blob               -> string arena
+
+   Text and blobs are stored one after another in the arena, value of row N
+   is placed between get_offsets()[N] and get_offsets()[N+1].
+   Null values are marked in null bitmap (bit is set for null).
+   Null rows still take place in values vector (default value) so row index
+   is the same for all vectors.
+
+   Column of type Null is a column without values or with unknown type.
+   It gets real type with first not null value (see set_type) */
+
+class DBLIB_API ResultColumn
+{
+public:
+	ResultColumn(std::string_view name, ValueType type);
+
+	const std::string& get_name() const;
+	ValueType get_type() const;
+	void set_type(ValueType type);
+
+	size_t get_rows_count() const;
+	void reserve(size_t rows_count);
+	void clear();
+
+	// appending values
+
+	void append_null();
+	void append_int16(int16_t value);
+	void append_int32(int32_t value);
+	void append_int64(int64_t value);
+	void append_float(float value);
+	void append_double(double value);
+	void append_str(std::string_view text);
+	void append_blob(const char *data, size_t size);
+	void append_date(const Date &date);
+	void append_time(const Time &time);
+	void append_timestamp(const TimeStamp &ts);
+
+	// access values (rows are counted from 0). Numeric values are converted
+	// into requested type. Default value is returned for null rows
+
+	bool is_null(size_t row) const;
+
+	int16_t get_int16(size_t row) const;
+	int32_t get_int32(size_t row) const;
+	int64_t get_int64(size_t row) const;
+	float get_float(size_t row) const;
+	double get_double(size_t row) const;
+	std::string_view get_str(size_t row) const;
+	std::string_view get_blob(size_t row) const;
+	const Date& get_date(size_t row) const;
+	const Time& get_time(size_t row) const;
+	const TimeStamp& get_timestamp(size_t row) const;
+
+	// raw data
+
+	template <typename T>
+	const std::vector<T>& get_values() const
+	{
+		return std::get<std::vector<T>>(values_);
+	}
+
+	const std::vector<uint64_t>& get_null_bitmap() const;
+	const std::vector<char>& get_arena() const;
+	const std::vector<size_t>& get_offsets() const;
+
+	size_t get_memory_size() const;
+
+private:
+	using Values = std::variant<
+		std::monostate,
+		std::vector<int16_t>,
+		std::vector<int32_t>,
+		std::vector<int64_t>,
+		std::vector<float>,
+		std::vector<double>,
+		std::vector<Date>,
+		std::vector<Time>,
+		std::vector<TimeStamp>
+	>;
+
+	std::string name_;
+	ValueType type_;
+	size_t rows_count_ = 0;
+	Values values_;
+	std::vector<uint64_t> null_bitmap_;
+	std::vector<char> arena_;
+	std::vector<size_t> offsets_;
+
+	void init_storage();
+	void mark_row(bool is_null);
+	bool is_arena_type() const;
+
+	void check_row(size_t row) const;
+
+	template <typename T>
+	void append_value(const T &value, const char *type_name);
+
+	template <typename T>
+	const T& get_value(size_t row, const char *type_name) const;
+
+	template <typename T>
+	T get_number(size_t row, const char *type_name) const;
+
+	std::string_view get_arena_item(size_t row) const;
+};
+
+
+/* class ResultSet */
+
+class DBLIB_API ResultSet
+{
+public:
+	size_t get_rows_count() const;
+	size_t get_columns_count() const;
+
+	// columns are counted from 1 as in Statement
+	ResultColumn& get_column(size_t index);
+	const ResultColumn& get_column(size_t index) const;
+	const ResultColumn& get_column(std::string_view name) const;
+	size_t get_column_index(std::string_view name) const;
+
+	ResultColumn& add_column(std::string_view name, ValueType type);
+
+	void reserve(size_t rows_count);
+
+	// removes rows but keeps columns and its types
+	void clear_rows();
+
+	// removes rows and columns
+	void clear();
+
+	size_t get_memory_size() const;
+
+private:
+	std::vector<ResultColumn> columns_;
+};
+
+
+// Fetches all remaining rows of executed statement
+DBLIB_API ResultSet fetch_all_columnar(Statement &stmt);
+
+// Sets parameter of statement from value of column in row
+DBLIB_API void set_param_from_column(Statement &stmt, const IndexOrName &param, const ResultColumn &column, size_t row);
+
+} // namespace dblib
@@ -0,0 +1,102 @@
+/*
+
+Copyright (c) 2015-2022 Artyomov Denis (denis.artyomov@gmail.com)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "dblib_conf.hpp"
+#include "dblib.hpp"
+
+namespace dblib {
+
+struct DBLIB_API SchemaColumn
+{
+	std::string name;
+	std::string type_name; // type name of database
+	ValueType type = ValueType::Any;
+	bool nullable = true;
+};
+
+struct DBLIB_API SchemaIndex
+{
+	std::string name;
+	bool is_unique = false;
+	bool is_primary = false;
+	std::vector<std::string> columns;
+};
+
+struct DBLIB_API SchemaTable
+{
+	std::string name;
+	std::vector<SchemaColumn> columns;
+	std::vector<SchemaIndex> indexes;
+	std::vector<std::string> primary_key;
+
+	// names are compared case insensitive. nullptr if not found
+	const SchemaColumn* find_column(std::string_view name) const;
+	const SchemaIndex* find_index(std::string_view name) const;
+};
+
+
+/* class SchemaCatalog
+
+   Tables (and views) of current schema with columns, indexes and primary
+   keys. Loaded by one query for every database:
+
+     PostgreSQL: pg_class, pg_attribute, pg_index
+     Firebird:   RDB$RELATION_FIELDS, RDB$INDICES, RDB$INDEX_SEGMENTS
+     SQLite:     sqlite_master, pragma_table_info, pragma_index_list
+
+   Catalog can be saved into file and loaded back to avoid queries at startup.
+   Version is any text (for example version of database scheme of application).
+   File is not loaded if its version or driver name differs */
+
+class DBLIB_API SchemaCatalog
+{
+public:
+	void load(Transaction &tran);
+
+	// returns false if file doesn't exist or it is saved for other version
+	bool load_from_file(const FileName &file_name, std::string_view version, std::string_view driver_name);
+	void save_to_file(const FileName &file_name, std::string_view version) const;
+
+	void clear();
+
+	const std::string& get_driver_name() const;
+	const std::vector<SchemaTable>& get_tables() const;
+
+	// name is compared case insensitive. nullptr if not found
+	const SchemaTable* find_table(std::string_view name) const;
+
+private:
+	std::string driver_name_;
+	std::vector<SchemaTable> tables_; // sorted by name
+
+	void sort_tables();
+};
+
+} // namespace dblib
@@ -0,0 +1,103 @@
+/*
+
+Copyright (c) 2015-2022 Artyomov Denis (denis.artyomov@gmail.com)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "dblib_conf.hpp"
+#include "dblib.hpp"
+
+namespace dblib {
+
+struct DBLIB_API SequenceAllocatorParams
+{
+	// count of values reserved by one round trip to server
+	size_t block_size = 100;
+
+	// SQLite: table with counters of sequences. Created if not exists
+	std::string sqlite_counters_table = "dblib_sequences";
+};
+
+
+/* class SequenceAllocator
+
+   Reserves blocks of sequence values by one query and gives them out
+   without locks. Can be used from several threads at once:
+
+     PostgreSQL: select nextval('seq') from generate_series(1, block_size)
+     Firebird:   select gen_id(seq, block_size) from rdb$database
+     SQLite:     counter of sequence in table sqlite_counters_table is
+                 increased by block_size
+
+   Values are reserved in separate transactions of connection, so connection
+   must not be used by other code. Sequence must be ascending. Reserved but
+   not used values are lost when allocator is destroyed */
+
+class DBLIB_API SequenceAllocator
+{
+public:
+	SequenceAllocator(
+		const ConnectionPtr           &connection,
+		std::string_view              seq_name,
+		const SequenceAllocatorParams &params = {}
+	);
+
+	~SequenceAllocator();
+
+	int64_t next();
+
+	// count of round trips to server
+	size_t get_reservations_count() const;
+
+private:
+	using Range = std::pair<int64_t, int64_t>; // [first, last)
+
+	ConnectionPtr connection_;
+	std::string seq_name_;
+	SequenceAllocatorParams params_;
+	std::string driver_name_;
+	std::string select_sql_;
+	TransactionPtr tran_;
+	StatementPtr reserve_stmt_;
+	StatementPtr select_stmt_;
+	std::atomic<int64_t> next_;
+	std::atomic<int64_t> limit_;
+	std::mutex mutex_;
+	std::deque<Range> reserved_;
+	std::atomic<size_t> reservations_count_ = 0;
+
+	void init_sqlite_counter();
+	void reserve_block();
+	void next_slow();
+};
+
+} // namespace dblib
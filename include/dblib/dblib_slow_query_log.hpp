@@ -0,0 +1,133 @@
+/*
+
+Copyright (c) 2015-2022 Artyomov Denis (denis.artyomov@gmail.com)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "dblib_conf.hpp"
+#include "dblib.hpp"
+#include "dblib_tracer.hpp"
+
+namespace dblib {
+
+
+struct DBLIB_API SlowQuery
+{
+	std::string sql;
+	bool native_parameters_syntax = false; // sql uses native syntax of parameters of driver
+	std::optional<ParamValues> params;     // not set if driver can't return values of parameters
+	TraceClock::time_point begin_time;
+	std::chrono::nanoseconds execute_time {0};
+	std::chrono::nanoseconds fetch_time {0}; // sum of all fetches
+	size_t rows_count = 0;                   // fetched rows or rows changed by execute
+	bool failed = false;
+	std::string plan;                        // empty if plan is not captured
+};
+
+using SlowQuerySink = std::function<void(const SlowQuery &query)>;
+
+struct DBLIB_API SlowQueryLogParams
+{
+	// execute time + fetch time
+	std::chrono::nanoseconds threshold = std::chrono::milliseconds(100);
+
+	// side connection for capturing of plans. nullptr - plans are not captured.
+	// It is connected by log if it is not connected
+	ConnectionPtr plan_connection;
+
+	// PostgreSQL: EXPLAIN (ANALYZE, BUFFERS) instead of EXPLAIN. Query is
+	// executed again on side connection in transaction which is rolled back
+	bool analyze = false;
+
+	// slow queries are dropped if plans are captured slower than they appear
+	size_t max_queue_size = 1000;
+};
+
+
+/* class SlowQueryLog
+
+   Tracer which passes queries executed and fetched longer than threshold
+   into sink. Sink is called from worker thread of log after plan is
+   captured on side connection so threads executing queries are only
+   measuring time. Query is finished by end of fetching, by next prepare
+   or execute of the same statement. Query is not logged if its statement
+   is destroyed before end of fetching */
+
+class DBLIB_API SlowQueryLog : public Tracer
+{
+public:
+	SlowQueryLog(SlowQuerySink sink, const SlowQueryLogParams &params = {});
+	~SlowQueryLog();
+
+	void begin(TraceEvent &event) override;
+	void end(TraceEvent &event) override;
+
+	// waits until all slow queries are passed into sink
+	void flush();
+
+	size_t get_dropped_count() const;
+
+private:
+	struct Pending;
+
+	const uint64_t id_;
+	SlowQuerySink sink_;
+	SlowQueryLogParams params_;
+
+	mutable std::mutex mutex_;
+	std::condition_variable cond_;
+	std::deque<SlowQuery> queue_;
+	bool stop_ = false;
+	bool processing_ = false;
+	size_t dropped_count_ = 0;
+	std::thread worker_;
+
+	static std::vector<Pending>& get_thread_pendings();
+	void finish(Pending &pending, Statement *statement, bool with_params);
+	void push(SlowQuery &&query);
+	void worker_fun();
+};
+
+// Text of plan of query. Is used by SlowQueryLog for side connection.
+// EXPLAIN QUERY PLAN for SQLite, EXPLAIN [(ANALYZE, BUFFERS)] for PostgreSQL,
+// isc_info_sql_get_plan for Firebird and EXPLAIN for other drivers
+DBLIB_API std::string capture_query_plan(
+	Connection        &connection,
+	std::string_view  sql,
+	const ParamValues *params,
+	bool              analyze,
+	bool              use_native_parameters_syntax = false
+);
+
+} // namespace dblib
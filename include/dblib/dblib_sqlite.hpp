@@ -65,6 +65,7 @@ struct DBLIB_API SqliteApi
 	decltype(sqlite3_column_type)          *f_sqlite3_column_type = nullptr;
 	decltype(sqlite3_finalize)             *f_sqlite3_finalize = nullptr;
 	decltype(sqlite3_reset)                *f_sqlite3_reset = nullptr;
+	decltype(sqlite3_clear_bindings)       *f_sqlite3_clear_bindings = nullptr;
 	decltype(sqlite3_bind_parameter_index) *f_sqlite3_bind_parameter_index = nullptr;
 	decltype(sqlite3_changes)              *f_sqlite3_changes = nullptr;
 	decltype(sqlite3_last_insert_rowid)    *f_sqlite3_last_insert_rowid = nullptr;
@@ -185,6 +186,179 @@ public:
 };
 
 
+/* class SqliteFastStatement
+
+   Statement for code which works only with SQLite. Methods are not virtual
+   and are inlined into caller so binding parameters and reading columns
+   are direct calls of SQLite API. SQL is not preprocessed (use ?NNN
+   parameters), parameters and columns are accessed by index (counted from 1
+   as in Statement). Statement is not reported into tracer of connection.
+   Getters return SQLite conversion of null value (0 or empty string), use
+   is_null to check. Text and blob returned by getters are valid until next
+   fetch */
+
+class DBLIB_API SqliteFastStatement
+{
+public:
+	SqliteFastStatement(const SQLiteTransactionPtr &transaction);
+	~SqliteFastStatement();
+
+	SqliteFastStatement(const SqliteFastStatement&) = delete;
+	SqliteFastStatement& operator = (const SqliteFastStatement&) = delete;
+
+	void prepare(std::string_view sql);
+
+	void execute()
+	{
+		reset_if_needed();
+		step();
+		step_called_ = true;
+	}
+
+	bool fetch()
+	{
+		if (step_called_)
+			step_called_ = false;
+		else
+		{
+			if (last_step_result_ == SQLITE_DONE)
+				throw_wrong_seq("Fetch after data end");
+			step();
+		}
+		return last_step_result_ == SQLITE_ROW;
+	}
+
+	size_t get_changes_count() const
+	{
+		return api_.f_sqlite3_changes(db_);
+	}
+
+	int64_t get_last_row_id() const
+	{
+		return api_.f_sqlite3_last_insert_rowid(db_);
+	}
+
+	// parameters
+
+	void set_null(int index)
+	{
+		reset_if_needed();
+		check_ret_code(api_.f_sqlite3_bind_null(stmt_, index), "sqlite3_bind_null");
+	}
+
+	void set_int32(int index, int32_t value)
+	{
+		reset_if_needed();
+		check_ret_code(api_.f_sqlite3_bind_int(stmt_, index, value), "sqlite3_bind_int");
+	}
+
+	void set_int64(int index, int64_t value)
+	{
+		reset_if_needed();
+		check_ret_code(api_.f_sqlite3_bind_int64(stmt_, index, value), "sqlite3_bind_int64");
+	}
+
+	void set_double(int index, double value)
+	{
+		reset_if_needed();
+		check_ret_code(api_.f_sqlite3_bind_double(stmt_, index, value), "sqlite3_bind_double");
+	}
+
+	void set_u8str(int index, std::string_view text)
+	{
+		reset_if_needed();
+		check_ret_code(api_.f_sqlite3_bind_text(stmt_, index, text.data(), (int)text.size(), SQLITE_TRANSIENT), "sqlite3_bind_text");
+	}
+
+	void set_blob(int index, const char *blob_data, size_t blob_size)
+	{
+		reset_if_needed();
+		check_ret_code(api_.f_sqlite3_bind_blob(stmt_, index, blob_data, (int)blob_size, SQLITE_TRANSIENT), "sqlite3_bind_blob");
+	}
+
+	// columns
+
+	size_t get_columns_count() const
+	{
+		return api_.f_sqlite3_column_count(stmt_);
+	}
+
+	bool is_null(int index) const
+	{
+		return api_.f_sqlite3_column_type(stmt_, index - 1) == SQLITE_NULL;
+	}
+
+	int32_t get_int32(int index) const
+	{
+		return api_.f_sqlite3_column_int(stmt_, index - 1);
+	}
+
+	int64_t get_int64(int index) const
+	{
+		return api_.f_sqlite3_column_int64(stmt_, index - 1);
+	}
+
+	double get_double(int index) const
+	{
+		return api_.f_sqlite3_column_double(stmt_, index - 1);
+	}
+
+	std::string_view get_str_utf8(int index) const
+	{
+		auto text = (const char*)api_.f_sqlite3_column_text(stmt_, index - 1);
+		if (!text) return {};
+		return { text, (size_t)api_.f_sqlite3_column_bytes(stmt_, index - 1) };
+	}
+
+	std::string_view get_blob(int index) const
+	{
+		auto data = (const char*)api_.f_sqlite3_column_blob(stmt_, index - 1);
+		if (!data) return {};
+		return { data, (size_t)api_.f_sqlite3_column_bytes(stmt_, index - 1) };
+	}
+
+	sqlite3_stmt* get_stmt() const
+	{
+		return stmt_;
+	}
+
+private:
+	SQLiteTransactionPtr transaction_;
+	const SqliteApi &api_;
+	sqlite3 *db_;
+	sqlite3_stmt *stmt_ = nullptr;
+	bool must_be_reseted_ = false;
+	bool step_called_ = false;
+	int last_step_result_ = -1;
+	std::string last_sql_;
+
+	void reset_if_needed()
+	{
+		if (!must_be_reseted_) return;
+		must_be_reseted_ = false;
+		check_ret_code(api_.f_sqlite3_reset(stmt_), "sqlite3_reset");
+	}
+
+	void step()
+	{
+		last_step_result_ = api_.f_sqlite3_step(stmt_);
+		if ((last_step_result_ == SQLITE_ROW) || (last_step_result_ == SQLITE_DONE))
+			must_be_reseted_ = true;
+		else
+			throw_error(last_step_result_, "sqlite3_step");
+	}
+
+	void check_ret_code(int ret_code, const char *fun_name) const
+	{
+		if (ret_code != SQLITE_OK)
+			throw_error(ret_code, fun_name);
+	}
+
+	[[noreturn]] void throw_error(int ret_code, const char *fun_name) const;
+	[[noreturn]] static void throw_wrong_seq(const char *text);
+};
+
+
 DBLIB_API SqliteLibPtr create_sqlite_lib();
 
 } // namespace dblib
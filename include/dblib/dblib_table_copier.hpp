@@ -0,0 +1,91 @@
+/*
+
+Copyright (c) 2015-2022 Artyomov Denis (denis.artyomov@gmail.com)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "dblib_conf.hpp"
+#include "dblib.hpp"
+
+namespace dblib {
+
+struct DBLIB_API TableCopierParams
+{
+	size_t batch_size = 10000;   // rows in one batch passed from reader to writer
+	size_t queue_size = 4;       // max count of read batches waiting for writer
+	size_t commit_rows = 100000; // commit destination every N rows (0 - only at the end)
+};
+
+struct DBLIB_API TableCopierStats
+{
+	using Duration = std::chrono::duration<double>;
+
+	size_t rows_count = 0;
+	size_t batches_count = 0;
+	size_t commits_count = 0;
+	Duration total_time {};
+	Duration write_time {};  // time spent by writer for inserting data
+	Duration wait_time {};   // time spent by writer for waiting data from reader
+
+	double get_rows_per_second() const;
+};
+
+
+/* class TableCopier
+
+   Copies result of query into table of other (or same) database. Source
+   statement is fetched by columnar batches in separate thread, destination
+   is written in calling thread. Count of batches between threads is limited
+   by TableCopierParams::queue_size.
+
+   Destination is written by the fastest way for DBMS:
+     PostgreSQL:       binary COPY, values are converted into types of destination columns
+     SQLite, Firebird: prepared insert inside of transaction
+
+   Source and destination must use different connections */
+
+class DBLIB_API TableCopier
+{
+public:
+	TableCopier(const TableCopierParams &params = {});
+
+	// src - executed statement. Names of destination columns are taken from
+	// source if dst_columns is empty. Destination transaction is started if
+	// required and committed every TableCopierParams::commit_rows rows and at the end
+	TableCopierStats copy(
+		Statement                      &src,
+		Transaction                    &dst,
+		std::string_view               dst_table,
+		const std::vector<std::string> &dst_columns = {}
+	);
+
+private:
+	TableCopierParams params_;
+};
+
+} // namespace dblib
@@ -0,0 +1,149 @@
+/*
+
+Copyright (c) 2015-2022 Artyomov Denis (denis.artyomov@gmail.com)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "dblib_conf.hpp"
+#include "dblib.hpp"
+
+namespace dblib {
+
+
+enum class TraceOperation
+{
+	Prepare,
+	Execute,
+	Fetch,
+	Commit,
+	Rollback
+};
+
+DBLIB_API const char* trace_operation_to_string(TraceOperation operation);
+
+using TraceClock = std::chrono::steady_clock;
+
+struct DBLIB_API TraceEvent
+{
+	TraceOperation operation = TraceOperation::Execute;
+	std::string_view sql;           // as passed by user. Empty for commit and rollback
+	bool native_parameters_syntax = false; // sql uses native syntax of parameters of driver
+	Statement *statement = nullptr; // statement of prepare, execute and fetch
+	size_t rows_count = 0;          // fetched (0 or 1) or changed rows if driver knows it cheaply
+	size_t bytes_count = 0;         // size of parameters for execute, size of values of row for fetch. 0 if unknown
+	size_t round_trips = 0;         // requests to server made by operation
+	bool failed = false;            // operation is finished by exception
+	ErrorType error_type = ErrorType::Normal; // kind of error if failed
+	TraceClock::time_point begin_time;
+	TraceClock::time_point end_time;
+	void *user_data = nullptr;      // set by Tracer::begin, is passed into Tracer::end
+};
+
+
+/* class Tracer
+
+   Is set by Connection::set_tracer and used by transactions and statements
+   created by the connection. begin and end are called for the same event
+   object. Methods must not throw. If tracer is not set library only checks
+   pointer for nullptr */
+
+class DBLIB_API Tracer
+{
+public:
+	virtual ~Tracer();
+
+	virtual void begin(TraceEvent &event) = 0;
+	virtual void end(TraceEvent &event) = 0;
+};
+
+
+/* class TracerList
+
+   Passes events into several tracers (for example MetricsRegistry,
+   SlowQueryLog and SpanTracer) in order of list. Every tracer gets its
+   own user_data. List is not changed after construction */
+
+class DBLIB_API TracerList : public Tracer
+{
+public:
+	TracerList(std::vector<TracerPtr> tracers);
+
+	void begin(TraceEvent &event) override;
+	void end(TraceEvent &event) override;
+
+	const std::vector<TracerPtr>& get_tracers() const { return tracers_; }
+
+private:
+	std::vector<TracerPtr> tracers_;
+};
+
+
+/* class SpanTracer
+
+   Adapter which converts events into spans in OpenTelemetry style
+   (names "db.prepare", "db.execute" ... and attributes "db.system",
+   "db.statement", "db.rows", "db.bytes"). Callback is called at the
+   end of operation */
+
+struct DBLIB_API TraceSpan
+{
+	std::string name;
+	std::vector<std::pair<std::string, std::string>> attributes;
+	bool error = false;
+	TraceClock::time_point start_time;
+	TraceClock::time_point end_time;
+};
+
+using TraceSpanFun = std::function<void(const TraceSpan &span)>;
+
+struct DBLIB_API SpanTracerParams
+{
+	bool fetch_spans = false; // span for every fetched row
+	size_t max_statement_len = 1024;
+};
+
+class DBLIB_API SpanTracer : public Tracer
+{
+public:
+	SpanTracer(std::string_view db_system, TraceSpanFun span_fun, const SpanTracerParams &params = {});
+
+	void begin(TraceEvent &event) override;
+	void end(TraceEvent &event) override;
+
+private:
+	std::string db_system_;
+	TraceSpanFun span_fun_;
+	SpanTracerParams params_;
+};
+
+} // namespace dblib
@@ -0,0 +1,99 @@
+/*
+
+Copyright (c) 2015-2022 Artyomov Denis (denis.artyomov@gmail.com)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "dblib_conf.hpp"
+#include "dblib.hpp"
+#include "dblib_result_set.hpp"
+
+namespace dblib {
+
+struct DBLIB_API UpsertParams
+{
+	// PostgreSQL: batch with this or more rows is written by COPY into
+	// temporary table and merged into destination by one statement
+	size_t staging_min_rows = 500;
+};
+
+struct DBLIB_API UpsertCounts
+{
+	size_t inserted = 0;
+	size_t updated = 0;
+};
+
+class UpsertStrategy;
+
+
+/* class Upserter
+
+   Inserts rows or updates existing ones with the same key:
+
+     PostgreSQL: insert ... on conflict (keys) do update for every row, or
+                 COPY into temporary table and one insert ... select ...
+                 on conflict for big batches
+     SQLite,
+     Firebird:   update by key and insert if no row was updated
+
+   Names of columns of ResultSet are names of table columns. Key may be
+   repeated inside of batch, the last row with this key wins. Columns which
+   are not keys are updated.
+
+   Temporary table of PostgreSQL is created by first big batch and
+   disappears if transaction is rolled back, so Upserter must not be used
+   after rollback of its transaction */
+
+class DBLIB_API Upserter
+{
+public:
+	Upserter(
+		Transaction                    &tran,
+		std::string_view               table,
+		const std::vector<std::string> &key_columns,
+		const UpsertParams             &params = {}
+	);
+
+	~Upserter();
+
+	UpsertCounts write(const ResultSet &rows);
+
+private:
+	Transaction &tran_;
+	std::string table_;
+	std::vector<std::string> key_columns_;
+	UpsertParams params_;
+	bool is_postgresql_ = false;
+	std::vector<std::string> columns_;
+	std::unique_ptr<UpsertStrategy> row_strategy_;
+	std::unique_ptr<UpsertStrategy> staging_strategy_;
+
+	void init_for_columns(const ResultSet &rows);
+};
+
+} // namespace dblib
@@ -23,8 +23,16 @@ THE SOFTWARE.
 */
 
 #include <assert.h>
+#include <string.h>
+
+#include <algorithm>
+#include <typeinfo>
 
 #include "../include/dblib/dblib.hpp"
+#include "../include/dblib/dblib_schema.hpp"
+#include "../include/dblib/dblib_tracer.hpp"
+#include "../include/dblib/dblib_exception.hpp"
+#include "dblib_stmt_tools.hpp"
 #include "dblib_type_cvt.hpp"
 
 namespace dblib {
@@ -50,6 +58,175 @@ TransactionParams::TransactionParams(LockResolution lock_resolution, bool autost
 {}
 
 
+/* struct ConnectionStats */
+
+uint64_t ConnectionStats::get_native_calls(NativeCallType type) const
+{
+	return native_calls[(size_t)type];
+}
+
+uint64_t ConnectionStats::get_native_calls_total() const
+{
+	uint64_t result = 0;
+	for (auto value : native_calls) result += value;
+	return result;
+}
+
+
+/* class Status */
+
+Status::Status(
+	ErrorType        error_type,
+	int              code,
+	int              ext_code,
+	const char       *fun_name,
+	const char       *code_expl,
+	std::string_view sql_state,
+	std::string_view driver_message) :
+	type_(StatusType::Error),
+	error_type_(error_type),
+	code_(code),
+	ext_code_(ext_code),
+	fun_name_(fun_name),
+	code_expl_(code_expl),
+	driver_message_(driver_message)
+{
+	size_t len = std::min(sql_state.size(), sizeof(sql_state_) - 1);
+	memcpy(sql_state_, sql_state.data(), len);
+	sql_state_[len] = 0;
+}
+
+Status Status::make_no_data()
+{
+	Status result;
+	result.type_ = StatusType::NoData;
+	return result;
+}
+
+Status Status::make_from_exception(const ExceptionEx &exception)
+{
+	ErrorType error_type = ErrorType::Normal;
+	if (dynamic_cast<const LockException*>(&exception))
+		error_type = ErrorType::Lock;
+	else if (dynamic_cast<const TransactionException*>(&exception))
+		error_type = ErrorType::Transaction;
+	else if (dynamic_cast<const ConnectionLostException*>(&exception))
+		error_type = ErrorType::LostConnection;
+	else if (dynamic_cast<const ConnectException*>(&exception))
+		error_type = ErrorType::Connection;
+
+	// text of exception is already formatted so fun_name is not set
+	return Status(
+		error_type,
+		exception.get_code(),
+		exception.get_ext_code(),
+		nullptr,
+		nullptr,
+		{},
+		exception.what()
+	);
+}
+
+StatusType Status::get_type() const
+{
+	return type_;
+}
+
+bool Status::is_ok() const
+{
+	return type_ == StatusType::Ok;
+}
+
+bool Status::is_no_data() const
+{
+	return type_ == StatusType::NoData;
+}
+
+bool Status::is_error() const
+{
+	return type_ == StatusType::Error;
+}
+
+ErrorType Status::get_error_type() const
+{
+	return error_type_;
+}
+
+bool Status::is_lock_error() const
+{
+	return is_error() && (error_type_ == ErrorType::Lock);
+}
+
+int Status::get_code() const
+{
+	return code_;
+}
+
+int Status::get_ext_code() const
+{
+	return ext_code_;
+}
+
+std::string_view Status::get_sql_state() const
+{
+	return sql_state_;
+}
+
+const std::string& Status::get_driver_message() const
+{
+	return driver_message_;
+}
+
+std::string Status::get_message() const
+{
+	if (!is_error()) return {};
+	if (!fun_name_) return driver_message_;
+
+	return format_error_text(
+		fun_name_,
+		code_,
+		code_expl_ ? code_expl_ : "",
+		sql_state_,
+		driver_message_,
+		{}
+	);
+}
+
+void Status::throw_if_error() const
+{
+	if (is_error())
+		throw_exception_of_type(error_type_, get_message(), code_, ext_code_);
+}
+
+// Only errors reported by database are converted into status.
+// Errors of call sequence, conversion errors etc. are thrown further
+static bool is_database_error(const ExceptionEx &exception)
+{
+	const auto &type = typeid(exception);
+	return
+		(type == typeid(ExceptionEx)) ||
+		(type == typeid(TransactionException)) ||
+		(type == typeid(LockException)) ||
+		(type == typeid(ConnectException)) ||
+		(type == typeid(ConnectionLostException));
+}
+
+template <typename Fun>
+static Status call_and_get_status(const Fun &fun)
+{
+	try
+	{
+		fun();
+	}
+	catch (const ExceptionEx &exception)
+	{
+		if (!is_database_error(exception)) throw;
+		return Status::make_from_exception(exception);
+	}
+	return {};
+}
+
+
 /* class Connection */
 
 Connection::~Connection()
@@ -65,6 +242,65 @@ int Connection::get_default_transaction_lock_timeout() const
 	return default_transaction_lock_timeout_;
 }
 
+const SchemaCatalog& Connection::get_schema_catalog()
+{
+	if (!schema_catalog_)
+	{
+		auto catalog = std::make_shared<SchemaCatalog>();
+		auto tran = create_transaction(TransactionParams(TransactionAccess::Read));
+		catalog->load(*tran);
+		tran->commit();
+		schema_catalog_ = catalog;
+	}
+
+	return *schema_catalog_;
+}
+
+const SchemaCatalog& Connection::get_schema_catalog(const FileName &cache_file, std::string_view version)
+{
+	if (!schema_catalog_)
+	{
+		auto catalog = std::make_shared<SchemaCatalog>();
+		if (catalog->load_from_file(cache_file, version, get_driver_name()))
+			schema_catalog_ = catalog;
+		else
+			get_schema_catalog().save_to_file(cache_file, version);
+	}
+
+	return *schema_catalog_;
+}
+
+void Connection::reset_schema_catalog()
+{
+	schema_catalog_.reset();
+}
+
+ConnectionStats Connection::get_connection_stats() const
+{
+	return {};
+}
+
+void Connection::reset_connection_stats()
+{}
+
+void Connection::set_statements_pool_size(size_t /*max_size*/)
+{}
+
+StatementsPoolStats Connection::get_statements_pool_stats() const
+{
+	return {};
+}
+
+void Connection::set_tracer(const TracerPtr &tracer)
+{
+	tracer_ = tracer;
+}
+
+const TracerPtr& Connection::get_tracer() const
+{
+	return tracer_;
+}
+
 
 /* class Transaction */
 
@@ -81,15 +317,36 @@ void Transaction::start()
 void Transaction::commit()
 {
 	check_started();
+	TraceScope trace(get_connection()->get_tracer().get(), TraceOperation::Commit, {});
 	internal_commit();
 	state_ = TransactionState::Commited;
 }
 
+Status Transaction::try_commit()
+{
+	check_started();
+	TraceScope trace(get_connection()->get_tracer().get(), TraceOperation::Commit, {});
+	Status status = internal_try_commit();
+	if (status.is_error())
+		trace.set_error(status.get_error_type());
+	else
+		state_ = TransactionState::Commited;
+	return status;
+}
+
+Status Transaction::internal_try_commit()
+{
+	return call_and_get_status([this] { internal_commit(); });
+}
+
 void Transaction::commit_and_start()
 {
 	check_started();
-	internal_commit();
-	state_ = TransactionState::Commited;
+	{
+		TraceScope trace(get_connection()->get_tracer().get(), TraceOperation::Commit, {});
+		internal_commit();
+		state_ = TransactionState::Commited;
+	}
 	internal_start();
 	state_ = TransactionState::Started;
 }
@@ -97,6 +354,7 @@ void Transaction::commit_and_start()
 void Transaction::rollback()
 {
 	check_started();
+	TraceScope trace(get_connection()->get_tracer().get(), TraceOperation::Rollback, {});
 	internal_rollback();
 	state_ = TransactionState::Rollbacked;
 }
@@ -104,8 +362,11 @@ void Transaction::rollback()
 void Transaction::rollback_and_start()
 {
 	check_started();
-	internal_rollback();
-	state_ = TransactionState::Rollbacked;
+	{
+		TraceScope trace(get_connection()->get_tracer().get(), TraceOperation::Rollback, {});
+		internal_rollback();
+		state_ = TransactionState::Rollbacked;
+	}
 	internal_start();
 	state_ = TransactionState::Started;
 }
@@ -265,6 +526,20 @@ Statement::~Statement()
 {}
 
 
+Status Statement::try_execute()
+{
+	return call_and_get_status([this] { execute(); });
+}
+
+Status Statement::try_fetch()
+{
+	bool fetched = false;
+	Status status = call_and_get_status([this, &fetched] { fetched = fetch(); });
+	if (status.is_ok() && !fetched) return Status::make_no_data();
+	return status;
+}
+
+
 void Statement::set_int32(const IndexOrName& param, int32_t value)
 {
 	set_int32_opt(param, value);
@@ -400,6 +675,27 @@ void Statement::set(const IndexOrName& param, const TimeStamp& ts)
 	set_timestamp_opt(param, ts);
 }
 
+void Statement::set_params(const ParamValues& values)
+{
+	for (size_t i = 0; i < values.size(); i++)
+	{
+		size_t index = i + 1;
+		std::visit([this, index](const auto& value)
+		{
+			using T = std::decay_t<decltype(value)>;
+			if constexpr (std::is_same_v<T, std::monostate>)
+				set_null(index);
+			else
+				set(index, value);
+		}, values[i]);
+	}
+}
+
+ParamValues Statement::get_param_values()
+{
+	throw FunctionalityNotSupported();
+}
+
 
 int32_t Statement::get_int32(const IndexOrName& column)
 {
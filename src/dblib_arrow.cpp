@@ -0,0 +1,749 @@
+/*
+
+Copyright (c) 2015-2022 Artyomov Denis (denis.artyomov@gmail.com)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+#include <string.h>
+#include <assert.h>
+
+#include <algorithm>
+#include <limits>
+
+#include "../include/dblib/dblib_arrow.hpp"
+#include "../include/dblib/dblib_exception.hpp"
+#include "../include/dblib/dblib_cvt_utils.hpp"
+
+namespace dblib {
+
+namespace {
+
+/* Minimal flatbuffers builder. Objects are placed from the beginning of
+   buffer to the end. Referenced object is always placed after the reference
+   (flatbuffers offsets are unsigned) */
+
+struct FbField
+{
+	uint16_t id;
+	uint8_t size;
+	uint64_t value;
+	bool is_offset;
+};
+
+FbField fb_scalar(uint16_t id, uint8_t size, uint64_t value)
+{
+	return { id, size, value, false };
+}
+
+FbField fb_offset(uint16_t id)
+{
+	return { id, 4, 0, true };
+}
+
+size_t align_up(size_t value, size_t alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+class FbBuilder
+{
+public:
+	FbBuilder(std::vector<char> &data) :
+		data_(data)
+	{
+		data_.clear();
+	}
+
+	size_t add_offset_slot()
+	{
+		align(4);
+		size_t result = data_.size();
+		put(0, 4);
+		return result;
+	}
+
+	// positions of offset fields are placed into offset_slots in order of fields
+	size_t add_table(std::initializer_list<FbField> fields, size_t *offset_slots = nullptr)
+	{
+		uint16_t slots_count = 0;
+		for (auto &field : fields)
+			slots_count = std::max<uint16_t>(slots_count, field.id + 1);
+
+		// fields are placed from largest to smallest
+		const FbField* sorted[16] = {};
+		assert(fields.size() <= 16);
+		std::transform(fields.begin(), fields.end(), sorted, [](auto &field) { return &field; });
+		std::stable_sort(sorted, sorted + fields.size(), [](auto f1, auto f2) { return f1->size > f2->size; });
+
+		uint16_t field_offsets[16] = {};
+		size_t table_size = 4;
+		size_t table_align = 4;
+		for (size_t i = 0; i < fields.size(); i++)
+		{
+			auto field = sorted[i];
+			table_size = align_up(table_size, field->size);
+			field_offsets[field->id] = (uint16_t)table_size;
+			table_size += field->size;
+			table_align = std::max<size_t>(table_align, field->size);
+		}
+
+		// vtable
+		align(2);
+		size_t vtable_pos = data_.size();
+		put(4 + 2 * slots_count, 2);
+		put(table_size, 2);
+		for (uint16_t i = 0; i < slots_count; i++)
+			put(field_offsets[i], 2);
+
+		// table
+		align(table_align);
+		size_t table_pos = data_.size();
+		put(table_pos - vtable_pos, 4);
+		for (size_t i = 0; i < fields.size(); i++)
+		{
+			auto field = sorted[i];
+			data_.resize(table_pos + field_offsets[field->id], 0);
+			put(field->value, field->size);
+		}
+
+		for (auto &field : fields)
+			if (field.is_offset) *offset_slots++ = table_pos + field_offsets[field.id];
+
+		return table_pos;
+	}
+
+	size_t add_string(std::string_view text)
+	{
+		align(4);
+		size_t result = data_.size();
+		put(text.size(), 4);
+		data_.insert(data_.end(), text.begin(), text.end());
+		data_.push_back(0);
+		return result;
+	}
+
+	// offset of element N is at result + 4 + 4 * N
+	size_t add_offsets_vector(size_t count)
+	{
+		align(4);
+		size_t result = data_.size();
+		put(count, 4);
+		data_.resize(data_.size() + 4 * count, 0);
+		return result;
+	}
+
+	// vector of structs { int64_t; int64_t; }
+	size_t add_int64_pairs_vector(const std::vector<std::pair<int64_t, int64_t>> &items)
+	{
+		align(8, 4);
+		size_t result = data_.size();
+		put(items.size(), 4);
+		for (auto &item : items)
+		{
+			put(item.first, 8);
+			put(item.second, 8);
+		}
+		return result;
+	}
+
+	void set_offset(size_t slot, size_t target)
+	{
+		assert(target > slot);
+		uint32_t value = (uint32_t)(target - slot);
+		for (size_t i = 0; i < 4; i++)
+			data_[slot + i] = (char)(value >> (8 * i));
+	}
+
+private:
+	std::vector<char> &data_;
+
+	void align(size_t alignment, size_t extra = 0)
+	{
+		while ((data_.size() + extra) % alignment != 0)
+			data_.push_back(0);
+	}
+
+	void put(uint64_t value, size_t size)
+	{
+		for (size_t i = 0; i < size; i++)
+			data_.push_back((char)(value >> (8 * i)));
+	}
+};
+
+// Arrow format constants
+const uint64_t MetadataVersionV5 = 4;
+const uint64_t MessageHeaderSchema = 1;
+const uint64_t MessageHeaderRecordBatch = 3;
+
+const uint64_t TypeInt = 2;
+const uint64_t TypeFloatingPoint = 3;
+const uint64_t TypeBinary = 4;
+const uint64_t TypeUtf8 = 5;
+const uint64_t TypeBool = 6;
+const uint64_t TypeDate = 8;
+const uint64_t TypeTime = 9;
+const uint64_t TypeTimestamp = 10;
+
+const uint64_t PrecisionSingle = 1;
+const uint64_t PrecisionDouble = 2;
+const uint64_t DateUnitDay = 0;
+const uint64_t TimeUnitMicrosecond = 2;
+
+const int32_t UnixEpochJulianDay = 2440588;
+const int64_t USecsInDay = 24LL * 60LL * 60LL * 1000LL * 1000LL;
+
+ValueType get_schema_type(ValueType type)
+{
+	switch (type)
+	{
+	case ValueType::Null:
+	case ValueType::Char:
+		return ValueType::Varchar;
+
+	case ValueType::Short:
+	case ValueType::Integer:
+	case ValueType::BigInt:
+	case ValueType::Float:
+	case ValueType::Double:
+	case ValueType::Boolean:
+	case ValueType::Varchar:
+	case ValueType::Blob:
+	case ValueType::Date:
+	case ValueType::Time:
+	case ValueType::Timestamp:
+		return type;
+
+	default:
+		break;
+	}
+
+	throw WrongTypeConvException(field_type_to_string(type), "arrow type");
+}
+
+uint64_t get_arrow_type(ValueType type)
+{
+	switch (type)
+	{
+	case ValueType::Short:
+	case ValueType::Integer:
+	case ValueType::BigInt:
+		return TypeInt;
+
+	case ValueType::Float:
+	case ValueType::Double:
+		return TypeFloatingPoint;
+
+	case ValueType::Boolean:
+		return TypeBool;
+
+	case ValueType::Varchar:
+		return TypeUtf8;
+
+	case ValueType::Blob:
+		return TypeBinary;
+
+	case ValueType::Date:
+		return TypeDate;
+
+	case ValueType::Time:
+		return TypeTime;
+
+	case ValueType::Timestamp:
+		return TypeTimestamp;
+
+	default:
+		break;
+	}
+
+	throw WrongTypeConvException(field_type_to_string(type), "arrow type");
+}
+
+size_t add_type_table(FbBuilder &builder, ValueType type)
+{
+	switch (type)
+	{
+	case ValueType::Short:
+		return builder.add_table({ fb_scalar(0, 4, 16), fb_scalar(1, 1, 1) });
+
+	case ValueType::Integer:
+		return builder.add_table({ fb_scalar(0, 4, 32), fb_scalar(1, 1, 1) });
+
+	case ValueType::BigInt:
+		return builder.add_table({ fb_scalar(0, 4, 64), fb_scalar(1, 1, 1) });
+
+	case ValueType::Float:
+		return builder.add_table({ fb_scalar(0, 2, PrecisionSingle) });
+
+	case ValueType::Double:
+		return builder.add_table({ fb_scalar(0, 2, PrecisionDouble) });
+
+	case ValueType::Date:
+		return builder.add_table({ fb_scalar(0, 2, DateUnitDay) });
+
+	case ValueType::Time:
+		return builder.add_table({ fb_scalar(0, 2, TimeUnitMicrosecond), fb_scalar(1, 4, 64) });
+
+	case ValueType::Timestamp:
+		return builder.add_table({ fb_scalar(0, 2, TimeUnitMicrosecond) });
+
+	default: // Bool, Utf8 and Binary tables are empty
+		return builder.add_table({});
+	}
+}
+
+size_t build_message_header(FbBuilder &builder, uint64_t header_type, size_t body_size)
+{
+	size_t root_slot = builder.add_offset_slot();
+	size_t header_slot = 0;
+
+	size_t message = builder.add_table({
+			fb_scalar(0, 2, MetadataVersionV5),
+			fb_scalar(1, 1, header_type),
+			fb_offset(2),
+			fb_scalar(3, 8, body_size)
+		},
+		&header_slot
+	);
+
+	builder.set_offset(root_slot, message);
+
+	return header_slot;
+}
+
+int64_t time_to_usecs(const Time &time)
+{
+	return
+		(((int64_t)time.hour * 60 + time.min) * 60 + time.sec) * 1000000LL +
+		(int64_t)time.msec * 1000 +
+		time.usec;
+}
+
+int64_t date_to_unix_days(const Date &date)
+{
+	return date_to_julianday_integer(date) - UnixEpochJulianDay;
+}
+
+bool is_null_row(const std::vector<uint64_t> &null_bitmap, size_t row)
+{
+	return (null_bitmap[row / 64] >> (row % 64)) & 1;
+}
+
+class BodyBuilder
+{
+public:
+	BodyBuilder(std::vector<char> &body) :
+		body_(body)
+	{
+		body_.clear();
+	}
+
+	std::vector<std::pair<int64_t, int64_t>> nodes;
+	std::vector<std::pair<int64_t, int64_t>> buffers;
+
+	// all buffers are aligned to 8 bytes
+	char* add_buffer(size_t size)
+	{
+		size_t offset = body_.size();
+		body_.resize(offset + align_up(size, 8), 0);
+		buffers.emplace_back(offset, size);
+		return body_.data() + offset;
+	}
+
+	template <typename T>
+	T* add_typed_buffer(size_t count)
+	{
+		return reinterpret_cast<T*>(add_buffer(count * sizeof(T)));
+	}
+
+	void add_column(const ResultColumn &column, ValueType schema_type);
+
+private:
+	std::vector<char> &body_;
+
+	void add_validity(const ResultColumn &column);
+
+	template <typename T>
+	void add_values(const ResultColumn &column);
+
+	void add_bools(const ResultColumn &column);
+	void add_dates(const ResultColumn &column);
+	void add_times(const ResultColumn &column);
+	void add_timestamps(const ResultColumn &column);
+	void add_strings(const ResultColumn &column);
+};
+
+void BodyBuilder::add_validity(const ResultColumn &column)
+{
+	size_t rows_count = column.get_rows_count();
+	auto &null_bitmap = column.get_null_bitmap();
+
+	size_t null_count = 0;
+	for (uint64_t word : null_bitmap)
+		for (; word != 0; word &= word - 1) null_count++;
+
+	nodes.emplace_back(rows_count, null_count);
+
+	if (null_count == 0)
+	{
+		add_buffer(0);
+		return;
+	}
+
+	// bit is set for not null value in arrow
+	size_t size = (rows_count + 7) / 8;
+	char *dst = add_buffer(size);
+	for (size_t i = 0; i < size; i++)
+		dst[i] = (char)(~null_bitmap[i / 8] >> (8 * (i % 8)));
+
+	if (rows_count % 8 != 0)
+		dst[size - 1] &= (char)((1 << (rows_count % 8)) - 1);
+}
+
+template <typename T>
+void BodyBuilder::add_values(const ResultColumn &column)
+{
+	size_t rows_count = column.get_rows_count();
+	T *dst = add_typed_buffer<T>(rows_count);
+	if (column.get_type() == ValueType::Null) return;
+	auto &values = column.get_values<T>();
+	memcpy(dst, values.data(), rows_count * sizeof(T));
+}
+
+void BodyBuilder::add_bools(const ResultColumn &column)
+{
+	size_t rows_count = column.get_rows_count();
+	char *dst = add_buffer((rows_count + 7) / 8);
+	if (column.get_type() == ValueType::Null) return;
+	auto &values = column.get_values<int32_t>();
+	for (size_t i = 0; i < rows_count; i++)
+		if (values[i] != 0) dst[i / 8] |= (char)(1 << (i % 8));
+}
+
+void BodyBuilder::add_dates(const ResultColumn &column)
+{
+	size_t rows_count = column.get_rows_count();
+	int32_t *dst = add_typed_buffer<int32_t>(rows_count);
+	if (column.get_type() == ValueType::Null) return;
+	auto &values = column.get_values<Date>();
+	auto &null_bitmap = column.get_null_bitmap();
+	for (size_t i = 0; i < rows_count; i++)
+		if (!is_null_row(null_bitmap, i)) dst[i] = (int32_t)date_to_unix_days(values[i]);
+}
+
+void BodyBuilder::add_times(const ResultColumn &column)
+{
+	size_t rows_count = column.get_rows_count();
+	int64_t *dst = add_typed_buffer<int64_t>(rows_count);
+	if (column.get_type() == ValueType::Null) return;
+	auto &values = column.get_values<Time>();
+	for (size_t i = 0; i < rows_count; i++)
+		dst[i] = time_to_usecs(values[i]);
+}
+
+void BodyBuilder::add_timestamps(const ResultColumn &column)
+{
+	size_t rows_count = column.get_rows_count();
+	int64_t *dst = add_typed_buffer<int64_t>(rows_count);
+	if (column.get_type() == ValueType::Null) return;
+	auto &values = column.get_values<TimeStamp>();
+	auto &null_bitmap = column.get_null_bitmap();
+	for (size_t i = 0; i < rows_count; i++)
+	{
+		if (is_null_row(null_bitmap, i)) continue;
+		dst[i] = date_to_unix_days(values[i].date) * USecsInDay + time_to_usecs(values[i].time);
+	}
+}
+
+void BodyBuilder::add_strings(const ResultColumn &column)
+{
+	size_t rows_count = column.get_rows_count();
+	int32_t *offsets_dst = add_typed_buffer<int32_t>(rows_count + 1);
+
+	if (column.get_type() == ValueType::Null)
+	{
+		add_buffer(0);
+		return;
+	}
+
+	auto &arena = column.get_arena();
+	if (arena.size() > (size_t)std::numeric_limits<int32_t>::max())
+		throw WrongArgumentException("Data of column " + column.get_name() + " is too large for one record batch");
+
+	auto &offsets = column.get_offsets();
+	for (size_t i = 0; i <= rows_count; i++)
+		offsets_dst[i] = (int32_t)offsets[i];
+
+	char *data_dst = add_buffer(arena.size());
+	if (!arena.empty())
+		memcpy(data_dst, arena.data(), arena.size());
+}
+
+void BodyBuilder::add_column(const ResultColumn &column, ValueType schema_type)
+{
+	add_validity(column);
+
+	switch (schema_type)
+	{
+	case ValueType::Short:
+		add_values<int16_t>(column);
+		break;
+
+	case ValueType::Integer:
+		add_values<int32_t>(column);
+		break;
+
+	case ValueType::BigInt:
+		add_values<int64_t>(column);
+		break;
+
+	case ValueType::Float:
+		add_values<float>(column);
+		break;
+
+	case ValueType::Double:
+		add_values<double>(column);
+		break;
+
+	case ValueType::Boolean:
+		add_bools(column);
+		break;
+
+	case ValueType::Date:
+		add_dates(column);
+		break;
+
+	case ValueType::Time:
+		add_times(column);
+		break;
+
+	case ValueType::Timestamp:
+		add_timestamps(column);
+		break;
+
+	case ValueType::Varchar:
+	case ValueType::Blob:
+		add_strings(column);
+		break;
+
+	default:
+		assert(false);
+		break;
+	}
+}
+
+} // namespace
+
+
+/* class ArrowStreamWriter */
+
+ArrowStreamWriter::ArrowStreamWriter(const ArrowOutputFun &output, const ArrowWriterParams &params) :
+	output_(output),
+	params_(params)
+{}
+
+ArrowStreamWriter::ArrowStreamWriter(const FileName &file_name, const ArrowWriterParams &params) :
+	params_(params)
+{
+#if defined(DBLIB_WINDOWS)
+	file_ = _wfopen(file_name.c_str(), L"wb");
+#else
+	file_ = fopen(file_name.c_str(), "wb");
+#endif
+
+	if (!file_)
+		throw WrongArgumentException("Can't create file " + file_name_to_utf8(file_name));
+
+	output_ = [this](const char *data, size_t size)
+	{
+		if (fwrite(data, 1, size, file_) != size)
+			throw InternalException("Error during writing arrow file", 0, 0);
+	};
+}
+
+ArrowStreamWriter::~ArrowStreamWriter()
+{
+	if (file_) fclose(file_);
+}
+
+size_t ArrowStreamWriter::write(Statement &stmt)
+{
+	ResultSet result;
+	size_t rows_count = 0;
+
+	for (;;)
+	{
+		size_t batch_rows_count = stmt.fetch_columnar(result, params_.batch_size);
+		write_batch(result);
+		rows_count += batch_rows_count;
+
+		if ((params_.batch_size == 0) || (batch_rows_count < params_.batch_size))
+			break;
+
+		result.clear_rows();
+
+		// columns without type are written as strings
+		for (size_t i = 1; i <= result.get_columns_count(); i++)
+		{
+			auto &column = result.get_column(i);
+			if (column.get_type() == ValueType::Null)
+				column.set_type(ValueType::Varchar);
+		}
+	}
+
+	return rows_count;
+}
+
+void ArrowStreamWriter::write_batch(const ResultSet &result)
+{
+	if (finished_)
+		throw WrongSeqException("Arrow stream is already finished");
+
+	if (!schema_written_)
+		write_schema(result);
+	else
+		check_schema(result);
+
+	size_t rows_count = result.get_rows_count();
+	if (rows_count == 0) return;
+
+	BodyBuilder body_builder(body_);
+	for (size_t i = 0; i < schema_types_.size(); i++)
+		body_builder.add_column(result.get_column(i + 1), schema_types_[i]);
+
+	FbBuilder builder(metadata_);
+	size_t header_slot = build_message_header(builder, MessageHeaderRecordBatch, body_.size());
+
+	size_t slots[2] = {};
+	size_t record_batch = builder.add_table({
+			fb_scalar(0, 8, rows_count),
+			fb_offset(1),
+			fb_offset(2)
+		},
+		slots
+	);
+	builder.set_offset(header_slot, record_batch);
+	builder.set_offset(slots[0], builder.add_int64_pairs_vector(body_builder.nodes));
+	builder.set_offset(slots[1], builder.add_int64_pairs_vector(body_builder.buffers));
+
+	write_message();
+}
+
+void ArrowStreamWriter::write_schema(const ResultSet &result)
+{
+	size_t columns_count = result.get_columns_count();
+
+	schema_types_.clear();
+	for (size_t i = 1; i <= columns_count; i++)
+		schema_types_.push_back(get_schema_type(result.get_column(i).get_type()));
+
+	FbBuilder builder(metadata_);
+	size_t header_slot = build_message_header(builder, MessageHeaderSchema, 0);
+
+	size_t fields_slot = 0;
+	size_t schema = builder.add_table({ fb_offset(1) }, &fields_slot);
+	builder.set_offset(header_slot, schema);
+
+	size_t fields = builder.add_offsets_vector(columns_count);
+	builder.set_offset(fields_slot, fields);
+
+	for (size_t i = 0; i < columns_count; i++)
+	{
+		size_t slots[3] = {}; // name, type, children
+
+		size_t field = builder.add_table({
+				fb_offset(0),
+				fb_scalar(1, 1, 1), // nullable
+				fb_scalar(2, 1, get_arrow_type(schema_types_[i])),
+				fb_offset(3),
+				fb_offset(5)
+			},
+			slots
+		);
+
+		builder.set_offset(fields + 4 + 4 * i, field);
+		builder.set_offset(slots[0], builder.add_string(result.get_column(i + 1).get_name()));
+		builder.set_offset(slots[1], add_type_table(builder, schema_types_[i]));
+		builder.set_offset(slots[2], builder.add_offsets_vector(0));
+	}
+
+	body_.clear();
+	write_message();
+	schema_written_ = true;
+}
+
+void ArrowStreamWriter::check_schema(const ResultSet &result) const
+{
+	if (result.get_columns_count() != schema_types_.size())
+		throw WrongArgumentException("Columns count differs from count of columns in arrow schema");
+
+	for (size_t i = 0; i < schema_types_.size(); i++)
+	{
+		auto &column = result.get_column(i + 1);
+		auto type = column.get_type();
+		if (type == ValueType::Null) continue;
+
+		if (get_schema_type(type) != schema_types_[i])
+		{
+			throw WrongArgumentException(
+				"Type of column " + column.get_name() +
+				" (" + field_type_to_string(type) + ") differs from type in arrow schema"
+			);
+		}
+	}
+}
+
+// continuation marker, metadata size, metadata and body
+void ArrowStreamWriter::write_message()
+{
+	metadata_.resize(align_up(metadata_.size(), 8), 0);
+
+	char prefix[8] = {};
+	uint32_t continuation = 0xFFFFFFFF;
+	uint32_t metadata_size = (uint32_t)metadata_.size();
+	for (size_t i = 0; i < 4; i++)
+	{
+		prefix[i] = (char)(continuation >> (8 * i));
+		prefix[i + 4] = (char)(metadata_size >> (8 * i));
+	}
+
+	output_(prefix, sizeof(prefix));
+	output_(metadata_.data(), metadata_.size());
+	if (!body_.empty())
+		output_(body_.data(), body_.size());
+}
+
+void ArrowStreamWriter::finish()
+{
+	if (finished_)
+		throw WrongSeqException("Arrow stream is already finished");
+
+	if (!schema_written_)
+		write_schema(ResultSet());
+
+	const char end_of_stream[8] = { -1, -1, -1, -1, 0, 0, 0, 0 };
+	output_(end_of_stream, sizeof(end_of_stream));
+
+	if (file_) fflush(file_);
+
+	finished_ = true;
+}
+
+} // namespace dblib
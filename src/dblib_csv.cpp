@@ -0,0 +1,1108 @@
+/*
+
+Copyright (c) 2015-2022 Artyomov Denis (denis.artyomov@gmail.com)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+#include <string.h>
+
+#include <charconv>
+
+#include "../include/dblib/dblib_csv.hpp"
+#include "../include/dblib/dblib_exception.hpp"
+#include "../include/dblib/dblib_cvt_utils.hpp"
+#include "../include/dblib/dblib_postgresql.hpp"
+
+namespace dblib {
+
+namespace {
+
+const size_t ReaderBufferSize = 1024 * 1024;
+const size_t WriterBufferSize = 1024 * 1024;
+
+[[noreturn]] void throw_csv_cvt_error(std::string_view text, ValueType type, size_t record_number)
+{
+	throw WrongTypeConvException(
+		"Can't convert CSV value '" + std::string(text) +
+		"' into " + field_type_to_string(type) +
+		" (record " + std::to_string(record_number) + ")"
+	);
+}
+
+template <typename T>
+T parse_number(std::string_view text, ValueType type, size_t record_number)
+{
+	const char *begin = text.data();
+	const char *end = begin + text.size();
+	if ((begin != end) && (*begin == '+')) begin++;
+
+	T value {};
+	auto result = std::from_chars(begin, end, value);
+	if ((result.ec != std::errc()) || (result.ptr != end) || (begin == end))
+		throw_csv_cvt_error(text, type, record_number);
+
+	return value;
+}
+
+int32_t parse_bool(std::string_view text, size_t record_number)
+{
+	if ((text == "1") || (text == "t") || (text == "true") || (text == "TRUE") || (text == "True"))
+		return 1;
+
+	if ((text == "0") || (text == "f") || (text == "false") || (text == "FALSE") || (text == "False"))
+		return 0;
+
+	throw_csv_cvt_error(text, ValueType::Boolean, record_number);
+}
+
+int hex_digit_value(char chr)
+{
+	if ((chr >= '0') && (chr <= '9')) return chr - '0';
+	if ((chr >= 'a') && (chr <= 'f')) return chr - 'a' + 10;
+	if ((chr >= 'A') && (chr <= 'F')) return chr - 'A' + 10;
+	return -1;
+}
+
+// "\xHEX" -> bytes. Other text is copied as is
+void decode_blob(std::string_view text, std::vector<char> &blob, size_t record_number)
+{
+	blob.clear();
+
+	if ((text.size() < 2) || (text[0] != '\\') || (text[1] != 'x'))
+	{
+		blob.insert(blob.end(), text.begin(), text.end());
+		return;
+	}
+
+	if (text.size() % 2 != 0)
+		throw_csv_cvt_error(text, ValueType::Blob, record_number);
+
+	for (size_t i = 2; i < text.size(); i += 2)
+	{
+		int high = hex_digit_value(text[i]);
+		int low = hex_digit_value(text[i + 1]);
+		if ((high < 0) || (low < 0))
+			throw_csv_cvt_error(text, ValueType::Blob, record_number);
+		blob.push_back((char)((high << 4) | low));
+	}
+}
+
+bool read_digits(std::string_view text, size_t &pos, int &value)
+{
+	size_t begin = pos;
+	value = 0;
+	while ((pos < text.size()) && (text[pos] >= '0') && (text[pos] <= '9'))
+		value = value * 10 + (text[pos++] - '0');
+	return pos != begin;
+}
+
+bool read_char(std::string_view text, size_t &pos, char chr)
+{
+	if ((pos >= text.size()) || (text[pos] != chr)) return false;
+	pos++;
+	return true;
+}
+
+bool parse_date_part(std::string_view text, size_t &pos, Date &date)
+{
+	return
+		read_digits(text, pos, date.year) && read_char(text, pos, '-') &&
+		read_digits(text, pos, date.month) && read_char(text, pos, '-') &&
+		read_digits(text, pos, date.day);
+}
+
+bool parse_time_part(std::string_view text, size_t &pos, Time &time)
+{
+	bool ok =
+		read_digits(text, pos, time.hour) && read_char(text, pos, ':') &&
+		read_digits(text, pos, time.min) && read_char(text, pos, ':') &&
+		read_digits(text, pos, time.sec);
+
+	if (!ok) return false;
+
+	time.msec = 0;
+	time.usec = 0;
+
+	if (!read_char(text, pos, '.')) return true;
+
+	// fraction of second: first 3 digits are msec, next 3 digits are usec
+	int usecs = 0;
+	int digits = 0;
+	for (; (pos < text.size()) && (text[pos] >= '0') && (text[pos] <= '9'); pos++, digits++)
+		if (digits < 6) usecs = usecs * 10 + (text[pos] - '0');
+
+	if (digits == 0) return false;
+	for (; digits < 6; digits++) usecs *= 10;
+
+	time.msec = usecs / 1000;
+	time.usec = usecs % 1000;
+	return true;
+}
+
+char* format_uint(char *dst, int value, int width)
+{
+	for (int i = width - 1; i >= 0; i--)
+	{
+		dst[i] = (char)('0' + value % 10);
+		value /= 10;
+	}
+	return dst + width;
+}
+
+char* format_date(char *dst, const Date &date)
+{
+	if (date.year > 9999)
+		dst = std::to_chars(dst, dst + 10, date.year).ptr;
+	else
+		dst = format_uint(dst, date.year, 4);
+	*dst++ = '-';
+	dst = format_uint(dst, date.month, 2);
+	*dst++ = '-';
+	return format_uint(dst, date.day, 2);
+}
+
+char* format_time(char *dst, const Time &time)
+{
+	dst = format_uint(dst, time.hour, 2);
+	*dst++ = ':';
+	dst = format_uint(dst, time.min, 2);
+	*dst++ = ':';
+	dst = format_uint(dst, time.sec, 2);
+	if ((time.msec != 0) || (time.usec != 0))
+	{
+		*dst++ = '.';
+		dst = format_uint(dst, time.msec * 1000 + time.usec, 6);
+	}
+	return dst;
+}
+
+FILE* open_file(const FileName &file_name, bool for_write)
+{
+#if defined(DBLIB_WINDOWS)
+	FILE *result = _wfopen(file_name.c_str(), for_write ? L"wb" : L"rb");
+#else
+	FILE *result = fopen(file_name.c_str(), for_write ? "wb" : "rb");
+#endif
+
+	if (!result)
+		throw WrongArgumentException("Can't open file " + file_name_to_utf8(file_name));
+
+	return result;
+}
+
+} // namespace
+
+
+bool parse_csv_date(std::string_view text, Date &date)
+{
+	size_t pos = 0;
+	return parse_date_part(text, pos, date) && (pos == text.size());
+}
+
+bool parse_csv_time(std::string_view text, Time &time)
+{
+	size_t pos = 0;
+	return parse_time_part(text, pos, time) && (pos == text.size());
+}
+
+bool parse_csv_timestamp(std::string_view text, TimeStamp &ts)
+{
+	size_t pos = 0;
+	if (!parse_date_part(text, pos, ts.date)) return false;
+
+	ts.time = Time();
+	if (pos == text.size()) return true;
+
+	if ((text[pos] != ' ') && (text[pos] != 'T')) return false;
+	pos++;
+
+	return parse_time_part(text, pos, ts.time) && (pos == text.size());
+}
+
+
+/* struct CsvFormat */
+
+CsvFormat CsvFormat::tsv()
+{
+	CsvFormat result;
+	result.delimiter = '\t';
+	return result;
+}
+
+
+/* class CsvReader */
+
+CsvReader::CsvReader(const CsvInputFun &input, const CsvFormat &format) :
+	input_(input),
+	format_(format)
+{
+	init();
+}
+
+CsvReader::CsvReader(const FileName &file_name, const CsvFormat &format) :
+	format_(format)
+{
+	file_ = open_file(file_name, false);
+
+	input_ = [this](char *buffer, size_t size)
+	{
+		size_t result = fread(buffer, 1, size, file_);
+		if ((result == 0) && ferror(file_))
+			throw InternalException("Error during reading CSV file", 0, 0);
+		return result;
+	};
+
+	init();
+}
+
+CsvReader::~CsvReader()
+{
+	if (file_) fclose(file_);
+}
+
+void CsvReader::init()
+{
+	buffer_.resize(ReaderBufferSize);
+	is_special_[(unsigned char)format_.delimiter] = true;
+	is_special_[(unsigned char)'\r'] = true;
+	is_special_[(unsigned char)'\n'] = true;
+}
+
+bool CsvReader::read_more_data()
+{
+	if (eof_) return false;
+
+	if (buffer_begin_ != 0)
+	{
+		memmove(buffer_.data(), buffer_.data() + buffer_begin_, buffer_end_ - buffer_begin_);
+		buffer_end_ -= buffer_begin_;
+		buffer_begin_ = 0;
+	}
+
+	// record is larger than buffer
+	if (buffer_end_ == buffer_.size())
+		buffer_.resize(buffer_.size() * 2);
+
+	bool is_first_read = (buffer_end_ == 0) && (record_number_ == 0);
+
+	size_t size = input_(buffer_.data() + buffer_end_, buffer_.size() - buffer_end_);
+	if (size == 0)
+	{
+		eof_ = true;
+		return false;
+	}
+
+	buffer_end_ += size;
+
+	// skip UTF-8 BOM
+	if (is_first_read)
+	{
+		while (buffer_end_ < 3)
+		{
+			size = input_(buffer_.data() + buffer_end_, buffer_.size() - buffer_end_);
+			if (size == 0) break;
+			buffer_end_ += size;
+		}
+
+		if ((buffer_end_ >= 3) && (memcmp(buffer_.data(), "\xEF\xBB\xBF", 3) == 0))
+			buffer_begin_ = 3;
+	}
+
+	return true;
+}
+
+// returns false if more data is required to parse record
+bool CsvReader::parse_record(size_t &pos)
+{
+	fields_.clear();
+	storage_.clear();
+
+	const char *data = buffer_.data();
+	const size_t end = buffer_end_;
+	const char quote = format_.quote;
+
+	for (;;)
+	{
+		Field field = {};
+
+		if ((pos < end) && (data[pos] == quote))
+		{
+			size_t segment_begin = pos + 1;
+			size_t search_pos = segment_begin;
+			bool has_escapes = false;
+
+			for (;;)
+			{
+				auto quote_ptr = (const char*)memchr(data + search_pos, quote, end - search_pos);
+				if (!quote_ptr)
+				{
+					if (eof_)
+						throw WrongArgumentException("Quoted CSV field is not closed (record " + std::to_string(record_number_ + 1) + ")");
+					return false;
+				}
+
+				size_t quote_pos = quote_ptr - data;
+
+				// is quote escaped?
+				if ((quote_pos + 1 == end) && !eof_) return false;
+				if ((quote_pos + 1 < end) && (data[quote_pos + 1] == quote))
+				{
+					if (!has_escapes) field.begin = storage_.size();
+					has_escapes = true;
+					storage_.append(data + segment_begin, quote_pos + 1 - segment_begin);
+					segment_begin = search_pos = quote_pos + 2;
+					continue;
+				}
+
+				if (has_escapes)
+				{
+					storage_.append(data + segment_begin, quote_pos - segment_begin);
+					field.size = storage_.size() - field.begin;
+					field.in_storage = true;
+				}
+				else
+				{
+					field.begin = segment_begin;
+					field.size = quote_pos - segment_begin;
+				}
+
+				pos = quote_pos + 1;
+				break;
+			}
+
+			if ((pos < end) && !is_special_[(unsigned char)data[pos]])
+				throw WrongArgumentException("Wrong character after quoted CSV field (record " + std::to_string(record_number_ + 1) + ")");
+		}
+		else
+		{
+			size_t field_end = pos;
+			while ((field_end < end) && !is_special_[(unsigned char)data[field_end]])
+				field_end++;
+
+			if ((field_end == end) && !eof_) return false;
+
+			field.begin = pos;
+			field.size = field_end - pos;
+			field.is_null =
+				(field.size == format_.null_text.size()) &&
+				(memcmp(data + pos, format_.null_text.data(), field.size) == 0);
+
+			pos = field_end;
+		}
+
+		fields_.push_back(field);
+
+		if (pos == end) return true; // end of data
+
+		char chr = data[pos++];
+		if (chr == format_.delimiter) continue;
+
+		if (chr == '\r')
+		{
+			if (pos < end)
+			{
+				if (data[pos] == '\n') pos++;
+			}
+			else if (!eof_)
+				return false;
+		}
+
+		return true;
+	}
+}
+
+bool CsvReader::next_record()
+{
+	for (;;)
+	{
+		if ((buffer_begin_ == buffer_end_) && !read_more_data())
+		{
+			fields_.clear();
+			return false;
+		}
+
+		size_t pos = buffer_begin_;
+		if (parse_record(pos))
+		{
+			buffer_begin_ = pos;
+			record_number_++;
+			return true;
+		}
+
+		read_more_data();
+	}
+}
+
+void CsvReader::read_header()
+{
+	header_read_ = true;
+	if (!next_record()) return;
+
+	for (size_t i = 1; i <= fields_.size(); i++)
+		header_.emplace_back(get_field(i));
+}
+
+const std::vector<std::string>& CsvReader::get_header()
+{
+	if (format_.header && !header_read_)
+		read_header();
+
+	return header_;
+}
+
+bool CsvReader::read_record()
+{
+	if (format_.header && !header_read_)
+		read_header();
+
+	return next_record();
+}
+
+size_t CsvReader::get_fields_count() const
+{
+	return fields_.size();
+}
+
+void CsvReader::check_field_index(size_t index) const
+{
+	if ((index == 0) || (index > fields_.size()))
+		throw ColumnNotFoundException(std::to_string(index));
+}
+
+bool CsvReader::is_null(size_t index) const
+{
+	check_field_index(index);
+	return fields_[index - 1].is_null;
+}
+
+std::string_view CsvReader::get_field(size_t index) const
+{
+	check_field_index(index);
+	auto &field = fields_[index - 1];
+	const char *data = field.in_storage ? storage_.data() : buffer_.data();
+	return std::string_view(data + field.begin, field.size);
+}
+
+size_t CsvReader::get_record_number() const
+{
+	return record_number_;
+}
+
+void CsvReader::add_columns(ResultSet &result, const std::vector<ValueType> &types, size_t count)
+{
+	if (!types.empty() && (types.size() != count))
+		throw WrongArgumentException("Count of types differs from count of CSV fields");
+
+	for (size_t i = 0; i < count; i++)
+	{
+		result.add_column(
+			(i < header_.size()) ? header_[i] : "column" + std::to_string(i + 1),
+			types.empty() ? ValueType::Varchar : types[i]
+		);
+	}
+}
+
+size_t CsvReader::read_columnar(ResultSet &result, const std::vector<ValueType> &types, size_t max_rows)
+{
+	if (format_.header && !header_read_)
+		read_header();
+
+	if ((result.get_columns_count() == 0) && !header_.empty())
+		add_columns(result, types, header_.size());
+
+	size_t rows_count = 0;
+
+	while (((max_rows == 0) || (rows_count < max_rows)) && next_record())
+	{
+		if (result.get_columns_count() == 0)
+			add_columns(result, types, fields_.size());
+
+		if (fields_.size() != result.get_columns_count())
+			throw WrongArgumentException("Wrong count of CSV fields (record " + std::to_string(record_number_) + ")");
+
+		for (size_t i = 1; i <= fields_.size(); i++)
+		{
+			auto &column = result.get_column(i);
+
+			if (is_null(i))
+			{
+				column.append_null();
+				continue;
+			}
+
+			auto text = get_field(i);
+
+			switch (column.get_type())
+			{
+			case ValueType::Short:
+				column.append_int16(parse_number<int16_t>(text, ValueType::Short, record_number_));
+				break;
+
+			case ValueType::Integer:
+				column.append_int32(parse_number<int32_t>(text, ValueType::Integer, record_number_));
+				break;
+
+			case ValueType::Boolean:
+				column.append_int32(parse_bool(text, record_number_));
+				break;
+
+			case ValueType::BigInt:
+				column.append_int64(parse_number<int64_t>(text, ValueType::BigInt, record_number_));
+				break;
+
+			case ValueType::Float:
+				column.append_float(parse_number<float>(text, ValueType::Float, record_number_));
+				break;
+
+			case ValueType::Double:
+				column.append_double(parse_number<double>(text, ValueType::Double, record_number_));
+				break;
+
+			case ValueType::Blob:
+				decode_blob(text, blob_buffer_, record_number_);
+				column.append_blob(blob_buffer_.data(), blob_buffer_.size());
+				break;
+
+			case ValueType::Date:
+			{
+				Date date;
+				if (!parse_csv_date(text, date)) throw_csv_cvt_error(text, ValueType::Date, record_number_);
+				column.append_date(date);
+				break;
+			}
+
+			case ValueType::Time:
+			{
+				Time time;
+				if (!parse_csv_time(text, time)) throw_csv_cvt_error(text, ValueType::Time, record_number_);
+				column.append_time(time);
+				break;
+			}
+
+			case ValueType::Timestamp:
+			{
+				TimeStamp ts;
+				if (!parse_csv_timestamp(text, ts)) throw_csv_cvt_error(text, ValueType::Timestamp, record_number_);
+				column.append_timestamp(ts);
+				break;
+			}
+
+			case ValueType::Null:
+				column.set_type(ValueType::Varchar);
+				column.append_str(text);
+				break;
+
+			default:
+				column.append_str(text);
+				break;
+			}
+		}
+
+		rows_count++;
+	}
+
+	return rows_count;
+}
+
+
+/* class CsvWriter */
+
+CsvWriter::CsvWriter(const CsvOutputFun &output, const CsvFormat &format) :
+	output_(output),
+	format_(format)
+{
+	init();
+}
+
+CsvWriter::CsvWriter(const FileName &file_name, const CsvFormat &format) :
+	format_(format)
+{
+	file_ = open_file(file_name, true);
+
+	output_ = [this](const char *data, size_t size)
+	{
+		if (fwrite(data, 1, size, file_) != size)
+			throw InternalException("Error during writing CSV file", 0, 0);
+	};
+
+	init();
+}
+
+CsvWriter::~CsvWriter()
+{
+	if (file_)
+	{
+		if (!buffer_.empty())
+			fwrite(buffer_.data(), 1, buffer_.size(), file_);
+		fclose(file_);
+	}
+}
+
+void CsvWriter::init()
+{
+	buffer_.reserve(WriterBufferSize + 1024);
+	is_special_[(unsigned char)format_.delimiter] = true;
+	is_special_[(unsigned char)format_.quote] = true;
+	is_special_[(unsigned char)'\r'] = true;
+	is_special_[(unsigned char)'\n'] = true;
+}
+
+void CsvWriter::begin_field()
+{
+	if (!is_first_field_) buffer_.push_back(format_.delimiter);
+	is_first_field_ = false;
+}
+
+void CsvWriter::write_null()
+{
+	begin_field();
+	buffer_.append(format_.null_text);
+}
+
+void CsvWriter::write_int64(int64_t value)
+{
+	begin_field();
+	char text[24];
+	auto result = std::to_chars(text, text + sizeof(text), value);
+	buffer_.append(text, result.ptr);
+}
+
+void CsvWriter::write_float(float value)
+{
+	begin_field();
+	char text[32];
+	auto result = std::to_chars(text, text + sizeof(text), value);
+	buffer_.append(text, result.ptr);
+}
+
+void CsvWriter::write_double(double value)
+{
+	begin_field();
+	char text[32];
+	auto result = std::to_chars(text, text + sizeof(text), value);
+	buffer_.append(text, result.ptr);
+}
+
+void CsvWriter::write_str(std::string_view text)
+{
+	begin_field();
+
+	// text equal to null text is quoted to be different from null
+	bool need_quotes = (text == format_.null_text);
+	for (size_t i = 0; !need_quotes && (i < text.size()); i++)
+		need_quotes = is_special_[(unsigned char)text[i]];
+
+	if (!need_quotes)
+	{
+		buffer_.append(text);
+		return;
+	}
+
+	buffer_.push_back(format_.quote);
+	for (char chr : text)
+	{
+		if (chr == format_.quote) buffer_.push_back(chr);
+		buffer_.push_back(chr);
+	}
+	buffer_.push_back(format_.quote);
+}
+
+void CsvWriter::write_blob(const char *data, size_t size)
+{
+	static const char hex_digits[] = "0123456789abcdef";
+
+	begin_field();
+	buffer_.append("\\x");
+	for (size_t i = 0; i < size; i++)
+	{
+		buffer_.push_back(hex_digits[((unsigned char)data[i]) >> 4]);
+		buffer_.push_back(hex_digits[((unsigned char)data[i]) & 15]);
+	}
+}
+
+void CsvWriter::write_date(const Date &date)
+{
+	begin_field();
+	char text[32];
+	buffer_.append(text, format_date(text, date));
+}
+
+void CsvWriter::write_time(const Time &time)
+{
+	begin_field();
+	char text[32];
+	buffer_.append(text, format_time(text, time));
+}
+
+void CsvWriter::write_timestamp(const TimeStamp &ts)
+{
+	begin_field();
+	char text[64];
+	char *end = format_date(text, ts.date);
+	*end++ = ' ';
+	end = format_time(end, ts.time);
+	buffer_.append(text, end);
+}
+
+void CsvWriter::end_record()
+{
+	buffer_.append(format_.line_end);
+	is_first_field_ = true;
+
+	if (buffer_.size() >= WriterBufferSize)
+		flush();
+}
+
+void CsvWriter::flush()
+{
+	if (buffer_.empty()) return;
+	output_(buffer_.data(), buffer_.size());
+	buffer_.clear();
+	if (file_) fflush(file_);
+}
+
+void CsvWriter::write_header(const ResultSet &result)
+{
+	for (size_t i = 1; i <= result.get_columns_count(); i++)
+		write_str(result.get_column(i).get_name());
+	end_record();
+}
+
+void CsvWriter::write_value(const ResultColumn &column, size_t row)
+{
+	switch (column.get_type())
+	{
+	case ValueType::Short:
+		write_int64(column.get_values<int16_t>()[row]);
+		break;
+
+	case ValueType::Integer:
+	case ValueType::Boolean:
+		write_int64(column.get_values<int32_t>()[row]);
+		break;
+
+	case ValueType::BigInt:
+		write_int64(column.get_values<int64_t>()[row]);
+		break;
+
+	case ValueType::Float:
+		write_float(column.get_values<float>()[row]);
+		break;
+
+	case ValueType::Double:
+		write_double(column.get_values<double>()[row]);
+		break;
+
+	case ValueType::Char:
+	case ValueType::Varchar:
+		write_str(column.get_str(row));
+		break;
+
+	case ValueType::Blob:
+	{
+		auto blob = column.get_blob(row);
+		write_blob(blob.data(), blob.size());
+		break;
+	}
+
+	case ValueType::Date:
+		write_date(column.get_values<Date>()[row]);
+		break;
+
+	case ValueType::Time:
+		write_time(column.get_values<Time>()[row]);
+		break;
+
+	case ValueType::Timestamp:
+		write_timestamp(column.get_values<TimeStamp>()[row]);
+		break;
+
+	default:
+		write_null();
+		break;
+	}
+}
+
+void CsvWriter::write_rows(const ResultSet &result)
+{
+	size_t rows_count = result.get_rows_count();
+	size_t columns_count = result.get_columns_count();
+
+	for (size_t row = 0; row < rows_count; row++)
+	{
+		for (size_t col = 1; col <= columns_count; col++)
+		{
+			auto &column = result.get_column(col);
+			if (column.is_null(row))
+				write_null();
+			else
+				write_value(column, row);
+		}
+		end_record();
+	}
+}
+
+size_t CsvWriter::write(Statement &stmt, size_t batch_size)
+{
+	ResultSet result;
+	size_t rows_count = 0;
+	bool header_written = false;
+
+	for (;;)
+	{
+		size_t batch_rows_count = stmt.fetch_columnar(result, batch_size);
+
+		if (format_.header && !header_written)
+		{
+			write_header(result);
+			header_written = true;
+		}
+
+		write_rows(result);
+		rows_count += batch_rows_count;
+
+		if ((batch_size == 0) || (batch_rows_count < batch_size))
+			break;
+
+		result.clear_rows();
+	}
+
+	flush();
+
+	return rows_count;
+}
+
+
+/* import functions */
+
+size_t import_csv(CsvReader &reader, Statement &stmt, const std::vector<ValueType> &types)
+{
+	std::string text_buffer;
+	std::vector<char> blob_buffer;
+	size_t rows_count = 0;
+
+	while (reader.read_record())
+	{
+		size_t record_number = reader.get_record_number();
+		size_t fields_count = reader.get_fields_count();
+
+		if (!types.empty() && (types.size() != fields_count))
+			throw WrongArgumentException("Wrong count of CSV fields (record " + std::to_string(record_number) + ")");
+
+		for (size_t i = 1; i <= fields_count; i++)
+		{
+			if (reader.is_null(i))
+			{
+				stmt.set_null(i);
+				continue;
+			}
+
+			auto text = reader.get_field(i);
+			auto type = types.empty() ? ValueType::Varchar : types[i - 1];
+
+			switch (type)
+			{
+			case ValueType::Short:
+				stmt.set_int32(i, parse_number<int16_t>(text, type, record_number));
+				break;
+
+			case ValueType::Integer:
+				stmt.set_int32(i, parse_number<int32_t>(text, type, record_number));
+				break;
+
+			case ValueType::Boolean:
+				stmt.set_int32(i, parse_bool(text, record_number));
+				break;
+
+			case ValueType::BigInt:
+				stmt.set_int64(i, parse_number<int64_t>(text, type, record_number));
+				break;
+
+			case ValueType::Float:
+				stmt.set_float(i, parse_number<float>(text, type, record_number));
+				break;
+
+			case ValueType::Double:
+				stmt.set_double(i, parse_number<double>(text, type, record_number));
+				break;
+
+			case ValueType::Blob:
+				decode_blob(text, blob_buffer, record_number);
+				// data of empty vector may be nullptr which means null
+				stmt.set_blob(i, blob_buffer.empty() ? "" : blob_buffer.data(), blob_buffer.size());
+				break;
+
+			case ValueType::Date:
+			{
+				Date date;
+				if (!parse_csv_date(text, date)) throw_csv_cvt_error(text, type, record_number);
+				stmt.set_date(i, date);
+				break;
+			}
+
+			case ValueType::Time:
+			{
+				Time time;
+				if (!parse_csv_time(text, time)) throw_csv_cvt_error(text, type, record_number);
+				stmt.set_time(i, time);
+				break;
+			}
+
+			case ValueType::Timestamp:
+			{
+				TimeStamp ts;
+				if (!parse_csv_timestamp(text, ts)) throw_csv_cvt_error(text, type, record_number);
+				stmt.set_timestamp(i, ts);
+				break;
+			}
+
+			default:
+				text_buffer.assign(text);
+				stmt.set_u8str(i, text_buffer);
+				break;
+			}
+		}
+
+		stmt.execute();
+		rows_count++;
+	}
+
+	return rows_count;
+}
+
+size_t import_csv(
+	CsvReader                    &reader,
+	PgStatement                  &stmt,
+	std::string_view             copy_sql,
+	const std::vector<ValueType> &types,
+	size_t                       rows_per_copy)
+{
+	PgBuffer buffer;
+	std::vector<char> blob_buffer;
+	size_t rows_count = 0;
+	size_t rows_in_buffer = 0;
+
+	auto copy_buffer = [&]
+	{
+		if (rows_in_buffer == 0) return;
+		stmt.execute(copy_sql);
+		stmt.put_buffer(buffer);
+		buffer.clear();
+		rows_in_buffer = 0;
+	};
+
+	while (reader.read_record())
+	{
+		size_t record_number = reader.get_record_number();
+		size_t fields_count = reader.get_fields_count();
+
+		if (types.size() != fields_count)
+			throw WrongArgumentException("Wrong count of CSV fields (record " + std::to_string(record_number) + ")");
+
+		buffer.begin_tuple();
+
+		for (size_t i = 1; i <= fields_count; i++)
+		{
+			auto type = types[i - 1];
+
+			if (reader.is_null(i))
+			{
+				buffer.write_blob_opt(nullptr, 0);
+				continue;
+			}
+
+			auto text = reader.get_field(i);
+
+			switch (type)
+			{
+			case ValueType::Short:
+				buffer.write_int16_opt(parse_number<int16_t>(text, type, record_number));
+				break;
+
+			case ValueType::Integer:
+				buffer.write_int32_opt(parse_number<int32_t>(text, type, record_number));
+				break;
+
+			case ValueType::Boolean:
+				buffer.write_bool_opt(parse_bool(text, record_number) != 0);
+				break;
+
+			case ValueType::BigInt:
+				buffer.write_int64_opt(parse_number<int64_t>(text, type, record_number));
+				break;
+
+			case ValueType::Float:
+				buffer.write_float_opt(parse_number<float>(text, type, record_number));
+				break;
+
+			case ValueType::Double:
+				buffer.write_double_opt(parse_number<double>(text, type, record_number));
+				break;
+
+			case ValueType::Blob:
+				decode_blob(text, blob_buffer, record_number);
+				// data of empty vector may be nullptr which means null
+				buffer.write_blob_opt(blob_buffer.empty() ? "" : blob_buffer.data(), blob_buffer.size());
+				break;
+
+			case ValueType::Date:
+			{
+				Date date;
+				if (!parse_csv_date(text, date)) throw_csv_cvt_error(text, type, record_number);
+				buffer.write_date_opt(date);
+				break;
+			}
+
+			case ValueType::Time:
+			{
+				Time time;
+				if (!parse_csv_time(text, time)) throw_csv_cvt_error(text, type, record_number);
+				buffer.write_time_opt(time);
+				break;
+			}
+
+			case ValueType::Timestamp:
+			{
+				TimeStamp ts;
+				if (!parse_csv_timestamp(text, ts)) throw_csv_cvt_error(text, type, record_number);
+				buffer.write_timestamp_opt(ts);
+				break;
+			}
+
+			default:
+				buffer.write_blob_opt(text.data(), text.size());
+				break;
+			}
+		}
+
+		buffer.end_tuple();
+		rows_count++;
+
+		if (++rows_in_buffer >= rows_per_copy)
+			copy_buffer();
+	}
+
+	copy_buffer();
+
+	return rows_count;
+}
+
+} // namespace dblib
@@ -65,6 +65,18 @@ public:
 			throw SharedLibProcNotFoundError{ name };
 	}
 
+	// for functions which are absent in old versions of library
+	template <typename Fun>
+	bool try_load_func(Fun &fun, const char *name)
+	{
+#if defined (DBLIB_WINDOWS)
+		fun = (Fun)GetProcAddress(dll_, name);
+#elif defined (DBLIB_LINUX)
+		fun = (Fun)dlsym(dll_, name);
+#endif
+		return fun != nullptr;
+	}
+
 private:
 	DllType dll_ = nullptr;
 };
@@ -168,7 +168,7 @@ using FbLibDataPtr = std::shared_ptr<FbLibData>;
 
 /* class FbLibImpl */
 
-class FbLibImpl : public FbLib
+class FbLibImpl final : public FbLib
 {
 public:
 	FbLibImpl();
@@ -189,7 +189,7 @@ private:
 
 /* class FbServicesImpl */
 
-class FbServicesImpl : public FbServices
+class FbServicesImpl final : public FbServices
 {
 public:
 	FbServicesImpl(const FbLibDataPtr& lib);
@@ -218,7 +218,12 @@ private:
 
 /* class FbConnectionImpl */
 
-class FbConnectionImpl :
+class FbTransactionImpl;
+using FbTransactionImplPtr = std::shared_ptr<FbTransactionImpl>;
+
+class FbStatementImpl;
+
+class FbConnectionImpl final :
 	public FbConnection,
 	public std::enable_shared_from_this<FbConnectionImpl>
 {
@@ -244,6 +249,16 @@ public:
 
 	FbTransactionPtr create_fb_transaction(const TransactionParams& transaction_params) override;
 
+	ConnectionStats get_connection_stats() const override;
+	void reset_connection_stats() override;
+	void set_statements_pool_size(size_t max_size) override;
+	StatementsPoolStats get_statements_pool_stats() const override;
+
+	std::shared_ptr<FbStatementImpl> create_statement_impl(const FbTransactionImplPtr& tran);
+
+	void count_call(NativeCallType type, bool round_trip, size_t sent_bytes = 0);
+	ConnectionStats& get_stats_for_change();
+
 private:
 	FbLibDataPtr lib;
 	FbConnectParams connect_params_;
@@ -252,6 +267,10 @@ private:
 	short dialect_ = -1;
 	isc_db_handle db_handle_ = 0;
 	TransactionLevel default_transaction_level_ = DefaultTransactionLevel;
+	ConnectionStats stats_;
+	StatementsPool<FbStatementImpl> statements_pool_;
+
+	static void release_statement(FbStatementImpl* stmt);
 
 	void internal_disconnect(bool throw_exception);
 	void check_is_connected();
@@ -264,7 +283,7 @@ using FbConnectionImplPtr = std::shared_ptr<FbConnectionImpl>;
 
 /* class FbTransactionImpl */
 
-class FbTransactionImpl :
+class FbTransactionImpl final :
 	public FbTransaction,
 	public std::enable_shared_from_this<FbTransactionImpl>
 {
@@ -282,6 +301,7 @@ protected:
 	void internal_start() override;
 	void internal_commit() override;
 	void internal_rollback() override;
+	Status internal_try_commit() override;
 
 private:
 	FbLibDataPtr lib_;
@@ -293,8 +313,6 @@ private:
 	bool commit_on_destroy_ = true;
 };
 
-using FbTransactionImplPtr = std::shared_ptr<FbTransactionImpl>;
-
 
 /* class SqlDA */
 
@@ -306,7 +324,7 @@ public:
 	size_t get_size() const;
 
 	void alloc_fields();
-	void check_size(const FbApi& api, bool in, isc_stmt_handle stmt);
+	void check_size(const FbApi& api, bool in, isc_stmt_handle stmt, ConnectionStats& stats);
 	XSQLDA* data() { return data_; }
 
 	void close_blob_handles(const FbApi& api, bool throw_exception);
@@ -374,6 +392,7 @@ public:
 	OutSqlDA(int size) : SqlDA(size) {}
 
 	bool is_null(size_t index) const;
+	size_t get_row_size() const;
 	template <typename T>
 	T get_value(size_t index, int type);
 	std::string get_string(const FbApi& api, size_t index, FbConnectionImpl& conn, FbTransactionImpl& tran);
@@ -394,7 +413,7 @@ private:
 
 /* class FbStatementImpl */
 
-class FbStatementImpl :
+class FbStatementImpl final :
 	public FbStatement,
 	public IParameterSetterWithTypeCvt,
 	public IResultGetterWithTypeCvt
@@ -403,6 +422,10 @@ public:
 	FbStatementImpl(const FbLibDataPtr& lib, const FbConnectionImplPtr& conn, const FbTransactionImplPtr& tran);
 	~FbStatementImpl();
 
+	// statements pool
+	void attach(const FbConnectionImplPtr& conn, const FbTransactionImplPtr& tran);
+	FbConnectionImplPtr detach();
+
 	TransactionPtr get_transaction() override;
 
 	void prepare(std::string_view sql, bool use_native_parameters_syntax) override;
@@ -414,6 +437,7 @@ public:
 	StatementType get_type() override;
 
 	void execute() override;
+	Status try_execute() override;
 
 	size_t get_changes_count() override;
 
@@ -422,6 +446,7 @@ public:
 	std::string get_last_sql() const override;
 
 	bool fetch() override;
+	Status try_fetch() override;
 
 	size_t get_params_count() const override;
 	ValueType get_param_type(const IndexOrName& param) override;
@@ -459,6 +484,7 @@ public:
 	void get_blob_data(const IndexOrName& column, char* dst, size_t size) override;
 
 	isc_stmt_handle& get_handle() override;
+	std::string get_plan() override;
 
 	// IParameterSetterWithTypeCvt impl.
 	void set_int16_impl(size_t index, int16_t value) override;
@@ -505,7 +531,8 @@ private:
 	void check_has_data() const;
 	void close(bool throw_exception);
 	void close_cursor();
-	void internal_execute();
+	bool internal_execute(Status *status = nullptr);
+	bool fetch_impl(Status *status);
 
 	template<typename T>
 	void set_param_opt_impl(const IndexOrName& param, const std::optional<T>& value);
@@ -732,21 +759,19 @@ bool find_error_code(const ISC_STATUS* status_vect, ISC_STATUS error_code)
 	return false;
 }
 
-static void check_status_vector(
+// Throws exception if status is null or stores error in status and returns false
+static bool check_status_vector(
 	const FbApi       &api,
 	const char        *fun_name,
 	const ISC_STATUS  *status_vect,
-	std::string_view  sql)
+	std::string_view  sql,
+	Status            *status = nullptr)
 {
-	if (is_status_vector_ok(status_vect)) return;
+	if (is_status_vector_ok(status_vect)) return true;
 
 	// error code
 	ISC_LONG sql_code = api.f_isc_sqlcode(status_vect);
 
-	// error code explanation
-	char sql_msg[2048] = { 0 };
-	api.f_isc_sql_interprete((ISC_SHORT)sql_code, sql_msg, sizeof(sql_msg));
-
 	// error text
 	std::string whole_error_text;
 	const ISC_STATUS *status_vector_to_call = status_vect;
@@ -782,6 +807,25 @@ static void check_status_vector(
 		update_conflict ? ErrorType::Lock :
 		ErrorType::Normal;
 
+	// text of isc_sql_interprete is not static so it is not stored in status
+	if (status)
+	{
+		*status = Status(
+			error_type,
+			sql_code,
+			-1,
+			fun_name,
+			nullptr,
+			std::to_string(sql_code),
+			whole_error_text
+		);
+		return false;
+	}
+
+	// error code explanation
+	char sql_msg[2048] = { 0 };
+	api.f_isc_sql_interprete((ISC_SHORT)sql_code, sql_msg, sizeof(sql_msg));
+
 	// throw
 	throw_exception(
 		fun_name,
@@ -1080,6 +1124,7 @@ void FbConnectionImpl::connect()
 
 	assert(server_and_path.size() <= SHRT_MAX);
 
+	count_call(NativeCallType::Connect, true);
 	lib->api.f_isc_attach_database(
 		status_vect,
 		(short)server_and_path.size(),
@@ -1097,6 +1142,7 @@ void FbConnectionImpl::connect()
 		disconnect();
 
 		// connect to new created database
+		count_call(NativeCallType::Connect, true);
 		lib->api.f_isc_attach_database(
 			status_vect,
 			(short)server_and_path.size(),
@@ -1139,6 +1185,7 @@ void FbConnectionImpl::internal_disconnect(bool throw_exception)
 {
 	check_is_connected();
 	ISC_STATUS status_vect[StatusLen] = {};
+	count_call(NativeCallType::Connect, true);
 	lib->api.f_isc_detach_database(status_vect, &db_handle_);
 	if (throw_exception)
 		check_status_vector(lib->api, "isc_detach_database", status_vect, {});
@@ -1180,6 +1227,7 @@ void FbConnectionImpl::try_to_create_database()
 
 	check_not_greater(database_utf8.size(), SHRT_MAX, "Length of file is too long (>SHRT_MAX)");
 
+	count_call(NativeCallType::Connect, true);
 	lib->api.f_isc_create_database(
 		status_vect,
 		(short)database_utf8.size(),
@@ -1228,6 +1276,57 @@ short FbConnectionImpl::get_dialect() const
 	return dialect_;
 }
 
+ConnectionStats FbConnectionImpl::get_connection_stats() const
+{
+	return stats_;
+}
+
+void FbConnectionImpl::reset_connection_stats()
+{
+	stats_ = {};
+}
+
+void FbConnectionImpl::count_call(NativeCallType type, bool round_trip, size_t sent_bytes)
+{
+	count_native_call(stats_, type, round_trip, sent_bytes);
+}
+
+ConnectionStats& FbConnectionImpl::get_stats_for_change()
+{
+	return stats_;
+}
+
+void FbConnectionImpl::set_statements_pool_size(size_t max_size)
+{
+	statements_pool_.set_max_size(max_size);
+}
+
+StatementsPoolStats FbConnectionImpl::get_statements_pool_stats() const
+{
+	return statements_pool_.get_stats();
+}
+
+std::shared_ptr<FbStatementImpl> FbConnectionImpl::create_statement_impl(const FbTransactionImplPtr& tran)
+{
+	if (!statements_pool_.is_enabled())
+		return std::make_shared<FbStatementImpl>(lib, shared_from_this(), tran);
+
+	auto stmt = statements_pool_.acquire();
+	if (stmt)
+		stmt->attach(shared_from_this(), tran);
+	else
+		stmt = std::make_unique<FbStatementImpl>(lib, shared_from_this(), tran);
+
+	return statements_pool_.make_shared_ptr(std::move(stmt), &FbConnectionImpl::release_statement);
+}
+
+void FbConnectionImpl::release_statement(FbStatementImpl* stmt)
+{
+	std::unique_ptr<FbStatementImpl> holder(stmt);
+	if (auto conn = stmt->detach())
+		conn->statements_pool_.release(std::move(holder));
+}
+
 FbTransactionPtr FbConnectionImpl::create_fb_transaction(const TransactionParams& transaction_params)
 {
 	check_is_connected();
@@ -1344,12 +1443,13 @@ isc_tr_handle& FbTransactionImpl::get_handle()
 FbStatementPtr FbTransactionImpl::create_fb_statement()
 {
 	check_started();
-	return std::make_shared<FbStatementImpl>(lib_, conn_, shared_from_this());
+	return conn_->create_statement_impl(shared_from_this());
 }
 
 void FbTransactionImpl::internal_start()
 {
 	ISC_STATUS status_vect[StatusLen] = {};
+	conn_->count_call(NativeCallType::Transaction, true);
 	lib_->api.f_isc_start_transaction(
 		status_vect,
 		&tran_,
@@ -1364,15 +1464,29 @@ void FbTransactionImpl::internal_start()
 void FbTransactionImpl::internal_commit()
 {
 	ISC_STATUS status_vect[StatusLen] = {};
+	conn_->count_call(NativeCallType::Transaction, true);
 	lib_->api.f_isc_commit_transaction(status_vect, &tran_);
 	check_status_vector(lib_->api, "isc_commit_transaction", status_vect, {});
 	tran_ = 0;
 }
 
+Status FbTransactionImpl::internal_try_commit()
+{
+	// handle is kept if commit fails so transaction can be rolled back
+	Status status;
+	ISC_STATUS status_vect[StatusLen] = {};
+	conn_->count_call(NativeCallType::Transaction, true);
+	lib_->api.f_isc_commit_transaction(status_vect, &tran_);
+	if (check_status_vector(lib_->api, "isc_commit_transaction", status_vect, {}, &status))
+		tran_ = 0;
+	return status;
+}
+
 void FbTransactionImpl::internal_rollback()
 {
 	check_started();
 	ISC_STATUS status_vect[StatusLen] = {};
+	conn_->count_call(NativeCallType::Transaction, true);
 	lib_->api.f_isc_rollback_transaction(status_vect, &tran_);
 	check_status_vector(lib_->api, "isc_rollback_transaction", status_vect, {});
 	tran_ = 0;
@@ -1431,7 +1545,7 @@ size_t SqlDA::get_size() const
 }
 
 
-void SqlDA::check_size(const FbApi& api, bool in, isc_stmt_handle stmt)
+void SqlDA::check_size(const FbApi& api, bool in, isc_stmt_handle stmt, ConnectionStats& stats)
 {
 	if (data_->sqld > data_->sqln)
 	{
@@ -1441,11 +1555,13 @@ void SqlDA::check_size(const FbApi& api, bool in, isc_stmt_handle stmt)
 
 		if (in)
 		{
+			count_native_call(stats, NativeCallType::Prepare, true);
 			api.f_isc_dsql_describe_bind(status_vect, &stmt, DaVersion, data_);
 			check_status_vector(api, "isc_dsql_describe_bind", status_vect, {});
 		}
 		else
 		{
+			count_native_call(stats, NativeCallType::Prepare, false);
 			api.f_isc_dsql_describe(status_vect, &stmt, DaVersion, data_);
 			check_status_vector(api, "isc_dsql_describe", status_vect, {});
 		}
@@ -1624,6 +1740,7 @@ void InSqlDA::blob_param(
 	ISC_QUAD& blob_id = as<ISC_QUAD>(var);
 
 	ISC_STATUS status_vect[StatusLen] = {};
+	conn.count_call(NativeCallType::Blob, true);
 	api.f_isc_create_blob2(
 		status_vect,
 		&conn.get_handle(),
@@ -1639,12 +1756,14 @@ void InSqlDA::blob_param(
 	while (blob_size != 0)
 	{
 		uint16_t len = (blob_size > SHRT_MAX) ? SHRT_MAX : (short)blob_size;
+		conn.count_call(NativeCallType::Blob, false, len);
 		api.f_isc_put_segment(status_vect, &bl_handle, len, blob_data);
 		check_status_vector(api, "isc_put_segment", status_vect, {});
 		blob_data += len;
 		blob_size -= len;
 	}
 
+	conn.count_call(NativeCallType::Blob, true);
 	api.f_isc_close_blob(status_vect, &bl_handle);
 	check_status_vector(api, "isc_close_blob", status_vect, {});
 }
@@ -1655,6 +1774,21 @@ bool OutSqlDA::is_null(size_t index) const
 	return null(index) == -1;
 }
 
+size_t OutSqlDA::get_row_size() const
+{
+	size_t result = 0;
+	for (size_t i = 1; i <= get_size(); i++)
+	{
+		if (is_null(i)) continue;
+		const XSQLVAR* var = get_var(i);
+		if ((var->sqltype & ~1) == SQL_VARYING)
+			result += 2 + *(const unsigned short*)var->sqldata;
+		else
+			result += var->sqllen;
+	}
+	return result;
+}
+
 
 /* class OutSqlDA */
 
@@ -1745,6 +1879,7 @@ void OutSqlDA::prepare_blob_handle(
 	ISC_STATUS status_vect[StatusLen] = {};
 	ISC_QUAD& blob_id = as<ISC_QUAD>(var);
 
+	conn.count_call(NativeCallType::Blob, true);
 	api.f_isc_open_blob2(
 		status_vect,
 		&conn.get_handle(),
@@ -1774,6 +1909,7 @@ size_t OutSqlDA::get_blob_size(
 	ISC_STATUS status_vect[StatusLen] = {};
 
 	assert(res_buffer.size() <= SHRT_MAX);
+	conn.count_call(NativeCallType::Blob, true);
 	api.f_isc_blob_info(
 		status_vect,
 		&bl_handle,
@@ -1812,6 +1948,7 @@ void OutSqlDA::read_blob(
 		unsigned short bytes_read = 0;
 		unsigned short to_read = (size < SHRT_MAX) ? (unsigned short)size : SHRT_MAX;
 
+		conn.count_call(NativeCallType::Blob, true);
 		auto res = api.f_isc_get_segment(
 			status_vect,
 			&bl_handle,
@@ -1821,6 +1958,7 @@ void OutSqlDA::read_blob(
 		);
 
 		check_status_vector(api, "isc_get_segment", status_vect,{});
+		conn.get_stats_for_change().result_bytes += bytes_read;
 
 		std::copy(buffer.begin(), buffer.begin() + bytes_read, dst_from);
 
@@ -1860,6 +1998,28 @@ TransactionPtr FbStatementImpl::get_transaction()
 	return tran_;
 }
 
+void FbStatementImpl::attach(const FbConnectionImplPtr& conn, const FbTransactionImplPtr& tran)
+{
+	conn_ = conn;
+	tran_ = tran;
+}
+
+// Frees statement handle and resets state. SQLDA buffers are kept
+FbConnectionImplPtr FbStatementImpl::detach()
+{
+	close(false);
+	sql_preprocessor_.clear();
+	type_ = StatementType::Unknown;
+	cursor_opened_ = false;
+	last_sql_.clear();
+	preprocessed_sql_.clear();
+	sql_preprocessed_flag_ = false;
+	columns_helper_.clear();
+	has_data_ = false;
+	tran_.reset();
+	return std::move(conn_);
+}
+
 void FbStatementImpl::check_is_prepared() const
 {
 	if (stmt_ == 0)
@@ -1880,6 +2040,7 @@ void FbStatementImpl::close(bool throw_exception)
 	in_sqlda_.close_blob_handles(lib_->api, throw_exception);
 
 	ISC_STATUS status_vect[StatusLen] = {};
+	conn_->count_call(NativeCallType::Prepare, false);
 	lib_->api.f_isc_dsql_free_statement(status_vect, &stmt_, DSQL_drop);
 
 	if (throw_exception)
@@ -1902,6 +2063,7 @@ void FbStatementImpl::close_cursor()
 	has_data_ = false;
 
 	ISC_STATUS status_vect[StatusLen] = {};
+	conn_->count_call(NativeCallType::Execute, false);
 	lib_->api.f_isc_dsql_free_statement(status_vect, &stmt_, DSQL_close);
 	check_status_vector(lib_->api, "isc_dsql_free_statement", status_vect, {});
 }
@@ -1913,6 +2075,7 @@ void FbStatementImpl::prepare_impl(std::string_view sql)
 	has_data_ = false;
 
 	ISC_STATUS status_vect[StatusLen] = {};
+	conn_->count_call(NativeCallType::Prepare, false);
 	lib_->api.f_isc_dsql_allocate_statement(
 		status_vect,
 		&conn_->get_handle(),
@@ -1921,6 +2084,7 @@ void FbStatementImpl::prepare_impl(std::string_view sql)
 	check_status_vector(lib_->api, "isc_dsql_allocate_statement", status_vect, {});
 
 	assert(sql.size() <= USHRT_MAX);
+	conn_->count_call(NativeCallType::Prepare, true, sql.size());
 	lib_->api.f_isc_dsql_prepare(
 		status_vect,
 		&tran_->get_handle(),
@@ -1934,6 +2098,7 @@ void FbStatementImpl::prepare_impl(std::string_view sql)
 
 	type_ = get_type_internal();
 
+	conn_->count_call(NativeCallType::Prepare, true);
 	lib_->api.f_isc_dsql_describe_bind(
 		status_vect,
 		&stmt_,
@@ -1942,10 +2107,10 @@ void FbStatementImpl::prepare_impl(std::string_view sql)
 	);
 	check_status_vector(lib_->api, "isc_dsql_describe_bind", status_vect, {});
 
-	in_sqlda_.check_size(lib_->api, true, stmt_);
+	in_sqlda_.check_size(lib_->api, true, stmt_, conn_->get_stats_for_change());
 	in_sqlda_.alloc_fields();
 
-	out_sqlda_.check_size(lib_->api, false, stmt_);
+	out_sqlda_.check_size(lib_->api, false, stmt_, conn_->get_stats_for_change());
 	out_sqlda_.alloc_fields();
 }
 
@@ -1961,6 +2126,7 @@ StatementType FbStatementImpl::get_type_internal()
 
 	char type_item[] = { isc_info_sql_stmt_type };
 	char res_buffer[128] = {};
+	conn_->count_call(NativeCallType::Info, true);
 	lib_->api.f_isc_dsql_sql_info(
 		status_vect,
 		&stmt_,
@@ -1997,12 +2163,20 @@ void FbStatementImpl::execute()
 	internal_execute();
 }
 
+Status FbStatementImpl::try_execute()
+{
+	Status status;
+	internal_execute(&status);
+	return status;
+}
+
 size_t FbStatementImpl::get_changes_count()
 {
 	ISC_STATUS status_vect[StatusLen] = {};
 
 	char type_item[] = { isc_info_sql_records, isc_info_end };
 	char res_buffer[128] = {};
+	conn_->count_call(NativeCallType::Info, true);
 	lib_->api.f_isc_dsql_sql_info(
 		status_vect,
 		&stmt_,
@@ -2043,13 +2217,16 @@ std::string FbStatementImpl::get_last_sql() const
 	return last_sql_;
 }
 
-void FbStatementImpl::internal_execute()
+bool FbStatementImpl::internal_execute(Status *status)
 {
 	check_is_prepared();
 
+	TraceScope trace(conn_->get_tracer().get(), TraceOperation::Execute, last_sql_, this);
+
 	close_cursor();
 
 	ISC_STATUS status_vect[StatusLen] = {};
+	conn_->count_call(NativeCallType::Execute, true);
 	lib_->api.f_isc_dsql_execute2(
 		status_vect,
 		&tran_->get_handle(),
@@ -2059,16 +2236,21 @@ void FbStatementImpl::internal_execute()
 		nullptr
 	);
 
-	check_status_vector(lib_->api, "isc_dsql_execute2", status_vect, last_sql_);
+	bool ok = check_status_vector(lib_->api, "isc_dsql_execute2", status_vect, last_sql_, status);
 
-	if (type_ == StatementType::Select)
+	if (ok && (type_ == StatementType::Select))
 		cursor_opened_ = true;
 
 	in_sqlda_.close_blob_handles(lib_->api, true);
+
+	if (!ok) trace.set_error(status->get_error_type());
+	return ok;
 }
 
 void FbStatementImpl::prepare(std::string_view sql, bool use_native_parameters_syntax)
 {
+	TraceScope trace(conn_->get_tracer().get(), TraceOperation::Prepare, sql, this);
+
 	last_sql_ = sql;
 
 	sql_preprocessor_.preprocess(
@@ -2100,21 +2282,40 @@ void FbStatementImpl::execute(std::wstring_view sql)
 }
 
 bool FbStatementImpl::fetch()
+{
+	return fetch_impl(nullptr);
+}
+
+Status FbStatementImpl::try_fetch()
+{
+	Status status;
+	bool fetched = fetch_impl(&status);
+	if (status.is_ok() && !fetched) return Status::make_no_data();
+	return status;
+}
+
+// returns false at the end of data or if error is stored in status
+bool FbStatementImpl::fetch_impl(Status *status)
 {
 	check_is_prepared();
 
+	TraceScope trace(conn_->get_tracer().get(), TraceOperation::Fetch, last_sql_, this);
+
 	has_data_ = false;
 
 	out_sqlda_.close_blob_handles(lib_->api, true);
 	out_sqlda_.clear_null_flags();
 
 	ISC_STATUS status_vect[StatusLen] = {};
-	ISC_STATUS status = lib_->api.f_isc_dsql_fetch(status_vect, &stmt_, DaVersion, out_sqlda_.data());
-	switch (status)
+	conn_->count_call(NativeCallType::Fetch, false);
+	ISC_STATUS fetch_res = lib_->api.f_isc_dsql_fetch(status_vect, &stmt_, DaVersion, out_sqlda_.data());
+	switch (fetch_res)
 	{
 	case 0:
 		cursor_opened_ = true;
 		has_data_ = true;
+		conn_->get_stats_for_change().result_bytes += out_sqlda_.get_row_size();
+		trace.set_rows_count(1);
 		return true;
 
 	case 100:
@@ -2125,7 +2326,8 @@ bool FbStatementImpl::fetch()
 		throw WrongSeqException("Can't fetch data");
 	}
 
-	check_status_vector(lib_->api, "isc_dsql_fetch", status_vect, {});
+	if (!check_status_vector(lib_->api, "isc_dsql_fetch", status_vect, {}, status))
+		trace.set_error(status->get_error_type());
 	return false;
 }
 
@@ -2503,6 +2705,37 @@ isc_stmt_handle& FbStatementImpl::get_handle()
 	return stmt_;
 }
 
+std::string FbStatementImpl::get_plan()
+{
+	check_is_prepared();
+
+	ISC_STATUS status_vect[StatusLen] = {};
+
+	char plan_item[] = { isc_info_sql_get_plan };
+	std::vector<char> res_buffer(32768);
+	conn_->count_call(NativeCallType::Info, true);
+	lib_->api.f_isc_dsql_sql_info(
+		status_vect,
+		&stmt_,
+		sizeof(plan_item),
+		plan_item,
+		(short)(res_buffer.size() - 1),
+		res_buffer.data()
+	);
+	check_status_vector(lib_->api, "isc_dsql_sql_info", status_vect, last_sql_);
+
+	if (res_buffer[0] != isc_info_sql_get_plan) return {};
+
+	int plan_len = (int)lib_->api.f_isc_portable_integer((const ISC_UCHAR*)&res_buffer[1], 2);
+	std::string result(res_buffer.data() + 3, (size_t)plan_len);
+
+	// plan starts with new line
+	while (!result.empty() && ((result.front() == '\n') || (result.front() == '\r')))
+		result.erase(0, 1);
+
+	return result;
+}
+
 FbLibPtr create_fb_lib()
 {
 	return std::make_shared<FbLibImpl>();
@@ -0,0 +1,286 @@
+/*
+
+Copyright (c) 2015-2022 Artyomov Denis (denis.artyomov@gmail.com)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+#include "../include/dblib/dblib_keyset_scanner.hpp"
+#include "../include/dblib/dblib_exception.hpp"
+
+namespace dblib {
+
+/* class KeysetScanner */
+
+KeysetScanner::KeysetScanner(
+	Statement                      &stmt,
+	std::string_view               base_sql,
+	const std::vector<std::string> &key_columns,
+	const KeysetScannerParams      &params
+) :
+	stmt_(stmt),
+	params_(params),
+	key_columns_(key_columns)
+{
+	if (key_columns_.empty())
+		throw WrongArgumentException("Key columns of KeysetScanner are not defined");
+
+	if (params_.page_size == 0)
+		throw WrongArgumentException("KeysetScannerParams::page_size can't be 0");
+
+	build_sql(base_sql);
+}
+
+KeysetScanner::~KeysetScanner()
+{
+	if (next_page_future_.valid())
+		next_page_future_.wait();
+}
+
+void KeysetScanner::build_sql(std::string_view base_sql)
+{
+	auto driver_name = stmt_.get_transaction()->get_connection()->get_driver_name();
+	bool is_firebird = (driver_name == "firebird");
+
+	std::string page_size_text = std::to_string(params_.page_size);
+
+	std::string order_by = " order by ";
+	for (size_t i = 0; i < key_columns_.size(); i++)
+	{
+		if (i != 0) order_by.append(", ");
+		order_by.append(key_columns_[i]);
+	}
+
+	std::string limit = is_firebird ? " rows " + page_size_text : " limit " + page_size_text;
+
+	std::string select = "select * from (" + std::string(base_sql) + ") dblib_keyset";
+
+	std::string condition;
+
+	if (is_firebird)
+	{
+		// (k1 > ?1) or (k1 = ?1 and k2 > ?2) or ...
+		for (size_t i = 0; i < key_columns_.size(); i++)
+		{
+			if (i != 0) condition.append(" or ");
+			condition.append("(");
+			for (size_t j = 0; j < i; j++)
+				condition.append(key_columns_[j] + " = ?" + std::to_string(j + 1) + " and ");
+			condition.append(key_columns_[i] + " > ?" + std::to_string(i + 1) + ")");
+		}
+	}
+	else
+	{
+		// (k1, k2) > (?1, ?2)
+		std::string keys, values;
+		for (size_t i = 0; i < key_columns_.size(); i++)
+		{
+			if (i != 0)
+			{
+				keys.append(", ");
+				values.append(", ");
+			}
+			keys.append(key_columns_[i]);
+			values.append("?" + std::to_string(i + 1));
+		}
+		condition = "(" + keys + ") > (" + values + ")";
+	}
+
+	first_page_sql_ = select + order_by + limit;
+	next_page_sql_ = select + " where " + condition + order_by + limit;
+}
+
+ParamValues KeysetScanner::get_last_key() const
+{
+	ParamValues result;
+
+	size_t rows_count = page_.get_rows_count();
+	if (rows_count == 0)
+		throw WrongSeqException("Page is empty");
+
+	size_t row = rows_count - 1;
+
+	for (auto &key_column : key_columns_)
+	{
+		auto &column = page_.get_column(page_.get_column_index(key_column));
+
+		if (column.is_null(row))
+			throw WrongArgumentException("Value of key column " + key_column + " is null");
+
+		switch (column.get_type())
+		{
+		case ValueType::Short:
+		case ValueType::Integer:
+		case ValueType::Boolean:
+			result.emplace_back(column.get_int32(row));
+			break;
+
+		case ValueType::BigInt:
+			result.emplace_back(column.get_int64(row));
+			break;
+
+		case ValueType::Float:
+		case ValueType::Double:
+			result.emplace_back(column.get_double(row));
+			break;
+
+		case ValueType::Char:
+		case ValueType::Varchar:
+			result.emplace_back(std::string(column.get_str(row)));
+			break;
+
+		case ValueType::Date:
+			result.emplace_back(column.get_date(row));
+			break;
+
+		case ValueType::Time:
+			result.emplace_back(column.get_time(row));
+			break;
+
+		case ValueType::Timestamp:
+			result.emplace_back(column.get_timestamp(row));
+			break;
+
+		default:
+			throw WrongArgumentException(
+				"Type " + field_type_to_string(column.get_type()) +
+				" of key column " + key_column + " is not supported"
+			);
+		}
+	}
+
+	return result;
+}
+
+void KeysetScanner::read_page(ResultSet &page, const ParamValues &last_key)
+{
+	if (last_key.empty())
+		stmt_.execute(first_page_sql_);
+
+	else
+	{
+		if (!next_page_prepared_)
+		{
+			stmt_.prepare(next_page_sql_);
+			next_page_prepared_ = true;
+		}
+
+		stmt_.set_params(last_key);
+		stmt_.execute();
+	}
+
+	page.clear_rows();
+	stmt_.fetch_columnar(page, params_.page_size);
+}
+
+void KeysetScanner::start_reading_next_page()
+{
+	next_page_future_ = std::async(
+		std::launch::async,
+		[this, last_key = get_last_key()]
+		{
+			read_page(next_page_, last_key);
+		}
+	);
+}
+
+bool KeysetScanner::fetch_page()
+{
+	row_is_valid_ = false;
+
+	if (finished_)
+	{
+		page_.clear_rows();
+		return false;
+	}
+
+	if (next_page_future_.valid())
+	{
+		next_page_future_.get();
+		std::swap(page_, next_page_);
+	}
+	else
+		read_page(page_, started_ ? get_last_key() : ParamValues());
+
+	started_ = true;
+
+	size_t rows_count = page_.get_rows_count();
+	if (rows_count == 0)
+	{
+		finished_ = true;
+		return false;
+	}
+
+	pages_count_++;
+
+	if (rows_count < params_.page_size)
+		finished_ = true;
+
+	else if (params_.prefetch)
+		start_reading_next_page();
+
+	return true;
+}
+
+bool KeysetScanner::fetch()
+{
+	if (row_is_valid_ && (row_ + 1 < page_.get_rows_count()))
+	{
+		row_++;
+		return true;
+	}
+
+	if (!fetch_page())
+		return false;
+
+	row_ = 0;
+	row_is_valid_ = true;
+	return true;
+}
+
+const ResultSet& KeysetScanner::get_page() const
+{
+	return page_;
+}
+
+size_t KeysetScanner::get_row() const
+{
+	if (!row_is_valid_)
+		throw WrongSeqException("Scanner doesn't contain data");
+
+	return row_;
+}
+
+size_t KeysetScanner::get_pages_count() const
+{
+	return pages_count_;
+}
+
+const std::string& KeysetScanner::get_first_page_sql() const
+{
+	return first_page_sql_;
+}
+
+const std::string& KeysetScanner::get_next_page_sql() const
+{
+	return next_page_sql_;
+}
+
+} // namespace dblib
@@ -0,0 +1,493 @@
+/*
+
+Copyright (c) 2015-2022 Artyomov Denis (denis.artyomov@gmail.com)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+
+#include "../include/dblib/dblib_metrics.hpp"
+
+namespace dblib {
+
+/* struct OperationMetrics */
+
+uint64_t OperationMetrics::get_errors_count() const
+{
+	uint64_t result = 0;
+	for (auto count : errors) result += count;
+	return result;
+}
+
+uint64_t OperationMetrics::get_quantile_ns(double quantile) const
+{
+	if (count == 0) return 0;
+
+	uint64_t rank = (uint64_t)(quantile * (double)count + 0.5);
+	if (rank == 0) rank = 1;
+
+	uint64_t sum = 0;
+	for (size_t i = 0; i < LatencyBucketBoundsNs.size(); i++)
+	{
+		sum += buckets[i];
+		if (sum >= rank) return std::min(LatencyBucketBoundsNs[i], max_ns);
+	}
+
+	return max_ns;
+}
+
+
+/* struct StatementMetrics */
+
+const OperationMetrics& StatementMetrics::get(TraceOperation operation) const
+{
+	return operations[(size_t)operation];
+}
+
+uint64_t StatementMetrics::get_total_ns() const
+{
+	uint64_t result = 0;
+	for (auto &op : operations) result += op.total_ns;
+	return result;
+}
+
+uint64_t StatementMetrics::get_total_count() const
+{
+	uint64_t result = 0;
+	for (auto &op : operations) result += op.count;
+	return result;
+}
+
+
+/* sql_fingerprint */
+
+static bool is_ident_char(char chr)
+{
+	return
+		((chr >= 'a') && (chr <= 'z')) ||
+		((chr >= 'A') && (chr <= 'Z')) ||
+		((chr >= '0') && (chr <= '9')) ||
+		(chr == '_') || (chr == '$') || (chr == '?') || (chr == ':') || (chr == '@') ||
+		((unsigned char)chr >= 0x80);
+}
+
+static bool is_digit(char chr)
+{
+	return (chr >= '0') && (chr <= '9');
+}
+
+static bool is_space(char chr)
+{
+	return (chr == ' ') || (chr == '\t') || (chr == '\r') || (chr == '\n');
+}
+
+// ? after "?, " or "(?, " is collapsed into previous one
+static void append_literal_placeholder(std::string &result)
+{
+	if ((result.size() >= 3) && (result.compare(result.size() - 3, 3, "?, ") == 0))
+		result.resize(result.size() - 2);
+	else if ((result.size() >= 2) && (result.compare(result.size() - 2, 2, "?,") == 0))
+		result.resize(result.size() - 1);
+	else
+		result.push_back('?');
+}
+
+std::string sql_fingerprint(std::string_view sql)
+{
+	std::string result;
+	result.reserve(sql.size());
+
+	bool space = false;
+	size_t i = 0;
+
+	while (i < sql.size())
+	{
+		char chr = sql[i];
+
+		if (is_space(chr))
+		{
+			space = true;
+			i++;
+			continue;
+		}
+
+		if ((chr == '-') && (i + 1 < sql.size()) && (sql[i + 1] == '-'))
+		{
+			while ((i < sql.size()) && (sql[i] != '\n')) i++;
+			space = true;
+			continue;
+		}
+
+		if ((chr == '/') && (i + 1 < sql.size()) && (sql[i + 1] == '*'))
+		{
+			auto end = sql.find("*/", i + 2);
+			i = (end == std::string_view::npos) ? sql.size() : end + 2;
+			space = true;
+			continue;
+		}
+
+		if (space && !result.empty() && (chr != ')') && (chr != ',') && (result.back() != '('))
+			result.push_back(' ');
+		space = false;
+
+		if (chr == '\'')
+		{
+			for (i++; i < sql.size(); i++)
+			{
+				if (sql[i] != '\'') continue;
+				if ((i + 1 < sql.size()) && (sql[i + 1] == '\'')) { i++; continue; }
+				break;
+			}
+			i++;
+			append_literal_placeholder(result);
+		}
+		else if (chr == '"')
+		{
+			auto end = sql.find('"', i + 1);
+			if (end == std::string_view::npos) end = sql.size() - 1;
+			result.append(sql.substr(i, end - i + 1));
+			i = end + 1;
+		}
+		else if (is_digit(chr) && (result.empty() || !is_ident_char(result.back())))
+		{
+			while ((i < sql.size()) && (is_digit(sql[i]) || (sql[i] == '.'))) i++;
+			append_literal_placeholder(result);
+		}
+		else
+		{
+			result.push_back(((chr >= 'A') && (chr <= 'Z')) ? (char)(chr - 'A' + 'a') : chr);
+			i++;
+		}
+	}
+
+	return result;
+}
+
+
+/* class MetricsRegistry */
+
+struct MetricsRegistry::Counters
+{
+	struct Operation
+	{
+		std::atomic<uint64_t> count {0};
+		std::atomic<uint64_t> total_ns {0};
+		std::atomic<uint64_t> max_ns {0};
+		std::array<std::atomic<uint64_t>, LatencyBucketsCount> buckets {};
+		std::array<std::atomic<uint64_t>, ErrorTypesCount> errors {};
+	};
+
+	std::array<Operation, TraceOperationsCount> operations;
+	std::atomic<uint64_t> rows_fetched {0};
+	std::atomic<uint64_t> rows_changed {0};
+	std::atomic<uint64_t> bytes {0};
+	std::atomic<uint64_t> round_trips {0};
+};
+
+// Counters are written only by thread owning the shard so relaxed
+// load + store is enough. Snapshot reads them with relaxed loads
+static void inc(std::atomic<uint64_t> &counter, uint64_t value)
+{
+	counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+struct MetricsRegistry::Shard
+{
+	// locked by owning thread when new fingerprint is added and by snapshot
+	std::mutex mutex;
+	std::map<std::string, std::unique_ptr<Counters>, std::less<>> by_fingerprint;
+
+	// used only by owning thread
+	std::map<std::string, Counters*, std::less<>> by_sql;
+};
+
+static constexpr size_t MaxSqlTextsInShard = 10000;
+
+static std::atomic<uint64_t> registries_counter = 0;
+
+MetricsRegistry::MetricsRegistry() :
+	id_(++registries_counter)
+{}
+
+MetricsRegistry::~MetricsRegistry()
+{}
+
+void MetricsRegistry::begin(TraceEvent &)
+{}
+
+void MetricsRegistry::end(TraceEvent &event)
+{
+	auto &shard = get_thread_shard();
+	auto &counters = get_counters(shard, event.sql, event.operation);
+	auto &op = counters.operations[(size_t)event.operation];
+
+	uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(event.end_time - event.begin_time).count();
+
+	size_t bucket = std::lower_bound(LatencyBucketBoundsNs.begin(), LatencyBucketBoundsNs.end(), ns) - LatencyBucketBoundsNs.begin();
+
+	inc(op.count, 1);
+	inc(op.total_ns, ns);
+	inc(op.buckets[bucket], 1);
+	if (ns > op.max_ns.load(std::memory_order_relaxed))
+		op.max_ns.store(ns, std::memory_order_relaxed);
+	if (event.failed)
+		inc(op.errors[(size_t)event.error_type], 1);
+
+	if (event.operation == TraceOperation::Fetch)
+		inc(counters.rows_fetched, event.rows_count);
+	else if (event.operation == TraceOperation::Execute)
+		inc(counters.rows_changed, event.rows_count);
+
+	inc(counters.bytes, event.bytes_count);
+	inc(counters.round_trips, event.round_trips);
+}
+
+MetricsRegistry::Shard& MetricsRegistry::get_thread_shard()
+{
+	// shards of registries of this thread. Shard with use_count() == 1
+	// belongs to destroyed registry
+	static thread_local std::vector<std::pair<uint64_t, ShardPtr>> thread_shards;
+
+	for (auto &item : thread_shards)
+		if (item.first == id_) return *item.second;
+
+	thread_shards.erase(
+		std::remove_if(
+			thread_shards.begin(), thread_shards.end(),
+			[](auto &item) { return item.second.use_count() == 1; }
+		),
+		thread_shards.end()
+	);
+
+	auto shard = std::make_shared<Shard>();
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		shards_.push_back(shard);
+	}
+	thread_shards.emplace_back(id_, shard);
+
+	return *shard;
+}
+
+MetricsRegistry::Counters& MetricsRegistry::get_counters(Shard &shard, std::string_view sql, TraceOperation operation)
+{
+	if (sql.empty())
+		sql = trace_operation_to_string(operation);
+
+	auto sql_it = shard.by_sql.find(sql);
+	if (sql_it != shard.by_sql.end())
+		return *sql_it->second;
+
+	if (shard.by_sql.size() >= MaxSqlTextsInShard)
+		shard.by_sql.clear();
+
+	auto fingerprint = sql_fingerprint(sql);
+
+	Counters* counters = nullptr;
+	auto it = shard.by_fingerprint.find(fingerprint);
+	if (it != shard.by_fingerprint.end())
+		counters = it->second.get();
+	else
+	{
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		counters = shard.by_fingerprint.emplace(fingerprint, std::make_unique<Counters>()).first->second.get();
+	}
+
+	shard.by_sql.emplace(sql, counters);
+	return *counters;
+}
+
+std::vector<StatementMetrics> MetricsRegistry::snapshot() const
+{
+	std::map<std::string, StatementMetrics> merged;
+
+	auto load = [](const std::atomic<uint64_t> &value)
+	{
+		return value.load(std::memory_order_relaxed);
+	};
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	for (auto &shard : shards_)
+	{
+		std::lock_guard<std::mutex> shard_lock(shard->mutex);
+		for (auto &[fingerprint, counters] : shard->by_fingerprint)
+		{
+			auto &dst = merged[fingerprint];
+			dst.fingerprint = fingerprint;
+
+			for (size_t i = 0; i < TraceOperationsCount; i++)
+			{
+				auto &src_op = counters->operations[i];
+				auto &dst_op = dst.operations[i];
+				dst_op.count += load(src_op.count);
+				dst_op.total_ns += load(src_op.total_ns);
+				dst_op.max_ns = std::max(dst_op.max_ns, load(src_op.max_ns));
+				for (size_t j = 0; j < LatencyBucketsCount; j++)
+					dst_op.buckets[j] += load(src_op.buckets[j]);
+				for (size_t j = 0; j < ErrorTypesCount; j++)
+					dst_op.errors[j] += load(src_op.errors[j]);
+			}
+
+			dst.rows_fetched += load(counters->rows_fetched);
+			dst.rows_changed += load(counters->rows_changed);
+			dst.bytes += load(counters->bytes);
+			dst.round_trips += load(counters->round_trips);
+		}
+	}
+
+	std::vector<StatementMetrics> result;
+	result.reserve(merged.size());
+	for (auto &item : merged)
+		result.push_back(std::move(item.second));
+
+	std::stable_sort(
+		result.begin(), result.end(),
+		[](const StatementMetrics &left, const StatementMetrics &right)
+		{
+			return left.get_total_ns() > right.get_total_ns();
+		}
+	);
+
+	return result;
+}
+
+static std::string escape_label_value(std::string_view value)
+{
+	std::string result;
+	result.reserve(value.size());
+	for (char chr : value)
+	{
+		switch (chr)
+		{
+		case '\\': result.append("\\\\"); break;
+		case '"':  result.append("\\\""); break;
+		case '\n': result.append("\\n"); break;
+		default:   result.push_back(chr); break;
+		}
+	}
+	return result;
+}
+
+static const char* error_type_to_label(ErrorType error_type)
+{
+	switch (error_type)
+	{
+	case ErrorType::Normal:         return "normal";
+	case ErrorType::Transaction:    return "transaction";
+	case ErrorType::Lock:           return "lock";
+	case ErrorType::Connection:     return "connection";
+	case ErrorType::LostConnection: return "lost_connection";
+	}
+
+	return "";
+}
+
+static std::string ns_to_seconds_str(uint64_t ns)
+{
+	char buffer[64] = {};
+	snprintf(buffer, sizeof(buffer), "%.9g", (double)ns / 1e9);
+	return buffer;
+}
+
+std::string MetricsRegistry::to_prometheus(std::string_view prefix) const
+{
+	auto metrics = snapshot();
+	std::string result;
+	std::string name_prefix(prefix);
+
+	auto header = [&](const char *name, const char *type, const char *help)
+	{
+		result.append("# HELP ").append(name_prefix).append(name).append(" ").append(help).append("\n");
+		result.append("# TYPE ").append(name_prefix).append(name).append(" ").append(type).append("\n");
+	};
+
+	auto labels = [](const std::string &fingerprint, const char *operation)
+	{
+		std::string result = "fingerprint=\"" + escape_label_value(fingerprint) + "\"";
+		if (operation)
+			result.append(",operation=\"").append(operation).append("\"");
+		return result;
+	};
+
+	header("_operation_duration_seconds", "histogram", "Duration of prepare, execute, fetch, commit and rollback");
+	for (auto &statement : metrics)
+	{
+		for (size_t i = 0; i < TraceOperationsCount; i++)
+		{
+			auto &op = statement.operations[i];
+			if (op.count == 0) continue;
+
+			auto op_labels = labels(statement.fingerprint, trace_operation_to_string((TraceOperation)i));
+			auto metric = name_prefix + "_operation_duration_seconds";
+
+			uint64_t cumulative = 0;
+			for (size_t j = 0; j < LatencyBucketsCount; j++)
+			{
+				cumulative += op.buckets[j];
+				auto le = (j < LatencyBucketBoundsNs.size()) ? ns_to_seconds_str(LatencyBucketBoundsNs[j]) : "+Inf";
+				result.append(metric).append("_bucket{").append(op_labels).append(",le=\"").append(le).append("\"} ");
+				result.append(std::to_string(cumulative)).append("\n");
+			}
+
+			result.append(metric).append("_sum{").append(op_labels).append("} ").append(ns_to_seconds_str(op.total_ns)).append("\n");
+			result.append(metric).append("_count{").append(op_labels).append("} ").append(std::to_string(op.count)).append("\n");
+		}
+	}
+
+	header("_errors_total", "counter", "Failed operations by type of error");
+	for (auto &statement : metrics)
+	{
+		for (size_t i = 0; i < TraceOperationsCount; i++)
+		{
+			auto &op = statement.operations[i];
+			for (size_t j = 0; j < ErrorTypesCount; j++)
+			{
+				if (op.errors[j] == 0) continue;
+				result.append(name_prefix).append("_errors_total{");
+				result.append(labels(statement.fingerprint, trace_operation_to_string((TraceOperation)i)));
+				result.append(",error_type=\"").append(error_type_to_label((ErrorType)j)).append("\"} ");
+				result.append(std::to_string(op.errors[j])).append("\n");
+			}
+		}
+	}
+
+	auto counter = [&](const char *name, const char *help, uint64_t StatementMetrics::*field)
+	{
+		header(name, "counter", help);
+		for (auto &statement : metrics)
+		{
+			if (statement.*field == 0) continue;
+			result.append(name_prefix).append(name).append("{").append(labels(statement.fingerprint, nullptr)).append("} ");
+			result.append(std::to_string(statement.*field)).append("\n");
+		}
+	};
+
+	counter("_rows_fetched_total", "Fetched rows", &StatementMetrics::rows_fetched);
+	counter("_rows_changed_total", "Rows changed by execute", &StatementMetrics::rows_changed);
+	counter("_bytes_total", "Bytes of parameters and fetched values", &StatementMetrics::bytes);
+	counter("_round_trips_total", "Requests to server", &StatementMetrics::round_trips);
+
+	return result;
+}
+
+} // namespace dblib
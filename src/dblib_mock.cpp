@@ -0,0 +1,955 @@
+/*
+
+Copyright (c) 2015-2022 Artyomov Denis (denis.artyomov@gmail.com)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+#include <string.h>
+
+#include "../include/dblib/dblib_mock.hpp"
+#include "../include/dblib/dblib_cvt_utils.hpp"
+#include "dblib_stmt_tools.hpp"
+#include "dblib_type_cvt.hpp"
+
+namespace dblib {
+
+
+/* class MockConnectionImpl */
+
+class MockConnectionImpl final :
+	public MockConnection,
+	public std::enable_shared_from_this<MockConnectionImpl>
+{
+public:
+	MockConnectionImpl(const MockConfig &config);
+
+	void connect() override;
+	void disconnect() override;
+	bool is_connected() const override;
+	bool supports_sequences() const override;
+	TransactionPtr create_transaction(const TransactionParams &transaction_params) override;
+
+	void set_default_transaction_level(TransactionLevel level) override;
+	TransactionLevel get_default_transaction_level() const override;
+
+	void direct_execute(std::string_view sql) override;
+	std::string get_driver_name() const override;
+
+	const MockStats& get_stats() const override;
+	void reset_stats() override;
+
+	const MockConfig& get_config() const;
+	MockStats& get_stats_for_change();
+
+private:
+	MockConfig config_;
+	MockStats stats_;
+	bool is_connected_ = false;
+	TransactionLevel default_level_ = TransactionLevel::Default;
+
+	void check_is_connected() const;
+};
+
+using MockConnectionImplPtr = std::shared_ptr<MockConnectionImpl>;
+
+
+/* class MockTransactionImpl */
+
+class MockTransactionImpl final :
+	public Transaction,
+	public std::enable_shared_from_this<MockTransactionImpl>
+{
+public:
+	MockTransactionImpl(const MockConnectionImplPtr &conn);
+
+	ConnectionPtr get_connection() override;
+	StatementPtr create_statement() override;
+
+protected:
+	void internal_start() override;
+	void internal_commit() override;
+	void internal_rollback() override;
+
+private:
+	MockConnectionImplPtr conn_;
+};
+
+using MockTransactionImplPtr = std::shared_ptr<MockTransactionImpl>;
+
+
+/* class MockSqlPreprocessorActions */
+
+class MockSqlPreprocessorActions : public SqlPreprocessorActions
+{
+public:
+	MockSqlPreprocessorActions(bool supports_sequences) :
+		supports_sequences_(supports_sequences)
+	{}
+
+protected:
+	void append_index_param_to_sql(const std::string& parameter, int param_index, std::string& sql) const override
+	{
+		sql.append("?");
+		sql.append(std::to_string(param_index));
+	}
+
+	void append_named_param_to_sql(const std::string& parameter, int param_index, std::string& sql) const override
+	{
+		sql.append("?");
+		sql.append(std::to_string(param_index));
+	}
+
+	void append_if_seq_data(const std::string& data, const std::string& other, std::string& sql) const override
+	{
+		if (!supports_sequences_) return;
+		sql.append(data);
+		sql.append(other);
+	}
+
+	void append_seq_generator(const std::string& seq_name, const std::string& other, std::string& sql) const override
+	{
+		if (!supports_sequences_) return;
+		sql.append("nextval('");
+		sql.append(seq_name);
+		sql.append("')");
+		sql.append(other);
+	}
+
+private:
+	bool supports_sequences_;
+};
+
+
+/* class MockStatementImpl */
+
+class MockStatementImpl final :
+	public Statement,
+	public IResultGetterWithTypeCvt
+{
+public:
+	MockStatementImpl(const MockConnectionImplPtr &conn, const MockTransactionImplPtr &tran);
+
+	TransactionPtr get_transaction() override;
+
+	void prepare(std::string_view sql, bool use_native_parameters_syntax) override;
+	void prepare(std::wstring_view sql, bool use_native_parameters_syntax) override;
+
+	void execute(std::string_view sql) override;
+	void execute(std::wstring_view sql) override;
+
+	StatementType get_type() override;
+
+	void execute() override;
+
+	size_t get_changes_count() override;
+	int64_t get_last_row_id() override;
+
+	std::string get_last_sql() const override;
+
+	bool fetch() override;
+
+	size_t get_params_count() const override;
+	ValueType get_param_type(const IndexOrName& param) override;
+	void set_null(const IndexOrName& param) override;
+
+	void set_int32_opt(const IndexOrName& param, Int32Opt value) override;
+	void set_int64_opt(const IndexOrName& param, Int64Opt value) override;
+	void set_float_opt(const IndexOrName& param, FloatOpt value) override;
+	void set_double_opt(const IndexOrName& param, DoubleOpt value) override;
+	void set_u8str_opt(const IndexOrName& param, const StringOpt &text) override;
+	void set_wstr_opt(const IndexOrName& param, const WStringOpt &text) override;
+	void set_date_opt(const IndexOrName& param, const DateOpt &date) override;
+	void set_time_opt(const IndexOrName& param, const TimeOpt &time) override;
+	void set_timestamp_opt(const IndexOrName& param, const TimeStampOpt &ts) override;
+
+	void set_blob(const IndexOrName& param, const char *blob_data, size_t blob_size) override;
+
+	ParamValues get_param_values() override;
+
+	size_t get_columns_count() override;
+	ValueType get_column_type(const IndexOrName& column) override;
+	std::string get_column_name(size_t index) override;
+
+	bool is_null(const IndexOrName& column) override;
+
+	Int32Opt get_int32_opt(const IndexOrName& column) override;
+	Int64Opt get_int64_opt(const IndexOrName& column) override;
+	FloatOpt get_float_opt(const IndexOrName& column) override;
+	DoubleOpt get_double_opt(const IndexOrName& column) override;
+	StringOpt get_str_utf8_opt(const IndexOrName& column) override;
+	WStringOpt get_wstr_opt(const IndexOrName& column) override;
+	DateOpt get_date_opt(const IndexOrName& column) override;
+	TimeOpt get_time_opt(const IndexOrName& column) override;
+	TimeStampOpt get_timestamp_opt(const IndexOrName& column) override;
+	size_t get_blob_size(const IndexOrName& column) override;
+	void get_blob_data(const IndexOrName& column, char *dst, size_t size) override;
+
+	// IResultGetterWithTypeCvt
+	int16_t get_int16_impl(size_t index) override;
+	int32_t get_int32_impl(size_t index) override;
+	int64_t get_int64_impl(size_t index) override;
+	float get_float_impl(size_t index) override;
+	double get_double_impl(size_t index) override;
+	std::string get_str_utf8_impl(size_t index) override;
+	std::wstring get_wstr_impl(size_t index) override;
+
+private:
+	MockConnectionImplPtr conn_;
+	MockTransactionImplPtr tran_;
+
+	bool is_prepared_ = false;
+	bool contains_data_ = false;
+	std::string last_sql_;
+	SqlPreprocessor sql_preprocessor_;
+	ColumnsHelper columns_helper_;
+	ParamValues params_;
+	const MockResult *result_ = nullptr;
+	size_t fetched_rows_count_ = 0;
+	size_t row_ = 0;
+
+	void check_is_prepared() const;
+	void check_contains_data() const;
+	void internal_execute();
+	size_t get_row_bytes() const;
+	static size_t get_param_size(const ParamValue &param);
+
+	const ResultColumn& get_column_for_value(const IndexOrName& column);
+
+	template <typename T>
+	void set_param_impl(const IndexOrName& param, const T &value);
+
+	template <typename T, typename V>
+	void set_param_opt_impl(const IndexOrName& param, const std::optional<V> &value);
+
+	template <typename T>
+	std::optional<T> get_value_with_type_cvt(const IndexOrName& column);
+};
+
+
+/* class MockConnectionImpl */
+
+MockConnectionImpl::MockConnectionImpl(const MockConfig &config) :
+	config_(config)
+{}
+
+void MockConnectionImpl::connect()
+{
+	if (is_connected_)
+		throw WrongSeqException("Database is connected");
+
+	is_connected_ = true;
+}
+
+void MockConnectionImpl::disconnect()
+{
+	check_is_connected();
+	is_connected_ = false;
+}
+
+bool MockConnectionImpl::is_connected() const
+{
+	return is_connected_;
+}
+
+bool MockConnectionImpl::supports_sequences() const
+{
+	return config_.supports_sequences;
+}
+
+TransactionPtr MockConnectionImpl::create_transaction(const TransactionParams &transaction_params)
+{
+	check_is_connected();
+
+	auto tran = std::make_shared<MockTransactionImpl>(shared_from_this());
+	if (transaction_params.autostart)
+		tran->start();
+	return tran;
+}
+
+void MockConnectionImpl::set_default_transaction_level(TransactionLevel level)
+{
+	default_level_ = level;
+}
+
+TransactionLevel MockConnectionImpl::get_default_transaction_level() const
+{
+	return default_level_;
+}
+
+void MockConnectionImpl::direct_execute(std::string_view sql)
+{
+	check_is_connected();
+	stats_.executes_count++;
+}
+
+std::string MockConnectionImpl::get_driver_name() const
+{
+	return "mock";
+}
+
+const MockStats& MockConnectionImpl::get_stats() const
+{
+	return stats_;
+}
+
+void MockConnectionImpl::reset_stats()
+{
+	stats_ = {};
+}
+
+const MockConfig& MockConnectionImpl::get_config() const
+{
+	return config_;
+}
+
+MockStats& MockConnectionImpl::get_stats_for_change()
+{
+	return stats_;
+}
+
+void MockConnectionImpl::check_is_connected() const
+{
+	if (is_connected_) return;
+	throw WrongSeqException("Database is not connected");
+}
+
+
+/* class MockTransactionImpl */
+
+MockTransactionImpl::MockTransactionImpl(const MockConnectionImplPtr &conn) :
+	conn_(conn)
+{}
+
+ConnectionPtr MockTransactionImpl::get_connection()
+{
+	return conn_;
+}
+
+StatementPtr MockTransactionImpl::create_statement()
+{
+	return std::make_shared<MockStatementImpl>(conn_, shared_from_this());
+}
+
+void MockTransactionImpl::internal_start()
+{
+	conn_->get_stats_for_change().transactions_count++;
+}
+
+void MockTransactionImpl::internal_commit()
+{}
+
+void MockTransactionImpl::internal_rollback()
+{}
+
+
+/* class MockStatementImpl */
+
+MockStatementImpl::MockStatementImpl(const MockConnectionImplPtr &conn, const MockTransactionImplPtr &tran) :
+	conn_(conn),
+	tran_(tran),
+	columns_helper_(*this)
+{}
+
+TransactionPtr MockStatementImpl::get_transaction()
+{
+	return tran_;
+}
+
+void MockStatementImpl::check_is_prepared() const
+{
+	if (!is_prepared_)
+		throw WrongSeqException("Statement is not prepared");
+}
+
+void MockStatementImpl::check_contains_data() const
+{
+	if (!contains_data_)
+		throw WrongSeqException("Statement does not have data");
+}
+
+void MockStatementImpl::prepare(std::string_view sql, bool use_native_parameters_syntax)
+{
+	TraceScope trace(conn_->get_tracer().get(), TraceOperation::Prepare, sql, this);
+
+	last_sql_ = sql;
+
+	sql_preprocessor_.preprocess(
+		sql,
+		use_native_parameters_syntax,
+		true,
+		MockSqlPreprocessorActions(conn_->get_config().supports_sequences)
+	);
+
+	columns_helper_.clear();
+
+	params_.clear();
+	params_.resize(sql_preprocessor_.get_parameters_count());
+
+	result_ = nullptr;
+	contains_data_ = false;
+	is_prepared_ = true;
+
+	conn_->get_stats_for_change().prepares_count++;
+}
+
+void MockStatementImpl::prepare(std::wstring_view sql, bool use_native_parameters_syntax)
+{
+	prepare(utf16_to_utf8(sql), use_native_parameters_syntax);
+}
+
+StatementType MockStatementImpl::get_type()
+{
+	check_is_prepared();
+	return StatementType::Unknown;
+}
+
+void MockStatementImpl::internal_execute()
+{
+	TraceScope trace(conn_->get_tracer().get(), TraceOperation::Execute, last_sql_, this);
+
+	if (trace.is_active())
+	{
+		for (auto &param : params_)
+			trace.add_bytes(get_param_size(param));
+	}
+
+	auto &config = conn_->get_config();
+	auto &sql = sql_preprocessor_.get_preprocessed_sql();
+
+	if (config.params_sink)
+		config.params_sink(sql, params_);
+
+	result_ = config.result_fun ? config.result_fun(sql) : nullptr;
+	fetched_rows_count_ = 0;
+	contains_data_ = false;
+
+	conn_->get_stats_for_change().executes_count++;
+
+	if (trace.is_active() && result_)
+		trace.set_rows_count(result_->changes_count);
+}
+
+size_t MockStatementImpl::get_param_size(const ParamValue &param)
+{
+	if (auto str = std::get_if<std::string>(&param))
+		return str->size();
+
+	return std::visit(
+		[](const auto &value) -> size_t
+		{
+			using T = std::decay_t<decltype(value)>;
+			return std::is_same_v<T, std::monostate> ? 0 : sizeof(T);
+		},
+		param
+	);
+}
+
+size_t MockStatementImpl::get_row_bytes() const
+{
+	size_t result = 0;
+	auto &rows = result_->rows;
+	for (size_t i = 1; i <= rows.get_columns_count(); i++)
+	{
+		auto &column = rows.get_column(i);
+		if (column.is_null(row_)) continue;
+
+		switch (column.get_type())
+		{
+		case ValueType::Char:
+		case ValueType::Varchar:
+		case ValueType::Blob:
+			result += column.get_blob(row_).size();
+			break;
+
+		case ValueType::Short:
+			result += sizeof(int16_t);
+			break;
+
+		case ValueType::Integer:
+		case ValueType::Boolean:
+		case ValueType::Float:
+			result += sizeof(int32_t);
+			break;
+
+		case ValueType::Date:
+			result += sizeof(Date);
+			break;
+
+		case ValueType::Time:
+			result += sizeof(Time);
+			break;
+
+		case ValueType::Timestamp:
+			result += sizeof(TimeStamp);
+			break;
+
+		default:
+			result += sizeof(int64_t);
+			break;
+		}
+	}
+
+	return result;
+}
+
+void MockStatementImpl::execute()
+{
+	check_is_prepared();
+	internal_execute();
+}
+
+void MockStatementImpl::execute(std::string_view sql)
+{
+	prepare(sql, true);
+	internal_execute();
+}
+
+void MockStatementImpl::execute(std::wstring_view sql)
+{
+	prepare(sql, true);
+	internal_execute();
+}
+
+size_t MockStatementImpl::get_changes_count()
+{
+	return result_ ? result_->changes_count : 0;
+}
+
+int64_t MockStatementImpl::get_last_row_id()
+{
+	return 0;
+}
+
+std::string MockStatementImpl::get_last_sql() const
+{
+	return last_sql_;
+}
+
+bool MockStatementImpl::fetch()
+{
+	check_is_prepared();
+
+	TraceScope trace(conn_->get_tracer().get(), TraceOperation::Fetch, last_sql_, this);
+
+	contains_data_ = false;
+	if (result_ == nullptr) return false;
+
+	size_t rows_count = result_->rows.get_rows_count();
+	if (fetched_rows_count_ >= rows_count * result_->repeat_count)
+		return false;
+
+	row_ = fetched_rows_count_ % rows_count;
+	fetched_rows_count_++;
+	contains_data_ = true;
+
+	conn_->get_stats_for_change().fetched_rows_count++;
+
+	if (trace.is_active())
+	{
+		trace.set_rows_count(1);
+		trace.add_bytes(get_row_bytes());
+	}
+
+	return true;
+}
+
+size_t MockStatementImpl::get_params_count() const
+{
+	check_is_prepared();
+	return params_.size();
+}
+
+ValueType MockStatementImpl::get_param_type(const IndexOrName& param)
+{
+	check_is_prepared();
+	return ValueType::Any;
+}
+
+template <typename T>
+void MockStatementImpl::set_param_impl(const IndexOrName& param, const T &value)
+{
+	check_is_prepared();
+
+	sql_preprocessor_.do_for_param_indexes(
+		param,
+		[&](size_t param_index)
+		{
+			if (param_index > params_.size())
+				params_.resize(param_index);
+			params_[param_index - 1] = value;
+		}
+	);
+}
+
+template <typename T, typename V>
+void MockStatementImpl::set_param_opt_impl(const IndexOrName& param, const std::optional<V> &value)
+{
+	if (value.has_value())
+		set_param_impl(param, T(*value));
+	else
+		set_param_impl(param, std::monostate());
+}
+
+void MockStatementImpl::set_null(const IndexOrName& param)
+{
+	set_param_impl(param, std::monostate());
+}
+
+void MockStatementImpl::set_int32_opt(const IndexOrName& param, Int32Opt value)
+{
+	set_param_opt_impl<int32_t>(param, value);
+}
+
+void MockStatementImpl::set_int64_opt(const IndexOrName& param, Int64Opt value)
+{
+	set_param_opt_impl<int64_t>(param, value);
+}
+
+void MockStatementImpl::set_float_opt(const IndexOrName& param, FloatOpt value)
+{
+	set_param_opt_impl<float>(param, value);
+}
+
+void MockStatementImpl::set_double_opt(const IndexOrName& param, DoubleOpt value)
+{
+	set_param_opt_impl<double>(param, value);
+}
+
+void MockStatementImpl::set_u8str_opt(const IndexOrName& param, const StringOpt &text)
+{
+	set_param_opt_impl<std::string>(param, text);
+}
+
+void MockStatementImpl::set_wstr_opt(const IndexOrName& param, const WStringOpt &text)
+{
+	if (text.has_value())
+		set_param_impl(param, utf16_to_utf8(*text));
+	else
+		set_param_impl(param, std::monostate());
+}
+
+void MockStatementImpl::set_date_opt(const IndexOrName& param, const DateOpt &date)
+{
+	set_param_opt_impl<Date>(param, date);
+}
+
+void MockStatementImpl::set_time_opt(const IndexOrName& param, const TimeOpt &time)
+{
+	set_param_opt_impl<Time>(param, time);
+}
+
+void MockStatementImpl::set_timestamp_opt(const IndexOrName& param, const TimeStampOpt &ts)
+{
+	set_param_opt_impl<TimeStamp>(param, ts);
+}
+
+void MockStatementImpl::set_blob(const IndexOrName& param, const char *blob_data, size_t blob_size)
+{
+	if (blob_data)
+		set_param_impl(param, std::string(blob_data, blob_size));
+	else
+		set_param_impl(param, std::monostate());
+}
+
+ParamValues MockStatementImpl::get_param_values()
+{
+	check_is_prepared();
+	return params_;
+}
+
+size_t MockStatementImpl::get_columns_count()
+{
+	check_is_prepared();
+	return result_ ? result_->rows.get_columns_count() : 0;
+}
+
+ValueType MockStatementImpl::get_column_type(const IndexOrName& column)
+{
+	check_is_prepared();
+	if (!result_) throw ColumnNotFoundException(column.to_str());
+	return result_->rows.get_column(columns_helper_.get_column_index(column)).get_type();
+}
+
+std::string MockStatementImpl::get_column_name(size_t index)
+{
+	check_is_prepared();
+	if (!result_) throw ColumnNotFoundException(std::to_string(index));
+	return result_->rows.get_column(index).get_name();
+}
+
+const ResultColumn& MockStatementImpl::get_column_for_value(const IndexOrName& column)
+{
+	check_is_prepared();
+	check_contains_data();
+	return result_->rows.get_column(columns_helper_.get_column_index(column));
+}
+
+bool MockStatementImpl::is_null(const IndexOrName& column)
+{
+	return get_column_for_value(column).is_null(row_);
+}
+
+template <typename T>
+std::optional<T> MockStatementImpl::get_value_with_type_cvt(const IndexOrName& column)
+{
+	auto &col = get_column_for_value(column);
+	if (col.is_null(row_)) return {};
+
+	auto type = col.get_type();
+	if (type == ValueType::Boolean)
+		type = ValueType::Integer;
+	else if (type == ValueType::Blob)
+		type = ValueType::Varchar;
+
+	return get_with_type_cvt<T>(*this, type, columns_helper_.get_column_index(column));
+}
+
+Int32Opt MockStatementImpl::get_int32_opt(const IndexOrName& column)
+{
+	return get_value_with_type_cvt<int32_t>(column);
+}
+
+Int64Opt MockStatementImpl::get_int64_opt(const IndexOrName& column)
+{
+	return get_value_with_type_cvt<int64_t>(column);
+}
+
+FloatOpt MockStatementImpl::get_float_opt(const IndexOrName& column)
+{
+	return get_value_with_type_cvt<float>(column);
+}
+
+DoubleOpt MockStatementImpl::get_double_opt(const IndexOrName& column)
+{
+	return get_value_with_type_cvt<double>(column);
+}
+
+StringOpt MockStatementImpl::get_str_utf8_opt(const IndexOrName& column)
+{
+	return get_value_with_type_cvt<std::string>(column);
+}
+
+WStringOpt MockStatementImpl::get_wstr_opt(const IndexOrName& column)
+{
+	return get_value_with_type_cvt<std::wstring>(column);
+}
+
+DateOpt MockStatementImpl::get_date_opt(const IndexOrName& column)
+{
+	auto &col = get_column_for_value(column);
+	if (col.is_null(row_)) return {};
+
+	switch (col.get_type())
+	{
+	case ValueType::Date:
+		return col.get_date(row_);
+
+	case ValueType::Timestamp:
+		return col.get_timestamp(row_).date;
+
+	default:
+		break;
+	}
+
+	throw WrongTypeConvException(field_type_to_string(col.get_type()), "Date");
+}
+
+TimeOpt MockStatementImpl::get_time_opt(const IndexOrName& column)
+{
+	auto &col = get_column_for_value(column);
+	if (col.is_null(row_)) return {};
+
+	switch (col.get_type())
+	{
+	case ValueType::Time:
+		return col.get_time(row_);
+
+	case ValueType::Timestamp:
+		return col.get_timestamp(row_).time;
+
+	default:
+		break;
+	}
+
+	throw WrongTypeConvException(field_type_to_string(col.get_type()), "Time");
+}
+
+TimeStampOpt MockStatementImpl::get_timestamp_opt(const IndexOrName& column)
+{
+	auto &col = get_column_for_value(column);
+	if (col.is_null(row_)) return {};
+
+	switch (col.get_type())
+	{
+	case ValueType::Date:
+		return TimeStamp(col.get_date(row_), {});
+
+	case ValueType::Timestamp:
+		return col.get_timestamp(row_);
+
+	default:
+		break;
+	}
+
+	throw WrongTypeConvException(field_type_to_string(col.get_type()), "TimeStamp");
+}
+
+size_t MockStatementImpl::get_blob_size(const IndexOrName& column)
+{
+	auto &col = get_column_for_value(column);
+	if (col.is_null(row_)) throw ColumnValueIsNullException(column.to_str());
+	return col.get_blob(row_).size();
+}
+
+void MockStatementImpl::get_blob_data(const IndexOrName& column, char *dst, size_t size)
+{
+	auto &col = get_column_for_value(column);
+	if (col.is_null(row_)) throw ColumnValueIsNullException(column.to_str());
+
+	auto blob = col.get_blob(row_);
+	if (size > blob.size())
+		throw WrongTypeConvException("Buffer size is larger than blob size");
+
+	memcpy(dst, blob.data(), size);
+}
+
+int16_t MockStatementImpl::get_int16_impl(size_t index)
+{
+	return result_->rows.get_column(index).get_int16(row_);
+}
+
+int32_t MockStatementImpl::get_int32_impl(size_t index)
+{
+	return result_->rows.get_column(index).get_int32(row_);
+}
+
+int64_t MockStatementImpl::get_int64_impl(size_t index)
+{
+	return result_->rows.get_column(index).get_int64(row_);
+}
+
+float MockStatementImpl::get_float_impl(size_t index)
+{
+	return result_->rows.get_column(index).get_float(row_);
+}
+
+double MockStatementImpl::get_double_impl(size_t index)
+{
+	return result_->rows.get_column(index).get_double(row_);
+}
+
+std::string MockStatementImpl::get_str_utf8_impl(size_t index)
+{
+	return std::string(result_->rows.get_column(index).get_str(row_));
+}
+
+std::wstring MockStatementImpl::get_wstr_impl(size_t index)
+{
+	return utf8_to_utf16(result_->rows.get_column(index).get_str(row_));
+}
+
+
+/* functions */
+
+MockConnectionPtr create_mock_connection(const MockConfig &config)
+{
+	return std::make_shared<MockConnectionImpl>(config);
+}
+
+ResultSet make_mock_rows(const std::vector<ValueType> &types, size_t rows_count)
+{
+	ResultSet result;
+
+	for (size_t i = 0; i < types.size(); i++)
+		result.add_column("col" + std::to_string(i + 1), types[i]);
+
+	result.reserve(rows_count);
+
+	const char blob[16] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
+
+	for (size_t row = 0; row < rows_count; row++)
+	{
+		int value = (int)row;
+		Date date = julianday_integer_to_date(2451545 + value % 10000);
+		Time time(value % 24, value % 60, (value / 60) % 60);
+
+		for (size_t i = 0; i < types.size(); i++)
+		{
+			auto &column = result.get_column(i + 1);
+
+			switch (types[i])
+			{
+			case ValueType::Short:
+				column.append_int16((int16_t)(value % 10000));
+				break;
+
+			case ValueType::Integer:
+				column.append_int32(value);
+				break;
+
+			case ValueType::Boolean:
+				column.append_int32(value % 2);
+				break;
+
+			case ValueType::BigInt:
+				column.append_int64((int64_t)value * 1000003);
+				break;
+
+			case ValueType::Float:
+				column.append_float((float)value * 0.5f);
+				break;
+
+			case ValueType::Double:
+				column.append_double((double)value * 0.25);
+				break;
+
+			case ValueType::Char:
+			case ValueType::Varchar:
+				column.append_str("value " + std::to_string(value));
+				break;
+
+			case ValueType::Date:
+				column.append_date(date);
+				break;
+
+			case ValueType::Time:
+				column.append_time(time);
+				break;
+
+			case ValueType::Timestamp:
+				column.append_timestamp(TimeStamp(date, time));
+				break;
+
+			case ValueType::Blob:
+				column.append_blob(blob, sizeof(blob));
+				break;
+
+			default:
+				column.append_null();
+				break;
+			}
+		}
+	}
+
+	return result;
+}
+
+} // namespace dblib
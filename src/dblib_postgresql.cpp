@@ -24,11 +24,31 @@ THE SOFTWARE.
 
 #include <vector>
 #include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <utility>
 #include <string.h>
 #include <assert.h>
+#include <errno.h>
+
+#include "../include/dblib/dblib_conf.hpp"
+
+#if defined(DBLIB_WINDOWS)
+	#define NOMINMAX
+	#include <winsock2.h>
+	#if defined(_MSC_VER)
+		#pragma comment(lib, "ws2_32.lib")
+	#endif
+#elif defined(DBLIB_LINUX)
+	#include <poll.h>
+#endif
+
 #include "../include/dblib/dblib_postgresql.hpp"
 #include "../include/dblib/dblib_exception.hpp"
 #include "../include/dblib/dblib_cvt_utils.hpp"
+#include "../include/dblib/dblib_result_set.hpp"
+#include "../include/dblib/dblib_csv.hpp"
 #include "dblib_stmt_tools.hpp"
 #include "dblib_type_cvt.hpp"
 #include "dblib_dyn.hpp"
@@ -48,6 +68,20 @@ constexpr Oid TIMESTAMPOID = 1114;
 constexpr Oid BYTEAOID = 17;
 constexpr Oid NAMEOID = 19;
 constexpr Oid TEXTOID = 25;
+constexpr Oid BOOLOID = 16;
+constexpr Oid JSONOID = 114;
+constexpr Oid UUIDOID = 2950;
+constexpr Oid JSONBOID = 3802;
+constexpr Oid TIMESTAMPTZOID = 1184;
+constexpr Oid NUMERICOID = 1700;
+
+constexpr char JsonbVersion = 1;
+
+// statuses of pipeline mode which are absent in libpq-fe.h of old versions
+constexpr size_t CachedStmtsMaxCount = 256;
+
+constexpr ExecStatusType PgresPipelineSync = (ExecStatusType)10;
+constexpr ExecStatusType PgresPipelineAborted = (ExecStatusType)11;
 
 
 /* class PgBuffer */
@@ -120,6 +154,12 @@ void PgBuffer::write_len(uint32_t len)
 	write_value<int32_t>(len);
 }
 
+void PgBuffer::write_int16_opt(std::optional<int16_t> value)
+{
+	assert(start_tuple_pos_);
+	write_opt(value);
+}
+
 void PgBuffer::write_int32_opt(Int32Opt value)
 {
 	assert(start_tuple_pos_);
@@ -233,6 +273,175 @@ void PgBuffer::write_timestamp_opt(const TimeStampOpt& ts)
 	++col_count_;
 }
 
+void PgBuffer::write_bool_opt(std::optional<bool> value)
+{
+	assert(start_tuple_pos_);
+
+	if (value)
+	{
+		write_len(1);
+		data_.push_back(*value ? 1 : 0);
+	}
+	else
+	{
+		write_null();
+	}
+
+	++col_count_;
+}
+
+void PgBuffer::write_blob_opt(const char* data, size_t size)
+{
+	assert(start_tuple_pos_);
+
+	if (data)
+	{
+		write_len((uint32_t)size);
+		data_.insert(data_.end(), data, data + size);
+	}
+	else
+	{
+		write_null();
+	}
+
+	++col_count_;
+}
+
+static std::string_view get_column_text(const ResultColumn &column, size_t row, std::string &text_buffer)
+{
+	char text[64];
+	std::to_chars_result result {};
+
+	switch (column.get_type())
+	{
+	case ValueType::Char:
+	case ValueType::Varchar:
+	case ValueType::Blob:
+		return column.get_str(row);
+
+	case ValueType::Short:
+	case ValueType::Integer:
+	case ValueType::Boolean:
+	case ValueType::BigInt:
+		result = std::to_chars(text, text + sizeof(text), column.get_int64(row));
+		break;
+
+	case ValueType::Float:
+		result = std::to_chars(text, text + sizeof(text), column.get_float(row));
+		break;
+
+	case ValueType::Double:
+		result = std::to_chars(text, text + sizeof(text), column.get_double(row));
+		break;
+
+	default:
+		throw WrongTypeConvException(field_type_to_string(column.get_type()), field_type_to_string(ValueType::Varchar));
+	}
+
+	text_buffer.assign(text, result.ptr);
+	return text_buffer;
+}
+
+static TimeStamp get_column_timestamp(const ResultColumn &column, size_t row, ValueType dst_type)
+{
+	TimeStamp result;
+
+	switch (column.get_type())
+	{
+	case ValueType::Date:
+		result.date = column.get_date(row);
+		return result;
+
+	case ValueType::Time:
+		result.time = column.get_time(row);
+		return result;
+
+	case ValueType::Timestamp:
+		return column.get_timestamp(row);
+
+	// SQLite keeps date and time as julian day or as text
+	case ValueType::Float:
+	case ValueType::Double:
+		if (dst_type == ValueType::Time)
+			result.time = days_to_time(column.get_double(row));
+		else
+			result = julianday_to_timestamp(column.get_double(row));
+		return result;
+
+	case ValueType::Char:
+	case ValueType::Varchar:
+	{
+		auto text = column.get_str(row);
+		bool ok =
+			(dst_type == ValueType::Time)
+			? parse_csv_time(text, result.time)
+			: parse_csv_timestamp(text, result);
+		if (!ok)
+			throw WrongTypeConvException("Can't convert '" + std::string(text) + "' into " + field_type_to_string(dst_type));
+		return result;
+	}
+
+	default:
+		throw WrongTypeConvException(field_type_to_string(column.get_type()), field_type_to_string(dst_type));
+	}
+}
+
+void PgBuffer::write_column_value(const ResultColumn &column, size_t row, ValueType dst_type)
+{
+	if (column.is_null(row))
+	{
+		write_blob_opt(nullptr, 0);
+		return;
+	}
+
+	switch (dst_type)
+	{
+	case ValueType::Short:
+		write_int16_opt(column.get_int16(row));
+		break;
+
+	case ValueType::Integer:
+		write_int32_opt(column.get_int32(row));
+		break;
+
+	case ValueType::BigInt:
+		write_int64_opt(column.get_int64(row));
+		break;
+
+	case ValueType::Float:
+		write_float_opt(column.get_float(row));
+		break;
+
+	case ValueType::Double:
+		write_double_opt(column.get_double(row));
+		break;
+
+	case ValueType::Char:
+	case ValueType::Varchar:
+	case ValueType::Blob:
+	{
+		auto text = get_column_text(column, row, text_buffer_);
+		write_blob_opt(text.data(), text.size());
+		break;
+	}
+
+	case ValueType::Date:
+		write_date_opt(get_column_timestamp(column, row, dst_type).date);
+		break;
+
+	case ValueType::Time:
+		write_time_opt(get_column_timestamp(column, row, dst_type).time);
+		break;
+
+	case ValueType::Timestamp:
+		write_timestamp_opt(get_column_timestamp(column, row, dst_type));
+		break;
+
+	default:
+		throw WrongTypeConvException(field_type_to_string(column.get_type()), field_type_to_string(dst_type));
+	}
+}
+
 void PgBuffer::end_tuple()
 {
 	assert(start_tuple_pos_);
@@ -320,7 +529,7 @@ using PgLibDataPtr = std::shared_ptr<PgLibData>;
 
 /* class PgLibImpl */
 
-class PgLibImpl : public PgLib
+class PgLibImpl final : public PgLib
 {
 public:
 	PgLibImpl();
@@ -337,7 +546,12 @@ private:
 
 /* class PgConnectionImpl */
 
-class PgConnectionImpl :
+class PgTransactionImpl;
+using PgTransactionImplPtr = std::shared_ptr<PgTransactionImpl>;
+
+class PgStatementImpl;
+
+class PgConnectionImpl final :
 	public PgConnection,
 	public std::enable_shared_from_this<PgConnectionImpl>
 {
@@ -354,21 +568,64 @@ public:
 	TransactionLevel get_default_transaction_level() const override;
 	void direct_execute(std::string_view sql) override;
 	std::string get_driver_name() const override;
+	ConnectionStats get_connection_stats() const override;
+	void reset_connection_stats() override;
+	void set_statements_pool_size(size_t max_size) override;
+	StatementsPoolStats get_statements_pool_stats() const override;
 
 	PGconn* get_connection() override;
 	PgTransactionPtr create_pg_transaction(const TransactionParams& transaction_params) override;
+	PgNotificationListenerPtr create_notification_listener(const PgListenerParams &params) override;
+
+	std::shared_ptr<PgStatementImpl> create_statement_impl(const PgTransactionImplPtr& tran);
 
 	void skip_previous_data();
 
+	// Commands queued in pipeline are sent by sync_pipeline. Pipeline
+	// mode is left in skip_previous_data when all results are read
+	void enter_pipeline_mode();
+	bool sync_pipeline(Status *status);
+
+	// Named statements with declared types of parameters prepared once for
+	// connection. Key is SQL text with types of parameters. Least recently
+	// used statement without users is deallocated if there are more than
+	// CachedStmtsMaxCount statements. reset_cached_stmts is called when
+	// statements are lost on server (DISCARD ALL or DEALLOCATE ALL)
+	const std::string& acquire_cached_stmt(const std::string &key, bool &is_prepared);
+	void release_cached_stmt(const std::string &key, const std::string &name);
+	void remove_cached_stmt(const std::string &key);
+	void reset_cached_stmts();
+
+	void count_call(NativeCallType type, bool round_trip, size_t sent_bytes = 0);
+	void count_result(PGresult* result);
+
 private:
 	PgLibDataPtr lib_;
 	PgConnectParams conn_params_;
 	PGconn* conn_ = nullptr;
+	bool in_pipeline_mode_ = false;
+	bool pipeline_is_synced_ = false;
+	struct CachedStmt
+	{
+		std::string name;
+		size_t users_count = 0;
+		uint64_t last_use = 0;
+	};
+
+	std::map<std::string, CachedStmt> cached_stmts_;
+	unsigned cached_stmts_counter_ = 0;
+	uint64_t cached_stmts_use_counter_ = 0;
+	ConnectionStats stats_;
 	TransactionLevel default_transaction_level_ = DefaultTransactionLevel;
 	std::string direct_execute_buffer_;
+	StatementsPool<PgStatementImpl> statements_pool_;
 
 	void disconnect_impl();
 	void check_is_connected();
+	void exit_pipeline_mode();
+	void evict_cached_stmt();
+
+	static void release_statement(PgStatementImpl* stmt);
 };
 
 using PgConnectionImplPtr = std::shared_ptr<PgConnectionImpl>;
@@ -376,7 +633,7 @@ using PgConnectionImplPtr = std::shared_ptr<PgConnectionImpl>;
 
 /* class PgTransactionImpl */
 
-class PgTransactionImpl :
+class PgTransactionImpl final :
 	public PgTransaction,
 	public std::enable_shared_from_this<PgTransactionImpl>
 {
@@ -388,38 +645,61 @@ public:
 	StatementPtr create_statement() override;
 	PgStatementPtr create_pg_statement() override;
 
+	// BEGIN is not sent by start(). It is queued before first statement of
+	// transaction (begin_in_pipeline) and its results are read after the
+	// statement is queued (end_begin_in_pipeline). So BEGIN and statement
+	// are sent to server in one flush. BEGIN is not prepared as named
+	// statement so it doesn't depend on DISCARD ALL or DEALLOCATE ALL.
+	// Without pipeline support BEGIN is executed by begin_in_pipeline
+	bool begin_in_pipeline(bool statement_can_be_pipelined);
+	bool end_begin_in_pipeline(Status *status);
+
+	// BEGIN as prefix of multi-statement simple query
+	std::string take_deferred_begin_sql();
+
+	// Rolls back transaction broken by first statement. BEGIN is sent
+	// again with next statement
+	void restore_deferred_begin();
+
 protected:
 	void internal_start() override;
 	void internal_commit() override;
 	void internal_rollback() override;
+	Status internal_try_commit() override;
 
 private:
 	PgLibDataPtr lib_;
 	PgConnectionImplPtr conn_;
 	TransactionParams params_;
-	std::string sql_;
+	std::vector<std::string> begin_commands_;
+	bool begin_is_deferred_ = false;
 
-	void exec(const char *sql);
+	bool exec(const char *sql, Status *status = nullptr);
 };
 
-using PgTransactionImplPtr = std::shared_ptr<PgTransactionImpl>;
-
 
 /* class PgStatementImpl */
 
-class PgStatementImpl :
+class PgStatementImpl final :
 	public PgStatement,
 	public IParameterSetterWithTypeCvt,
 	public IResultGetterWithTypeCvt
 {
 public:
 	PgStatementImpl(const PgLibDataPtr &lib, const PgConnectionImplPtr& conn, const PgTransactionImplPtr& tran);
+	~PgStatementImpl();
+
+	// statements pool
+	void attach(const PgConnectionImplPtr& conn, const PgTransactionImplPtr& tran);
+	PgConnectionImplPtr detach();
 
 	// impl. Statement
 	TransactionPtr get_transaction() override;
 
 	void prepare(std::string_view sql, bool use_native_parameters_syntax) override;
 	void prepare(std::wstring_view sql, bool use_native_parameters_syntax) override;
+	void prepare_with_types(std::string_view sql, const std::vector<Oid> &param_types, bool use_native_parameters_syntax) override;
+	void prepare_with_value_types(std::string_view sql, const std::vector<ValueType> &param_types, bool use_native_parameters_syntax) override;
 
 	void execute(std::string_view sql) override;
 	void execute(std::wstring_view sql) override;
@@ -427,6 +707,7 @@ public:
 	StatementType get_type() override;
 
 	void execute() override;
+	Status try_execute() override;
 
 	size_t get_changes_count() override;
 	int64_t get_last_row_id() override;
@@ -434,6 +715,7 @@ public:
 	std::string get_last_sql() const override;
 
 	bool fetch() override;
+	Status try_fetch() override;
 
 	size_t get_params_count() const override;
 	ValueType get_param_type(const IndexOrName& param) override;
@@ -451,6 +733,8 @@ public:
 
 	void set_blob(const IndexOrName& param, const char* blob_data, size_t blob_size) override;
 
+	ParamValues get_param_values() override;
+
 	size_t get_columns_count() override;
 	ValueType get_column_type(const IndexOrName& colum) override;
 	std::string get_column_name(size_t index) override;
@@ -469,6 +753,8 @@ public:
 	size_t get_blob_size(const IndexOrName& column) override;
 	void get_blob_data(const IndexOrName& column, char* dst, size_t size) override;
 
+	size_t fetch_columnar(ResultSet& result, size_t max_rows) override;
+
 	// impl. IParameterSetterWithTypeCvt
 	void set_int16_impl(size_t index, int16_t value) override;
 	void set_int32_impl(size_t index, int32_t value) override;
@@ -490,36 +776,78 @@ public:
 	// impl. PgStatement
 	void put_copy_data(const char* data, int data_len) override;
 	void put_buffer(const PgBuffer& buffer) override;
+	void set_cursor_mode(const PgCursorParams &params) override;
+	void reset_cursor_mode() override;
+	bool is_cursor_mode() const override;
+	std::optional<bool> get_bool_opt(const IndexOrName &column) override;
+	void set_bool_opt(const IndexOrName &param, std::optional<bool> value) override;
+	std::optional<PgUuid> get_uuid_opt(const IndexOrName &column) override;
+	void set_uuid_opt(const IndexOrName &param, const std::optional<PgUuid> &value) override;
+	std::string_view get_json_view(const IndexOrName &column) override;
+	void set_json(const IndexOrName &param, std::string_view json) override;
 
 private:
-	struct ParamValue
+	struct ParamData
 	{
 		static constexpr unsigned FixedBufferSize = 8;
 		std::array<char, FixedBufferSize> fixed_buffer;
 		std::vector<char> str;
 	};
 
-	using ParamValues = std::vector<ParamValue>;
+	using ParamDataItems = std::vector<ParamData>;
 
 	PgLibDataPtr lib_;
 	PgConnectionImplPtr conn_;
 	PgTransactionImplPtr tran_;
 	std::string sql_buffer_;
+	std::string last_sql_; // as passed by user, sql_buffer_ can be wrapped into cursor
+	bool last_sql_is_native_ = false;
 	SqlPreprocessor sql_preprocessor_;
 	PGresultHandler result_;
 	StmtState state_ = StmtState::Undef;
 	bool result_contains_first_row_data_ = false;
 	bool contains_data_ = false;
 	std::vector<Oid> param_types_;
-	ParamValues param_data_;
+	ParamDataItems param_data_;
 	std::vector <const char*> param_values_;
 	std::vector<int> param_lengths_;
 	std::vector<int> param_formats_;
 	std::string utf16_to_utf8_buffer_;
 	std::wstring utf8_to_utf16_buffer_;
+	std::string text_buffer_;
 	ColumnsHelper columns_helper_;
-
-	void fetch_and_check_if_result_is_end_of_tuples();
+	std::vector<Oid> column_oids_;
+	int row_ = 0;
+	std::optional<PgCursorParams> cursor_params_;
+	std::string cursor_name_;
+	std::string cursor_sql_;
+	std::string stmt_name_; // not empty for statement prepared as cursor or cached
+	std::string cached_stmt_key_;
+	bool stmt_is_cached_ = false;
+	bool cursor_is_declared_ = false;
+	bool cursor_is_open_ = false;
+	bool cursor_has_more_rows_ = false;
+	int cursor_rows_count_ = 0;
+	int cursor_fetch_size_ = 0;
+
+	void prepare_impl(std::string_view sql, bool use_native_parameters_syntax, const std::vector<Oid> *param_types);
+	void prepare_and_describe(std::string_view sql, const std::vector<Oid> *param_types);
+	void prepare_and_describe_pipelined(std::string_view sql, const std::vector<Oid> *param_types);
+	void prepare_without_describe(std::string_view sql, const std::vector<Oid> &param_types);
+	void execute_impl(std::string_view sql);
+	bool execute_prepared_impl(Status *status = nullptr, bool prepare_if_stmt_is_lost = true);
+	bool prepare_lost_stmt_and_execute(bool begin_is_pipelined, Status *status);
+	bool execute_traced(Status *status);
+	bool fetch_impl(Status *status = nullptr);
+	bool fetch_traced(Status *status);
+	size_t get_result_changes_count();
+	size_t get_row_bytes();
+	bool fetch_and_check_if_result_is_end_of_tuples(Status *status = nullptr);
+	bool check_if_result_is_end_of_tuples(Status *status);
+	void wrap_sql_into_cursor();
+	void fetch_cursor_batch();
+	void close_cursor(bool check_if_exists);
+	void deallocate_named_stmt();
 
 	template <typename T>
 	void set_value_parameter(size_t param_index, T value);
@@ -527,9 +855,13 @@ private:
 	template <typename T>
 	void set_param_opt_impl(const IndexOrName& param, const std::optional<T>& value);
 
+	template <typename T>
+	bool set_param_without_cvt(size_t param_index, const T& value);
+
 	void check_is_in_executed_state() const;
 	void check_is_in_prepared_or_executed_state() const;
 	void check_contains_data() const;
+	void check_columns_are_known();
 
 	bool is_null_impl(size_t col_index);
 
@@ -547,6 +879,43 @@ private:
 	template<typename T>
 	T get_value_impl(size_t col_index);
 
+	std::string_view get_text_view(size_t col_index);
+	void set_text_impl(size_t index, std::string_view text);
+
+};
+
+
+/* class PgNotificationListenerImpl */
+
+class PgNotificationListenerImpl final : public PgNotificationListener
+{
+public:
+	PgNotificationListenerImpl(const PgLibDataPtr &lib, const PgConnectionImplPtr &conn, const PgListenerParams &params);
+
+	void listen(std::string_view channel, const PgNotificationHandler &handler) override;
+	void unlisten(std::string_view channel) override;
+	void set_reconnect_handler(const std::function<void()> &handler) override;
+	size_t wait(int timeout_ms) override;
+	size_t dispatch() override;
+	size_t get_reconnects_count() const override;
+
+private:
+	using Handlers = std::map<std::string, PgNotificationHandler, std::less<>>;
+
+	PgLibDataPtr lib_;
+	PgConnectionImplPtr conn_;
+	PgListenerParams params_;
+	Handlers handlers_;
+	std::function<void()> reconnect_handler_;
+	size_t reconnects_count_ = 0;
+	std::vector<PgNotification> received_;
+
+	void exec(const char *command, std::string_view channel);
+	bool is_connection_lost();
+	void reconnect();
+	bool consume_input();
+	bool wait_for_socket(int timeout_ms);
+	size_t dispatch_received();
 };
 
 // ":aaa ?3 :aaa" -> "$1 $2 $1"
@@ -590,21 +959,25 @@ private:
 
 using Statuses = std::initializer_list<ExecStatusType>;
 
-static void check_result_status(
+// check_result_status and check_ret_code throw exception if status is null
+// or store error in status and return false
+
+static bool check_result_status(
 	const PgApi      &api,
 	const PGconn     *conn,
 	const PGresult   *res,
 	const char       *fun_name,
 	Statuses         ok_statuses,
 	std::string_view sql,
-	ErrorType        error_type)
+	ErrorType        error_type,
+	Status           *status = nullptr)
 {
-	if (res == nullptr) return;
+	if (res == nullptr) return true;
 
 	auto res_status = api.f_PQresultStatus(res);
 
 	auto it = std::find(ok_statuses.begin(), ok_statuses.end(), res_status);
-	if (it != ok_statuses.end()) return;
+	if (it != ok_statuses.end()) return true;
 
 	auto conn_status = api.f_PQstatus(conn);
 
@@ -620,6 +993,20 @@ static void check_result_status(
 	const char* res_status_str = api.f_PQresStatus(res_status);
 	const char* res_verb_error_str = api.f_PQresultVerboseErrorMessage(res, PQERRORS_VERBOSE, PQSHOW_CONTEXT_ALWAYS);
 
+	if (status)
+	{
+		*status = Status(
+			error_type,
+			(int)res_status,
+			-1,
+			fun_name,
+			res_status_str,
+			sql_code,
+			res_verb_error_str ? res_verb_error_str : std::string_view{}
+		);
+		return false;
+	}
+
 	throw_exception(
 		fun_name,
 		(int)res_status,
@@ -634,17 +1021,18 @@ static void check_result_status(
 
 using OkCodes = std::initializer_list<int>;
 
-static void check_ret_code(
+static bool check_ret_code(
 	const PgApi      &api,
 	const PGconn     *conn,
 	int              ret_code,
 	const char       *fun_name,
 	OkCodes          ok_codes,
 	std::string_view sql,
-	ErrorType        error_type)
+	ErrorType        error_type,
+	Status           *status = nullptr)
 {
 	auto it = std::find(ok_codes.begin(), ok_codes.end(), ret_code);
-	if (it != ok_codes.end()) return;
+	if (it != ok_codes.end()) return true;
 
 	switch (api.f_PQstatus(conn))
 	{
@@ -658,6 +1046,20 @@ static void check_ret_code(
 
 	const char* err_msg = api.f_PQerrorMessage(conn);
 
+	if (status)
+	{
+		*status = Status(
+			error_type,
+			(int)ret_code,
+			-1,
+			fun_name,
+			nullptr,
+			{},
+			err_msg ? err_msg : std::string_view{}
+		);
+		return false;
+	}
+
 	throw_exception(
 		fun_name,
 		(int)ret_code,
@@ -670,6 +1072,47 @@ static void check_ret_code(
 	);
 }
 
+// PQexec returns null if query is not sent. For example in pipeline
+// mode so connection must leave it by skip_previous_data before PQexec
+
+static bool check_exec_result(
+	const PgApi      &api,
+	const PGconn     *conn,
+	const PGresult   *res,
+	Statuses         ok_statuses,
+	std::string_view sql,
+	ErrorType        error_type,
+	Status           *status = nullptr)
+{
+	if (res == nullptr)
+		return check_ret_code(api, conn, 0, "PQexec", { 1 }, sql, error_type, status);
+
+	return check_result_status(api, conn, res, "PQexec", ok_statuses, sql, error_type, status);
+}
+
+// SQLSTATE 26000 - prepared statement does not exist
+
+static bool is_stmt_lost_error(const PgApi &api, const PGresult *res)
+{
+	if (!res || (api.f_PQresultStatus(res) != PGRES_FATAL_ERROR)) return false;
+	const char *sql_state = api.f_PQresultErrorField(res, PG_DIAG_SQLSTATE);
+	return sql_state && (std::string_view(sql_state) == "26000");
+}
+
+static bool is_copy_sql(std::string_view sql)
+{
+	auto pos = sql.find_first_not_of(" \t\r\n");
+	if (pos == std::string_view::npos) return false;
+
+	auto word = sql.substr(pos, 5);
+	if (word.size() < 4) return false;
+
+	for (size_t i = 0; i < 4; i++)
+		if (tolower((unsigned char)word[i]) != "copy"[i]) return false;
+
+	return (word.size() == 4) || !isalnum((unsigned char)word[4]);
+}
+
 static ValueType oid_to_value_type(Oid uid)
 {
 	switch (uid)
@@ -704,7 +1147,21 @@ static ValueType oid_to_value_type(Oid uid)
 		return ValueType::Time;
 
 	case TIMESTAMPOID:
+	case TIMESTAMPTZOID: // in UTC
 		return ValueType::Timestamp;
+
+	case BOOLOID:
+		return ValueType::Boolean;
+
+	case BYTEAOID:
+		return ValueType::Blob;
+
+	// converted into text on client side
+	case JSONOID:
+	case JSONBOID:
+	case UUIDOID:
+	case NUMERICOID:
+		return ValueType::Varchar;
 	}
 
 	throw InternalException(
@@ -714,6 +1171,29 @@ static ValueType oid_to_value_type(Oid uid)
 	);
 }
 
+static Oid value_type_to_oid(ValueType type)
+{
+	switch (type)
+	{
+	case ValueType::Short:     return INT2OID;
+	case ValueType::Integer:   return INT4OID;
+	case ValueType::BigInt:    return INT8OID;
+	case ValueType::Float:     return FLOAT4OID;
+	case ValueType::Double:    return FLOAT8OID;
+	case ValueType::Char:      return BPCHAROID;
+	case ValueType::Varchar:   return VARCHAROID;
+	case ValueType::Boolean:   return BOOLOID;
+	case ValueType::Date:      return DATEOID;
+	case ValueType::Time:      return TIMEOID;
+	case ValueType::Timestamp: return TIMESTAMPOID;
+	case ValueType::Blob:      return BYTEAOID;
+	case ValueType::Any:       return 0; // inferred by server
+
+	default:
+		throw WrongArgumentException("Type of parameter is not supported in prepare_with_value_types");
+	}
+}
+
 const int64_t USecsInDay = 24LL * 60LL * 60LL * 1000LL * 1000LL;
 const int DaysBetweenJDayAnd2000Year = 2451545;
 
@@ -803,84 +1283,335 @@ TimeStamp pg_ts_to_dblib_ts(int64_t pg_ts)
 	return result;
 }
 
-/* class PgLib */
+// Binary format of numeric: ndigits, weight, sign, dscale (int16 each) and
+// ndigits of base 10000 digits. Value = sum(digit[i] * 10000^(weight-i))
 
-PgLib::~PgLib()
-{}
+constexpr uint16_t NumericPos = 0x0000;
+constexpr uint16_t NumericNeg = 0x4000;
+constexpr uint16_t NumericNaN = 0xC000;
+constexpr uint16_t NumericPInf = 0xD000;
+constexpr uint16_t NumericNInf = 0xF000;
+constexpr size_t NumericHeaderSize = 8;
+constexpr int NumericMaxDScale = 0x3FFF;
 
+std::string pg_numeric_to_str(const char *data, size_t size)
+{
+	if (size < NumericHeaderSize)
+		throw InternalException("Wrong size of numeric value", (int)size, 0);
 
-/* class PgLibImpl */
+	int ndigits = read_value_from_bytes_be<int16_t>(data);
+	int weight = read_value_from_bytes_be<int16_t>(data + 2);
+	uint16_t sign = read_value_from_bytes_be<uint16_t>(data + 4);
+	int dscale = read_value_from_bytes_be<int16_t>(data + 6);
 
-PgLibImpl::PgLibImpl()
-{
-	lib_ = std::make_shared<PgLibData>();
-}
+	if ((ndigits < 0) || (size < NumericHeaderSize + 2 * (size_t)ndigits))
+		throw InternalException("Wrong size of numeric value", (int)size, ndigits);
 
-void PgLibImpl::load(const FileName &dyn_lib_file_name)
-{
-	auto& module = lib_->module;
-	auto& api = lib_->api;
+	switch (sign)
+	{
+	case NumericNaN:
+		return "NaN";
 
-	if (module.is_loaded()) return;
+	case NumericPInf:
+		return "Infinity";
 
-	auto file_name = dyn_lib_file_name;
+	case NumericNInf:
+		return "-Infinity";
+	}
 
-#if defined(DBLIB_WINDOWS)
-	if (file_name.empty())
-		file_name = L"libpq.dll";
-#elif defined(DBLIB_LINUX)
-	if (file_name.empty())
-		file_name = "libpq.so";
-#endif
+	auto get_digit = [&](int index) -> int
+	{
+		if ((index < 0) || (index >= ndigits)) return 0;
+		return read_value_from_bytes_be<int16_t>(data + NumericHeaderSize + 2 * index);
+	};
 
-	module.load(file_name);
+	std::string result;
 
-	module.load_func(api.f_PQconnectdbParams,           "PQconnectdbParams");
-	module.load_func(api.f_PQfinish,                    "PQfinish");
-	module.load_func(api.f_PQstatus,                    "PQstatus");
-	module.load_func(api.f_PQerrorMessage,              "PQerrorMessage");
-	module.load_func(api.f_PQexec,                      "PQexec");
-	module.load_func(api.f_PQprepare,                   "PQprepare");
-	module.load_func(api.f_PQsendQueryParams,           "PQsendQueryParams");
-	module.load_func(api.f_PQsendQueryPrepared,         "PQsendQueryPrepared");
-	module.load_func(api.f_PQsetSingleRowMode,          "PQsetSingleRowMode");
-	module.load_func(api.f_PQgetResult,                 "PQgetResult");
-	module.load_func(api.f_PQresultStatus,              "PQresultStatus");
-	module.load_func(api.f_PQresStatus,                 "PQresStatus");
-	module.load_func(api.f_PQresultErrorMessage,        "PQresultErrorMessage");
-	module.load_func(api.f_PQresultVerboseErrorMessage, "PQresultVerboseErrorMessage");
-	module.load_func(api.f_PQresultErrorField,          "PQresultErrorField");
-	module.load_func(api.f_PQntuples,                   "PQntuples");
-	module.load_func(api.f_PQnfields,                   "PQnfields");
-	module.load_func(api.f_PQbinaryTuples,              "PQbinaryTuples");
-	module.load_func(api.f_PQfname,                     "PQfname");
-	module.load_func(api.f_PQftype,                     "PQftype");
-	module.load_func(api.f_PQfsize,                     "PQfsize");
-	module.load_func(api.f_PQcmdTuples,                 "PQcmdTuples");
-	module.load_func(api.f_PQgetvalue,                  "PQgetvalue");
-	module.load_func(api.f_PQgetlength,                 "PQgetlength");
-	module.load_func(api.f_PQgetisnull,                 "PQgetisnull");
-	module.load_func(api.f_PQnparams,                   "PQnparams");
-	module.load_func(api.f_PQparamtype,                 "PQparamtype");
-	module.load_func(api.f_PQdescribePrepared,          "PQdescribePrepared");
-	module.load_func(api.f_PQclear,                     "PQclear");
-	module.load_func(api.f_PQputCopyData,               "PQputCopyData");
-	module.load_func(api.f_PQputCopyEnd,                "PQputCopyEnd");
-}
+	auto append_4_chars = [&](int digit)
+	{
+		result.push_back(char('0' + digit / 1000));
+		result.push_back(char('0' + digit / 100 % 10));
+		result.push_back(char('0' + digit / 10 % 10));
+		result.push_back(char('0' + digit % 10));
+	};
 
-bool PgLibImpl::is_loaded() const
-{
-	return lib_->module.is_loaded();
-}
+	if (sign == NumericNeg) result.push_back('-');
 
-const PgApi& PgLibImpl::get_api()
-{
-	return lib_->api;
-}
+	if (weight < 0)
+		result.push_back('0');
+	else
+	{
+		result.append(std::to_string(get_digit(0)));
+		for (int i = 1; i <= weight; i++)
+			append_4_chars(get_digit(i));
+	}
 
-PgConnectionPtr PgLibImpl::create_connection(const PgConnectParams& connect_params)
-{
-	return std::make_shared<PgConnectionImpl>(lib_, connect_params);
+	if (dscale > 0)
+	{
+		result.push_back('.');
+		size_t frac_pos = result.size();
+		for (int i = weight + 1; result.size() - frac_pos < (size_t)dscale; i++)
+			append_4_chars(get_digit(i));
+		result.resize(frac_pos + dscale);
+	}
+
+	return result;
+}
+
+bool str_to_pg_numeric(std::string_view text, std::vector<char> &result)
+{
+	auto write_header = [&](int ndigits, int weight, uint16_t sign, int dscale)
+	{
+		result.resize(NumericHeaderSize + 2 * ndigits);
+		write_value_into_bytes_be((int16_t)ndigits, result.data());
+		write_value_into_bytes_be((int16_t)weight, result.data() + 2);
+		write_value_into_bytes_be(sign, result.data() + 4);
+		write_value_into_bytes_be((int16_t)dscale, result.data() + 6);
+	};
+
+	if (text == "NaN")
+	{
+		write_header(0, 0, NumericNaN, 0);
+		return true;
+	}
+
+	uint16_t sign = NumericPos;
+	if (!text.empty() && ((text.front() == '-') || (text.front() == '+')))
+	{
+		if (text.front() == '-') sign = NumericNeg;
+		text.remove_prefix(1);
+	}
+
+	auto point_pos = text.find('.');
+	std::string_view int_part = text.substr(0, point_pos);
+	std::string_view frac_part = (point_pos != std::string_view::npos) ? text.substr(point_pos + 1) : std::string_view{};
+
+	auto is_digits = [](std::string_view str)
+	{
+		return std::all_of(str.begin(), str.end(), [](char chr) { return (chr >= '0') && (chr <= '9'); });
+	};
+
+	if ((int_part.empty() && frac_part.empty()) || !is_digits(int_part) || !is_digits(frac_part))
+		return false;
+
+	if (frac_part.size() > (size_t)NumericMaxDScale)
+		return false;
+
+	while (!int_part.empty() && (int_part.front() == '0')) int_part.remove_prefix(1);
+
+	// text is aligned to groups of 4 chars by zeros at left and right
+	int int_groups = int((int_part.size() + 3) / 4);
+	int frac_groups = int((frac_part.size() + 3) / 4);
+	size_t left_pad = 4 * int_groups - int_part.size();
+
+	auto get_char_digit = [&](size_t pos) -> int
+	{
+		if (pos < left_pad) return 0;
+		pos -= left_pad;
+		if (pos < int_part.size()) return int_part[pos] - '0';
+		pos -= int_part.size();
+		if (pos < frac_part.size()) return frac_part[pos] - '0';
+		return 0;
+	};
+
+	auto get_digit = [&](int group)
+	{
+		int digit = 0;
+		for (int i = 0; i < 4; i++)
+			digit = digit * 10 + get_char_digit(4 * group + i);
+		return digit;
+	};
+
+	int first = 0;
+	int last = int_groups + frac_groups - 1;
+	while ((first <= last) && (get_digit(first) == 0)) first++;
+	while ((last >= first) && (get_digit(last) == 0)) last--;
+
+	if (first > last)
+	{
+		write_header(0, 0, NumericPos, (int)frac_part.size());
+		return true;
+	}
+
+	write_header(last - first + 1, int_groups - 1 - first, sign, (int)frac_part.size());
+	char *digits_data = result.data() + NumericHeaderSize;
+	for (int group = first; group <= last; group++, digits_data += 2)
+		write_value_into_bytes_be((int16_t)get_digit(group), digits_data);
+
+	return true;
+}
+
+std::string pg_uuid_to_str(const PgUuid &uuid)
+{
+	static const char hex_chars[] = "0123456789abcdef";
+
+	std::string result;
+	result.reserve(36);
+	for (size_t i = 0; i < uuid.size(); i++)
+	{
+		if ((i == 4) || (i == 6) || (i == 8) || (i == 10)) result.push_back('-');
+		result.push_back(hex_chars[uuid[i] >> 4]);
+		result.push_back(hex_chars[uuid[i] & 0xF]);
+	}
+	return result;
+}
+
+bool str_to_pg_uuid(std::string_view text, PgUuid &result)
+{
+	auto hex_to_int = [](char chr) -> int
+	{
+		if ((chr >= '0') && (chr <= '9')) return chr - '0';
+		if ((chr >= 'a') && (chr <= 'f')) return chr - 'a' + 10;
+		if ((chr >= 'A') && (chr <= 'F')) return chr - 'A' + 10;
+		return -1;
+	};
+
+	size_t pos = 0;
+	for (auto &byte : result)
+	{
+		// hyphens are allowed between bytes
+		if ((pos != 0) && (pos < text.size()) && (text[pos] == '-'))
+			pos++;
+
+		if (pos + 2 > text.size()) return false;
+		int high = hex_to_int(text[pos]);
+		int low = hex_to_int(text[pos + 1]);
+		if ((high < 0) || (low < 0)) return false;
+		byte = uint8_t(high * 16 + low);
+		pos += 2;
+	}
+
+	return pos == text.size();
+}
+
+// text of value in binary format (numeric and uuid are formatted into buffer)
+static std::string_view pg_value_to_text(Oid oid, const char *value, size_t len, std::string &buffer)
+{
+	switch (oid)
+	{
+	case JSONBOID:
+		if ((len == 0) || (value[0] != JsonbVersion))
+			throw InternalException("Unsupported version of jsonb", len ? value[0] : -1, 0);
+		return { value + 1, len - 1 };
+
+	case UUIDOID:
+	{
+		if (len != sizeof(PgUuid))
+			throw InternalException("Wrong size of uuid value", (int)len, 0);
+		PgUuid uuid;
+		memcpy(uuid.data(), value, uuid.size());
+		buffer = pg_uuid_to_str(uuid);
+		return buffer;
+	}
+
+	case NUMERICOID:
+		buffer = pg_numeric_to_str(value, len);
+		return buffer;
+
+	case BOOLOID:
+		return (len != 0) && value[0] ? "true" : "false";
+	}
+
+	return { value, len };
+}
+
+/* struct PgApi */
+
+bool PgApi::supports_pipeline_mode() const
+{
+	return f_PQenterPipelineMode && f_PQexitPipelineMode && f_PQpipelineSync;
+}
+
+
+/* class PgLib */
+
+PgLib::~PgLib()
+{}
+
+
+/* class PgLibImpl */
+
+PgLibImpl::PgLibImpl()
+{
+	lib_ = std::make_shared<PgLibData>();
+}
+
+void PgLibImpl::load(const FileName &dyn_lib_file_name)
+{
+	auto& module = lib_->module;
+	auto& api = lib_->api;
+
+	if (module.is_loaded()) return;
+
+	auto file_name = dyn_lib_file_name;
+
+#if defined(DBLIB_WINDOWS)
+	if (file_name.empty())
+		file_name = L"libpq.dll";
+#elif defined(DBLIB_LINUX)
+	if (file_name.empty())
+		file_name = "libpq.so";
+#endif
+
+	module.load(file_name);
+
+	module.load_func(api.f_PQconnectdbParams,           "PQconnectdbParams");
+	module.load_func(api.f_PQfinish,                    "PQfinish");
+	module.load_func(api.f_PQstatus,                    "PQstatus");
+	module.load_func(api.f_PQtransactionStatus,         "PQtransactionStatus");
+	module.load_func(api.f_PQerrorMessage,              "PQerrorMessage");
+	module.load_func(api.f_PQexec,                      "PQexec");
+	module.load_func(api.f_PQprepare,                   "PQprepare");
+	module.load_func(api.f_PQsendQueryParams,           "PQsendQueryParams");
+	module.load_func(api.f_PQsendQueryPrepared,         "PQsendQueryPrepared");
+	module.load_func(api.f_PQsetSingleRowMode,          "PQsetSingleRowMode");
+	module.load_func(api.f_PQgetResult,                 "PQgetResult");
+	module.load_func(api.f_PQresultStatus,              "PQresultStatus");
+	module.load_func(api.f_PQresStatus,                 "PQresStatus");
+	module.load_func(api.f_PQresultErrorMessage,        "PQresultErrorMessage");
+	module.load_func(api.f_PQresultVerboseErrorMessage, "PQresultVerboseErrorMessage");
+	module.load_func(api.f_PQresultErrorField,          "PQresultErrorField");
+	module.load_func(api.f_PQntuples,                   "PQntuples");
+	module.load_func(api.f_PQnfields,                   "PQnfields");
+	module.load_func(api.f_PQbinaryTuples,              "PQbinaryTuples");
+	module.load_func(api.f_PQfname,                     "PQfname");
+	module.load_func(api.f_PQftype,                     "PQftype");
+	module.load_func(api.f_PQfsize,                     "PQfsize");
+	module.load_func(api.f_PQcmdTuples,                 "PQcmdTuples");
+	module.load_func(api.f_PQgetvalue,                  "PQgetvalue");
+	module.load_func(api.f_PQgetlength,                 "PQgetlength");
+	module.load_func(api.f_PQgetisnull,                 "PQgetisnull");
+	module.load_func(api.f_PQnparams,                   "PQnparams");
+	module.load_func(api.f_PQparamtype,                 "PQparamtype");
+	module.load_func(api.f_PQdescribePrepared,          "PQdescribePrepared");
+	module.load_func(api.f_PQclear,                     "PQclear");
+	module.load_func(api.f_PQputCopyData,               "PQputCopyData");
+	module.load_func(api.f_PQputCopyEnd,                "PQputCopyEnd");
+	module.load_func(api.f_PQnotifies,                  "PQnotifies");
+	module.load_func(api.f_PQconsumeInput,              "PQconsumeInput");
+	module.load_func(api.f_PQsocket,                    "PQsocket");
+	module.load_func(api.f_PQfreemem,                   "PQfreemem");
+	module.load_func(api.f_PQsendPrepare,               "PQsendPrepare");
+	module.load_func(api.f_PQsendDescribePrepared,      "PQsendDescribePrepared");
+
+	module.try_load_func(api.f_PQenterPipelineMode,     "PQenterPipelineMode");
+	module.try_load_func(api.f_PQexitPipelineMode,      "PQexitPipelineMode");
+	module.try_load_func(api.f_PQpipelineSync,          "PQpipelineSync");
+}
+
+bool PgLibImpl::is_loaded() const
+{
+	return lib_->module.is_loaded();
+}
+
+const PgApi& PgLibImpl::get_api()
+{
+	return lib_->api;
+}
+
+PgConnectionPtr PgLibImpl::create_connection(const PgConnectParams& connect_params)
+{
+	return std::make_shared<PgConnectionImpl>(lib_, connect_params);
 }
 
 
@@ -936,7 +1667,10 @@ void PgConnectionImpl::connect()
 	keywords.push_back(nullptr);
 	values.push_back(nullptr);
 
+	count_call(NativeCallType::Connect, true);
 	conn_ = lib_->api.f_PQconnectdbParams(keywords.data(), values.data(), 0);
+	in_pipeline_mode_ = false;
+	cached_stmts_.clear();
 
 	try
 	{
@@ -965,6 +1699,7 @@ void PgConnectionImpl::disconnect()
 
 void PgConnectionImpl::disconnect_impl()
 {
+	count_call(NativeCallType::Connect, false);
 	lib_->api.f_PQfinish(conn_);
 	conn_ = nullptr;
 }
@@ -1003,8 +1738,9 @@ void PgConnectionImpl::direct_execute(std::string_view sql)
 
 	auto exec_impl = [this](const char* sql)
 	{
-		auto result = lib_->api.f_PQexec(conn_, sql);
-		check_result_status(lib_->api, conn_, result, "PQexec", { PGRES_COMMAND_OK }, sql, ErrorType::Normal);
+		count_call(NativeCallType::Execute, true, strlen(sql));
+		PGresultHandler result(lib_->api, lib_->api.f_PQexec(conn_, sql));
+		check_exec_result(lib_->api, conn_, result.get(), { PGRES_COMMAND_OK }, sql, ErrorType::Normal);
 	};
 
 	exec_impl(direct_execute_buffer_.c_str());
@@ -1016,6 +1752,64 @@ std::string PgConnectionImpl::get_driver_name() const
 	return "postgresql";
 }
 
+ConnectionStats PgConnectionImpl::get_connection_stats() const
+{
+	return stats_;
+}
+
+void PgConnectionImpl::reset_connection_stats()
+{
+	stats_ = {};
+}
+
+void PgConnectionImpl::set_statements_pool_size(size_t max_size)
+{
+	statements_pool_.set_max_size(max_size);
+}
+
+StatementsPoolStats PgConnectionImpl::get_statements_pool_stats() const
+{
+	return statements_pool_.get_stats();
+}
+
+std::shared_ptr<PgStatementImpl> PgConnectionImpl::create_statement_impl(const PgTransactionImplPtr& tran)
+{
+	if (!statements_pool_.is_enabled())
+		return std::make_shared<PgStatementImpl>(lib_, shared_from_this(), tran);
+
+	auto stmt = statements_pool_.acquire();
+	if (stmt)
+		stmt->attach(shared_from_this(), tran);
+	else
+		stmt = std::make_unique<PgStatementImpl>(lib_, shared_from_this(), tran);
+
+	return statements_pool_.make_shared_ptr(std::move(stmt), &PgConnectionImpl::release_statement);
+}
+
+void PgConnectionImpl::release_statement(PgStatementImpl* stmt)
+{
+	std::unique_ptr<PgStatementImpl> holder(stmt);
+	if (auto conn = stmt->detach())
+		conn->statements_pool_.release(std::move(holder));
+}
+
+void PgConnectionImpl::count_call(NativeCallType type, bool round_trip, size_t sent_bytes)
+{
+	count_native_call(stats_, type, round_trip, sent_bytes);
+}
+
+void PgConnectionImpl::count_result(PGresult* result)
+{
+	if (result == nullptr) return;
+
+	auto &api = lib_->api;
+	int rows_count = api.f_PQntuples(result);
+	int columns_count = api.f_PQnfields(result);
+	for (int row = 0; row < rows_count; row++)
+		for (int col = 0; col < columns_count; col++)
+			stats_.result_bytes += api.f_PQgetlength(result, row, col);
+}
+
 PGconn* PgConnectionImpl::get_connection()
 {
 	check_is_connected();
@@ -1034,15 +1828,144 @@ PgTransactionPtr PgConnectionImpl::create_pg_transaction(const TransactionParams
 	return tran;
 }
 
+PgNotificationListenerPtr PgConnectionImpl::create_notification_listener(const PgListenerParams &params)
+{
+	check_is_connected();
+	return std::make_shared<PgNotificationListenerImpl>(lib_, shared_from_this(), params);
+}
+
 void PgConnectionImpl::skip_previous_data()
 {
+	if (in_pipeline_mode_)
+	{
+		exit_pipeline_mode();
+		return;
+	}
+
 	for (;;)
 	{
+		count_call(NativeCallType::Fetch, false);
 		PGresultHandler res(lib_->api, lib_->api.f_PQgetResult(conn_));
 		if (res.get() == nullptr) break;
 	}
 }
 
+void PgConnectionImpl::enter_pipeline_mode()
+{
+	int res = lib_->api.f_PQenterPipelineMode(conn_);
+	check_ret_code(lib_->api, conn_, res, "PQenterPipelineMode", { 1 }, {}, ErrorType::Normal);
+	in_pipeline_mode_ = true;
+	pipeline_is_synced_ = false;
+}
+
+bool PgConnectionImpl::sync_pipeline(Status *status)
+{
+	pipeline_is_synced_ = true;
+	int res = lib_->api.f_PQpipelineSync(conn_);
+	return check_ret_code(lib_->api, conn_, res, "PQpipelineSync", { 1 }, {}, ErrorType::Normal, status);
+}
+
+const std::string& PgConnectionImpl::acquire_cached_stmt(const std::string &key, bool &is_prepared)
+{
+	auto it = cached_stmts_.find(key);
+	is_prepared = (it != cached_stmts_.end());
+
+	if (!is_prepared)
+	{
+		if (cached_stmts_.size() >= CachedStmtsMaxCount)
+			evict_cached_stmt();
+
+		CachedStmt stmt;
+		stmt.name = "dblib_stmt_" + std::to_string(++cached_stmts_counter_);
+		it = cached_stmts_.emplace(key, std::move(stmt)).first;
+	}
+
+	it->second.users_count++;
+	it->second.last_use = ++cached_stmts_use_counter_;
+	return it->second.name;
+}
+
+// name is checked because cache may be reset while statement is used
+
+void PgConnectionImpl::release_cached_stmt(const std::string &key, const std::string &name)
+{
+	auto it = cached_stmts_.find(key);
+	if ((it != cached_stmts_.end()) && (it->second.name == name) && (it->second.users_count != 0))
+		it->second.users_count--;
+}
+
+void PgConnectionImpl::remove_cached_stmt(const std::string &key)
+{
+	cached_stmts_.erase(key);
+}
+
+void PgConnectionImpl::evict_cached_stmt()
+{
+	auto lru = cached_stmts_.end();
+	for (auto it = cached_stmts_.begin(); it != cached_stmts_.end(); ++it)
+	{
+		if (it->second.users_count != 0) continue;
+		if ((lru == cached_stmts_.end()) || (it->second.last_use < lru->second.last_use))
+			lru = it;
+	}
+
+	// all statements are in use
+	if (lru == cached_stmts_.end()) return;
+
+	std::string sql = "DEALLOCATE " + lru->second.name;
+	cached_stmts_.erase(lru);
+
+	auto &api = lib_->api;
+	skip_previous_data();
+	count_call(NativeCallType::Prepare, true, sql.size());
+	PGresultHandler result(api, api.f_PQexec(conn_, sql.c_str()));
+
+	// statement is already deallocated by DISCARD ALL or DEALLOCATE ALL.
+	// Error is not reported if it doesn't break transaction
+	if (is_stmt_lost_error(api, result.get()))
+	{
+		reset_cached_stmts();
+		if (api.f_PQtransactionStatus(conn_) != PQTRANS_INERROR) return;
+	}
+
+	check_exec_result(api, conn_, result.get(), { PGRES_COMMAND_OK }, sql, ErrorType::Normal);
+}
+
+// statements with new names are prepared after reset
+
+void PgConnectionImpl::reset_cached_stmts()
+{
+	cached_stmts_.clear();
+}
+
+// Skips unread results of pipeline till result of sync. Null is returned
+// once after results of each command, two nulls in a row mean that server
+// sends nothing more (connection is lost)
+void PgConnectionImpl::exit_pipeline_mode()
+{
+	auto &api = lib_->api;
+
+	in_pipeline_mode_ = false;
+	if (!pipeline_is_synced_)
+		api.f_PQpipelineSync(conn_);
+
+	for (bool prev_is_null = false;;)
+	{
+		count_call(NativeCallType::Fetch, false);
+		PGresultHandler res(api, api.f_PQgetResult(conn_));
+		if (res.get() == nullptr)
+		{
+			if (prev_is_null) break;
+			prev_is_null = true;
+			continue;
+		}
+		prev_is_null = false;
+		if (api.f_PQresultStatus(res.get()) == PgresPipelineSync) break;
+	}
+
+	api.f_PQexitPipelineMode(conn_);
+}
+
 void PgConnectionImpl::check_is_connected()
 {
 	if (!is_connected())
@@ -1085,108 +2008,288 @@ StatementPtr PgTransactionImpl::create_statement()
 
 void PgTransactionImpl::internal_start()
 {
-	sql_ = "BEGIN TRANSACTION";
+	std::string sql = "BEGIN TRANSACTION";
 
 	switch (params_.level)
 	{
 	case TransactionLevel::Serializable:
-		sql_.append(" ISOLATION LEVEL SERIALIZABLE");
+		sql.append(" ISOLATION LEVEL SERIALIZABLE");
 		break;
 
 	case TransactionLevel::RepeatableRead:
-		sql_.append(" ISOLATION LEVEL REPEATABLE READ");
+		sql.append(" ISOLATION LEVEL REPEATABLE READ");
 		break;
 
 	case TransactionLevel::ReadCommitted:
-		sql_.append(" ISOLATION LEVEL READ COMMITTED");
+		sql.append(" ISOLATION LEVEL READ COMMITTED");
 		break;
 
 	case TransactionLevel::DirtyRead:
-		sql_.append(" ISOLATION LEVEL READ UNCOMMITTED");
+		sql.append(" ISOLATION LEVEL READ UNCOMMITTED");
 		break;
 	}
 
 	switch (params_.access)
 	{
 	case TransactionAccess::Read:
-		sql_.append(" READ ONLY");
+		sql.append(" READ ONLY");
 		break;
 
 	case TransactionAccess::ReadAndWrite:
-		sql_.append(" READ WRITE");
+		sql.append(" READ WRITE");
 		break;
 	}
 
 	// TODO: DEFERRABLE
 
-	exec(sql_.c_str());
+	begin_commands_.clear();
+	begin_commands_.push_back(sql);
 
 	auto lock_time_out = params_.lock_time_out;
 	if (lock_time_out == -1)
 		lock_time_out = conn_->get_default_transaction_lock_timeout();
 
 	if (lock_time_out != -1)
-	{
-		sql_ = "SET LOCAL lock_timeout = '" + std::to_string(lock_time_out) + "s';";
-		exec(sql_.c_str());
-	}
+		begin_commands_.push_back("SET LOCAL lock_timeout = '" + std::to_string(lock_time_out) + "s'");
+
+	begin_is_deferred_ = true;
 }
 
 void PgTransactionImpl::internal_commit()
 {
+	if (std::exchange(begin_is_deferred_, false)) return;
 	exec("COMMIT");
 }
 
 void PgTransactionImpl::internal_rollback()
 {
+	if (std::exchange(begin_is_deferred_, false)) return;
 	exec("ROLLBACK");
 }
 
-void PgTransactionImpl::exec(const char* sql)
+Status PgTransactionImpl::internal_try_commit()
 {
-	conn_->skip_previous_data();
-	auto result = lib_->api.f_PQexec(conn_->get_connection(), sql);
-	check_result_status(lib_->api, conn_->get_connection(), result, "PQexec", { PGRES_COMMAND_OK }, sql, ErrorType::Transaction);
+	Status status;
+	if (std::exchange(begin_is_deferred_, false)) return status;
+	exec("COMMIT", &status);
+	return status;
 }
 
-PgStatementPtr PgTransactionImpl::create_pg_statement()
+// returns true if BEGIN is queued in pipeline. Statement must be queued
+// after it and end_begin_in_pipeline must be called then
+
+bool PgTransactionImpl::begin_in_pipeline(bool statement_can_be_pipelined)
 {
-	return std::make_shared<PgStatementImpl>(
-		lib_,
-		conn_,
-		shared_from_this()
-	);
-}
+	if (!std::exchange(begin_is_deferred_, false)) return false;
 
+	auto &api = lib_->api;
+	if (!statement_can_be_pipelined || !api.supports_pipeline_mode())
+	{
+		for (auto &command : begin_commands_)
+			exec(command.c_str());
+		return false;
+	}
 
-/* class PgStatementImpl */
+	// commands use unnamed statement so statement of PgStatement
+	// prepared as unnamed must be parsed again after them
+	auto conn = conn_->get_connection();
+	conn_->enter_pipeline_mode();
+	for (auto &command : begin_commands_)
+	{
+		conn_->count_call(NativeCallType::Transaction, false, command.size());
+		int res = api.f_PQsendQueryParams(conn, command.c_str(), 0, nullptr, nullptr, nullptr, nullptr, 0);
+		check_ret_code(api, conn, res, "PQsendQueryParams", { 1 }, command, ErrorType::Transaction);
+	}
 
-PgStatementImpl::PgStatementImpl(
-	const PgLibDataPtr&         lib,
-	const PgConnectionImplPtr&  conn,
-	const PgTransactionImplPtr& tran
-) :
-	lib_(lib),
-	conn_(conn),
-	tran_(tran),
-	result_(lib->api),
-	columns_helper_(*this)
-{
+	return true;
 }
 
-TransactionPtr PgStatementImpl::get_transaction()
+bool PgTransactionImpl::end_begin_in_pipeline(Status *status)
 {
-	return tran_;
-}
+	auto &api = lib_->api;
+	auto conn = conn_->get_connection();
 
-void PgStatementImpl::prepare(
-	std::string_view sql,
+	if (!conn_->sync_pipeline(status)) return false;
+	conn_->count_call(NativeCallType::Transaction, true);
+
+	for (auto &command : begin_commands_)
+	{
+		PGresultHandler result(api, api.f_PQgetResult(conn));
+		PGresultHandler(api, api.f_PQgetResult(conn)); // null after results of command
+
+		bool ok = result.get()
+			? check_result_status(api, conn, result.get(), "PQgetResult", { PGRES_COMMAND_OK }, command, ErrorType::Transaction, status)
+			: check_ret_code(api, conn, 0, "PQgetResult", { 1 }, command, ErrorType::Transaction, status);
+
+		if (!ok) return false;
+	}
+
+	return true;
+}
+
+void PgTransactionImpl::restore_deferred_begin()
+{
+	exec("ROLLBACK");
+	begin_is_deferred_ = true;
+}
+
+std::string PgTransactionImpl::take_deferred_begin_sql()
+{
+	std::string result;
+	if (!std::exchange(begin_is_deferred_, false)) return result;
+
+	for (auto &command : begin_commands_)
+	{
+		result.append(command);
+		result.append("; ");
+	}
+
+	conn_->count_call(NativeCallType::Transaction, false, result.size());
+	return result;
+}
+
+bool PgTransactionImpl::exec(const char* sql, Status *status)
+{
+	conn_->skip_previous_data();
+	conn_->count_call(NativeCallType::Transaction, true, strlen(sql));
+	PGresultHandler result(lib_->api, lib_->api.f_PQexec(conn_->get_connection(), sql));
+	return check_exec_result(
+		lib_->api,
+		conn_->get_connection(),
+		result.get(),
+		{ PGRES_COMMAND_OK },
+		sql,
+		ErrorType::Transaction,
+		status
+	);
+}
+
+PgStatementPtr PgTransactionImpl::create_pg_statement()
+{
+	return conn_->create_statement_impl(shared_from_this());
+}
+
+
+/* class PgStatementImpl */
+
+PgStatementImpl::PgStatementImpl(
+	const PgLibDataPtr&         lib,
+	const PgConnectionImplPtr&  conn,
+	const PgTransactionImplPtr& tran
+) :
+	lib_(lib),
+	conn_(conn),
+	tran_(tran),
+	result_(lib->api),
+	columns_helper_(*this)
+{
+}
+
+PgStatementImpl::~PgStatementImpl()
+{
+	try
+	{
+		if (conn_ && conn_->is_connected())
+		{
+			close_cursor(true);
+			deallocate_named_stmt();
+		}
+	}
+	catch (...) {}
+}
+
+TransactionPtr PgStatementImpl::get_transaction()
+{
+	return tran_;
+}
+
+void PgStatementImpl::attach(const PgConnectionImplPtr& conn, const PgTransactionImplPtr& tran)
+{
+	conn_ = conn;
+	tran_ = tran;
+}
+
+// Releases server side objects and resets state. Buffers are kept.
+// Returns nullptr if statement can't be reused
+PgConnectionImplPtr PgStatementImpl::detach()
+{
+	try
+	{
+		if (conn_->is_connected())
+		{
+			close_cursor(true);
+			deallocate_named_stmt();
+		}
+	}
+	catch (...)
+	{
+		return nullptr;
+	}
+
+	result_.set(nullptr);
+	state_ = StmtState::Undef;
+	result_contains_first_row_data_ = false;
+	contains_data_ = false;
+	columns_helper_.clear();
+	sql_preprocessor_.clear();
+	sql_buffer_.clear();
+	last_sql_.clear();
+	last_sql_is_native_ = false;
+	row_ = 0;
+	cursor_params_.reset();
+	cursor_sql_.clear();
+	cursor_is_declared_ = false;
+	cursor_is_open_ = false;
+	cursor_has_more_rows_ = false;
+	cursor_rows_count_ = 0;
+	cursor_fetch_size_ = 0;
+
+	tran_.reset();
+	return std::move(conn_);
+}
+
+void PgStatementImpl::prepare(
+	std::string_view sql,
 	bool             use_native_parameters_syntax)
 {
+	prepare_impl(sql, use_native_parameters_syntax, nullptr);
+}
+
+void PgStatementImpl::prepare_with_types(
+	std::string_view        sql,
+	const std::vector<Oid>  &param_types,
+	bool                    use_native_parameters_syntax)
+{
+	prepare_impl(sql, use_native_parameters_syntax, &param_types);
+}
+
+void PgStatementImpl::prepare_with_value_types(
+	std::string_view              sql,
+	const std::vector<ValueType>  &param_types,
+	bool                          use_native_parameters_syntax)
+{
+	std::vector<Oid> oids;
+	oids.reserve(param_types.size());
+	for (auto type : param_types)
+		oids.push_back(value_type_to_oid(type));
+
+	prepare_impl(sql, use_native_parameters_syntax, &oids);
+}
+
+void PgStatementImpl::prepare_impl(
+	std::string_view        sql,
+	bool                    use_native_parameters_syntax,
+	const std::vector<Oid>  *param_types)
+{
+	TraceScope trace(conn_->get_tracer().get(), TraceOperation::Prepare, sql, this);
+	trace.set_native_parameters_syntax(use_native_parameters_syntax);
+
 	columns_helper_.clear();
 
 	result_.set(nullptr);
 	conn_->skip_previous_data();
+	close_cursor(true);
+	deallocate_named_stmt();
 
 	sql_preprocessor_.preprocess(
 		sql,
@@ -1196,13 +2299,59 @@ void PgStatementImpl::prepare(
 	);
 
 	sql_buffer_ = sql_preprocessor_.get_preprocessed_sql();
+	last_sql_ = sql;
+	last_sql_is_native_ = use_native_parameters_syntax;
+
+	// FETCH destroys unnamed prepared statement so
+	// statement declaring cursor is named
+	cursor_is_declared_ = cursor_params_.has_value();
+	if (cursor_is_declared_)
+	{
+		wrap_sql_into_cursor();
+		stmt_name_ = cursor_name_;
+	}
+
+	// types of parameters are asked from server if some of them are not declared
+	bool all_types_declared =
+		param_types &&
+		(std::find(param_types->begin(), param_types->end(), 0) == param_types->end());
+
+	if (all_types_declared)
+		prepare_without_describe(sql, *param_types);
+	else if (lib_->api.supports_pipeline_mode())
+		prepare_and_describe_pipelined(sql, param_types);
+	else
+		prepare_and_describe(sql, param_types);
+
+	int params_count = all_types_declared ? (int)param_types->size() : lib_->api.f_PQnparams(result_.get());
+
+	param_types_.resize(params_count);
+	for (int i = 0; i < params_count; i++)
+		param_types_[i] = all_types_declared ? (*param_types)[i] : lib_->api.f_PQparamtype(result_.get(), i);
+
+	param_data_.resize(params_count);
+	for (auto& item : param_data_) item.str.clear();
+
+	param_values_.resize(params_count);
+	for (auto& item : param_values_) item = nullptr;
+
+	param_lengths_.resize(params_count);
+	for (auto& item : param_lengths_) item = 0;
+
+	param_formats_.assign(params_count, 1); // all binary format
+
+	state_ = StmtState::Prepared;
+}
 
+void PgStatementImpl::prepare_and_describe(std::string_view sql, const std::vector<Oid> *param_types)
+{
+	conn_->count_call(NativeCallType::Prepare, true, sql_buffer_.size());
 	PGresultHandler tmp_result(lib_->api, lib_->api.f_PQprepare(
 		conn_->get_connection(),
-		"",
+		stmt_name_.c_str(),
 		sql_buffer_.c_str(),
-		0,
-		nullptr
+		param_types ? (int)param_types->size() : 0,
+		param_types ? param_types->data() : nullptr
 	));
 
 	check_result_status(
@@ -1215,9 +2364,10 @@ void PgStatementImpl::prepare(
 		ErrorType::Normal
 	);
 
+	conn_->count_call(NativeCallType::Prepare, true);
 	result_.set(lib_->api.f_PQdescribePrepared(
 		conn_->get_connection(),
-		""
+		stmt_name_.c_str()
 	));
 
 	check_result_status(
@@ -1229,25 +2379,103 @@ void PgStatementImpl::prepare(
 		sql,
 		ErrorType::Normal
 	);
+}
 
-	int params_count = lib_->api.f_PQnparams(result_.get());
+// Prepare and describe are sent to server in one flush
+void PgStatementImpl::prepare_and_describe_pipelined(std::string_view sql, const std::vector<Oid> *param_types)
+{
+	auto &api = lib_->api;
+	auto conn = conn_->get_connection();
 
-	param_types_.resize(params_count);
-	for (int i = 0; i < params_count; i++)
-		param_types_[i] = lib_->api.f_PQparamtype(result_.get(), i);
+	int res = api.f_PQenterPipelineMode(conn);
+	check_ret_code(api, conn, res, "PQenterPipelineMode", { 1 }, {}, ErrorType::Normal);
 
-	param_data_.resize(params_count);
-	for (auto& item : param_data_) item.str.clear();
+	int types_count = param_types ? (int)param_types->size() : 0;
+	const Oid *types = param_types ? param_types->data() : nullptr;
 
-	param_values_.resize(params_count);
-	for (auto& item : param_values_) item = nullptr;
+	bool sent =
+		api.f_PQsendPrepare(conn, stmt_name_.c_str(), sql_buffer_.c_str(), types_count, types) &&
+		api.f_PQsendDescribePrepared(conn, stmt_name_.c_str()) &&
+		api.f_PQpipelineSync(conn);
 
-	param_lengths_.resize(params_count);
-	for (auto& item : param_lengths_) item = 0;
+	conn_->count_call(NativeCallType::Prepare, true, sql_buffer_.size());
 
-	param_formats_.resize(params_count, 1); // all binary format
+	// result of each query is followed by null. Results of queries after failed
+	// one have status PGRES_PIPELINE_ABORTED. Pipeline ends with PGRES_PIPELINE_SYNC
+	PGresultHandler prepare_result(api);
+	PGresultHandler sync_result(api);
+	if (sent)
+	{
+		prepare_result.set(api.f_PQgetResult(conn));
+		PGresultHandler(api, api.f_PQgetResult(conn));
 
-	state_ = StmtState::Prepared;
+		conn_->count_call(NativeCallType::Prepare, false);
+		result_.set(api.f_PQgetResult(conn));
+		PGresultHandler(api, api.f_PQgetResult(conn));
+
+		sync_result.set(api.f_PQgetResult(conn));
+	}
+
+	api.f_PQexitPipelineMode(conn);
+
+	if (!sent || !prepare_result.get() || !sync_result.get())
+		check_ret_code(api, conn, 0, "PQgetResult", { 1 }, sql, ErrorType::Normal);
+
+	check_result_status(api, conn, prepare_result.get(), "PQsendPrepare", { PGRES_COMMAND_OK }, sql, ErrorType::Normal);
+	check_result_status(api, conn, result_.get(), "PQsendDescribePrepared", { PGRES_COMMAND_OK }, sql, ErrorType::Normal);
+	check_result_status(api, conn, sync_result.get(), "PQpipelineSync", { PgresPipelineSync }, sql, ErrorType::Normal);
+}
+
+// Server doesn't describe statement. Result of prepare has no columns.
+// Statement not declaring cursor is prepared once for connection
+
+void PgStatementImpl::prepare_without_describe(std::string_view sql, const std::vector<Oid> &param_types)
+{
+	if (!cursor_is_declared_)
+	{
+		cached_stmt_key_ = sql_buffer_;
+		cached_stmt_key_.push_back('\0');
+		for (Oid type : param_types)
+			cached_stmt_key_.append(std::to_string(type)).push_back(',');
+
+		bool is_prepared = false;
+		stmt_name_ = conn_->acquire_cached_stmt(cached_stmt_key_, is_prepared);
+		stmt_is_cached_ = true;
+		if (is_prepared) return;
+	}
+
+	conn_->count_call(NativeCallType::Prepare, true, sql_buffer_.size());
+	result_.set(lib_->api.f_PQprepare(
+		conn_->get_connection(),
+		stmt_name_.c_str(),
+		sql_buffer_.c_str(),
+		(int)param_types.size(),
+		param_types.empty() ? nullptr : param_types.data()
+	));
+
+	bool prepared =
+		result_.get() &&
+		(lib_->api.f_PQresultStatus(result_.get()) == PGRES_COMMAND_OK);
+
+	if (!prepared && stmt_is_cached_)
+	{
+		conn_->remove_cached_stmt(cached_stmt_key_);
+		stmt_name_.clear();
+		stmt_is_cached_ = false;
+	}
+
+	check_result_status(
+		lib_->api,
+		conn_->get_connection(),
+		result_.get(),
+		"PQprepare",
+		{ PGRES_COMMAND_OK },
+		sql,
+		ErrorType::Normal
+	);
+
+	// the same state as for statement taken from cache
+	result_.set(nullptr);
 }
 
 void PgStatementImpl::prepare(
@@ -1259,14 +2487,24 @@ void PgStatementImpl::prepare(
 }
 
 void PgStatementImpl::execute(std::string_view sql)
+{
+	TraceScope trace(conn_->get_tracer().get(), TraceOperation::Execute, sql, this);
+	trace.set_native_parameters_syntax(true);
+	execute_impl(sql);
+	if (trace.is_active()) trace.set_rows_count(get_result_changes_count());
+}
+
+void PgStatementImpl::execute_impl(std::string_view sql)
 {
 	columns_helper_.clear();
 
 	result_contains_first_row_data_ = false;
 	contains_data_ = false;
+	row_ = 0;
 
 	result_.set(nullptr);
 	conn_->skip_previous_data();
+	close_cursor(true);
 
 	sql_preprocessor_.preprocess(
 		sql,
@@ -1276,7 +2514,49 @@ void PgStatementImpl::execute(std::string_view sql)
 	);
 
 	sql_buffer_ = sql_preprocessor_.get_preprocessed_sql();
+	last_sql_ = sql;
+	last_sql_is_native_ = true;
+
+	// directly executed sql has no parameters
+	param_types_.clear();
+	param_data_.clear();
+	param_values_.clear();
+	param_lengths_.clear();
+	param_formats_.clear();
+
+	cursor_is_declared_ = cursor_params_.has_value();
+	if (cursor_is_declared_)
+	{
+		wrap_sql_into_cursor();
 
+		// deferred BEGIN and DECLARE are sent as one multi-statement query
+		std::string declare_sql = tran_->take_deferred_begin_sql();
+		declare_sql.append(sql_buffer_);
+
+		conn_->count_call(NativeCallType::Execute, true, declare_sql.size());
+		PGresultHandler declare_result(lib_->api, lib_->api.f_PQexec(conn_->get_connection(), declare_sql.c_str()));
+
+		check_exec_result(
+			lib_->api,
+			conn_->get_connection(),
+			declare_result.get(),
+			{ PGRES_COMMAND_OK },
+			sql,
+			ErrorType::Normal
+		);
+
+		cursor_is_open_ = true;
+		fetch_cursor_batch();
+
+		result_contains_first_row_data_ = true;
+		state_ = StmtState::Executed;
+		return;
+	}
+
+	// COPY is not allowed in pipeline mode
+	bool begin_is_pipelined = tran_->begin_in_pipeline(!is_copy_sql(sql_buffer_));
+
+	conn_->count_call(NativeCallType::Execute, !begin_is_pipelined, sql_buffer_.size());
 	int res = lib_->api.f_PQsendQueryParams(
 		conn_->get_connection(),
 		sql_buffer_.c_str(),
@@ -1298,6 +2578,9 @@ void PgStatementImpl::execute(std::string_view sql)
 		ErrorType::Normal
 	);
 
+	if (begin_is_pipelined)
+		tran_->end_begin_in_pipeline(nullptr);
+
 	res = lib_->api.f_PQsetSingleRowMode(conn_->get_connection());
 
 	check_ret_code(
@@ -1316,26 +2599,40 @@ void PgStatementImpl::execute(std::string_view sql)
 	state_ = StmtState::Executed;
 }
 
-void PgStatementImpl::fetch_and_check_if_result_is_end_of_tuples()
+bool PgStatementImpl::fetch_and_check_if_result_is_end_of_tuples(Status *status)
 {
+	conn_->count_call(NativeCallType::Fetch, false);
 	result_.set(lib_->api.f_PQgetResult(conn_->get_connection()));
-	if (!result_.get()) return;
+	return check_if_result_is_end_of_tuples(status);
+}
 
-	check_result_status(
+bool PgStatementImpl::check_if_result_is_end_of_tuples(Status *status)
+{
+	if (!result_.get()) return true;
+	conn_->count_result(result_.get());
+
+	bool ok = check_result_status(
 		lib_->api,
 		conn_->get_connection(),
 		result_.get(),
 		"PQgetResult",
 		{ PGRES_SINGLE_TUPLE, PGRES_COMMAND_OK, PGRES_TUPLES_OK, PGRES_COPY_IN },
 		{},
-		ErrorType::Normal
+		ErrorType::Normal,
+		status
 	);
 
-	auto status = lib_->api.f_PQresultStatus(result_.get());
-	if ((status == PGRES_TUPLES_OK) || (status == PGRES_COMMAND_OK) || (status == PGRES_COPY_IN))
+	if (!ok)
 	{
 		contains_data_ = false;
-		return;
+		return false;
+	}
+
+	auto res_status = lib_->api.f_PQresultStatus(result_.get());
+	if ((res_status == PGRES_TUPLES_OK) || (res_status == PGRES_COMMAND_OK) || (res_status == PGRES_COPY_IN))
+	{
+		contains_data_ = false;
+		return true;
 	}
 
 	int rows_count = lib_->api.f_PQntuples(result_.get());
@@ -1347,6 +2644,7 @@ void PgStatementImpl::fetch_and_check_if_result_is_end_of_tuples()
 		throw InternalException("Result format is not binary", rows_count, 0);
 
 	contains_data_ = true;
+	return true;
 }
 
 void PgStatementImpl::execute(std::wstring_view sql)
@@ -1360,18 +2658,91 @@ StatementType PgStatementImpl::get_type()
 }
 
 void PgStatementImpl::execute()
+{
+	execute_traced(nullptr);
+}
+
+Status PgStatementImpl::try_execute()
+{
+	Status status;
+	execute_traced(&status);
+	return status;
+}
+
+bool PgStatementImpl::execute_traced(Status *status)
+{
+	TraceScope trace(conn_->get_tracer().get(), TraceOperation::Execute, last_sql_, this);
+	trace.set_native_parameters_syntax(last_sql_is_native_);
+
+	if (trace.is_active())
+	{
+		for (int length : param_lengths_)
+			trace.add_bytes(length);
+	}
+
+	if (!execute_prepared_impl(status))
+	{
+		trace.set_error(status->get_error_type());
+		return false;
+	}
+
+	if (trace.is_active()) trace.set_rows_count(get_result_changes_count());
+	return true;
+}
+
+size_t PgStatementImpl::get_result_changes_count()
+{
+	if (!result_.get()) return 0;
+	return (size_t)atoi(lib_->api.f_PQcmdTuples(result_.get()));
+}
+
+size_t PgStatementImpl::get_row_bytes()
+{
+	auto &api = lib_->api;
+	int columns_count = api.f_PQnfields(result_.get());
+	size_t result = 0;
+	for (int i = 0; i < columns_count; i++)
+		result += api.f_PQgetlength(result_.get(), row_, i);
+	return result;
+}
+
+bool PgStatementImpl::execute_prepared_impl(Status *status, bool prepare_if_stmt_is_lost)
 {
 	result_contains_first_row_data_ = false;
 	contains_data_ = false;
+	row_ = 0;
 
 	result_.set(nullptr);
 	conn_->skip_previous_data();
+	close_cursor(true);
 
 	int params_count = (int)param_data_.size();
 
+	size_t params_bytes = 0;
+	for (int i = 0; i < params_count; i++)
+		if (param_values_[i]) params_bytes += param_lengths_[i];
+
+	bool begin_is_pipelined = tran_->begin_in_pipeline(true);
+
+	// BEGIN replaces unnamed statement
+	bool reparse_unnamed = begin_is_pipelined && stmt_name_.empty();
+	if (reparse_unnamed)
+	{
+		conn_->count_call(NativeCallType::Prepare, false, sql_buffer_.size());
+		int res = lib_->api.f_PQsendPrepare(
+			conn_->get_connection(),
+			"",
+			sql_buffer_.c_str(),
+			params_count,
+			params_count ? param_types_.data() : nullptr
+		);
+		check_ret_code(lib_->api, conn_->get_connection(), res, "PQsendPrepare", { 1 }, sql_buffer_, ErrorType::Normal);
+	}
+
+	conn_->count_call(NativeCallType::Execute, !begin_is_pipelined, params_bytes);
 	int res = lib_->api.f_PQsendQueryPrepared(
 		conn_->get_connection(),
-		"",
+		stmt_name_.c_str(),
 		params_count,
 		params_count ? param_values_.data() : nullptr,
 		params_count ?param_lengths_.data() : nullptr,
@@ -1379,16 +2750,66 @@ void PgStatementImpl::execute()
 		1
 	);
 
-	check_ret_code(
+	bool ok = check_ret_code(
 		lib_->api,
 		conn_->get_connection(),
 		res,
 		"PQsendQueryPrepared",
 		{ 1 },
 		{},
-		ErrorType::Normal
+		ErrorType::Normal,
+		status
 	);
 
+	if (!ok) return false;
+
+	if (begin_is_pipelined && !tran_->end_begin_in_pipeline(status))
+		return false;
+
+	if (reparse_unnamed)
+	{
+		PGresultHandler prepare_result(lib_->api, lib_->api.f_PQgetResult(conn_->get_connection()));
+		PGresultHandler(lib_->api, lib_->api.f_PQgetResult(conn_->get_connection()));
+
+		ok = check_result_status(
+			lib_->api,
+			conn_->get_connection(),
+			prepare_result.get(),
+			"PQsendPrepare",
+			{ PGRES_COMMAND_OK },
+			sql_buffer_,
+			ErrorType::Normal,
+			status
+		);
+
+		if (!ok) return false;
+	}
+
+	if (cursor_is_declared_)
+	{
+		conn_->count_call(NativeCallType::Fetch, false);
+		PGresultHandler declare_result(lib_->api, lib_->api.f_PQgetResult(conn_->get_connection()));
+
+		check_result_status(
+			lib_->api,
+			conn_->get_connection(),
+			declare_result.get(),
+			"PQgetResult",
+			{ PGRES_COMMAND_OK },
+			sql_buffer_,
+			ErrorType::Normal
+		);
+
+		conn_->skip_previous_data();
+
+		cursor_is_open_ = true;
+		fetch_cursor_batch();
+
+		result_contains_first_row_data_ = true;
+		state_ = StmtState::Executed;
+		return true;
+	}
+
 	res = lib_->api.f_PQsetSingleRowMode(conn_->get_connection());
 
 	check_ret_code(
@@ -1401,10 +2822,45 @@ void PgStatementImpl::execute()
 		ErrorType::Normal
 	);
 
-	fetch_and_check_if_result_is_end_of_tuples();
+	conn_->count_call(NativeCallType::Fetch, false);
+	result_.set(lib_->api.f_PQgetResult(conn_->get_connection()));
+
+	if (prepare_if_stmt_is_lost && stmt_is_cached_ && is_stmt_lost_error(lib_->api, result_.get()))
+		return prepare_lost_stmt_and_execute(begin_is_pipelined, status);
+
+	if (!check_if_result_is_end_of_tuples(status)) return false;
 
 	result_contains_first_row_data_ = true;
 	state_ = StmtState::Executed;
+	return true;
+}
+
+// Cached statement is lost on server after DISCARD ALL or DEALLOCATE ALL.
+// It is prepared again if error doesn't break transaction. Transaction
+// broken by the first statement is started again
+
+bool PgStatementImpl::prepare_lost_stmt_and_execute(bool begin_is_pipelined, Status *status)
+{
+	conn_->skip_previous_data();
+
+	auto tran_status = lib_->api.f_PQtransactionStatus(conn_->get_connection());
+	bool can_prepare =
+		(tran_status == PQTRANS_IDLE) ||
+		(begin_is_pipelined && (tran_status == PQTRANS_INERROR));
+
+	conn_->reset_cached_stmts();
+
+	if (!can_prepare)
+		return check_if_result_is_end_of_tuples(status);
+
+	if (tran_status == PQTRANS_INERROR)
+		tran_->restore_deferred_begin();
+
+	stmt_name_.clear();
+	stmt_is_cached_ = false;
+	prepare_without_describe(sql_buffer_, param_types_);
+
+	return execute_prepared_impl(status, false);
 }
 
 size_t PgStatementImpl::get_changes_count()
@@ -1421,10 +2877,42 @@ int64_t PgStatementImpl::get_last_row_id()
 
 std::string PgStatementImpl::get_last_sql() const
 {
-	return sql_buffer_;
+	return last_sql_;
 }
 
 bool PgStatementImpl::fetch()
+{
+	return fetch_traced(nullptr);
+}
+
+Status PgStatementImpl::try_fetch()
+{
+	Status status;
+	bool fetched = fetch_traced(&status);
+	if (status.is_ok() && !fetched) return Status::make_no_data();
+	return status;
+}
+
+bool PgStatementImpl::fetch_traced(Status *status)
+{
+	Tracer* tracer = conn_->get_tracer().get();
+	if (!tracer) return fetch_impl(status);
+
+	TraceScope trace(tracer, TraceOperation::Fetch, last_sql_, this);
+	trace.set_native_parameters_syntax(last_sql_is_native_);
+	bool result = fetch_impl(status);
+	if (result)
+	{
+		trace.set_rows_count(1);
+		trace.add_bytes(get_row_bytes());
+	}
+	else if (status && status->is_error())
+		trace.set_error(status->get_error_type());
+	return result;
+}
+
+// returns false at the end of data or if error is stored in status
+bool PgStatementImpl::fetch_impl(Status *status)
 {
 	if (result_contains_first_row_data_)
 	{
@@ -1434,11 +2922,147 @@ bool PgStatementImpl::fetch()
 
 	check_contains_data();
 
-	fetch_and_check_if_result_is_end_of_tuples();
+	if (cursor_is_declared_)
+	{
+		if (++row_ < cursor_rows_count_)
+			return true;
+
+		if (!cursor_has_more_rows_)
+		{
+			contains_data_ = false;
+			return false;
+		}
+
+		fetch_cursor_batch();
+		return contains_data_;
+	}
+
+	fetch_and_check_if_result_is_end_of_tuples(status);
 
 	return contains_data_;
 }
 
+void PgStatementImpl::set_cursor_mode(const PgCursorParams &params)
+{
+	if ((params.fetch_size == 0) || (params.fetch_size > INT32_MAX))
+		throw WrongArgumentException("Wrong PgCursorParams::fetch_size");
+
+	cursor_params_ = params;
+}
+
+void PgStatementImpl::reset_cursor_mode()
+{
+	cursor_params_.reset();
+}
+
+bool PgStatementImpl::is_cursor_mode() const
+{
+	return cursor_params_.has_value();
+}
+
+void PgStatementImpl::wrap_sql_into_cursor()
+{
+	static std::atomic<unsigned> cursors_counter = 0;
+
+	if (cursor_name_.empty())
+		cursor_name_ = "dblib_cursor_" + std::to_string(++cursors_counter);
+
+	sql_buffer_ =
+		"DECLARE " + cursor_name_ + " NO SCROLL CURSOR " +
+		(cursor_params_->with_hold ? "WITH HOLD " : "") +
+		"FOR " + sql_buffer_;
+
+	cursor_fetch_size_ = (int)cursor_params_->fetch_size;
+	cursor_sql_ = "FETCH FORWARD " + std::to_string(cursor_fetch_size_) + " FROM " + cursor_name_;
+}
+
+void PgStatementImpl::deallocate_named_stmt()
+{
+	// cached statement stays prepared for next users
+	if (std::exchange(stmt_is_cached_, false))
+	{
+		conn_->release_cached_stmt(cached_stmt_key_, stmt_name_);
+		stmt_name_.clear();
+	}
+
+	if (stmt_name_.empty()) return;
+
+	std::string sql = "DEALLOCATE " + stmt_name_;
+	stmt_name_.clear();
+
+	conn_->skip_previous_data();
+	conn_->count_call(NativeCallType::Prepare, true, sql.size());
+	PGresultHandler result(lib_->api, lib_->api.f_PQexec(conn_->get_connection(), sql.c_str()));
+	check_exec_result(lib_->api, conn_->get_connection(), result.get(), { PGRES_COMMAND_OK }, sql, ErrorType::Normal);
+}
+
+void PgStatementImpl::fetch_cursor_batch()
+{
+	auto &api = lib_->api;
+	auto *conn = conn_->get_connection();
+
+	conn_->count_call(NativeCallType::Fetch, true, cursor_sql_.size());
+	int res = api.f_PQsendQueryParams(
+		conn,
+		cursor_sql_.c_str(),
+		0,
+		nullptr,
+		nullptr,
+		nullptr,
+		nullptr,
+		1 // 1 - result in binary format
+	);
+
+	check_ret_code(api, conn, res, "PQsendQueryParams", { 1 }, cursor_sql_, ErrorType::Normal);
+
+	conn_->count_call(NativeCallType::Fetch, false);
+	result_.set(api.f_PQgetResult(conn));
+	conn_->count_result(result_.get());
+	if (!result_.get())
+		throw InternalException("No result for " + cursor_sql_, 0, 0);
+
+	check_result_status(api, conn, result_.get(), "PQgetResult", { PGRES_TUPLES_OK }, cursor_sql_, ErrorType::Normal);
+
+	conn_->skip_previous_data();
+
+	row_ = 0;
+	cursor_rows_count_ = api.f_PQntuples(result_.get());
+	cursor_has_more_rows_ = (cursor_rows_count_ == cursor_fetch_size_);
+	contains_data_ = (cursor_rows_count_ != 0);
+
+	if (!cursor_has_more_rows_)
+		close_cursor(false);
+}
+
+// check_if_exists - cursor without hold may be already closed by end of transaction
+
+void PgStatementImpl::close_cursor(bool check_if_exists)
+{
+	if (!cursor_is_open_) return;
+
+	cursor_is_open_ = false;
+	cursor_has_more_rows_ = false;
+
+	auto &api = lib_->api;
+	auto *conn = conn_->get_connection();
+
+	conn_->skip_previous_data();
+
+	if (check_if_exists)
+	{
+		std::string sql = "select 1 from pg_cursors where name = '" + cursor_name_ + "'";
+		conn_->count_call(NativeCallType::Execute, true, sql.size());
+		PGresultHandler exists_result(api, api.f_PQexec(conn, sql.c_str()));
+		check_exec_result(api, conn, exists_result.get(), { PGRES_TUPLES_OK }, sql, ErrorType::Normal);
+		if (api.f_PQntuples(exists_result.get()) == 0) return;
+	}
+
+	std::string sql = "CLOSE " + cursor_name_;
+	conn_->count_call(NativeCallType::Execute, true, sql.size());
+	PGresultHandler close_result(api, api.f_PQexec(conn, sql.c_str()));
+	check_exec_result(api, conn, close_result.get(), { PGRES_COMMAND_OK }, sql, ErrorType::Normal);
+}
+
 template <typename T>
 void PgStatementImpl::set_value_parameter(size_t param_index, T value)
 {
@@ -1453,7 +3077,7 @@ void PgStatementImpl::set_value_parameter(size_t param_index, T value)
 
 	if constexpr (size2 || size4 || size8)
 	{
-		static_assert(ParamValue::FixedBufferSize >= sizeof(T));
+		static_assert(ParamData::FixedBufferSize >= sizeof(T));
 		char* data = param_data_.at(param_index - 1).fixed_buffer.data();
 		write_value_into_bytes_be(value, data);
 		param_values_.at(param_index - 1) = data;
@@ -1461,6 +3085,50 @@ void PgStatementImpl::set_value_parameter(size_t param_index, T value)
 	}
 }
 
+// Value of the same type as type of parameter is set directly.
+// Returns false if conversion is needed
+
+template <typename T>
+bool PgStatementImpl::set_param_without_cvt(size_t param_index, const T& value)
+{
+	Oid type = param_types_.at(param_index - 1);
+
+	if constexpr (std::is_same_v<T, int16_t>)
+	{
+		if (type != INT2OID) return false;
+		set_int16_impl(param_index, value);
+	}
+	else if constexpr (std::is_same_v<T, int32_t>)
+	{
+		if (type != INT4OID) return false;
+		set_int32_impl(param_index, value);
+	}
+	else if constexpr (std::is_same_v<T, int64_t>)
+	{
+		if (type != INT8OID) return false;
+		set_int64_impl(param_index, value);
+	}
+	else if constexpr (std::is_same_v<T, float>)
+	{
+		if (type != FLOAT4OID) return false;
+		set_float_impl(param_index, value);
+	}
+	else if constexpr (std::is_same_v<T, double>)
+	{
+		if (type != FLOAT8OID) return false;
+		set_double_impl(param_index, value);
+	}
+	else if constexpr (std::is_same_v<T, std::string>)
+	{
+		if ((type != VARCHAROID) && (type != TEXTOID)) return false;
+		set_u8str_impl(param_index, value);
+	}
+	else
+		return false;
+
+	return true;
+}
+
 template <typename T>
 void PgStatementImpl::set_param_opt_impl(const IndexOrName& param, const std::optional<T>& value)
 {
@@ -1469,7 +3137,10 @@ void PgStatementImpl::set_param_opt_impl(const IndexOrName& param, const std::op
 	sql_preprocessor_.do_for_param_indexes(
 		param,
 		[&](size_t param_index) {
-			if (value.has_value())
+			if (!value.has_value())
+				param_values_.at(param_index - 1) = nullptr;
+
+			else if (!set_param_without_cvt(param_index, *value))
 			{
 				set_param_with_type_cvt(
 					*this,
@@ -1478,8 +3149,6 @@ void PgStatementImpl::set_param_opt_impl(const IndexOrName& param, const std::op
 					*value
 				);
 			}
-			else
-				param_values_.at(param_index - 1) = nullptr;
 		}
 	);
 }
@@ -1496,6 +3165,15 @@ void PgStatementImpl::check_is_in_prepared_or_executed_state() const
 		throw WrongSeqException("Statement is not prepared or executed");
 }
 
+// Statement prepared without description has no result till execute
+
+void PgStatementImpl::check_columns_are_known()
+{
+	check_is_in_prepared_or_executed_state();
+	if (!result_.get())
+		throw WrongSeqException("Columns of statement are not known before execute");
+}
+
 void PgStatementImpl::check_contains_data() const
 {
 	// if result_contains_first_row_data_ == true, fetch has not called
@@ -1631,27 +3309,98 @@ void PgStatementImpl::set_blob(const IndexOrName& param, const char* blob_data,
 
 			param_values_.at(param_index - 1) = str_buf.data();
 			param_lengths_.at(param_index - 1) = (int)blob_size;
+			param_formats_.at(param_index - 1) = 1;
 		}
 	);
 }
 
-size_t PgStatementImpl::get_columns_count()
+ParamValues PgStatementImpl::get_param_values()
 {
 	check_is_in_prepared_or_executed_state();
+
+	ParamValues result(param_values_.size());
+
+	for (size_t i = 0; i < param_values_.size(); i++)
+	{
+		const char* value = param_values_[i];
+		if (value == nullptr) continue;
+
+		size_t len = (size_t)param_lengths_[i];
+		auto& dst = result[i];
+
+		switch (param_types_[i])
+		{
+		case INT2OID:
+			if (len == sizeof(int16_t)) dst = (int32_t)read_value_from_bytes_be<int16_t>(value);
+			break;
+
+		case INT4OID:
+			if (len == sizeof(int32_t)) dst = read_value_from_bytes_be<int32_t>(value);
+			break;
+
+		case INT8OID:
+			if (len == sizeof(int64_t)) dst = read_value_from_bytes_be<int64_t>(value);
+			break;
+
+		case FLOAT4OID:
+			if (len == sizeof(float)) dst = read_value_from_bytes_be<float>(value);
+			break;
+
+		case FLOAT8OID:
+			if (len == sizeof(double)) dst = read_value_from_bytes_be<double>(value);
+			break;
+
+		case DATEOID:
+			if (len == sizeof(int32_t)) dst = pg_date_to_dblib_date(read_value_from_bytes_be<int32_t>(value));
+			break;
+
+		case TIMEOID:
+			if (len == sizeof(int64_t)) dst = pg_time_to_dblib_time(read_value_from_bytes_be<int64_t>(value));
+			break;
+
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			if (len == sizeof(int64_t)) dst = pg_ts_to_dblib_ts(read_value_from_bytes_be<int64_t>(value));
+			break;
+
+		case BOOLOID:
+			if (len == 1) dst = (int32_t)(value[0] != 0);
+			break;
+
+		case JSONBOID:
+		case UUIDOID:
+		case NUMERICOID:
+			if (param_formats_[i] == 1) dst = std::string(pg_value_to_text(param_types_[i], value, len, text_buffer_));
+			break;
+		}
+
+		if (std::holds_alternative<std::monostate>(dst))
+			dst = std::string(value, len);
+	}
+
+	return result;
+}
+
+size_t PgStatementImpl::get_columns_count()
+{
+	check_columns_are_known();
 	return lib_->api.f_PQnfields(result_.get());
 }
 
 ValueType PgStatementImpl::get_column_type(const IndexOrName& colum)
 {
-	check_is_in_prepared_or_executed_state();
+	check_columns_are_known();
 	size_t index = columns_helper_.get_column_index(colum);
 	return oid_to_value_type(lib_->api.f_PQftype(result_.get(), (int)index - 1));
 }
 
 std::string PgStatementImpl::get_column_name(size_t index)
 {
-	check_is_in_prepared_or_executed_state();
-	return lib_->api.f_PQfname(result_.get(), (int)index - 1);
+	check_columns_are_known();
+	const char *name = lib_->api.f_PQfname(result_.get(), (int)index - 1);
+	if (!name)
+		throw WrongArgumentException("Wrong column index " + std::to_string(index));
+	return name;
 }
 
 bool PgStatementImpl::is_null(const IndexOrName& column)
@@ -1663,7 +3412,7 @@ bool PgStatementImpl::is_null(const IndexOrName& column)
 
 bool PgStatementImpl::is_null_impl(size_t col_index)
 {
-	return lib_->api.f_PQgetisnull(result_.get(), 0, (int)col_index - 1) != 0;
+	return lib_->api.f_PQgetisnull(result_.get(), row_, (int)col_index - 1) != 0;
 }
 
 template<typename T>
@@ -1721,6 +3470,9 @@ std::optional<T> PgStatementImpl::get_dt_opt_impl(
 
 	Oid real_col_oid = lib_->api.f_PQftype(result_.get(), (int)index - 1);
 
+	// timestamptz has the same binary format as timestamp (in UTC)
+	if (real_col_oid == TIMESTAMPTZOID) real_col_oid = TIMESTAMPOID;
+
 	if (real_col_oid != col_oid)
 		throw WrongTypeConvException(error_text_if_oid_not_match);
 
@@ -1776,7 +3528,7 @@ size_t PgStatementImpl::get_blob_size(const IndexOrName& column)
 	if (lib_->api.f_PQftype(result_.get(), (int)index - 1) != BYTEAOID)
 		throw WrongTypeConvException("Result is not in bytea format");
 
-	return lib_->api.f_PQgetlength(result_.get(), 0, (int)index - 1);
+	return lib_->api.f_PQgetlength(result_.get(), row_, (int)index - 1);
 }
 
 void PgStatementImpl::get_blob_data(const IndexOrName& column, char* dst, size_t size)
@@ -1790,14 +3542,132 @@ void PgStatementImpl::get_blob_data(const IndexOrName& column, char* dst, size_t
 	if (lib_->api.f_PQftype(result_.get(), (int)index - 1) != BYTEAOID)
 		throw WrongTypeConvException("Result is not in bytea format");
 
-	const char* value = lib_->api.f_PQgetvalue(result_.get(), 0, (int)index - 1);
+	const char* value = lib_->api.f_PQgetvalue(result_.get(), row_, (int)index - 1);
 
-	size_t real_len = lib_->api.f_PQgetlength(result_.get(), 0, (int)index - 1);
+	size_t real_len = lib_->api.f_PQgetlength(result_.get(), row_, (int)index - 1);
 	if (size > real_len) size = real_len;
 
 	memcpy(dst, value, size);
 }
 
+size_t PgStatementImpl::fetch_columnar(ResultSet& result, size_t max_rows)
+{
+	check_is_in_executed_state();
+
+	auto &api = lib_->api;
+	int columns_count = api.f_PQnfields(result_.get());
+
+	column_oids_.resize(columns_count);
+	for (int i = 0; i < columns_count; i++)
+		column_oids_[i] = api.f_PQftype(result_.get(), i);
+
+	if (result.get_columns_count() == 0)
+	{
+		for (int i = 0; i < columns_count; i++)
+		{
+			Oid oid = column_oids_[i];
+			result.add_column(
+				api.f_PQfname(result_.get(), i),
+				oid_to_value_type(oid)
+			);
+		}
+	}
+	else if (result.get_columns_count() != (size_t)columns_count)
+		throw WrongArgumentException("Columns count of result set and statement are different");
+
+	size_t rows_count = 0;
+
+	while (((max_rows == 0) || (rows_count < max_rows)) && fetch())
+	{
+		auto *res = result_.get();
+
+		for (int i = 0; i < columns_count; i++)
+		{
+			auto &column = result.get_column(i + 1);
+
+			if (api.f_PQgetisnull(res, row_, i))
+			{
+				column.append_null();
+				continue;
+			}
+
+			const char *value = api.f_PQgetvalue(res, row_, i);
+
+			switch (column_oids_[i])
+			{
+			case INT2OID:
+				column.append_int16(read_value_from_bytes_be<int16_t>(value));
+				break;
+
+			case INT4OID:
+				column.append_int32(read_value_from_bytes_be<int32_t>(value));
+				break;
+
+			case INT8OID:
+				column.append_int64(read_value_from_bytes_be<int64_t>(value));
+				break;
+
+			case FLOAT4OID:
+				column.append_float(read_value_from_bytes_be<float>(value));
+				break;
+
+			case FLOAT8OID:
+				column.append_double(read_value_from_bytes_be<double>(value));
+				break;
+
+			case VARCHAROID:
+			case NAMEOID:
+			case TEXTOID:
+			case BYTEAOID:
+				column.append_blob(value, api.f_PQgetlength(res, row_, i));
+				break;
+
+			case BPCHAROID:
+			{
+				std::string_view text(value, api.f_PQgetlength(res, row_, i));
+				while (!text.empty() && (text.back() == ' ')) text.remove_suffix(1); // trim right
+				column.append_str(text);
+				break;
+			}
+
+			case DATEOID:
+				column.append_date(pg_date_to_dblib_date(read_value_from_bytes_be<int32_t>(value)));
+				break;
+
+			case TIMEOID:
+				column.append_time(pg_time_to_dblib_time(read_value_from_bytes_be<int64_t>(value)));
+				break;
+
+			case TIMESTAMPOID:
+			case TIMESTAMPTZOID:
+				column.append_timestamp(pg_ts_to_dblib_ts(read_value_from_bytes_be<int64_t>(value)));
+				break;
+
+			case BOOLOID:
+				column.append_int32(value[0] != 0);
+				break;
+
+			case JSONOID:
+			case JSONBOID:
+			case UUIDOID:
+			case NUMERICOID:
+				column.append_str(pg_value_to_text(column_oids_[i], value, api.f_PQgetlength(res, row_, i), text_buffer_));
+				break;
+
+			default:
+				throw WrongTypeConvException(
+					"Type for oid=" + std::to_string(column_oids_[i]) +
+					" is not supported in fetch_columnar"
+				);
+			}
+		}
+
+		rows_count++;
+	}
+
+	return rows_count;
+}
+
 void PgStatementImpl::set_int16_impl(size_t index, int16_t value)
 {
 	set_value_parameter(index, value);
@@ -1824,13 +3694,48 @@ void PgStatementImpl::set_double_impl(size_t index, double value)
 }
 
 void PgStatementImpl::set_u8str_impl(size_t index, const std::string& text)
+{
+	set_text_impl(index, text);
+}
+
+void PgStatementImpl::set_text_impl(size_t index, std::string_view text)
 {
 	auto& str_buf = param_data_.at(index - 1).str;
-	str_buf.assign(text.begin(), text.end());
+	bool is_binary = true;
+
+	switch (param_types_.at(index - 1))
+	{
+	case NUMERICOID:
+		is_binary = str_to_pg_numeric(text, str_buf);
+		break;
+
+	case UUIDOID:
+	{
+		PgUuid uuid;
+		is_binary = str_to_pg_uuid(text, uuid);
+		if (is_binary) str_buf.assign(uuid.begin(), uuid.end());
+		break;
+	}
+
+	case JSONBOID:
+		str_buf.assign(1, JsonbVersion);
+		str_buf.insert(str_buf.end(), text.begin(), text.end());
+		break;
+
+	default:
+		str_buf.assign(text.begin(), text.end());
+		break;
+	}
+
+	// value is passed in text format and converted by server if client can't convert it
+	if (!is_binary) str_buf.assign(text.begin(), text.end());
+
+	size_t len = str_buf.size();
 	str_buf.push_back(0);
 
 	param_values_.at(index - 1) = str_buf.data();
-	param_lengths_.at(index - 1) = (int)text.length();
+	param_lengths_.at(index - 1) = (int)len;
+	param_formats_.at(index - 1) = is_binary ? 1 : 0;
 }
 
 void PgStatementImpl::set_wstr_impl(size_t index, const std::wstring& text)
@@ -1843,21 +3748,23 @@ template<typename T>
 T PgStatementImpl::get_value_impl(size_t col_index)
 {
 	T result {};
-	const char* value = lib_->api.f_PQgetvalue(result_.get(), 0, (int)col_index - 1);
 
 	if constexpr (std::is_same_v<T, std::string>)
 	{
-		int len = lib_->api.f_PQgetlength(result_.get(), 0, (int)col_index - 1);
-		result.assign(value, value + len);
+		result = get_text_view(col_index);
 	}
 	else if constexpr (std::is_same_v<T, std::wstring>)
 	{
-		int len = lib_->api.f_PQgetlength(result_.get(), 0, (int)col_index - 1);
-		utf8_to_utf16(std::string_view{ value , (size_t)len }, utf8_to_utf16_buffer_);
+		utf8_to_utf16(get_text_view(col_index), utf8_to_utf16_buffer_);
 		result = utf8_to_utf16_buffer_;
 	}
 	else
 	{
+		const char* value = lib_->api.f_PQgetvalue(result_.get(), row_, (int)col_index - 1);
+
+		if (lib_->api.f_PQftype(result_.get(), (int)col_index - 1) == BOOLOID)
+			return (T)(value[0] != 0);
+
 		int len = lib_->api.f_PQfsize(result_.get(), (int)col_index - 1);
 		if (len != sizeof(T))
 			throw InternalException("Real value size and size of type doesn't match", -1, -1);
@@ -1869,6 +3776,20 @@ T PgStatementImpl::get_value_impl(size_t col_index)
 }
 
 
+std::string_view PgStatementImpl::get_text_view(size_t col_index)
+{
+	auto &api = lib_->api;
+	auto *res = result_.get();
+	int col = (int)col_index - 1;
+
+	return pg_value_to_text(
+		api.f_PQftype(res, col),
+		api.f_PQgetvalue(res, row_, col),
+		api.f_PQgetlength(res, row_, col),
+		text_buffer_
+	);
+}
+
 int16_t PgStatementImpl::get_int16_impl(size_t index)
 {
 	return get_value_impl<int16_t>(index);
@@ -1906,6 +3827,7 @@ std::wstring PgStatementImpl::get_wstr_impl(size_t index)
 
 void PgStatementImpl::put_copy_data(const char* data, int data_len)
 {
+	conn_->count_call(NativeCallType::Copy, false, data_len);
 	auto put_data_res = lib_->api.f_PQputCopyData(conn_->get_connection(), data, data_len);
 
 	check_ret_code(
@@ -1918,6 +3840,7 @@ void PgStatementImpl::put_copy_data(const char* data, int data_len)
 		ErrorType::Normal
 	);
 
+	conn_->count_call(NativeCallType::Copy, true);
 	auto put_end_res = lib_->api.f_PQputCopyEnd(conn_->get_connection(), nullptr);
 
 	check_ret_code(
@@ -1930,6 +3853,7 @@ void PgStatementImpl::put_copy_data(const char* data, int data_len)
 		ErrorType::Normal
 	);
 
+	conn_->count_call(NativeCallType::Fetch, false);
 	result_.set(lib_->api.f_PQgetResult(conn_->get_connection()));
 	if (!result_.get()) return;
 
@@ -1949,6 +3873,342 @@ void PgStatementImpl::put_buffer(const PgBuffer& buffer)
 	put_copy_data(buffer.get_data(), (int)buffer.get_size());
 }
 
+std::optional<bool> PgStatementImpl::get_bool_opt(const IndexOrName &column)
+{
+	auto value = get_value_opt_impl<int32_t>(column);
+	if (!value.has_value()) return {};
+	return *value != 0;
+}
+
+void PgStatementImpl::set_bool_opt(const IndexOrName &param, std::optional<bool> value)
+{
+	check_is_in_prepared_or_executed_state();
+
+	sql_preprocessor_.do_for_param_indexes(
+		param,
+		[&](size_t param_index)
+		{
+			Oid param_oid = param_types_.at(param_index - 1);
+
+			if (!value.has_value())
+				param_values_.at(param_index - 1) = nullptr;
+
+			else if (param_oid == BOOLOID)
+			{
+				char* data = param_data_.at(param_index - 1).fixed_buffer.data();
+				data[0] = *value ? 1 : 0;
+				param_values_.at(param_index - 1) = data;
+				param_lengths_.at(param_index - 1) = 1;
+			}
+
+			else
+				set_param_with_type_cvt(*this, oid_to_value_type(param_oid), param_index, (int32_t)*value);
+		}
+	);
+}
+
+std::optional<PgUuid> PgStatementImpl::get_uuid_opt(const IndexOrName &column)
+{
+	return get_dt_opt_impl<PgUuid>(
+		column,
+		UUIDOID,
+		"Result is not in uuid format",
+		[this](size_t index) {
+			PgUuid result;
+			const char* value = lib_->api.f_PQgetvalue(result_.get(), row_, (int)index - 1);
+			memcpy(result.data(), value, result.size());
+			return result;
+		}
+	);
+}
+
+void PgStatementImpl::set_uuid_opt(const IndexOrName &param, const std::optional<PgUuid> &value)
+{
+	check_is_in_prepared_or_executed_state();
+
+	sql_preprocessor_.do_for_param_indexes(
+		param,
+		[&](size_t param_index)
+		{
+			Oid param_oid = param_types_.at(param_index - 1);
+
+			if (!value.has_value())
+				param_values_.at(param_index - 1) = nullptr;
+
+			else if (param_oid == UUIDOID)
+			{
+				auto& str_buf = param_data_.at(param_index - 1).str;
+				str_buf.assign(value->begin(), value->end());
+				param_values_.at(param_index - 1) = str_buf.data();
+				param_lengths_.at(param_index - 1) = (int)value->size();
+				param_formats_.at(param_index - 1) = 1;
+			}
+
+			else
+				set_param_with_type_cvt(*this, oid_to_value_type(param_oid), param_index, pg_uuid_to_str(*value));
+		}
+	);
+}
+
+std::string_view PgStatementImpl::get_json_view(const IndexOrName &column)
+{
+	check_contains_data();
+
+	size_t index = columns_helper_.get_column_index(column);
+	if (is_null_impl(index)) return {};
+
+	switch (lib_->api.f_PQftype(result_.get(), (int)index - 1))
+	{
+	case JSONOID:
+	case JSONBOID:
+	case TEXTOID:
+	case VARCHAROID:
+		return get_text_view(index);
+	}
+
+	throw WrongTypeConvException("Result is not in json format");
+}
+
+void PgStatementImpl::set_json(const IndexOrName &param, std::string_view json)
+{
+	check_is_in_prepared_or_executed_state();
+
+	sql_preprocessor_.do_for_param_indexes(
+		param,
+		[&](size_t param_index)
+		{
+			switch (param_types_.at(param_index - 1))
+			{
+			case JSONOID:
+			case JSONBOID:
+			case TEXTOID:
+			case VARCHAROID:
+				set_text_impl(param_index, json);
+				break;
+
+			default:
+				throw WrongTypeConvException("Parameter is not in json format");
+			}
+		}
+	);
+}
+
+
+/* class PgNotificationListener */
+
+PgNotificationListener::~PgNotificationListener()
+{}
+
+
+/* class PgNotificationListenerImpl */
+
+PgNotificationListenerImpl::PgNotificationListenerImpl(const PgLibDataPtr &lib, const PgConnectionImplPtr &conn, const PgListenerParams &params) :
+	lib_(lib),
+	conn_(conn),
+	params_(params)
+{}
+
+void PgNotificationListenerImpl::listen(std::string_view channel, const PgNotificationHandler &handler)
+{
+	auto it = handlers_.find(channel);
+	if (it != handlers_.end())
+	{
+		it->second = handler;
+		return;
+	}
+
+	if (is_connection_lost()) reconnect();
+	exec("LISTEN", channel);
+	handlers_.emplace(channel, handler);
+}
+
+void PgNotificationListenerImpl::unlisten(std::string_view channel)
+{
+	auto it = handlers_.find(channel);
+	if (it == handlers_.end()) return;
+
+	handlers_.erase(it);
+	if (!is_connection_lost()) exec("UNLISTEN", channel);
+}
+
+void PgNotificationListenerImpl::set_reconnect_handler(const std::function<void()> &handler)
+{
+	reconnect_handler_ = handler;
+}
+
+size_t PgNotificationListenerImpl::wait(int timeout_ms)
+{
+	using Clock = std::chrono::steady_clock;
+
+	if (is_connection_lost()) reconnect();
+
+	// notifications can be read by previous command
+	size_t result = dispatch_received();
+	if (result != 0) return result;
+
+	auto deadline = Clock::now() + std::chrono::milliseconds(timeout_ms);
+
+	for (;;)
+	{
+		int rest_ms = -1;
+		if (timeout_ms >= 0)
+		{
+			auto rest = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now());
+			rest_ms = std::max((int)rest.count(), 0);
+		}
+
+		if (!wait_for_socket(rest_ms)) return 0;
+
+		if (!consume_input())
+		{
+			reconnect();
+			return 0;
+		}
+
+		result = dispatch_received();
+		if (result != 0) return result;
+
+		// socket contained other messages
+		if (rest_ms == 0) return 0;
+	}
+}
+
+size_t PgNotificationListenerImpl::dispatch()
+{
+	if (is_connection_lost() || !consume_input())
+	{
+		reconnect();
+		return 0;
+	}
+	return dispatch_received();
+}
+
+size_t PgNotificationListenerImpl::get_reconnects_count() const
+{
+	return reconnects_count_;
+}
+
+void PgNotificationListenerImpl::exec(const char *command, std::string_view channel)
+{
+	std::string sql = command;
+	sql.append(" \"");
+	for (char chr : channel)
+	{
+		if (chr == '"') sql.push_back('"');
+		sql.push_back(chr);
+	}
+	sql.append("\"");
+
+	auto conn = conn_->get_connection();
+	conn_->skip_previous_data();
+	conn_->count_call(NativeCallType::Execute, true, sql.size());
+	PGresultHandler result(lib_->api, lib_->api.f_PQexec(conn, sql.c_str()));
+	check_exec_result(lib_->api, conn, result.get(), { PGRES_COMMAND_OK }, sql, ErrorType::Normal);
+}
+
+bool PgNotificationListenerImpl::is_connection_lost()
+{
+	return
+		!conn_->is_connected() ||
+		(lib_->api.f_PQstatus(conn_->get_connection()) == CONNECTION_BAD);
+}
+
+void PgNotificationListenerImpl::reconnect()
+{
+	if (!params_.auto_reconnect)
+	{
+		throw ConnectionLostException(
+			"Connection of notification listener is lost",
+			(int)CONNECTION_BAD,
+			0
+		);
+	}
+
+	if (conn_->is_connected()) conn_->disconnect();
+	conn_->connect();
+
+	for (auto &[channel, handler] : handlers_)
+		exec("LISTEN", channel);
+
+	reconnects_count_++;
+	if (reconnect_handler_) reconnect_handler_();
+}
+
+bool PgNotificationListenerImpl::consume_input()
+{
+	conn_->count_call(NativeCallType::Fetch, false);
+	return lib_->api.f_PQconsumeInput(conn_->get_connection()) == 1;
+}
+
+// returns false on timeout
+bool PgNotificationListenerImpl::wait_for_socket(int timeout_ms)
+{
+	int socket = lib_->api.f_PQsocket(conn_->get_connection());
+	if (socket < 0)
+		throw InternalException("PQsocket returned invalid socket", socket, 0);
+
+	for (;;)
+	{
+#if defined(DBLIB_WINDOWS)
+		WSAPOLLFD fd = {};
+		fd.fd = (SOCKET)socket;
+		fd.events = POLLRDNORM;
+		int res = WSAPoll(&fd, 1, timeout_ms);
+		if (res == SOCKET_ERROR)
+			throw InternalException("WSAPoll failed", WSAGetLastError(), 0);
+#else
+		pollfd fd = {};
+		fd.fd = socket;
+		fd.events = POLLIN;
+		int res = poll(&fd, 1, timeout_ms);
+		if ((res < 0) && (errno == EINTR)) continue;
+		if (res < 0)
+			throw InternalException("poll failed", errno, 0);
+#endif
+		return res != 0;
+	}
+}
+
+size_t PgNotificationListenerImpl::dispatch_received()
+{
+	auto &api = lib_->api;
+	auto conn = conn_->get_connection();
+
+	received_.clear();
+	while (PGnotify *notify = api.f_PQnotifies(conn))
+	{
+		std::string_view channel = notify->relname ? notify->relname : "";
+		std::string_view payload = notify->extra ? notify->extra : "";
+
+		bool is_duplicate = params_.coalesce && std::any_of(
+			received_.begin(),
+			received_.end(),
+			[&](const PgNotification &item) { return (item.channel == channel) && (item.payload == payload); }
+		);
+
+		if (!is_duplicate)
+		{
+			auto &item = received_.emplace_back();
+			item.channel = channel;
+			item.payload = payload;
+			item.backend_pid = notify->be_pid;
+		}
+
+		api.f_PQfreemem(notify);
+	}
+
+	size_t result = 0;
+	for (auto &notification : received_)
+	{
+		auto it = handlers_.find(notification.channel);
+		if (it == handlers_.end()) continue;
+		it->second(notification);
+		result++;
+	}
+	return result;
+}
+
+
 PgLibPtr create_pg_lib()
 {
 	return std::make_shared<PgLibImpl>();
@@ -0,0 +1,643 @@
+/*
+
+Copyright (c) 2015-2022 Artyomov Denis (denis.artyomov@gmail.com)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+#include <string.h>
+#include <ctype.h>
+
+#include <algorithm>
+
+#include "../include/dblib/dblib_query_cache.hpp"
+
+namespace dblib {
+
+/* SQL parsing */
+
+namespace {
+
+enum class SqlTokenType
+{
+	Word,
+	QuotedWord,
+	Symbol,
+	End
+};
+
+struct SqlToken
+{
+	SqlTokenType type = SqlTokenType::End;
+	std::string_view text;
+
+	bool is_name() const
+	{
+		return (type == SqlTokenType::Word) || (type == SqlTokenType::QuotedWord);
+	}
+
+	bool is_word(const char *word) const
+	{
+		if (type != SqlTokenType::Word) return false;
+		size_t len = strlen(word);
+		if (text.size() != len) return false;
+		for (size_t i = 0; i < len; i++)
+			if (tolower((unsigned char)text[i]) != word[i]) return false;
+		return true;
+	}
+
+	bool is_symbol(char symbol) const
+	{
+		return (type == SqlTokenType::Symbol) && (text[0] == symbol);
+	}
+};
+
+class SqlTokenizer
+{
+public:
+	SqlTokenizer(std::string_view sql) :
+		sql_(sql)
+	{}
+
+	SqlToken next()
+	{
+		skip_spaces_and_comments();
+
+		SqlToken result;
+		if (pos_ >= sql_.size()) return result;
+
+		char chr = sql_[pos_];
+
+		if (is_word_char(chr))
+		{
+			size_t begin = pos_;
+			while ((pos_ < sql_.size()) && is_word_char(sql_[pos_])) pos_++;
+			result.type = SqlTokenType::Word;
+			result.text = sql_.substr(begin, pos_ - begin);
+		}
+		else if ((chr == '"') || (chr == '`') || (chr == '['))
+		{
+			char end_chr = (chr == '[') ? ']' : chr;
+			size_t begin = ++pos_;
+			while ((pos_ < sql_.size()) && (sql_[pos_] != end_chr)) pos_++;
+			result.type = SqlTokenType::QuotedWord;
+			result.text = sql_.substr(begin, pos_ - begin);
+			if (pos_ < sql_.size()) pos_++;
+		}
+		else if (chr == '\'')
+		{
+			// string literal ('' inside literal is two literals in a row)
+			size_t begin = pos_++;
+			while ((pos_ < sql_.size()) && (sql_[pos_] != '\'')) pos_++;
+			if (pos_ < sql_.size()) pos_++;
+			result.type = SqlTokenType::Symbol;
+			result.text = sql_.substr(begin, pos_ - begin);
+		}
+		else
+		{
+			result.type = SqlTokenType::Symbol;
+			result.text = sql_.substr(pos_++, 1);
+		}
+
+		return result;
+	}
+
+	SqlToken peek()
+	{
+		size_t pos = pos_;
+		auto result = next();
+		pos_ = pos;
+		return result;
+	}
+
+	size_t get_position(const SqlToken &token) const
+	{
+		return token.text.data() - sql_.data();
+	}
+
+private:
+	std::string_view sql_;
+	size_t pos_ = 0;
+
+	static bool is_word_char(char chr)
+	{
+		return isalnum((unsigned char)chr) || (chr == '_') || (chr == '$') || ((unsigned char)chr >= 0x80);
+	}
+
+	void skip_spaces_and_comments()
+	{
+		for (;;)
+		{
+			while ((pos_ < sql_.size()) && isspace((unsigned char)sql_[pos_])) pos_++;
+
+			if (sql_.substr(pos_, 2) == "--")
+			{
+				while ((pos_ < sql_.size()) && (sql_[pos_] != '\n')) pos_++;
+			}
+			else if (sql_.substr(pos_, 2) == "/*")
+			{
+				auto end = sql_.find("*/", pos_ + 2);
+				pos_ = (end == std::string_view::npos) ? sql_.size() : end + 2;
+			}
+			else
+				break;
+		}
+	}
+};
+
+std::string to_lower(std::string_view text)
+{
+	std::string result(text);
+	for (auto &chr : result)
+		chr = (char)tolower((unsigned char)chr);
+	return result;
+}
+
+// reads "name" or "schema.name". Schema is ignored. Names are compared
+// case-insensitively even if they are quoted
+std::string read_table_name(SqlTokenizer &tokenizer, const SqlToken &first_token)
+{
+	SqlToken name = first_token;
+
+	while (tokenizer.peek().is_symbol('.'))
+	{
+		tokenizer.next();
+		auto token = tokenizer.next();
+		if (!token.is_name()) break;
+		name = token;
+	}
+
+	return to_lower(name.text);
+}
+
+bool is_reserved_word(const SqlToken &token)
+{
+	static const char* words[] = {
+		"where", "join", "inner", "left", "right", "full", "cross", "outer",
+		"natural", "on", "using", "group", "order", "having", "union", "except",
+		"intersect", "limit", "offset", "rows", "fetch", "for", "window", "plan",
+		"returning", "set", "values", "lateral", "with", "select", "from",
+		"into", "do", "when", "matching"
+	};
+
+	for (auto word : words)
+		if (token.is_word(word)) return true;
+
+	return false;
+}
+
+} // namespace
+
+std::vector<std::string> get_sql_source_tables(std::string_view sql)
+{
+	std::vector<std::string> result;
+	SqlTokenizer tokenizer(sql);
+
+	auto add_table = [&result](std::string &&table)
+	{
+		if (std::find(result.begin(), result.end(), table) == result.end())
+			result.push_back(std::move(table));
+	};
+
+	for (;;)
+	{
+		auto token = tokenizer.next();
+		if (token.type == SqlTokenType::End) break;
+
+		if (!token.is_word("from") && !token.is_word("join")) continue;
+
+		for (;;)
+		{
+			// subqueries are processed by main loop
+			if (!tokenizer.peek().is_name() || is_reserved_word(tokenizer.peek())) break;
+
+			auto table = read_table_name(tokenizer, tokenizer.next());
+
+			// table function
+			if (tokenizer.peek().is_symbol('(')) break;
+
+			add_table(std::move(table));
+
+			// alias
+			if (tokenizer.peek().is_word("as"))
+			{
+				tokenizer.next();
+				tokenizer.next();
+			}
+			else if (tokenizer.peek().is_name() && !is_reserved_word(tokenizer.peek()))
+				tokenizer.next();
+
+			if (!tokenizer.peek().is_symbol(',')) break;
+			tokenizer.next();
+		}
+	}
+
+	return result;
+}
+
+std::string get_sql_target_table(std::string_view sql)
+{
+	SqlTokenizer tokenizer(sql);
+
+	auto token = tokenizer.next();
+	while (token.is_symbol('(')) token = tokenizer.next();
+
+	auto read_name = [&tokenizer]() -> std::string
+	{
+		auto token = tokenizer.next();
+		return token.is_name() ? read_table_name(tokenizer, token) : std::string();
+	};
+
+	auto skip_word = [&tokenizer](const char *word)
+	{
+		if (tokenizer.peek().is_word(word)) tokenizer.next();
+	};
+
+	if (token.is_word("insert") || token.is_word("replace"))
+	{
+		if (tokenizer.peek().is_word("or")) // INSERT OR REPLACE ...
+		{
+			tokenizer.next();
+			tokenizer.next();
+		}
+		skip_word("into");
+		return read_name();
+	}
+
+	else if (token.is_word("update"))
+	{
+		if (tokenizer.peek().is_word("or")) // UPDATE OR INSERT INTO ..., UPDATE OR REPLACE ...
+		{
+			tokenizer.next();
+			tokenizer.next();
+			skip_word("into");
+		}
+		return read_name();
+	}
+
+	else if (token.is_word("delete"))
+	{
+		skip_word("from");
+		return read_name();
+	}
+
+	else if (token.is_word("merge"))
+	{
+		skip_word("into");
+		return read_name();
+	}
+
+	else if (token.is_word("truncate"))
+	{
+		skip_word("table");
+		return read_name();
+	}
+
+	else if (token.is_word("alter") || token.is_word("drop"))
+	{
+		if (!tokenizer.peek().is_word("table")) return {};
+		tokenizer.next();
+		if (tokenizer.peek().is_word("if")) // DROP TABLE IF EXISTS
+		{
+			tokenizer.next();
+			tokenizer.next();
+		}
+		return read_name();
+	}
+
+	else if (token.is_word("with"))
+	{
+		// looking for statement after common table expressions
+		int depth = 0;
+		for (;;)
+		{
+			token = tokenizer.next();
+			if (token.type == SqlTokenType::End) break;
+			if (token.is_symbol('(')) depth++;
+			else if (token.is_symbol(')')) depth--;
+			else if ((depth == 0) && (token.is_word("select"))) break;
+			else if (
+				(depth == 0) &&
+				(token.is_word("insert") || token.is_word("update") ||
+				 token.is_word("delete") || token.is_word("merge")))
+			{
+				return get_sql_target_table(sql.substr(tokenizer.get_position(token)));
+			}
+		}
+	}
+
+	return {};
+}
+
+static bool sql_can_change_anything(std::string_view sql)
+{
+	SqlTokenizer tokenizer(sql);
+	auto token = tokenizer.next();
+
+	static const char* words[] = {
+		"insert", "update", "delete", "merge", "replace", "truncate",
+		"alter", "drop", "execute", "call", "exec", "do"
+	};
+
+	for (auto word : words)
+		if (token.is_word(word)) return true;
+
+	return false;
+}
+
+
+/* class QueryCache */
+
+QueryCache::QueryCache(const QueryCacheParams &params) :
+	params_(params)
+{}
+
+void QueryCache::make_key(std::string_view sql, const ParamValues &params, std::string &key) const
+{
+	key.assign(sql);
+
+	for (auto &param : params)
+	{
+		key.push_back('\0');
+		key.push_back((char)param.index());
+
+		std::visit([&key](const auto &value)
+		{
+			using T = std::decay_t<decltype(value)>;
+			if constexpr (std::is_same_v<T, std::string>)
+			{
+				size_t size = value.size();
+				key.append((const char*)&size, sizeof(size));
+				key.append(value);
+			}
+			else if constexpr (!std::is_same_v<T, std::monostate>)
+				key.append((const char*)&value, sizeof(value));
+		}, param);
+	}
+}
+
+ResultSetPtr QueryCache::get(std::string_view sql, const ParamValues &params)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	make_key(sql, params, key_buffer_);
+
+	auto it = items_by_key_.find(key_buffer_);
+	if (it == items_by_key_.end())
+	{
+		stats_.misses++;
+		return nullptr;
+	}
+
+	auto item_it = it->second;
+
+	if (item_it->expire_time <= Clock::now())
+	{
+		erase_item(item_it);
+		stats_.misses++;
+		return nullptr;
+	}
+
+	items_.splice(items_.begin(), items_, item_it);
+	stats_.hits++;
+
+	return item_it->result;
+}
+
+void QueryCache::put(std::string_view sql, const ParamValues &params, const ResultSetPtr &result)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	put_impl(sql, params, result, invalidations_count_);
+}
+
+void QueryCache::put_impl(
+	std::string_view    sql,
+	const ParamValues   &params,
+	const ResultSetPtr  &result,
+	uint64_t            invalidations_count)
+{
+	// result was read before invalidation
+	if (invalidations_count != invalidations_count_) return;
+
+	make_key(sql, params, key_buffer_);
+
+	auto it = items_by_key_.find(key_buffer_);
+	if (it != items_by_key_.end())
+		erase_item(it->second);
+
+	Item item;
+	item.key = key_buffer_;
+	item.tables = get_sql_source_tables(sql);
+	item.result = result;
+	item.expire_time = Clock::now() + params_.ttl;
+	item.memory_size = sizeof(Item) + item.key.capacity() + result->get_memory_size();
+	for (auto &table : item.tables)
+		item.memory_size += sizeof(table) + table.capacity();
+
+	if (item.memory_size > params_.max_memory_size) return;
+
+	items_.push_front(std::move(item));
+	items_by_key_[items_.front().key] = items_.begin();
+	memory_size_ += items_.front().memory_size;
+
+	evict_items();
+}
+
+ResultSetPtr QueryCache::query(Statement &stmt, std::string_view sql, const ParamValues &params)
+{
+	// transaction sees its own not committed changes
+	auto tran = stmt.get_transaction();
+	bool use_cache = !has_pending_invalidations(tran.get());
+
+	if (use_cache)
+	{
+		if (auto result = get(sql, params))
+			return result;
+	}
+
+	uint64_t invalidations_count = 0;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		invalidations_count = invalidations_count_;
+	}
+
+	stmt.prepare(sql);
+	stmt.set_params(params);
+	stmt.execute();
+
+	auto result = std::make_shared<ResultSet>(fetch_all_columnar(stmt));
+
+	if (use_cache)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		put_impl(sql, params, result, invalidations_count);
+	}
+
+	return result;
+}
+
+void QueryCache::execute(Statement &stmt, std::string_view sql, const ParamValues &params)
+{
+	stmt.prepare(sql);
+	stmt.set_params(params);
+	stmt.execute();
+
+	auto table = get_sql_target_table(sql);
+	bool changes_all = table.empty() && sql_can_change_anything(sql);
+
+	if (!table.empty())
+		invalidate_table(table);
+
+	else if (changes_all)
+		invalidate_all();
+
+	else
+		return;
+
+	auto tran = stmt.get_transaction();
+	if (!tran) return;
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto &pending = pending_invalidations_[tran.get()];
+	if (changes_all)
+		pending.all = true;
+	else if (std::find(pending.tables.begin(), pending.tables.end(), table) == pending.tables.end())
+		pending.tables.push_back(std::move(table));
+}
+
+void QueryCache::commit(Transaction &tran)
+{
+	tran.commit();
+
+	PendingInvalidation pending;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		auto it = pending_invalidations_.find(&tran);
+		if (it == pending_invalidations_.end()) return;
+		pending = std::move(it->second);
+		pending_invalidations_.erase(it);
+	}
+
+	// results put by other transactions before commit are removed again
+	if (pending.all)
+		invalidate_all();
+	else
+	{
+		for (auto &table : pending.tables)
+			invalidate_table(table);
+	}
+}
+
+void QueryCache::rollback(Transaction &tran)
+{
+	tran.rollback();
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	pending_invalidations_.erase(&tran);
+}
+
+bool QueryCache::has_pending_invalidations(const Transaction *tran) const
+{
+	if (tran == nullptr) return false;
+	std::lock_guard<std::mutex> lock(mutex_);
+	return pending_invalidations_.find(tran) != pending_invalidations_.end();
+}
+
+void QueryCache::erase_item(Items::iterator it)
+{
+	memory_size_ -= it->memory_size;
+	items_by_key_.erase(it->key);
+	items_.erase(it);
+}
+
+void QueryCache::evict_items()
+{
+	while (!items_.empty() && (memory_size_ > params_.max_memory_size))
+	{
+		erase_item(std::prev(items_.end()));
+		stats_.evictions++;
+	}
+}
+
+void QueryCache::invalidate_table(std::string_view table_name)
+{
+	// "schema.name" and quoted names are read the same way as in sql
+	SqlTokenizer tokenizer(table_name);
+	auto first_token = tokenizer.next();
+	auto table = first_token.is_name() ? read_table_name(tokenizer, first_token) : to_lower(table_name);
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	invalidations_count_++;
+
+	for (auto it = items_.begin(); it != items_.end();)
+	{
+		auto cur_it = it++;
+		auto &tables = cur_it->tables;
+		if (std::find(tables.begin(), tables.end(), table) != tables.end())
+		{
+			erase_item(cur_it);
+			stats_.invalidations++;
+		}
+	}
+}
+
+void QueryCache::invalidate_by_sql(std::string_view sql)
+{
+	auto table = get_sql_target_table(sql);
+
+	if (!table.empty())
+		invalidate_table(table);
+
+	else if (sql_can_change_anything(sql))
+		invalidate_all();
+}
+
+void QueryCache::invalidate_all()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	invalidations_count_++;
+	stats_.invalidations += items_.size();
+
+	items_by_key_.clear();
+	items_.clear();
+	memory_size_ = 0;
+}
+
+size_t QueryCache::get_items_count() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return items_.size();
+}
+
+size_t QueryCache::get_memory_size() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return memory_size_;
+}
+
+QueryCacheStats QueryCache::get_stats() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return stats_;
+}
+
+} // namespace dblib
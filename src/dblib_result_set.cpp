@@ -0,0 +1,642 @@
+/*
+
+Copyright (c) 2015-2022 Artyomov Denis (denis.artyomov@gmail.com)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+#include <string.h>
+
+#include "../include/dblib/dblib_result_set.hpp"
+#include "../include/dblib/dblib_exception.hpp"
+#include "dblib_type_cvt.hpp"
+#include "dblib_stmt_tools.hpp"
+
+namespace dblib {
+
+/* class ResultColumn */
+
+ResultColumn::ResultColumn(std::string_view name, ValueType type) :
+	name_(name),
+	type_(type)
+{
+	init_storage();
+}
+
+const std::string& ResultColumn::get_name() const
+{
+	return name_;
+}
+
+ValueType ResultColumn::get_type() const
+{
+	return type_;
+}
+
+void ResultColumn::set_type(ValueType type)
+{
+	if (type == type_) return;
+
+	if ((type_ != ValueType::Null) && (rows_count_ != 0))
+		throw WrongSeqException("Type of not empty column " + name_ + " can't be changed");
+
+	type_ = type;
+	init_storage();
+}
+
+size_t ResultColumn::get_rows_count() const
+{
+	return rows_count_;
+}
+
+void ResultColumn::init_storage()
+{
+	// all rows before type initialization are null rows
+	switch (type_)
+	{
+	case ValueType::Short:
+		values_ = std::vector<int16_t>(rows_count_);
+		break;
+
+	case ValueType::Integer:
+	case ValueType::Boolean:
+		values_ = std::vector<int32_t>(rows_count_);
+		break;
+
+	case ValueType::BigInt:
+		values_ = std::vector<int64_t>(rows_count_);
+		break;
+
+	case ValueType::Float:
+		values_ = std::vector<float>(rows_count_);
+		break;
+
+	case ValueType::Double:
+		values_ = std::vector<double>(rows_count_);
+		break;
+
+	case ValueType::Date:
+		values_ = std::vector<Date>(rows_count_);
+		break;
+
+	case ValueType::Time:
+		values_ = std::vector<Time>(rows_count_);
+		break;
+
+	case ValueType::Timestamp:
+		values_ = std::vector<TimeStamp>(rows_count_);
+		break;
+
+	default:
+		values_ = std::monostate{};
+		break;
+	}
+
+	arena_.clear();
+	offsets_.clear();
+	if (is_arena_type())
+		offsets_.assign(rows_count_ + 1, 0);
+}
+
+bool ResultColumn::is_arena_type() const
+{
+	return
+		(type_ == ValueType::Char) ||
+		(type_ == ValueType::Varchar) ||
+		(type_ == ValueType::Blob);
+}
+
+void ResultColumn::reserve(size_t rows_count)
+{
+	std::visit([rows_count](auto& values)
+	{
+		if constexpr (!std::is_same_v<std::decay_t<decltype(values)>, std::monostate>)
+			values.reserve(rows_count);
+	}, values_);
+
+	if (is_arena_type())
+		offsets_.reserve(rows_count + 1);
+
+	null_bitmap_.reserve((rows_count + 63) / 64);
+}
+
+void ResultColumn::clear()
+{
+	std::visit([](auto& values)
+	{
+		if constexpr (!std::is_same_v<std::decay_t<decltype(values)>, std::monostate>)
+			values.clear();
+	}, values_);
+
+	arena_.clear();
+	offsets_.clear();
+	if (is_arena_type())
+		offsets_.push_back(0);
+
+	null_bitmap_.clear();
+	rows_count_ = 0;
+}
+
+void ResultColumn::mark_row(bool is_null)
+{
+	size_t word_index = rows_count_ / 64;
+	if (word_index >= null_bitmap_.size())
+		null_bitmap_.push_back(0);
+
+	if (is_null)
+		null_bitmap_[word_index] |= uint64_t(1) << (rows_count_ % 64);
+
+	rows_count_++;
+}
+
+void ResultColumn::check_row(size_t row) const
+{
+	if (row >= rows_count_)
+		throw WrongArgumentException("Row " + std::to_string(row) + " is out of range of column " + name_);
+}
+
+template <typename T>
+void ResultColumn::append_value(const T &value, const char *type_name)
+{
+	auto *values = std::get_if<std::vector<T>>(&values_);
+	if (!values)
+		throw WrongTypeConvException(type_name, field_type_to_string(type_));
+
+	values->push_back(value);
+	mark_row(false);
+}
+
+void ResultColumn::append_null()
+{
+	if (is_arena_type())
+		offsets_.push_back(arena_.size());
+	else
+	{
+		std::visit([](auto& values)
+		{
+			if constexpr (!std::is_same_v<std::decay_t<decltype(values)>, std::monostate>)
+				values.emplace_back();
+		}, values_);
+	}
+
+	mark_row(true);
+}
+
+void ResultColumn::append_int16(int16_t value)
+{
+	append_value(value, "int16_t");
+}
+
+void ResultColumn::append_int32(int32_t value)
+{
+	append_value(value, "int32_t");
+}
+
+void ResultColumn::append_int64(int64_t value)
+{
+	append_value(value, "int64_t");
+}
+
+void ResultColumn::append_float(float value)
+{
+	append_value(value, "float");
+}
+
+void ResultColumn::append_double(double value)
+{
+	append_value(value, "double");
+}
+
+void ResultColumn::append_str(std::string_view text)
+{
+	append_blob(text.data(), text.size());
+}
+
+void ResultColumn::append_blob(const char *data, size_t size)
+{
+	if (!is_arena_type())
+		throw WrongTypeConvException("string", field_type_to_string(type_));
+
+	arena_.insert(arena_.end(), data, data + size);
+	offsets_.push_back(arena_.size());
+	mark_row(false);
+}
+
+void ResultColumn::append_date(const Date &date)
+{
+	append_value(date, "Date");
+}
+
+void ResultColumn::append_time(const Time &time)
+{
+	append_value(time, "Time");
+}
+
+void ResultColumn::append_timestamp(const TimeStamp &ts)
+{
+	append_value(ts, "TimeStamp");
+}
+
+bool ResultColumn::is_null(size_t row) const
+{
+	check_row(row);
+	return (null_bitmap_[row / 64] >> (row % 64)) & 1;
+}
+
+template <typename T>
+const T& ResultColumn::get_value(size_t row, const char *type_name) const
+{
+	check_row(row);
+
+	auto *values = std::get_if<std::vector<T>>(&values_);
+	if (!values)
+		throw WrongTypeConvException(field_type_to_string(type_), type_name);
+
+	return (*values)[row];
+}
+
+template <typename T>
+T ResultColumn::get_number(size_t row, const char *type_name) const
+{
+	check_row(row);
+
+	switch (type_)
+	{
+	case ValueType::Short:
+		return int_to<T>(std::get<std::vector<int16_t>>(values_)[row]);
+
+	case ValueType::Integer:
+	case ValueType::Boolean:
+		return int_to<T>(std::get<std::vector<int32_t>>(values_)[row]);
+
+	case ValueType::BigInt:
+		return int_to<T>(std::get<std::vector<int64_t>>(values_)[row]);
+
+	case ValueType::Float:
+		return float_to<T>(std::get<std::vector<float>>(values_)[row]);
+
+	case ValueType::Double:
+		return float_to<T>(std::get<std::vector<double>>(values_)[row]);
+
+	case ValueType::Char:
+	case ValueType::Varchar:
+		if (is_null(row)) return T();
+		return str_to<T>(std::string(get_arena_item(row)));
+
+	default:
+		break;
+	}
+
+	throw WrongTypeConvException(field_type_to_string(type_), type_name);
+}
+
+std::string_view ResultColumn::get_arena_item(size_t row) const
+{
+	size_t begin = offsets_[row];
+	size_t end = offsets_[row + 1];
+	return std::string_view(arena_.data() + begin, end - begin);
+}
+
+int16_t ResultColumn::get_int16(size_t row) const
+{
+	return get_number<int16_t>(row, "int16_t");
+}
+
+int32_t ResultColumn::get_int32(size_t row) const
+{
+	return get_number<int32_t>(row, "int32_t");
+}
+
+int64_t ResultColumn::get_int64(size_t row) const
+{
+	return get_number<int64_t>(row, "int64_t");
+}
+
+float ResultColumn::get_float(size_t row) const
+{
+	return get_number<float>(row, "float");
+}
+
+double ResultColumn::get_double(size_t row) const
+{
+	return get_number<double>(row, "double");
+}
+
+std::string_view ResultColumn::get_str(size_t row) const
+{
+	check_row(row);
+	if (!is_arena_type())
+		throw WrongTypeConvException(field_type_to_string(type_), "string");
+	return get_arena_item(row);
+}
+
+std::string_view ResultColumn::get_blob(size_t row) const
+{
+	return get_str(row);
+}
+
+const Date& ResultColumn::get_date(size_t row) const
+{
+	return get_value<Date>(row, "Date");
+}
+
+const Time& ResultColumn::get_time(size_t row) const
+{
+	return get_value<Time>(row, "Time");
+}
+
+const TimeStamp& ResultColumn::get_timestamp(size_t row) const
+{
+	return get_value<TimeStamp>(row, "TimeStamp");
+}
+
+const std::vector<uint64_t>& ResultColumn::get_null_bitmap() const
+{
+	return null_bitmap_;
+}
+
+const std::vector<char>& ResultColumn::get_arena() const
+{
+	return arena_;
+}
+
+const std::vector<size_t>& ResultColumn::get_offsets() const
+{
+	return offsets_;
+}
+
+size_t ResultColumn::get_memory_size() const
+{
+	size_t result = sizeof(*this) + name_.capacity();
+
+	std::visit([&result](const auto& values)
+	{
+		if constexpr (!std::is_same_v<std::decay_t<decltype(values)>, std::monostate>)
+			result += values.capacity() * sizeof(values[0]);
+	}, values_);
+
+	result += null_bitmap_.capacity() * sizeof(uint64_t);
+	result += arena_.capacity();
+	result += offsets_.capacity() * sizeof(size_t);
+
+	return result;
+}
+
+
+/* class ResultSet */
+
+size_t ResultSet::get_rows_count() const
+{
+	return columns_.empty() ? 0 : columns_.front().get_rows_count();
+}
+
+size_t ResultSet::get_columns_count() const
+{
+	return columns_.size();
+}
+
+ResultColumn& ResultSet::get_column(size_t index)
+{
+	if ((index == 0) || (index > columns_.size()))
+		throw ColumnNotFoundException(std::to_string(index));
+	return columns_[index - 1];
+}
+
+const ResultColumn& ResultSet::get_column(size_t index) const
+{
+	if ((index == 0) || (index > columns_.size()))
+		throw ColumnNotFoundException(std::to_string(index));
+	return columns_[index - 1];
+}
+
+const ResultColumn& ResultSet::get_column(std::string_view name) const
+{
+	return columns_[get_column_index(name) - 1];
+}
+
+size_t ResultSet::get_column_index(std::string_view name) const
+{
+	CaseInsensitiveComparer less;
+	for (size_t i = 0; i < columns_.size(); i++)
+	{
+		const auto &column_name = columns_[i].get_name();
+		if (!less(column_name, name) && !less(name, column_name))
+			return i + 1;
+	}
+	throw ColumnNotFoundException(name);
+}
+
+ResultColumn& ResultSet::add_column(std::string_view name, ValueType type)
+{
+	if (get_rows_count() != 0)
+		throw WrongSeqException("Can't add column into not empty result set");
+
+	return columns_.emplace_back(name, type);
+}
+
+void ResultSet::reserve(size_t rows_count)
+{
+	for (auto &column : columns_)
+		column.reserve(rows_count);
+}
+
+void ResultSet::clear_rows()
+{
+	for (auto &column : columns_)
+		column.clear();
+}
+
+void ResultSet::clear()
+{
+	columns_.clear();
+}
+
+size_t ResultSet::get_memory_size() const
+{
+	size_t result = sizeof(*this);
+	for (auto &column : columns_)
+		result += column.get_memory_size();
+	return result;
+}
+
+
+/* Statement::fetch_columnar */
+
+static ValueType get_columnar_type(Statement &stmt, size_t index)
+{
+	auto type = stmt.get_column_type(index);
+	if ((type == ValueType::Any) || (type == ValueType::None))
+		type = ValueType::Varchar;
+	return type;
+}
+
+size_t Statement::fetch_columnar(ResultSet& result, size_t max_rows)
+{
+	size_t columns_count = get_columns_count();
+
+	if (result.get_columns_count() == 0)
+	{
+		for (size_t i = 1; i <= columns_count; i++)
+			result.add_column(get_column_name(i), ValueType::Null);
+	}
+	else if (result.get_columns_count() != columns_count)
+		throw WrongArgumentException("Columns count of result set and statement are different");
+
+	std::vector<char> blob_buffer;
+	size_t rows_count = 0;
+
+	while (((max_rows == 0) || (rows_count < max_rows)) && fetch())
+	{
+		for (size_t i = 1; i <= columns_count; i++)
+		{
+			auto &column = result.get_column(i);
+
+			if (is_null(i))
+			{
+				column.append_null();
+				continue;
+			}
+
+			if (column.get_type() == ValueType::Null)
+				column.set_type(get_columnar_type(*this, i));
+
+			switch (column.get_type())
+			{
+			case ValueType::Short:
+				column.append_int16(int_to<int16_t>(get_int32(i)));
+				break;
+
+			case ValueType::Integer:
+			case ValueType::Boolean:
+				column.append_int32(get_int32(i));
+				break;
+
+			case ValueType::BigInt:
+				column.append_int64(get_int64(i));
+				break;
+
+			case ValueType::Float:
+				column.append_float(get_float(i));
+				break;
+
+			case ValueType::Double:
+				column.append_double(get_double(i));
+				break;
+
+			case ValueType::Char:
+			case ValueType::Varchar:
+				column.append_str(get_str_utf8(i));
+				break;
+
+			case ValueType::Blob:
+				blob_buffer.resize(get_blob_size(i));
+				get_blob_data(i, blob_buffer.data(), blob_buffer.size());
+				column.append_blob(blob_buffer.data(), blob_buffer.size());
+				break;
+
+			case ValueType::Date:
+				column.append_date(get_date(i));
+				break;
+
+			case ValueType::Time:
+				column.append_time(get_time(i));
+				break;
+
+			case ValueType::Timestamp:
+				column.append_timestamp(get_timestamp(i));
+				break;
+
+			default:
+				throw WrongTypeConvException(field_type_to_string(column.get_type()), "columnar value");
+			}
+		}
+
+		rows_count++;
+	}
+
+	return rows_count;
+}
+
+ResultSet fetch_all_columnar(Statement &stmt)
+{
+	ResultSet result;
+	stmt.fetch_columnar(result);
+	return result;
+}
+
+void set_param_from_column(Statement &stmt, const IndexOrName &param, const ResultColumn &column, size_t row)
+{
+	if (column.is_null(row))
+	{
+		stmt.set_null(param);
+		return;
+	}
+
+	switch (column.get_type())
+	{
+	case ValueType::Short:
+	case ValueType::Integer:
+	case ValueType::Boolean:
+		stmt.set_int32(param, column.get_int32(row));
+		break;
+
+	case ValueType::BigInt:
+		stmt.set_int64(param, column.get_int64(row));
+		break;
+
+	case ValueType::Float:
+		stmt.set_float(param, column.get_float(row));
+		break;
+
+	case ValueType::Double:
+		stmt.set_double(param, column.get_double(row));
+		break;
+
+	case ValueType::Char:
+	case ValueType::Varchar:
+		stmt.set_u8str(param, std::string(column.get_str(row)));
+		break;
+
+	case ValueType::Blob:
+	{
+		auto blob = column.get_blob(row);
+		stmt.set_blob(param, blob.data(), blob.size());
+		break;
+	}
+
+	case ValueType::Date:
+		stmt.set_date(param, column.get_date(row));
+		break;
+
+	case ValueType::Time:
+		stmt.set_time(param, column.get_time(row));
+		break;
+
+	case ValueType::Timestamp:
+		stmt.set_timestamp(param, column.get_timestamp(row));
+		break;
+
+	default:
+		stmt.set_null(param);
+		break;
+	}
+}
+
+} // namespace dblib
@@ -0,0 +1,529 @@
+/*
+
+Copyright (c) 2015-2022 Artyomov Denis (denis.artyomov@gmail.com)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+
+#include "../include/dblib/dblib_schema.hpp"
+#include "../include/dblib/dblib_exception.hpp"
+#include "../include/dblib/dblib_cvt_utils.hpp"
+#include "dblib_stmt_tools.hpp"
+
+namespace dblib {
+
+namespace {
+
+// Every query returns rows
+//   kind, table, index, column, type, not_null, is_unique, is_primary, position
+// kind is 'C' for column (index is empty) and 'I' for column of index
+
+const char *pg_schema_sql =
+	"select "
+		"cast('C' as varchar), cast(c.relname as varchar), cast('' as varchar), cast(a.attname as varchar), "
+		"cast(t.typname as varchar), cast(a.attnotnull as integer), 0, 0, cast(a.attnum as integer) "
+	"from pg_class c "
+	"join pg_namespace n on n.oid = c.relnamespace "
+	"join pg_attribute a on a.attrelid = c.oid "
+	"join pg_type t on t.oid = a.atttypid "
+	"where n.nspname = current_schema() and c.relkind in ('r', 'p', 'v', 'm', 'f') "
+		"and a.attnum > 0 and not a.attisdropped "
+	"union all "
+	"select "
+		"'I', cast(c.relname as varchar), cast(ic.relname as varchar), cast(a.attname as varchar), "
+		"'', 0, cast(i.indisunique as integer), cast(i.indisprimary as integer), cast(k.position as integer) "
+	"from pg_index i "
+	"join pg_class c on c.oid = i.indrelid "
+	"join pg_namespace n on n.oid = c.relnamespace "
+	"join pg_class ic on ic.oid = i.indexrelid "
+	"cross join lateral unnest(cast(i.indkey as int2[])) with ordinality as k(attnum, position) "
+	"join pg_attribute a on a.attrelid = c.oid and a.attnum = k.attnum "
+	"where n.nspname = current_schema() and k.position <= i.indnkeyatts "
+	"order by 2, 1, 3, 9";
+
+const char *fb_schema_sql =
+	"select "
+		"cast('C' as varchar(1)), trim(rf.rdb$relation_name), cast('' as varchar(63)), trim(rf.rdb$field_name), "
+		"cast(case f.rdb$field_type "
+			"when 7 then case when f.rdb$field_scale < 0 then 'numeric' else 'smallint' end "
+			"when 8 then case when f.rdb$field_scale < 0 then 'numeric' else 'integer' end "
+			"when 16 then case when f.rdb$field_scale < 0 then 'numeric' else 'bigint' end "
+			"when 10 then 'float' "
+			"when 27 then 'double precision' "
+			"when 14 then 'char' "
+			"when 37 then 'varchar' "
+			"when 12 then 'date' "
+			"when 13 then 'time' "
+			"when 35 then 'timestamp' "
+			"when 23 then 'boolean' "
+			"when 261 then case when f.rdb$field_sub_type = 1 then 'text' else 'blob' end "
+			"else 'unknown' "
+		"end as varchar(31)), "
+		"coalesce(rf.rdb$null_flag, f.rdb$null_flag, 0), 0, 0, rf.rdb$field_position "
+	"from rdb$relation_fields rf "
+	"join rdb$relations r on r.rdb$relation_name = rf.rdb$relation_name "
+	"join rdb$fields f on f.rdb$field_name = rf.rdb$field_source "
+	"where coalesce(r.rdb$system_flag, 0) = 0 "
+	"union all "
+	"select "
+		"'I', trim(i.rdb$relation_name), trim(i.rdb$index_name), trim(s.rdb$field_name), "
+		"'', 0, coalesce(i.rdb$unique_flag, 0), iif(rc.rdb$index_name is null, 0, 1), s.rdb$field_position "
+	"from rdb$indices i "
+	"join rdb$index_segments s on s.rdb$index_name = i.rdb$index_name "
+	"left join rdb$relation_constraints rc "
+		"on rc.rdb$index_name = i.rdb$index_name and rc.rdb$constraint_type = 'PRIMARY KEY' "
+	"where coalesce(i.rdb$system_flag, 0) = 0 "
+	"order by 2, 1, 3, 9";
+
+// integer primary key of SQLite is alias of rowid and has no index
+// in pragma_index_list so primary key is taken from pragma_table_info
+
+const char *sqlite_schema_sql =
+	"select 'C', m.name, '', p.name, p.type, p.\"notnull\", 0, 0, p.cid "
+	"from sqlite_master m join pragma_table_info(m.name) p "
+	"where m.type in ('table', 'view') and m.name not like 'sqlite\\_%' escape '\\' "
+	"union all "
+	"select 'I', m.name, 'primary', p.name, '', 0, 1, 1, p.pk "
+	"from sqlite_master m join pragma_table_info(m.name) p "
+	"where m.type = 'table' and m.name not like 'sqlite\\_%' escape '\\' and p.pk > 0 "
+	"union all "
+	"select 'I', m.name, il.name, ii.name, '', 0, il.\"unique\", 0, ii.seqno "
+	"from sqlite_master m "
+	"join pragma_index_list(m.name) il "
+	"join pragma_index_info(il.name) ii "
+	"where m.type = 'table' and m.name not like 'sqlite\\_%' escape '\\' and il.origin <> 'pk' and ii.name is not null "
+	"order by 2, 1, 3, 9";
+
+ValueType value_type_from_type_name(std::string_view type_name)
+{
+	std::string name;
+	for (char chr : type_name)
+	{
+		if (chr == '(') break;
+		name.push_back((char)tolower((unsigned char)chr));
+	}
+	while (!name.empty() && name.back() == ' ')
+		name.pop_back();
+
+	static const std::map<std::string, ValueType, std::less<>> types = {
+		{ "smallint",                    ValueType::Short     },
+		{ "int2",                        ValueType::Short     },
+		{ "integer",                     ValueType::Integer   },
+		{ "int",                         ValueType::Integer   },
+		{ "int4",                        ValueType::Integer   },
+		{ "bigint",                      ValueType::BigInt    },
+		{ "int8",                        ValueType::BigInt    },
+		{ "real",                        ValueType::Float     },
+		{ "float",                       ValueType::Float     },
+		{ "float4",                      ValueType::Float     },
+		{ "double",                      ValueType::Double    },
+		{ "double precision",            ValueType::Double    },
+		{ "float8",                      ValueType::Double    },
+		// numeric is converted into text by drivers to keep precision
+		{ "numeric",                     ValueType::Varchar   },
+		{ "decimal",                     ValueType::Varchar   },
+		{ "char",                        ValueType::Char      },
+		{ "character",                   ValueType::Char      },
+		{ "bpchar",                      ValueType::Char      },
+		{ "varchar",                     ValueType::Varchar   },
+		{ "character varying",           ValueType::Varchar   },
+		{ "text",                        ValueType::Varchar   },
+		{ "boolean",                     ValueType::Boolean   },
+		{ "bool",                        ValueType::Boolean   },
+		{ "date",                        ValueType::Date      },
+		{ "time",                        ValueType::Time      },
+		{ "timetz",                      ValueType::Time      },
+		{ "timestamp",                   ValueType::Timestamp },
+		{ "timestamptz",                 ValueType::Timestamp },
+		{ "datetime",                    ValueType::Timestamp },
+		{ "bytea",                       ValueType::Blob      },
+		{ "blob",                        ValueType::Blob      },
+	};
+
+	auto it = types.find(name);
+	return (it != types.end()) ? it->second : ValueType::Any;
+}
+
+bool is_same_name(std::string_view name1, std::string_view name2)
+{
+	CaseInsensitiveComparer less;
+	return !less(name1, name2) && !less(name2, name1);
+}
+
+template <typename T>
+const T* find_by_name(const std::vector<T> &items, std::string_view name)
+{
+	auto it = std::find_if(items.begin(), items.end(), [name](auto &item) { return is_same_name(item.name, name); });
+	return (it != items.end()) ? &*it : nullptr;
+}
+
+// File of catalog is text. Line is tag and fields separated by tab:
+//   dblib_schema_catalog <format version>
+//   version <version>
+//   driver <driver name>
+//   T <table name>
+//   C <name> <type name> <value type> <nullable>
+//   I <name> <is unique> <is primary> <columns> ...
+//   P <primary key columns> ...
+
+const char *catalog_file_signature = "dblib_schema_catalog";
+const char *catalog_file_format = "1";
+
+void append_field(std::string &line, std::string_view text)
+{
+	line.push_back('\t');
+	for (char chr : text)
+	{
+		switch (chr)
+		{
+		case '\t': line.append("\\t"); break;
+		case '\n': line.append("\\n"); break;
+		case '\\': line.append("\\\\"); break;
+		default: line.push_back(chr); break;
+		}
+	}
+}
+
+std::vector<std::string> split_line(std::string_view line)
+{
+	std::vector<std::string> result(1);
+	for (size_t i = 0; i < line.size(); i++)
+	{
+		char chr = line[i];
+		if (chr == '\t')
+			result.emplace_back();
+		else if (chr == '\\' && i + 1 < line.size())
+		{
+			char next = line[++i];
+			result.back().push_back((next == 't') ? '\t' : (next == 'n') ? '\n' : next);
+		}
+		else
+			result.back().push_back(chr);
+	}
+	return result;
+}
+
+// number of ValueType. Out of range value means corrupt file
+bool parse_value_type(const std::string &text, ValueType &type)
+{
+	if (text.empty() || text.size() > 3) return false;
+	for (char chr : text)
+		if (!isdigit((unsigned char)chr)) return false;
+
+	int value = atoi(text.c_str());
+	if (value > (int)ValueType::Null) return false;
+
+	type = (ValueType)value;
+	return true;
+}
+
+struct FileCloser
+{
+	void operator () (FILE *file) const { fclose(file); }
+};
+
+using FilePtr = std::unique_ptr<FILE, FileCloser>;
+
+FilePtr open_file(const FileName &file_name, bool for_write)
+{
+#if defined(DBLIB_WINDOWS)
+	return FilePtr(_wfopen(file_name.c_str(), for_write ? L"wb" : L"rb"));
+#else
+	return FilePtr(fopen(file_name.c_str(), for_write ? "wb" : "rb"));
+#endif
+}
+
+} // namespace
+
+
+/* struct SchemaTable */
+
+const SchemaColumn* SchemaTable::find_column(std::string_view name) const
+{
+	return find_by_name(columns, name);
+}
+
+const SchemaIndex* SchemaTable::find_index(std::string_view name) const
+{
+	return find_by_name(indexes, name);
+}
+
+
+/* class SchemaCatalog */
+
+void SchemaCatalog::load(Transaction &tran)
+{
+	auto driver_name = tran.get_connection()->get_driver_name();
+
+	const char *sql = nullptr;
+	if (driver_name == "postgresql")
+		sql = pg_schema_sql;
+	else if (driver_name == "firebird")
+		sql = fb_schema_sql;
+	else if (driver_name == "sqlite")
+		sql = sqlite_schema_sql;
+	else
+		throw FunctionalityNotSupported();
+
+	auto stmt = tran.create_statement();
+	stmt->execute(sql);
+
+	std::vector<SchemaTable> tables;
+
+	while (stmt->fetch())
+	{
+		auto table_name = stmt->get_str_utf8(2);
+		if (tables.empty() || tables.back().name != table_name)
+		{
+			tables.emplace_back();
+			tables.back().name = table_name;
+		}
+
+		auto &table = tables.back();
+
+		auto kind = stmt->get_str_utf8(1);
+		if (kind == "C")
+		{
+			auto &column = table.columns.emplace_back();
+			column.name = stmt->get_str_utf8(4);
+			column.type_name = stmt->get_str_utf8_or(5, "");
+			column.type = value_type_from_type_name(column.type_name);
+			column.nullable = (stmt->get_int32(6) == 0);
+		}
+		else
+		{
+			auto index_name = stmt->get_str_utf8(3);
+			if (table.indexes.empty() || table.indexes.back().name != index_name)
+			{
+				auto &index = table.indexes.emplace_back();
+				index.name = index_name;
+				index.is_unique = (stmt->get_int32(7) != 0);
+				index.is_primary = (stmt->get_int32(8) != 0);
+			}
+
+			auto &index = table.indexes.back();
+			index.columns.push_back(stmt->get_str_utf8(4));
+			if (index.is_primary)
+				table.primary_key.push_back(index.columns.back());
+		}
+	}
+
+	driver_name_ = driver_name;
+	tables_ = std::move(tables);
+	sort_tables();
+}
+
+bool SchemaCatalog::load_from_file(const FileName &file_name, std::string_view version, std::string_view driver_name)
+{
+	auto file = open_file(file_name, false);
+	if (!file) return false;
+
+	std::string text;
+	char buffer[64 * 1024];
+	for (;;)
+	{
+		size_t size = fread(buffer, 1, sizeof(buffer), file.get());
+		if (size == 0) break;
+		text.append(buffer, size);
+	}
+
+	file.reset();
+
+	std::vector<SchemaTable> tables;
+	size_t line_number = 0;
+	size_t pos = 0;
+
+	while (pos < text.size())
+	{
+		size_t end = text.find('\n', pos);
+		if (end == std::string::npos) end = text.size();
+		auto fields = split_line(std::string_view(text).substr(pos, end - pos));
+		pos = end + 1;
+		line_number++;
+
+		auto &tag = fields[0];
+
+		// header
+		if (line_number == 1)
+		{
+			if (tag != catalog_file_signature || fields.size() != 2 || fields[1] != catalog_file_format)
+				return false;
+		}
+		else if (line_number == 2)
+		{
+			if (tag != "version" || fields.size() != 2 || fields[1] != version)
+				return false;
+		}
+		else if (line_number == 3)
+		{
+			if (tag != "driver" || fields.size() != 2 || fields[1] != driver_name)
+				return false;
+		}
+
+		// tables
+		else if (tag == "T" && fields.size() == 2)
+		{
+			tables.emplace_back();
+			tables.back().name = fields[1];
+		}
+		else if (tables.empty())
+			return false;
+		else if (tag == "C" && fields.size() == 5)
+		{
+			auto &column = tables.back().columns.emplace_back();
+			column.name = fields[1];
+			column.type_name = fields[2];
+			if (!parse_value_type(fields[3], column.type))
+				return false;
+			column.nullable = (fields[4] == "1");
+		}
+		else if (tag == "I" && fields.size() >= 4)
+		{
+			auto &index = tables.back().indexes.emplace_back();
+			index.name = fields[1];
+			index.is_unique = (fields[2] == "1");
+			index.is_primary = (fields[3] == "1");
+			index.columns.assign(fields.begin() + 4, fields.end());
+		}
+		else if (tag == "P")
+			tables.back().primary_key.assign(fields.begin() + 1, fields.end());
+		else
+			return false;
+	}
+
+	if (line_number < 3)
+		return false;
+
+	driver_name_ = driver_name;
+	tables_ = std::move(tables);
+	sort_tables();
+
+	return true;
+}
+
+void SchemaCatalog::save_to_file(const FileName &file_name, std::string_view version) const
+{
+	std::string text;
+	std::string line;
+
+	auto add_line = [&text, &line](const char *tag)
+	{
+		text.append(tag);
+		text.append(line);
+		text.push_back('\n');
+		line.clear();
+	};
+
+	append_field(line, catalog_file_format);
+	add_line(catalog_file_signature);
+
+	append_field(line, version);
+	add_line("version");
+
+	append_field(line, driver_name_);
+	add_line("driver");
+
+	for (auto &table : tables_)
+	{
+		append_field(line, table.name);
+		add_line("T");
+
+		for (auto &column : table.columns)
+		{
+			append_field(line, column.name);
+			append_field(line, column.type_name);
+			append_field(line, std::to_string((int)column.type));
+			append_field(line, column.nullable ? "1" : "0");
+			add_line("C");
+		}
+
+		for (auto &index : table.indexes)
+		{
+			append_field(line, index.name);
+			append_field(line, index.is_unique ? "1" : "0");
+			append_field(line, index.is_primary ? "1" : "0");
+			for (auto &column : index.columns)
+				append_field(line, column);
+			add_line("I");
+		}
+
+		if (!table.primary_key.empty())
+		{
+			for (auto &column : table.primary_key)
+				append_field(line, column);
+			add_line("P");
+		}
+	}
+
+	auto file = open_file(file_name, true);
+	if (!file)
+		throw WrongArgumentException("Can't create file " + file_name_to_utf8(file_name));
+
+	if (fwrite(text.data(), 1, text.size(), file.get()) != text.size())
+		throw InternalException("Error during writing schema catalog file", 0, 0);
+}
+
+void SchemaCatalog::clear()
+{
+	driver_name_.clear();
+	tables_.clear();
+}
+
+const std::string& SchemaCatalog::get_driver_name() const
+{
+	return driver_name_;
+}
+
+const std::vector<SchemaTable>& SchemaCatalog::get_tables() const
+{
+	return tables_;
+}
+
+const SchemaTable* SchemaCatalog::find_table(std::string_view name) const
+{
+	CaseInsensitiveComparer less;
+
+	auto it = std::lower_bound(
+		tables_.begin(), tables_.end(), name,
+		[&less](const SchemaTable &table, std::string_view name) { return less(table.name, name); }
+	);
+
+	return (it != tables_.end() && !less(name, it->name)) ? &*it : nullptr;
+}
+
+void SchemaCatalog::sort_tables()
+{
+	CaseInsensitiveComparer less;
+
+	std::stable_sort(
+		tables_.begin(), tables_.end(),
+		[&less](const SchemaTable &table1, const SchemaTable &table2) { return less(table1.name, table2.name); }
+	);
+}
+
+} // namespace dblib
@@ -0,0 +1,188 @@
+/*
+
+Copyright (c) 2015-2022 Artyomov Denis (denis.artyomov@gmail.com)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+#include <limits>
+#include <vector>
+
+#include "../include/dblib/dblib_sequence.hpp"
+#include "../include/dblib/dblib_exception.hpp"
+
+namespace dblib {
+
+/* class SequenceAllocator
+
+   next_ and limit_ is current range of values. next_ is increased by CAS
+   only while it less than limit_. New range is set under mutex_ and only
+   when current one is exhausted: first next_ and then limit_. Begin of new
+   range is not less than end of previous one, so thread which has read old
+   next_ and new limit_ can't take value which doesn't belong to new range */
+
+SequenceAllocator::SequenceAllocator(const ConnectionPtr &connection, std::string_view seq_name, const SequenceAllocatorParams &params) :
+	connection_(connection),
+	seq_name_(seq_name),
+	params_(params),
+	next_(std::numeric_limits<int64_t>::min()),
+	limit_(std::numeric_limits<int64_t>::min())
+{
+	if (params_.block_size == 0)
+		throw WrongArgumentException("Block size of sequence allocator can't be 0");
+
+	driver_name_ = connection_->get_driver_name();
+
+	tran_ = connection_->create_transaction(TransactionParams(TransactionAccess::ReadAndWrite, false, false));
+	reserve_stmt_ = tran_->create_statement();
+	select_stmt_ = tran_->create_statement();
+
+	auto block_size = std::to_string(params_.block_size);
+
+	// PostgreSQL: begin and commit remove unnamed prepared statement so
+	// query is executed without preparing
+	if (driver_name_ == "postgresql")
+		select_sql_ = "select nextval('" + seq_name_ + "') from generate_series(1, " + block_size + ")";
+	else if (driver_name_ == "firebird")
+		select_sql_ = "select gen_id(" + seq_name_ + ", " + block_size + ") from rdb$database";
+	else if (driver_name_ == "sqlite")
+		init_sqlite_counter();
+	else
+		throw FunctionalityNotSupported();
+}
+
+SequenceAllocator::~SequenceAllocator() = default;
+
+void SequenceAllocator::init_sqlite_counter()
+{
+	auto &table = params_.sqlite_counters_table;
+
+	tran_->start();
+
+	select_stmt_->execute("create table if not exists " + table + " (name varchar(128) not null primary key, value bigint not null)");
+
+	select_stmt_->prepare("insert or ignore into " + table + " (name, value) values (?1, 0)");
+	select_stmt_->set_u8str(1, seq_name_);
+	select_stmt_->execute();
+
+	tran_->commit();
+
+	reserve_stmt_->prepare("update " + table + " set value = value + " + std::to_string(params_.block_size) + " where name = ?1");
+	select_stmt_->prepare("select value from " + table + " where name = ?1");
+}
+
+int64_t SequenceAllocator::next()
+{
+	for (;;)
+	{
+		int64_t value = next_.load();
+		if (value >= limit_.load())
+		{
+			next_slow();
+			continue;
+		}
+
+		if (next_.compare_exchange_weak(value, value + 1))
+			return value;
+	}
+}
+
+void SequenceAllocator::next_slow()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	int64_t limit = limit_.load();
+
+	// other thread has set new range
+	if (next_.load() < limit) return;
+
+	if (reserved_.empty())
+		reserve_block();
+
+	auto range = reserved_.front();
+	reserved_.pop_front();
+
+	if (range.first < limit)
+		throw WrongArgumentException("Sequence " + seq_name_ + " is not ascending");
+
+	next_.store(range.first);
+	limit_.store(range.second);
+}
+
+void SequenceAllocator::reserve_block()
+{
+	const int64_t block_size = (int64_t)params_.block_size;
+
+	tran_->start();
+
+	try
+	{
+		if (driver_name_ == "sqlite")
+		{
+			reserve_stmt_->set_u8str(1, seq_name_);
+			reserve_stmt_->execute();
+			select_stmt_->set_u8str(1, seq_name_);
+			select_stmt_->execute();
+		}
+		else
+			select_stmt_->execute(select_sql_);
+
+		std::vector<int64_t> values;
+		while (select_stmt_->fetch())
+			values.push_back(select_stmt_->get_int64(1));
+
+		if (driver_name_ == "postgresql")
+		{
+			// values of sequence can be not continuous if sequence is used
+			// by other connections at the same time
+			for (int64_t value : values)
+			{
+				if (!reserved_.empty() && reserved_.back().second == value)
+					reserved_.back().second++;
+				else
+					reserved_.emplace_back(value, value + 1);
+			}
+		}
+		else
+		{
+			if (values.size() != 1)
+				throw InternalException("Sequence " + seq_name_ + " returned wrong count of values", 0, 0);
+
+			int64_t last = values.front();
+			reserved_.emplace_back(last - block_size + 1, last + 1);
+		}
+
+		tran_->commit();
+	}
+	catch (...)
+	{
+		tran_->rollback();
+		throw;
+	}
+
+	reservations_count_++;
+}
+
+size_t SequenceAllocator::get_reservations_count() const
+{
+	return reservations_count_.load();
+}
+
+} // namespace dblib
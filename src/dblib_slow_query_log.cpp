@@ -0,0 +1,356 @@
+/*
+
+Copyright (c) 2015-2022 Artyomov Denis (denis.artyomov@gmail.com)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+#include <algorithm>
+#include <atomic>
+
+#include "../include/dblib/dblib_slow_query_log.hpp"
+#include "../include/dblib/dblib_firebird.hpp"
+#include "../include/dblib/dblib_exception.hpp"
+#include "dblib_stmt_tools.hpp"
+
+namespace dblib {
+
+/* class SlowQueryLog */
+
+// Query which is executed but not fetched to end
+struct SlowQueryLog::Pending
+{
+	uint64_t log_id = 0;
+	const Statement *statement = nullptr;
+	std::string sql; // statement sql can be changed by next prepare
+	bool native_parameters_syntax = false;
+	TraceClock::time_point begin_time;
+	std::chrono::nanoseconds execute_time {0};
+	std::chrono::nanoseconds fetch_time {0};
+	size_t rows_count = 0;
+	bool failed = false;
+};
+
+static constexpr size_t MaxPendingQueriesInThread = 64;
+
+static std::atomic<uint64_t> logs_counter = 0;
+
+SlowQueryLog::SlowQueryLog(SlowQuerySink sink, const SlowQueryLogParams &params) :
+	id_(++logs_counter),
+	sink_(std::move(sink)),
+	params_(params)
+{
+	worker_ = std::thread([this] { worker_fun(); });
+}
+
+SlowQueryLog::~SlowQueryLog()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	cond_.notify_all();
+	worker_.join();
+}
+
+std::vector<SlowQueryLog::Pending>& SlowQueryLog::get_thread_pendings()
+{
+	static thread_local std::vector<Pending> pendings;
+	return pendings;
+}
+
+void SlowQueryLog::begin(TraceEvent &event)
+{
+	if (!event.statement) return;
+	if ((event.operation != TraceOperation::Prepare) && (event.operation != TraceOperation::Execute)) return;
+
+	// previous query of statement is finished by new prepare or execute.
+	// Parameters are still valid only before prepare
+	auto &pendings = get_thread_pendings();
+	for (auto it = pendings.begin(); it != pendings.end(); ++it)
+	{
+		if ((it->log_id != id_) || (it->statement != event.statement)) continue;
+
+		Pending pending = *it;
+		pendings.erase(it);
+		if (pending.execute_time + pending.fetch_time >= params_.threshold)
+			finish(pending, event.statement, event.operation == TraceOperation::Prepare);
+		break;
+	}
+}
+
+void SlowQueryLog::end(TraceEvent &event)
+{
+	if (!event.statement) return;
+
+	auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(event.end_time - event.begin_time);
+
+	if (event.operation == TraceOperation::Execute)
+	{
+		Pending pending;
+		pending.log_id = id_;
+		pending.statement = event.statement;
+		pending.native_parameters_syntax = event.native_parameters_syntax;
+		pending.begin_time = event.begin_time;
+		pending.execute_time = duration;
+		pending.rows_count = event.rows_count;
+		pending.failed = event.failed;
+
+		bool has_rows = false;
+		if (!event.failed)
+		{
+			try
+			{
+				has_rows = (event.statement->get_columns_count() != 0);
+			}
+			catch (const Exception&) {}
+		}
+
+		if (!has_rows)
+		{
+			if (duration >= params_.threshold)
+			{
+				pending.sql = event.sql;
+				finish(pending, event.statement, true);
+			}
+			return;
+		}
+
+		pending.sql = event.sql;
+		pending.rows_count = 0;
+
+		auto &pendings = get_thread_pendings();
+		if (pendings.size() >= MaxPendingQueriesInThread)
+			pendings.erase(pendings.begin());
+		pendings.push_back(pending);
+	}
+
+	else if (event.operation == TraceOperation::Fetch)
+	{
+		auto &pendings = get_thread_pendings();
+		auto it = std::find_if(
+			pendings.begin(), pendings.end(),
+			[&](const Pending &item) { return (item.log_id == id_) && (item.statement == event.statement); }
+		);
+		if (it == pendings.end()) return;
+
+		it->fetch_time += duration;
+		it->rows_count += event.rows_count;
+		it->failed = it->failed || event.failed;
+
+		if ((event.rows_count == 0) || event.failed)
+		{
+			Pending pending = *it;
+			pendings.erase(it);
+			if (pending.execute_time + pending.fetch_time >= params_.threshold)
+				finish(pending, event.statement, true);
+		}
+	}
+}
+
+void SlowQueryLog::finish(Pending &pending, Statement *statement, bool with_params)
+{
+	SlowQuery query;
+	query.sql = std::move(pending.sql);
+	query.native_parameters_syntax = pending.native_parameters_syntax;
+	query.begin_time = pending.begin_time;
+	query.execute_time = pending.execute_time;
+	query.fetch_time = pending.fetch_time;
+	query.rows_count = pending.rows_count;
+	query.failed = pending.failed;
+
+	if (with_params)
+	{
+		try
+		{
+			query.params = statement->get_param_values();
+		}
+		catch (const Exception&) {}
+	}
+
+	push(std::move(query));
+}
+
+void SlowQueryLog::push(SlowQuery &&query)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (queue_.size() >= params_.max_queue_size)
+		{
+			dropped_count_++;
+			return;
+		}
+		queue_.push_back(std::move(query));
+	}
+	cond_.notify_all();
+}
+
+void SlowQueryLog::flush()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	cond_.wait(lock, [this] { return queue_.empty() && !processing_; });
+}
+
+size_t SlowQueryLog::get_dropped_count() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return dropped_count_;
+}
+
+void SlowQueryLog::worker_fun()
+{
+	for (;;)
+	{
+		SlowQuery query;
+
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			cond_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+			if (queue_.empty()) break;
+			query = std::move(queue_.front());
+			queue_.pop_front();
+			processing_ = true;
+		}
+
+		if (params_.plan_connection)
+		{
+			try
+			{
+				if (!params_.plan_connection->is_connected())
+					params_.plan_connection->connect();
+
+				query.plan = capture_query_plan(
+					*params_.plan_connection,
+					query.sql,
+					query.params ? &*query.params : nullptr,
+					params_.analyze,
+					query.native_parameters_syntax
+				);
+			}
+			catch (const std::exception &e)
+			{
+				query.plan = std::string("Plan is not captured: ") + e.what();
+			}
+		}
+
+		try
+		{
+			if (sink_) sink_(query);
+		}
+		catch (...) {}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			processing_ = false;
+		}
+		cond_.notify_all();
+	}
+}
+
+
+/* capture_query_plan */
+
+// Only indexes of parameters are needed to bind values
+class ParamsIndexesActions : public SqlPreprocessorActions
+{
+protected:
+	void append_index_param_to_sql(const std::string&, int, std::string&) const override {}
+	void append_named_param_to_sql(const std::string&, int, std::string&) const override {}
+	void append_if_seq_data(const std::string&, const std::string&, std::string&) const override {}
+	void append_seq_generator(const std::string&, const std::string&, std::string&) const override {}
+};
+
+// Values are ordered by native indexes of parameters and
+// sql contains parameters in dblib syntax (:name, @name or ?1)
+static void set_params_by_native_indexes(Statement &st, std::string_view sql, const ParamValues &values)
+{
+	SqlPreprocessor preprocessor;
+	preprocessor.preprocess(sql, false, true, ParamsIndexesActions());
+
+	preprocessor.do_for_params([&](const IndexOrName &param, size_t index)
+	{
+		if ((index == 0) || (index > values.size())) return;
+		std::visit([&](const auto& value)
+		{
+			using T = std::decay_t<decltype(value)>;
+			if constexpr (std::is_same_v<T, std::monostate>)
+				st.set_null(param);
+			else
+				st.set(param, value);
+		}, values[index - 1]);
+	});
+}
+
+std::string capture_query_plan(
+	Connection        &connection,
+	std::string_view  sql,
+	const ParamValues *params,
+	bool              analyze,
+	bool              use_native_parameters_syntax)
+{
+	auto driver_name = connection.get_driver_name();
+
+	auto tran = connection.create_transaction(TransactionParams(TransactionAccess::ReadAndWrite, true, false));
+	auto st = tran->create_statement();
+
+	std::string result;
+
+	if (driver_name == "firebird")
+	{
+		st->prepare(sql, use_native_parameters_syntax);
+		result = dynamic_cast<FbStatement&>(*st).get_plan();
+	}
+	else
+	{
+		std::string explain_sql;
+		size_t plan_column = 1;
+
+		if (driver_name == "sqlite")
+		{
+			explain_sql = "EXPLAIN QUERY PLAN ";
+			plan_column = 4; // id, parent, notused, detail
+		}
+		else if ((driver_name == "postgresql") && analyze)
+			explain_sql = "EXPLAIN (ANALYZE, BUFFERS) ";
+		else
+			explain_sql = "EXPLAIN ";
+
+		explain_sql.append(sql);
+
+		st->prepare(explain_sql, use_native_parameters_syntax);
+		if (params && use_native_parameters_syntax)
+			st->set_params(*params);
+		else if (params)
+			set_params_by_native_indexes(*st, sql, *params);
+		st->execute();
+
+		while (st->fetch())
+		{
+			if (!result.empty()) result.append("\n");
+			result.append(st->get_str_utf8_or(plan_column, {}));
+		}
+	}
+
+	tran->rollback();
+
+	return result;
+}
+
+} // namespace dblib
@@ -28,7 +28,9 @@ THE SOFTWARE.
 #include "dblib_dyn.hpp"
 #include "../include/dblib/dblib_sqlite.hpp"
 #include "../include/dblib/dblib_cvt_utils.hpp"
+#include "../include/dblib/dblib_result_set.hpp"
 #include "dblib_stmt_tools.hpp"
+#include "dblib_type_cvt.hpp"
 
 namespace dblib {
 
@@ -46,7 +48,7 @@ using SqliteLibImplPtr = std::shared_ptr<SqliteLibData>;
 
 /* class SqliteLibImpl */
 
-class SqliteLibImpl : public SqliteLib
+class SqliteLibImpl final : public SqliteLib
 {
 public:
 	SqliteLibImpl();
@@ -67,7 +69,12 @@ private:
 
 /* class SqliteConnectionImpl */
 
-class SqliteConnectionImpl :
+class SQLiteTransactionImpl;
+using SQLiteTransactionImplPtr = std::shared_ptr<SQLiteTransactionImpl>;
+
+class SQLiteStatementImpl;
+
+class SqliteConnectionImpl final :
 	public SqliteConnection,
 	public std::enable_shared_from_this<SqliteConnectionImpl>
 {
@@ -92,9 +99,14 @@ public:
 	void direct_execute(std::string_view sql) override;
 	std::string get_driver_name() const override;
 
+	void set_statements_pool_size(size_t max_size) override;
+	StatementsPoolStats get_statements_pool_stats() const override;
+
 	sqlite3* get_instance() override;
 	SQLiteTransactionPtr create_sqlite_transaction(const TransactionParams &transaction_params) override;
 
+	std::shared_ptr<SQLiteStatementImpl> create_statement_impl(const SQLiteTransactionImplPtr &tran);
+
 	void set_transaction_is_active(bool value);
 	bool is_transaction_active() const;
 
@@ -106,10 +118,13 @@ private:
 	SqliteConfig config_;
 	std::string tmp_sql_text_;
 	bool transaction_is_active_ = false;
+	StatementsPool<SQLiteStatementImpl> statements_pool_;
 
 	void check_is_not_connected();
 	void check_is_connected();
 	void disconnect_internal(bool check_ret_code);
+
+	static void release_statement(SQLiteStatementImpl *stmt);
 };
 
 using SqliteConnectionImplPtr = std::shared_ptr<SqliteConnectionImpl>;
@@ -117,7 +132,7 @@ using SqliteConnectionImplPtr = std::shared_ptr<SqliteConnectionImpl>;
 
 /* class SQLiteTransactionImpl */
 
-class SQLiteTransactionImpl :
+class SQLiteTransactionImpl final :
 	public SQLiteTransaction,
 	public std::enable_shared_from_this<SQLiteTransactionImpl>
 {
@@ -129,10 +144,14 @@ public:
 	StatementPtr create_statement() override;
 	SQLiteStatementPtr create_sqlite_statement() override;
 
+	const SqliteApi& get_api() const;
+	sqlite3* get_instance();
+
 protected:
 	void internal_start() override;
 	void internal_commit() override;
 	void internal_rollback() override;
+	Status internal_try_commit() override;
 
 private:
 	SqliteLibImplPtr lib_;
@@ -142,8 +161,6 @@ private:
 	int busy_time_out_ = 0;
 };
 
-using SQLiteTransactionImplPtr = std::shared_ptr<SQLiteTransactionImpl>;
-
 
 /* class SQLiteSqlPreprocessorActions */
 
@@ -173,12 +190,16 @@ protected:
 
 /* class SQLiteStatementImpl */
 
-class SQLiteStatementImpl : public SQLiteStatement
+class SQLiteStatementImpl final : public SQLiteStatement
 {
 public:
 	SQLiteStatementImpl(const SqliteLibImplPtr& lib, const SqliteConnectionImplPtr &conn, const SQLiteTransactionImplPtr &tran);
 	~SQLiteStatementImpl();
 
+	// statements pool
+	void attach(const SqliteConnectionImplPtr &conn, const SQLiteTransactionImplPtr &tran);
+	SqliteConnectionImplPtr detach();
+
 	TransactionPtr get_transaction() override;
 
 	void prepare(std::string_view sql, bool use_native_parameters_syntax) override;
@@ -190,6 +211,7 @@ public:
 	StatementType get_type() override;
 
 	void execute() override;
+	Status try_execute() override;
 
 	size_t get_changes_count() override;
 	int64_t get_last_row_id() override;
@@ -197,6 +219,7 @@ public:
 	std::string get_last_sql() const override;
 
 	bool fetch() override;
+	Status try_fetch() override;
 
 	size_t get_params_count() const override;
 	ValueType get_param_type(const IndexOrName& param) override;
@@ -233,6 +256,8 @@ public:
 	size_t get_blob_size(const IndexOrName& column) override;
 	void get_blob_data(const IndexOrName& column, char *dst, size_t size) override;
 
+	size_t fetch_columnar(ResultSet& result, size_t max_rows) override;
+
 	sqlite3_stmt* get_stmt() override;
 
 private:
@@ -248,12 +273,22 @@ private:
 	std::string parameter_name_tmp_;
 	bool contains_data_ = false;
 	std::string last_sql_;
+	bool last_sql_is_native_ = false;
 	SqlPreprocessor sql_preprocessor_;
 
+	// statement released into pool keeps prepared handle for the same sql
+	sqlite3_stmt *pooled_stmt_ = nullptr;
+	std::string pooled_sql_;
+	bool pooled_sql_is_native_ = false;
+
 	void close(bool check_ret_code);
+	void close_pooled_stmt();
 	void check_is_prepared() const;
 	void check_contains_data() const;
-	void internal_execute(bool do_reset_if_needed);
+	bool internal_execute(bool do_reset_if_needed, Status *status = nullptr);
+	bool traced_execute(Status *status = nullptr);
+	bool traced_fetch(Status *status = nullptr);
+	size_t get_row_bytes() const;
 	void reset_statement() const;
 
 	int get_param_index(const IndexOrName& param);
@@ -262,19 +297,35 @@ private:
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-static void check_sqlite_ret_code(
+// Throws exception if status is null or stores error in status and returns false
+static bool check_sqlite_ret_code(
 	const SqliteApi  &api,
 	int              ret_code,
 	const char       *fun_name,
 	sqlite3          *db,
 	std::string_view sql,
-	ErrorType        error_type)
+	ErrorType        error_type,
+	Status           *status = nullptr)
 {
-	if (ret_code == SQLITE_OK) return;
+	if (ret_code == SQLITE_OK) return true;
 
 	if (ret_code == SQLITE_BUSY)
 		error_type = ErrorType::Lock;
 
+	if (status)
+	{
+		*status = Status(
+			error_type,
+			ret_code,
+			api.f_sqlite3_extended_errcode(db),
+			fun_name,
+			api.f_sqlite3_errstr(ret_code),
+			{},
+			api.f_sqlite3_errmsg(db)
+		);
+		return false;
+	}
+
 	throw_exception(
 		fun_name,
 		ret_code,
@@ -351,7 +402,7 @@ void SqliteLibImpl::load(const FileName &dyn_lib_file_name)
 		file_name = L"sqlite3.dll";
 #elif defined(DBLIB_LINUX)
 	if (file_name.empty())
-		file_name = "fbclient.so";
+		file_name = "libsqlite3.so";
 #endif
 
 	module.load(file_name);
@@ -383,6 +434,7 @@ void SqliteLibImpl::load(const FileName &dyn_lib_file_name)
 	module.load_func(api.f_sqlite3_column_type,          "sqlite3_column_type");
 	module.load_func(api.f_sqlite3_finalize,             "sqlite3_finalize");
 	module.load_func(api.f_sqlite3_reset,                "sqlite3_reset");
+	module.load_func(api.f_sqlite3_clear_bindings,       "sqlite3_clear_bindings");
 	module.load_func(api.f_sqlite3_bind_parameter_index, "sqlite3_bind_parameter_index");
 	module.load_func(api.f_sqlite3_changes,              "sqlite3_changes");
 	module.load_func(api.f_sqlite3_last_insert_rowid,    "sqlite3_last_insert_rowid");
@@ -563,12 +615,46 @@ void SqliteConnectionImpl::check_is_connected()
 
 void SqliteConnectionImpl::disconnect_internal(bool check_ret_code)
 {
+	// pooled statements keep prepared handles
+	statements_pool_.clear();
+
 	int res = lib_->api.f_sqlite3_close(db_);
 	if (check_ret_code)
 		check_sqlite_ret_code(lib_->api, res, "sqlite3_close", db_, {}, ErrorType::Connection);
 	db_ = nullptr;
 }
 
+void SqliteConnectionImpl::set_statements_pool_size(size_t max_size)
+{
+	statements_pool_.set_max_size(max_size);
+}
+
+StatementsPoolStats SqliteConnectionImpl::get_statements_pool_stats() const
+{
+	return statements_pool_.get_stats();
+}
+
+std::shared_ptr<SQLiteStatementImpl> SqliteConnectionImpl::create_statement_impl(const SQLiteTransactionImplPtr &tran)
+{
+	if (!statements_pool_.is_enabled())
+		return std::make_shared<SQLiteStatementImpl>(lib_, shared_from_this(), tran);
+
+	auto stmt = statements_pool_.acquire();
+	if (stmt)
+		stmt->attach(shared_from_this(), tran);
+	else
+		stmt = std::make_unique<SQLiteStatementImpl>(lib_, shared_from_this(), tran);
+
+	return statements_pool_.make_shared_ptr(std::move(stmt), &SqliteConnectionImpl::release_statement);
+}
+
+void SqliteConnectionImpl::release_statement(SQLiteStatementImpl *stmt)
+{
+	std::unique_ptr<SQLiteStatementImpl> holder(stmt);
+	if (auto conn = stmt->detach())
+		conn->statements_pool_.release(std::move(holder));
+}
+
 sqlite3* SqliteConnectionImpl::get_instance()
 {
 	return db_;
@@ -636,7 +722,7 @@ StatementPtr SQLiteTransactionImpl::create_statement()
 
 SQLiteStatementPtr SQLiteTransactionImpl::create_sqlite_statement()
 {
-	return std::make_shared<SQLiteStatementImpl>(lib_, conn_, shared_from_this());
+	return conn_->create_statement_impl(shared_from_this());
 }
 
 ConnectionPtr SQLiteTransactionImpl::get_connection()
@@ -644,6 +730,16 @@ ConnectionPtr SQLiteTransactionImpl::get_connection()
 	return conn_;
 }
 
+const SqliteApi& SQLiteTransactionImpl::get_api() const
+{
+	return lib_->api;
+}
+
+sqlite3* SQLiteTransactionImpl::get_instance()
+{
+	return conn_->get_instance();
+}
+
 void SQLiteTransactionImpl::internal_start()
 {
 	if (conn_->is_transaction_active())
@@ -672,6 +768,18 @@ void SQLiteTransactionImpl::internal_commit()
 }
 
 
+Status SQLiteTransactionImpl::internal_try_commit()
+{
+	// transaction stays active if commit fails (SQLITE_BUSY)
+	Status status;
+	const char* sql = "commit";
+	int res = lib_->api.f_sqlite3_exec(conn_->get_instance(), sql, nullptr, nullptr, nullptr);
+	if (check_sqlite_ret_code(lib_->api, res, "sqlite3_exec", conn_->get_instance(), sql, ErrorType::Transaction, &status))
+		conn_->set_transaction_is_active(false);
+	return status;
+}
+
+
 void SQLiteTransactionImpl::internal_rollback()
 {
 	conn_->set_transaction_is_active(false);
@@ -698,6 +806,7 @@ SQLiteStatementImpl::SQLiteStatementImpl(
 SQLiteStatementImpl::~SQLiteStatementImpl()
 {
 	close(false);
+	close_pooled_stmt();
 }
 
 TransactionPtr SQLiteStatementImpl::get_transaction()
@@ -705,6 +814,39 @@ TransactionPtr SQLiteStatementImpl::get_transaction()
 	return tran_;
 }
 
+void SQLiteStatementImpl::attach(const SqliteConnectionImplPtr &conn, const SQLiteTransactionImplPtr &tran)
+{
+	conn_ = conn;
+	tran_ = tran;
+}
+
+// Resets state. Buffers and prepared handle are kept for next
+// prepare of the same sql
+SqliteConnectionImplPtr SQLiteStatementImpl::detach()
+{
+	close_pooled_stmt();
+
+	if (stmt_ != nullptr)
+	{
+		lib_->api.f_sqlite3_reset(stmt_);
+		lib_->api.f_sqlite3_clear_bindings(stmt_);
+		pooled_stmt_ = std::exchange(stmt_, nullptr);
+		pooled_sql_.swap(last_sql_);
+		pooled_sql_is_native_ = last_sql_is_native_;
+	}
+	else
+		sql_preprocessor_.clear();
+
+	must_be_reseted_ = false;
+	step_called_ = false;
+	contains_data_ = false;
+	columns_helper_.clear();
+	last_sql_.clear();
+	last_step_result_ = -1;
+	tran_.reset();
+	return std::move(conn_);
+}
+
 void SQLiteStatementImpl::close(bool check_ret_code)
 {
 	if (stmt_ == nullptr) return;
@@ -717,6 +859,13 @@ void SQLiteStatementImpl::close(bool check_ret_code)
 	contains_data_ = false;
 }
 
+void SQLiteStatementImpl::close_pooled_stmt()
+{
+	if (pooled_stmt_ == nullptr) return;
+	lib_->api.f_sqlite3_finalize(pooled_stmt_);
+	pooled_stmt_ = nullptr;
+}
+
 void SQLiteStatementImpl::check_is_prepared() const
 {
 	if (stmt_ == nullptr)
@@ -731,7 +880,23 @@ void SQLiteStatementImpl::check_contains_data() const
 
 void SQLiteStatementImpl::prepare(std::string_view sql, bool use_native_parameters_syntax)
 {
+	TraceScope trace(conn_->get_tracer().get(), TraceOperation::Prepare, sql, this);
+
+	// statement from pool is prepared again without parsing of sql
+	if (pooled_stmt_ && (pooled_sql_is_native_ == use_native_parameters_syntax) && (pooled_sql_ == sql))
+	{
+		close(false);
+		stmt_ = std::exchange(pooled_stmt_, nullptr);
+		last_sql_.swap(pooled_sql_);
+		last_sql_is_native_ = use_native_parameters_syntax;
+		columns_helper_.clear();
+		return;
+	}
+
+	close_pooled_stmt();
+
 	last_sql_ = sql;
+	last_sql_is_native_ = use_native_parameters_syntax;
 
 	sql_preprocessor_.preprocess(
 		sql,
@@ -768,24 +933,27 @@ StatementType SQLiteStatementImpl::get_type()
 	return StatementType::Unknown;
 }
 
-void SQLiteStatementImpl::internal_execute(bool do_reset_if_needed)
+bool SQLiteStatementImpl::internal_execute(bool do_reset_if_needed, Status *status)
 {
 	if (do_reset_if_needed) reset_statement();
 
 	last_step_result_ = lib_->api.f_sqlite3_step(stmt_);
 
 	if ((last_step_result_ == SQLITE_DONE) || (last_step_result_ == SQLITE_ROW))
+	{
 		must_be_reseted_ = true;
+		return true;
+	}
 
-	else
-		check_sqlite_ret_code(
-			lib_->api,
-			last_step_result_,
-			"sqlite3_step",
-			conn_->get_instance(),
-			last_sql_,
-			ErrorType::Normal
-		);
+	return check_sqlite_ret_code(
+		lib_->api,
+		last_step_result_,
+		"sqlite3_step",
+		conn_->get_instance(),
+		last_sql_,
+		ErrorType::Normal,
+		status
+	);
 }
 
 void SQLiteStatementImpl::reset_statement() const
@@ -799,8 +967,57 @@ void SQLiteStatementImpl::reset_statement() const
 void SQLiteStatementImpl::execute()
 {
 	check_is_prepared();
-	internal_execute(true);
+	traced_execute();
+}
+
+Status SQLiteStatementImpl::try_execute()
+{
+	check_is_prepared();
+	Status status;
+	traced_execute(&status);
+	return status;
+}
+
+bool SQLiteStatementImpl::traced_execute(Status *status)
+{
+	TraceScope trace(conn_->get_tracer().get(), TraceOperation::Execute, last_sql_, this);
+	if (!internal_execute(true, status))
+	{
+		trace.set_error(status->get_error_type());
+		return false;
+	}
 	step_called_ = true;
+
+	if (trace.is_active() && (lib_->api.f_sqlite3_column_count(stmt_) == 0))
+		trace.set_rows_count(lib_->api.f_sqlite3_changes(conn_->get_instance()));
+
+	return true;
+}
+
+size_t SQLiteStatementImpl::get_row_bytes() const
+{
+	auto &api = lib_->api;
+	int columns_count = api.f_sqlite3_column_count(stmt_);
+	size_t result = 0;
+
+	// sqlite3_column_bytes converts numbers into text so it is called only for text and blobs
+	for (int i = 0; i < columns_count; i++)
+	{
+		switch (api.f_sqlite3_column_type(stmt_, i))
+		{
+		case SQLITE_INTEGER:
+		case SQLITE_FLOAT:
+			result += 8;
+			break;
+
+		case SQLITE_TEXT:
+		case SQLITE_BLOB:
+			result += api.f_sqlite3_column_bytes(stmt_, i);
+			break;
+		}
+	}
+
+	return result;
 }
 
 size_t SQLiteStatementImpl::get_changes_count()
@@ -821,20 +1038,33 @@ std::string SQLiteStatementImpl::get_last_sql() const
 void SQLiteStatementImpl::execute(std::string_view sql)
 {
 	prepare(sql, true);
-	internal_execute(true);
-	step_called_ = true;
+	traced_execute();
 }
 
 void SQLiteStatementImpl::execute(std::wstring_view sql)
 {
 	prepare(sql, true);
-	internal_execute(true);
-	step_called_ = true;
+	traced_execute();
 }
 
 bool SQLiteStatementImpl::fetch()
 {
 	check_is_prepared();
+	return traced_fetch();
+}
+
+Status SQLiteStatementImpl::try_fetch()
+{
+	check_is_prepared();
+	Status status;
+	bool fetched = traced_fetch(&status);
+	if (status.is_ok() && !fetched) return Status::make_no_data();
+	return status;
+}
+
+bool SQLiteStatementImpl::traced_fetch(Status *status)
+{
+	TraceScope trace(conn_->get_tracer().get(), TraceOperation::Fetch, last_sql_, this);
 
 	if (step_called_)
 		step_called_ = false;
@@ -843,10 +1073,22 @@ bool SQLiteStatementImpl::fetch()
 		if (last_step_result_ == SQLITE_DONE)
 			throw WrongSeqException("Fetch after data end");
 
-		internal_execute(false);
+		if (!internal_execute(false, status))
+		{
+			trace.set_error(status->get_error_type());
+			contains_data_ = false;
+			return false;
+		}
 	}
 
 	contains_data_ = (last_step_result_ == SQLITE_ROW);
+
+	if (trace.is_active() && contains_data_)
+	{
+		trace.set_rows_count(1);
+		trace.add_bytes(get_row_bytes());
+	}
+
 	return contains_data_;
 }
 
@@ -1167,11 +1409,210 @@ void SQLiteStatementImpl::get_blob_data(const IndexOrName& column, char *dst, si
 	memcpy(dst, src, size);
 }
 
+static bool is_integer_column_type(ValueType type)
+{
+	return
+		(type == ValueType::Short) ||
+		(type == ValueType::Integer) ||
+		(type == ValueType::BigInt) ||
+		(type == ValueType::Boolean);
+}
+
+// Column of SQLite can contain values of different storage classes
+static bool sqlite_type_fits_column_type(int sqlite_type, ValueType type)
+{
+	if (is_integer_column_type(type))
+		return sqlite_type == SQLITE_INTEGER;
+
+	switch (type)
+	{
+	case ValueType::Float:
+	case ValueType::Double:
+	case ValueType::Date:
+	case ValueType::Time:
+	case ValueType::Timestamp:
+		return (sqlite_type == SQLITE_INTEGER) || (sqlite_type == SQLITE_FLOAT);
+
+	default:
+		return true;
+	}
+}
+
+// Integer column is converted into double when real value
+// appears after integers (numeric affinity)
+static void widen_integer_column_to_double(ResultColumn &column)
+{
+	ResultColumn widened(column.get_name(), ValueType::Double);
+	widened.reserve(column.get_rows_count());
+
+	for (size_t row = 0; row < column.get_rows_count(); row++)
+	{
+		if (column.is_null(row))
+			widened.append_null();
+		else
+			widened.append_double((double)column.get_int64(row));
+	}
+
+	column = std::move(widened);
+}
+
+size_t SQLiteStatementImpl::fetch_columnar(ResultSet& result, size_t max_rows)
+{
+	check_is_prepared();
+
+	auto &api = lib_->api;
+	int columns_count = api.f_sqlite3_column_count(stmt_);
+
+	if (result.get_columns_count() == 0)
+	{
+		for (int i = 0; i < columns_count; i++)
+			result.add_column(api.f_sqlite3_column_name(stmt_, i), ValueType::Null);
+	}
+	else if (result.get_columns_count() != (size_t)columns_count)
+		throw WrongArgumentException("Columns count of result set and statement are different");
+
+	size_t rows_count = 0;
+
+	while (((max_rows == 0) || (rows_count < max_rows)) && fetch())
+	{
+		for (int i = 0; i < columns_count; i++)
+		{
+			auto &column = result.get_column(i + 1);
+			int sqlite_type = api.f_sqlite3_column_type(stmt_, i);
+
+			if (sqlite_type == SQLITE_NULL)
+			{
+				column.append_null();
+				continue;
+			}
+
+			// sqlite integers are 64-bit
+			if (column.get_type() == ValueType::Null)
+				column.set_type((sqlite_type == SQLITE_INTEGER) ? ValueType::BigInt : cvt_sqlite_type_to_lib_type(sqlite_type));
+
+			else if (!sqlite_type_fits_column_type(sqlite_type, column.get_type()))
+			{
+				if ((sqlite_type == SQLITE_FLOAT) && is_integer_column_type(column.get_type()))
+					widen_integer_column_to_double(column);
+				else
+					throw WrongTypeConvException(
+						field_type_to_string(cvt_sqlite_type_to_lib_type(sqlite_type)),
+						field_type_to_string(column.get_type())
+					);
+			}
+
+			switch (column.get_type())
+			{
+			case ValueType::Short:
+				column.append_int16(int_to<int16_t>(api.f_sqlite3_column_int(stmt_, i)));
+				break;
+
+			case ValueType::Integer:
+			case ValueType::Boolean:
+				column.append_int32(api.f_sqlite3_column_int(stmt_, i));
+				break;
+
+			case ValueType::BigInt:
+				column.append_int64(api.f_sqlite3_column_int64(stmt_, i));
+				break;
+
+			case ValueType::Float:
+				column.append_float(float_to<float>(api.f_sqlite3_column_double(stmt_, i)));
+				break;
+
+			case ValueType::Double:
+				column.append_double(api.f_sqlite3_column_double(stmt_, i));
+				break;
+
+			case ValueType::Char:
+			case ValueType::Varchar:
+			{
+				auto text = (const char*)api.f_sqlite3_column_text(stmt_, i);
+				int size = api.f_sqlite3_column_bytes(stmt_, i);
+				column.append_blob(text, size);
+				break;
+			}
+
+			case ValueType::Blob:
+			{
+				auto data = (const char*)api.f_sqlite3_column_blob(stmt_, i);
+				int size = api.f_sqlite3_column_bytes(stmt_, i);
+				column.append_blob(data, size);
+				break;
+			}
+
+			case ValueType::Date:
+				column.append_date(julianday_to_date(api.f_sqlite3_column_double(stmt_, i)));
+				break;
+
+			case ValueType::Time:
+				column.append_time(days_to_time(api.f_sqlite3_column_double(stmt_, i)));
+				break;
+
+			case ValueType::Timestamp:
+				column.append_timestamp(julianday_to_timestamp(api.f_sqlite3_column_double(stmt_, i)));
+				break;
+
+			default:
+				throw WrongTypeConvException(field_type_to_string(column.get_type()), "columnar value");
+			}
+		}
+
+		rows_count++;
+	}
+
+	return rows_count;
+}
+
 sqlite3_stmt* SQLiteStatementImpl::get_stmt()
 {
 	return stmt_;
 }
 
+
+/* class SqliteFastStatement */
+
+SqliteFastStatement::SqliteFastStatement(const SQLiteTransactionPtr &transaction) :
+	transaction_(transaction),
+	api_(static_cast<SQLiteTransactionImpl&>(*transaction).get_api()),
+	db_(static_cast<SQLiteTransactionImpl&>(*transaction).get_instance())
+{}
+
+SqliteFastStatement::~SqliteFastStatement()
+{
+	if (stmt_)
+		api_.f_sqlite3_finalize(stmt_);
+}
+
+void SqliteFastStatement::prepare(std::string_view sql)
+{
+	if (stmt_)
+	{
+		api_.f_sqlite3_finalize(stmt_);
+		stmt_ = nullptr;
+	}
+
+	must_be_reseted_ = false;
+	step_called_ = false;
+	last_step_result_ = -1;
+	last_sql_ = sql;
+
+	int res = api_.f_sqlite3_prepare_v2(db_, sql.data(), (int)sql.size(), &stmt_, nullptr);
+	check_sqlite_ret_code(api_, res, "sqlite3_prepare", db_, sql, ErrorType::Normal);
+}
+
+void SqliteFastStatement::throw_error(int ret_code, const char *fun_name) const
+{
+	check_sqlite_ret_code(api_, ret_code, fun_name, db_, last_sql_, ErrorType::Normal);
+	throw InternalException("Unexpected SQLite return code", 0, 0);
+}
+
+void SqliteFastStatement::throw_wrong_seq(const char *text)
+{
+	throw WrongSeqException(text);
+}
+
+
 SqliteLibPtr create_sqlite_lib()
 {
 	return std::make_shared<SqliteLibImpl>();
@@ -71,8 +71,7 @@ void SqlPreprocessor::preprocess(
 	use_native_parameters_syntax_ = use_native_parameters_syntax;
 
 	preprocessed_sql_.clear();
-	indexed_params_.clear();
-	named_params_.clear();
+	params_count_ = 0;
 
 	int param_index = 1;
 
@@ -80,10 +79,7 @@ void SqlPreprocessor::preprocess(
 		sql,
 		preprocessed_sql_,
 		actions,
-		named_params_,
-		indexed_params_,
 		param_index,
-		use_native_parameters_syntax_,
 		supports_indexed_params
 	);
 }
@@ -93,38 +89,58 @@ const std::string& SqlPreprocessor::get_preprocessed_sql() const
 	return preprocessed_sql_;
 }
 
-void SqlPreprocessor::do_for_param_indexes(const IndexOrName& param, const std::function<void(size_t)>& fun)
+void SqlPreprocessor::clear()
 {
-	if (!use_native_parameters_syntax_)
-	{
-		std::vector<size_t>* param_indices = nullptr;
+	preprocessed_sql_.clear();
+	params_count_ = 0;
+	use_native_parameters_syntax_ = false;
+}
 
-		if (param.get_type() == IndexOrNameType::Index)
-		{
-			auto it = indexed_params_.find(param.get_index());
-			if (it != indexed_params_.end())
-				param_indices = &it->second;
-		}
-		else
-		{
-			auto it = named_params_.find(param.get_name());
-			if (it != named_params_.end())
-				param_indices = &it->second;
-		}
+static bool is_same_param_name(std::string_view name1, std::string_view name2)
+{
+	CaseInsensitiveComparer less;
+	return !less(name1, name2) && !less(name2, name1);
+}
 
-		if (!param_indices)
-			throw ParameterNotFoundException(param.to_str());
+SqlPreprocessor::Param* SqlPreprocessor::find_param(const IndexOrName& param)
+{
+	bool is_index = (param.get_type() == IndexOrNameType::Index);
 
-		for (auto param_index : *param_indices)
-			fun(param_index);
+	for (size_t i = 0; i < params_count_; i++)
+	{
+		auto& item = params_[i];
+		if (is_index != item.name.empty()) continue;
+
+		if (is_index ? (item.user_index == param.get_index()) : is_same_param_name(item.name, param.get_name()))
+			return &item;
 	}
-	else
-		fun(param.get_index());
+
+	return nullptr;
+}
+
+SqlPreprocessor::Param& SqlPreprocessor::add_param(std::string_view name, size_t user_index)
+{
+	if (params_count_ == params_.size())
+		params_.emplace_back();
+
+	auto& result = params_[params_count_++];
+	result.name.assign(name);
+	result.user_index = user_index;
+	result.indexes.clear();
+	return result;
+}
+
+const std::vector<size_t>& SqlPreprocessor::get_param_indexes(const IndexOrName& param) const
+{
+	if (auto item = const_cast<SqlPreprocessor*>(this)->find_param(param))
+		return item->indexes;
+
+	throw ParameterNotFoundException(param.to_str());
 }
 
 size_t SqlPreprocessor::get_parameters_count() const
 {
-	return indexed_params_.size() + named_params_.size();
+	return params_count_;
 }
 
 #ifdef DBLIB_BOOST_REGEX
@@ -137,12 +153,11 @@ void SqlPreprocessor::preprocess_internal(
 	std::string_view             sql,
 	std::string                  &preprocessed_sql,
 	const SqlPreprocessorActions &actions,
-	NamedParams                  &named_params,
-	IndexedParams                &indexed_params,
 	int                          &param_index,
-	bool                         use_native_parameters_syntax,
 	bool                         supports_indexed_params)
 {
+	bool use_native_parameters_syntax = use_native_parameters_syntax_;
+
 	static regex_ns::regex item_regex{
 		R"--((\?)\d+)--" // (gr 1) indexed param ?1, ?2 etc
 		"|"
@@ -184,15 +199,17 @@ void SqlPreprocessor::preprocess_internal(
 				preprocessed_sql.insert(preprocessed_sql.end(), begin, m[0].first);
 				parameter.assign(m[0].first + 1, m[0].second); // + 1 to skip ?
 				size_t user_index = atoi(parameter.c_str());
+				auto item = find_param(user_index);
 
-				if (supports_indexed_params && indexed_params.count(user_index))
+				if (supports_indexed_params && item)
 				{
-					size_t existing_index = indexed_params[user_index][0];
+					size_t existing_index = item->indexes[0];
 					actions.append_index_param_to_sql(parameter, (int)existing_index, preprocessed_sql);
 				}
 				else
 				{
-					indexed_params[user_index].push_back(param_index);
+					if (!item) item = &add_param({}, user_index);
+					item->indexes.push_back(param_index);
 					actions.append_index_param_to_sql(parameter, param_index, preprocessed_sql);
 					param_index++;
 				}
@@ -209,14 +226,17 @@ void SqlPreprocessor::preprocess_internal(
 				parameter.assign(m[0].first, m[0].second);
 				preprocessed_sql.insert(preprocessed_sql.end(), begin, m[0].first);
 
-				if (supports_indexed_params && named_params.count(parameter))
+				auto item = find_param(parameter);
+
+				if (supports_indexed_params && item)
 				{
-					size_t existing_index = named_params[parameter][0];
+					size_t existing_index = item->indexes[0];
 					actions.append_index_param_to_sql(parameter, (int)existing_index, preprocessed_sql);
 				}
 				else
 				{
-					named_params[parameter].push_back(param_index);
+					if (!item) item = &add_param(parameter, 0);
+					item->indexes.push_back(param_index);
 					actions.append_named_param_to_sql(parameter, param_index, preprocessed_sql);
 					param_index++;
 				}
@@ -241,10 +261,7 @@ void SqlPreprocessor::preprocess_internal(
 				std::string_view(&*m[6].first, m[6].length()),
 				in_placeholder_parsed_text,
 				actions,
-				named_params,
-				indexed_params,
 				param_index,
-				use_native_parameters_syntax,
 				supports_indexed_params
 			);
 
@@ -273,6 +290,56 @@ void SqlPreprocessor::preprocess_internal(
 }
 
 
+/* class BlocksCache */
+
+BlocksCache::~BlocksCache()
+{
+	for (void *block : blocks_)
+		::operator delete(block);
+}
+
+void BlocksCache::set_max_count(size_t max_count)
+{
+	std::lock_guard lock(mutex_);
+	max_count_ = max_count;
+	while (blocks_.size() > max_count_)
+	{
+		::operator delete(blocks_.back());
+		blocks_.pop_back();
+	}
+}
+
+void* BlocksCache::allocate(size_t size)
+{
+	{
+		std::lock_guard lock(mutex_);
+		if ((size == block_size_) && !blocks_.empty())
+		{
+			void *result = blocks_.back();
+			blocks_.pop_back();
+			return result;
+		}
+	}
+
+	return ::operator new(size);
+}
+
+void BlocksCache::deallocate(void *ptr, size_t size)
+{
+	{
+		std::lock_guard lock(mutex_);
+		if (block_size_ == 0) block_size_ = size;
+		if ((size == block_size_) && (blocks_.size() < max_count_))
+		{
+			blocks_.push_back(ptr);
+			return;
+		}
+	}
+
+	::operator delete(ptr);
+}
+
+
 /* class ColumnsHelper */
 
 ColumnsHelper::ColumnsHelper(Statement& statement) :
@@ -307,15 +374,22 @@ size_t ColumnsHelper::get_column_index(const IndexOrName& column)
 }
 
 
-void throw_exception(
+/* struct TraceThreadState */
+
+TraceThreadState& get_trace_thread_state()
+{
+	static thread_local TraceThreadState state;
+	return state;
+}
+
+
+std::string format_error_text(
 	const char       *fun_name,
 	int              code,
-	int              extended_code,
 	std::string_view code_expl,
 	std::string_view sql_state,
 	std::string_view err_msg,
-	std::string_view sql,
-	ErrorType        error_type)
+	std::string_view sql)
 {
 	std::string error_text;
 
@@ -346,6 +420,17 @@ void throw_exception(
 		error_text.append(sql);
 	}
 
+	return error_text;
+}
+
+void throw_exception_of_type(
+	ErrorType          error_type,
+	const std::string  &error_text,
+	int                code,
+	int                extended_code)
+{
+	get_trace_thread_state().error_type = error_type;
+
 	switch (error_type)
 	{
 	case ErrorType::Transaction:
@@ -366,5 +451,23 @@ void throw_exception(
 	}
 }
 
+void throw_exception(
+	const char       *fun_name,
+	int              code,
+	int              extended_code,
+	std::string_view code_expl,
+	std::string_view sql_state,
+	std::string_view err_msg,
+	std::string_view sql,
+	ErrorType        error_type)
+{
+	throw_exception_of_type(
+		error_type,
+		format_error_text(fun_name, code, code_expl, sql_state, err_msg, sql),
+		code,
+		extended_code
+	);
+}
+
 
 } // namespace dblib
\ No newline at end of file
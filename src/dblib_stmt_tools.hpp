@@ -25,8 +25,13 @@ THE SOFTWARE.
 #include <string>
 #include <functional>
 #include <map>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 #include "../include/dblib/dblib.hpp"
+#include "../include/dblib/dblib_tracer.hpp"
 
 namespace dblib {
 
@@ -68,27 +73,58 @@ public:
 
 	const std::string& get_preprocessed_sql() const;
 
-	void do_for_param_indexes(const IndexOrName& param, const std::function<void(size_t)>& fun);
+	void clear();
+
+	template <typename Fun>
+	void do_for_param_indexes(const IndexOrName& param, const Fun& fun)
+	{
+		if (!use_native_parameters_syntax_)
+		{
+			for (auto param_index : get_param_indexes(param))
+				fun(param_index);
+		}
+		else
+			fun(param.get_index());
+	}
+
+	// calls fun(param, index) for every parameter in dblib syntax and its native index
+	template <typename Fun>
+	void do_for_params(const Fun& fun) const
+	{
+		for (size_t i = 0; i < params_count_; i++)
+		{
+			auto& item = params_[i];
+			IndexOrName param = item.name.empty() ? IndexOrName(item.user_index) : IndexOrName(item.name);
+			for (auto index : item.indexes) fun(param, index);
+		}
+	}
 
 	size_t get_parameters_count() const;
 
 private:
-	using NamedParams = std::map<std::string, std::vector<size_t>, CaseInsensitiveComparer>;
-	using IndexedParams = std::map<size_t, std::vector<size_t>>;
+	// named (:name, @name) or indexed (?1) parameter. Items after
+	// params_count_ are not used and keep their buffers for next sql
+	struct Param
+	{
+		std::string name; // empty for indexed parameter
+		size_t user_index = 0;
+		std::vector<size_t> indexes;
+	};
 
 	std::string preprocessed_sql_;
-	NamedParams named_params_;
-	IndexedParams indexed_params_;
+	std::vector<Param> params_;
+	size_t params_count_ = 0;
 	bool use_native_parameters_syntax_ = false;
 
-	static void preprocess_internal(
+	const std::vector<size_t>& get_param_indexes(const IndexOrName& param) const;
+	Param* find_param(const IndexOrName& param);
+	Param& add_param(std::string_view name, size_t user_index);
+
+	void preprocess_internal(
 		std::string_view             sql,
 		std::string                  &preprocessed_sql,
 		const SqlPreprocessorActions &actions,
-		NamedParams                  &named_params,
-		IndexedParams                &indexed_params,
 		int                          &param_index,
-		bool                         use_native_parameters_syntax,
 		bool                         supports_indexed_params
 	);
 };
@@ -108,16 +144,281 @@ private:
 	bool initialized_ = false;
 };
 
-enum class ErrorType
+// Per thread data for tracing. round_trips is increased by drivers
+// at every request to server, error_type is set by throw_exception
+
+struct TraceThreadState
 {
-	Normal,
-	Transaction,
-	Lock,
-	Connection,
-	LostConnection
+	size_t round_trips = 0;
+	ErrorType error_type = ErrorType::Normal;
 };
 
-void throw_exception(
+TraceThreadState& get_trace_thread_state();
+
+inline void count_round_trip()
+{
+	get_trace_thread_state().round_trips++;
+}
+
+// Counts call of client library in stats of connection. Round trips
+// are also counted for tracer
+inline void count_native_call(ConnectionStats &stats, NativeCallType type, bool round_trip, size_t sent_bytes = 0)
+{
+	stats.native_calls[(size_t)type]++;
+	stats.sent_bytes += sent_bytes;
+	if (round_trip)
+	{
+		stats.round_trips++;
+		count_round_trip();
+	}
+}
+
+// Calls Tracer::begin in constructor and Tracer::end in destructor.
+// Does nothing if tracer is nullptr
+
+class TraceScope
+{
+public:
+	TraceScope(Tracer* tracer, TraceOperation operation, std::string_view sql, Statement *statement = nullptr)
+	{
+		if (!tracer) return;
+		tracer_ = tracer;
+		uncaught_exceptions_ = std::uncaught_exceptions();
+		auto &thread_state = get_trace_thread_state();
+		thread_state.error_type = ErrorType::Normal;
+		round_trips_ = thread_state.round_trips;
+		event_.operation = operation;
+		event_.sql = sql;
+		event_.statement = statement;
+		event_.begin_time = TraceClock::now();
+		tracer_->begin(event_);
+	}
+
+	~TraceScope()
+	{
+		if (!tracer_) return;
+		auto &thread_state = get_trace_thread_state();
+		if (std::uncaught_exceptions() > uncaught_exceptions_)
+		{
+			event_.failed = true;
+			event_.error_type = thread_state.error_type;
+		}
+		event_.round_trips = thread_state.round_trips - round_trips_;
+		event_.end_time = TraceClock::now();
+		tracer_->end(event_);
+	}
+
+	TraceScope(const TraceScope&) = delete;
+	TraceScope& operator = (const TraceScope&) = delete;
+
+	bool is_active() const
+	{
+		return tracer_ != nullptr;
+	}
+
+	void set_sql(std::string_view sql)
+	{
+		event_.sql = sql;
+	}
+
+	void set_native_parameters_syntax(bool native_parameters_syntax)
+	{
+		event_.native_parameters_syntax = native_parameters_syntax;
+	}
+
+	void set_rows_count(size_t rows_count)
+	{
+		event_.rows_count = rows_count;
+	}
+
+	void add_bytes(size_t bytes_count)
+	{
+		event_.bytes_count += bytes_count;
+	}
+
+	// for errors returned in Status
+	void set_error(ErrorType error_type)
+	{
+		event_.failed = true;
+		event_.error_type = error_type;
+	}
+
+private:
+	Tracer* tracer_ = nullptr;
+	int uncaught_exceptions_ = 0;
+	size_t round_trips_ = 0;
+	TraceEvent event_;
+};
+
+/* class BlocksCache
+
+   Memory blocks of the same size which are reused without allocations.
+   Is used for control blocks of shared pointers of pooled statements.
+   Blocks can be returned from any thread */
+
+class BlocksCache
+{
+public:
+	~BlocksCache();
+
+	void set_max_count(size_t max_count);
+
+	void* allocate(size_t size);
+	void deallocate(void *ptr, size_t size);
+
+private:
+	std::mutex mutex_;
+	std::vector<void*> blocks_;
+	size_t block_size_ = 0;
+	size_t max_count_ = 0;
+};
+
+template <typename T>
+class BlocksCacheAllocator
+{
+public:
+	using value_type = T;
+
+	BlocksCacheAllocator(const std::shared_ptr<BlocksCache> &cache) :
+		cache_(cache)
+	{}
+
+	template <typename U>
+	BlocksCacheAllocator(const BlocksCacheAllocator<U> &other) :
+		cache_(other.get_cache())
+	{}
+
+	T* allocate(size_t count)
+	{
+		return static_cast<T*>(cache_->allocate(count * sizeof(T)));
+	}
+
+	void deallocate(T* ptr, size_t count)
+	{
+		cache_->deallocate(ptr, count * sizeof(T));
+	}
+
+	const std::shared_ptr<BlocksCache>& get_cache() const
+	{
+		return cache_;
+	}
+
+	template <typename U>
+	bool operator == (const BlocksCacheAllocator<U> &other) const
+	{
+		return cache_ == other.get_cache();
+	}
+
+	template <typename U>
+	bool operator != (const BlocksCacheAllocator<U> &other) const
+	{
+		return cache_ != other.get_cache();
+	}
+
+private:
+	// control block keeps cache alive after connection is destroyed
+	std::shared_ptr<BlocksCache> cache_;
+};
+
+
+/* class StatementsPool
+
+   Statements released by user which wait for reuse by connection.
+   Statements in pool don't hold connection and transaction. Control
+   blocks of shared pointers are reused too so statement is taken from
+   pool without allocations */
+
+template <typename Stmt>
+class StatementsPool
+{
+public:
+	StatementsPool() :
+		blocks_(std::make_shared<BlocksCache>())
+	{}
+
+	void set_max_size(size_t max_size)
+	{
+		std::lock_guard lock(mutex_);
+		stats_.max_size = max_size;
+		if (items_.size() > max_size)
+			items_.resize(max_size);
+		blocks_->set_max_count(max_size);
+	}
+
+	bool is_enabled() const
+	{
+		std::lock_guard lock(mutex_);
+		return stats_.max_size != 0;
+	}
+
+	StatementsPoolStats get_stats() const
+	{
+		std::lock_guard lock(mutex_);
+		auto result = stats_;
+		result.size = items_.size();
+		return result;
+	}
+
+	// returns nullptr if pool is empty
+	std::unique_ptr<Stmt> acquire()
+	{
+		std::lock_guard lock(mutex_);
+		if (items_.empty())
+		{
+			stats_.created++;
+			return nullptr;
+		}
+		stats_.reused++;
+		auto result = std::move(items_.back());
+		items_.pop_back();
+		return result;
+	}
+
+	// statement is deleted if pool is full
+	void release(std::unique_ptr<Stmt> &&stmt)
+	{
+		std::lock_guard lock(mutex_);
+		if (items_.size() < stats_.max_size)
+			items_.push_back(std::move(stmt));
+	}
+
+	// deleter returns statement into pool
+	template <typename Deleter>
+	std::shared_ptr<Stmt> make_shared_ptr(std::unique_ptr<Stmt> &&stmt, Deleter deleter)
+	{
+		return std::shared_ptr<Stmt>(stmt.release(), deleter, BlocksCacheAllocator<Stmt>(blocks_));
+	}
+
+	void clear()
+	{
+		std::lock_guard lock(mutex_);
+		items_.clear();
+	}
+
+private:
+	mutable std::mutex mutex_;
+	std::vector<std::unique_ptr<Stmt>> items_;
+	StatementsPoolStats stats_;
+	std::shared_ptr<BlocksCache> blocks_;
+};
+
+std::string format_error_text(
+	const char       *fun_name,
+	int              code,
+	std::string_view code_expl,
+	std::string_view sql_state,
+	std::string_view err_msg,
+	std::string_view sql
+);
+
+[[noreturn]] void throw_exception_of_type(
+	ErrorType          error_type,
+	const std::string  &error_text,
+	int                code,
+	int                extended_code
+);
+
+[[noreturn]] void throw_exception(
 	const char       *fun_name,
 	int              code,
 	int              extended_code,
@@ -0,0 +1,355 @@
+/*
+
+Copyright (c) 2015-2022 Artyomov Denis (denis.artyomov@gmail.com)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "../include/dblib/dblib_table_copier.hpp"
+#include "../include/dblib/dblib_exception.hpp"
+#include "../include/dblib/dblib_result_set.hpp"
+#include "../include/dblib/dblib_postgresql.hpp"
+
+namespace dblib {
+
+namespace {
+
+using ResultSetUPtr = std::unique_ptr<ResultSet>;
+using Clock = std::chrono::steady_clock;
+
+/* class BatchQueue */
+
+class BatchQueue
+{
+public:
+	void push(ResultSetUPtr &&item)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		items_.push_back(std::move(item));
+		cond_.notify_one();
+	}
+
+	// returns false if queue is closed and empty
+	bool pop(ResultSetUPtr &item)
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		cond_.wait(lock, [this] { return !items_.empty() || closed_; });
+		if (items_.empty()) return false;
+		item = std::move(items_.front());
+		items_.pop_front();
+		return true;
+	}
+
+	// waiting items are still returned by pop
+	void close()
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		closed_ = true;
+		cond_.notify_all();
+	}
+
+	// waiting items are removed
+	void abort()
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		items_.clear();
+		closed_ = true;
+		cond_.notify_all();
+	}
+
+private:
+	std::mutex mutex_;
+	std::condition_variable cond_;
+	std::deque<ResultSetUPtr> items_;
+	bool closed_ = false;
+};
+
+
+/* class BatchWriter */
+
+class BatchWriter
+{
+public:
+	virtual ~BatchWriter() = default;
+	virtual void write(const ResultSet &batch) = 0;
+};
+
+
+/* class InsertBatchWriter
+
+   Prepared insert for SQLite and Firebird */
+
+class InsertBatchWriter : public BatchWriter
+{
+public:
+	InsertBatchWriter(StatementPtr stmt, const std::string &table, const std::vector<std::string> &columns);
+	void write(const ResultSet &batch) override;
+
+private:
+	StatementPtr stmt_;
+};
+
+InsertBatchWriter::InsertBatchWriter(StatementPtr stmt, const std::string &table, const std::vector<std::string> &columns) :
+	stmt_(stmt)
+{
+	std::string sql = "insert into " + table + " (";
+	std::string values;
+
+	for (size_t i = 0; i < columns.size(); i++)
+	{
+		if (i != 0)
+		{
+			sql.append(", ");
+			values.append(", ");
+		}
+		sql.append(columns[i]);
+		values.append("?" + std::to_string(i + 1));
+	}
+
+	sql.append(") values (" + values + ")");
+
+	stmt_->prepare(sql);
+}
+
+void InsertBatchWriter::write(const ResultSet &batch)
+{
+	size_t rows_count = batch.get_rows_count();
+	size_t columns_count = batch.get_columns_count();
+
+	for (size_t row = 0; row < rows_count; row++)
+	{
+		for (size_t col = 1; col <= columns_count; col++)
+			set_param_from_column(*stmt_, col, batch.get_column(col), row);
+
+		stmt_->execute();
+	}
+}
+
+
+/* class PgCopyBatchWriter
+
+   Binary COPY for PostgreSQL. Binary format requires exact types of
+   destination columns so values are converted by PgBuffer::write_column_value */
+
+class PgCopyBatchWriter : public BatchWriter
+{
+public:
+	PgCopyBatchWriter(PgStatementPtr stmt, const std::string &table, const std::vector<std::string> &columns);
+	void write(const ResultSet &batch) override;
+
+private:
+	PgStatementPtr stmt_;
+	std::string copy_sql_;
+	std::vector<ValueType> dst_types_;
+	PgBuffer buffer_;
+};
+
+PgCopyBatchWriter::PgCopyBatchWriter(PgStatementPtr stmt, const std::string &table, const std::vector<std::string> &columns) :
+	stmt_(stmt)
+{
+	std::string columns_text;
+	for (size_t i = 0; i < columns.size(); i++)
+	{
+		if (i != 0) columns_text.append(", ");
+		columns_text.append(columns[i]);
+	}
+
+	// types of destination columns
+	ResultSet columns_info;
+	stmt_->execute("select " + columns_text + " from " + table + " where 1 = 0");
+	stmt_->fetch_columnar(columns_info, 1);
+	for (size_t i = 1; i <= columns_info.get_columns_count(); i++)
+		dst_types_.push_back(columns_info.get_column(i).get_type());
+
+	copy_sql_ = "COPY " + table + " (" + columns_text + ") FROM STDIN (format binary)";
+}
+
+void PgCopyBatchWriter::write(const ResultSet &batch)
+{
+	size_t rows_count = batch.get_rows_count();
+	size_t columns_count = batch.get_columns_count();
+
+	if (columns_count != dst_types_.size())
+		throw WrongArgumentException("Count of source and destination columns are different");
+
+	buffer_.clear();
+
+	for (size_t row = 0; row < rows_count; row++)
+	{
+		buffer_.begin_tuple();
+		for (size_t col = 1; col <= columns_count; col++)
+			buffer_.write_column_value(batch.get_column(col), row, dst_types_[col - 1]);
+		buffer_.end_tuple();
+	}
+
+	stmt_->execute(copy_sql_);
+	stmt_->put_buffer(buffer_);
+}
+
+} // namespace
+
+
+/* struct TableCopierStats */
+
+double TableCopierStats::get_rows_per_second() const
+{
+	double seconds = total_time.count();
+	return (seconds > 0) ? rows_count / seconds : 0;
+}
+
+
+/* class TableCopier */
+
+TableCopier::TableCopier(const TableCopierParams &params) :
+	params_(params)
+{
+	if (params_.batch_size == 0)
+		throw WrongArgumentException("TableCopierParams::batch_size can't be 0");
+}
+
+TableCopierStats TableCopier::copy(
+	Statement                      &src,
+	Transaction                    &dst,
+	std::string_view               dst_table,
+	const std::vector<std::string> &dst_columns)
+{
+	TableCopierStats stats;
+	auto start_time = Clock::now();
+
+	if (dst.get_state() != TransactionState::Started)
+		dst.start();
+
+	// Free batches go from writer to reader, filled batches from reader to writer.
+	// Count of batches limits memory and count of batches waiting for writer
+
+	BatchQueue free_batches;
+	BatchQueue filled_batches;
+
+	for (size_t i = 0; i < params_.queue_size + 2; i++)
+		free_batches.push(std::make_unique<ResultSet>());
+
+	std::exception_ptr reader_error;
+
+	std::thread reader([&]
+	{
+		try
+		{
+			ResultSetUPtr batch;
+			while (free_batches.pop(batch))
+			{
+				batch->clear_rows();
+				size_t rows_count = src.fetch_columnar(*batch, params_.batch_size);
+				if (rows_count != 0)
+					filled_batches.push(std::move(batch));
+				if (rows_count < params_.batch_size)
+					break;
+			}
+		}
+		catch (...)
+		{
+			reader_error = std::current_exception();
+		}
+
+		filled_batches.close();
+	});
+
+	std::exception_ptr writer_error;
+
+	try
+	{
+		std::unique_ptr<BatchWriter> writer;
+		size_t rows_after_commit = 0;
+		ResultSetUPtr batch;
+
+		for (;;)
+		{
+			auto wait_start = Clock::now();
+			bool has_batch = filled_batches.pop(batch);
+			stats.wait_time += Clock::now() - wait_start;
+			if (!has_batch) break;
+
+			auto write_start = Clock::now();
+
+			if (!writer)
+			{
+				std::vector<std::string> columns = dst_columns;
+				if (columns.empty())
+				{
+					for (size_t i = 1; i <= batch->get_columns_count(); i++)
+						columns.push_back(batch->get_column(i).get_name());
+				}
+				else if (columns.size() != batch->get_columns_count())
+					throw WrongArgumentException("Count of source and destination columns are different");
+
+				auto stmt = dst.create_statement();
+				std::string table(dst_table);
+
+				if (auto pg_stmt = std::dynamic_pointer_cast<PgStatement>(stmt))
+					writer = std::make_unique<PgCopyBatchWriter>(pg_stmt, table, columns);
+				else
+					writer = std::make_unique<InsertBatchWriter>(stmt, table, columns);
+			}
+
+			writer->write(*batch);
+
+			stats.rows_count += batch->get_rows_count();
+			stats.batches_count++;
+			rows_after_commit += batch->get_rows_count();
+
+			if ((params_.commit_rows != 0) && (rows_after_commit >= params_.commit_rows))
+			{
+				dst.commit_and_start();
+				stats.commits_count++;
+				rows_after_commit = 0;
+			}
+
+			stats.write_time += Clock::now() - write_start;
+
+			free_batches.push(std::move(batch));
+		}
+	}
+	catch (...)
+	{
+		writer_error = std::current_exception();
+	}
+
+	// stops reader if writer failed
+	free_batches.abort();
+	reader.join();
+
+	if (writer_error) std::rethrow_exception(writer_error);
+	if (reader_error) std::rethrow_exception(reader_error);
+
+	dst.commit();
+	stats.commits_count++;
+
+	stats.total_time = Clock::now() - start_time;
+
+	return stats;
+}
+
+} // namespace dblib
@@ -0,0 +1,132 @@
+/*
+
+Copyright (c) 2015-2022 Artyomov Denis (denis.artyomov@gmail.com)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+#include <algorithm>
+#include <new>
+
+#include "../include/dblib/dblib_tracer.hpp"
+
+namespace dblib {
+
+const char* trace_operation_to_string(TraceOperation operation)
+{
+	switch (operation)
+	{
+	case TraceOperation::Prepare:  return "prepare";
+	case TraceOperation::Execute:  return "execute";
+	case TraceOperation::Fetch:    return "fetch";
+	case TraceOperation::Commit:   return "commit";
+	case TraceOperation::Rollback: return "rollback";
+	}
+
+	return "";
+}
+
+
+/* class Tracer */
+
+Tracer::~Tracer()
+{}
+
+
+/* class TracerList */
+
+TracerList::TracerList(std::vector<TracerPtr> tracers) :
+	tracers_(std::move(tracers))
+{
+	tracers_.erase(std::remove(tracers_.begin(), tracers_.end(), nullptr), tracers_.end());
+}
+
+void TracerList::begin(TraceEvent &event)
+{
+	// array of user_data is allocated only if some tracer uses it
+	void **tracers_data = nullptr;
+
+	for (size_t i = 0; i < tracers_.size(); i++)
+	{
+		event.user_data = nullptr;
+		tracers_[i]->begin(event);
+		if (event.user_data == nullptr) continue;
+
+		if (tracers_data == nullptr)
+			tracers_data = new (std::nothrow) void*[tracers_.size()]();
+
+		if (tracers_data != nullptr)
+			tracers_data[i] = event.user_data;
+	}
+
+	event.user_data = tracers_data;
+}
+
+void TracerList::end(TraceEvent &event)
+{
+	auto tracers_data = (void**)event.user_data;
+
+	for (size_t i = 0; i < tracers_.size(); i++)
+	{
+		event.user_data = tracers_data ? tracers_data[i] : nullptr;
+		tracers_[i]->end(event);
+	}
+
+	delete [] tracers_data;
+	event.user_data = nullptr;
+}
+
+
+/* class SpanTracer */
+
+SpanTracer::SpanTracer(std::string_view db_system, TraceSpanFun span_fun, const SpanTracerParams &params) :
+	db_system_(db_system),
+	span_fun_(std::move(span_fun)),
+	params_(params)
+{}
+
+void SpanTracer::begin(TraceEvent &)
+{}
+
+void SpanTracer::end(TraceEvent &event)
+{
+	if (!span_fun_) return;
+	if ((event.operation == TraceOperation::Fetch) && !params_.fetch_spans) return;
+
+	TraceSpan span;
+	span.name = "db.";
+	span.name.append(trace_operation_to_string(event.operation));
+	span.error = event.failed;
+	span.start_time = event.begin_time;
+	span.end_time = event.end_time;
+
+	span.attributes.emplace_back("db.system", db_system_);
+	if (!event.sql.empty())
+		span.attributes.emplace_back("db.statement", std::string(event.sql.substr(0, params_.max_statement_len)));
+	if (event.operation == TraceOperation::Execute || event.operation == TraceOperation::Fetch)
+	{
+		span.attributes.emplace_back("db.rows", std::to_string(event.rows_count));
+		span.attributes.emplace_back("db.bytes", std::to_string(event.bytes_count));
+	}
+
+	span_fun_(span);
+}
+
+} // namespace dblib
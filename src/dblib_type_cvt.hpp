@@ -405,6 +405,9 @@ T get_with_type_cvt(IResultGetterWithTypeCvt &dp, ValueType fld_type, size_t ind
 	case ValueType::BigInt:
 		return int_to<T>(dp.get_int64_impl(index));
 
+	case ValueType::Boolean:
+		return int_to<T>(dp.get_int32_impl(index));
+
 	case ValueType::Char:
 		if constexpr (std::is_same_v<T, std::string>)
 		{
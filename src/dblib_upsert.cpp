@@ -0,0 +1,377 @@
+/*
+
+Copyright (c) 2015-2022 Artyomov Denis (denis.artyomov@gmail.com)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+#include <ctype.h>
+
+#include <algorithm>
+
+#include "../include/dblib/dblib_upsert.hpp"
+#include "../include/dblib/dblib_exception.hpp"
+#include "../include/dblib/dblib_postgresql.hpp"
+#include "dblib_stmt_tools.hpp"
+
+namespace dblib {
+
+/* class UpsertStrategy */
+
+class UpsertStrategy
+{
+public:
+	virtual ~UpsertStrategy() = default;
+	virtual UpsertCounts write(const ResultSet &rows) = 0;
+};
+
+namespace {
+
+struct UpsertSql
+{
+	std::string columns;       // c1, c2, c3
+	std::string values;        // ?1, ?2, ?3
+	std::string key_columns;   // k1, k2
+	std::string key_condition; // k1 = ?1 and k2 = ?2
+	std::string set_values;    // c3 = ?3
+	std::string set_excluded;  // c3 = excluded.c3
+};
+
+UpsertSql build_upsert_sql(const std::vector<std::string> &columns, const std::vector<std::string> &key_columns)
+{
+	CaseInsensitiveComparer less;
+	auto is_same = [&less](const std::string &a, const std::string &b)
+	{
+		return !less(a, b) && !less(b, a);
+	};
+
+	UpsertSql result;
+
+	auto append = [](std::string &dst, const char *separator, const std::string &text)
+	{
+		if (!dst.empty()) dst.append(separator);
+		dst.append(text);
+	};
+
+	for (auto &key_column : key_columns)
+	{
+		auto it = std::find_if(columns.begin(), columns.end(), [&](auto &col) { return is_same(col, key_column); });
+		if (it == columns.end())
+			throw WrongArgumentException("Key column " + key_column + " is not found in upsert rows");
+
+		std::string param = "?" + std::to_string(it - columns.begin() + 1);
+		append(result.key_columns, ", ", key_column);
+		append(result.key_condition, " and ", key_column + " = " + param);
+	}
+
+	for (size_t i = 0; i < columns.size(); i++)
+	{
+		auto &column = columns[i];
+		std::string param = "?" + std::to_string(i + 1);
+
+		append(result.columns, ", ", column);
+		append(result.values, ", ", param);
+
+		bool is_key = std::any_of(key_columns.begin(), key_columns.end(), [&](auto &key) { return is_same(column, key); });
+		if (is_key) continue;
+
+		append(result.set_values, ", ", column + " = " + param);
+		append(result.set_excluded, ", ", column + " = excluded." + column);
+	}
+
+	return result;
+}
+
+void bind_row(Statement &stmt, const ResultSet &rows, size_t row)
+{
+	for (size_t col = 1; col <= rows.get_columns_count(); col++)
+		set_param_from_column(stmt, col, rows.get_column(col), row);
+}
+
+
+/* class UpdateInsertStrategy
+
+   SQLite and Firebird. Count of updated rows says if row exists */
+
+class UpdateInsertStrategy : public UpsertStrategy
+{
+public:
+	UpdateInsertStrategy(Transaction &tran, const std::string &table, const UpsertSql &sql);
+	UpsertCounts write(const ResultSet &rows) override;
+
+private:
+	StatementPtr update_stmt_;
+	StatementPtr insert_stmt_;
+};
+
+UpdateInsertStrategy::UpdateInsertStrategy(Transaction &tran, const std::string &table, const UpsertSql &sql)
+{
+	if (sql.set_values.empty())
+		throw WrongArgumentException("There are no columns to update in upsert except keys");
+
+	update_stmt_ = tran.create_statement();
+	update_stmt_->prepare("update " + table + " set " + sql.set_values + " where " + sql.key_condition);
+
+	insert_stmt_ = tran.create_statement();
+	insert_stmt_->prepare("insert into " + table + " (" + sql.columns + ") values (" + sql.values + ")");
+}
+
+UpsertCounts UpdateInsertStrategy::write(const ResultSet &rows)
+{
+	UpsertCounts result;
+
+	for (size_t row = 0; row < rows.get_rows_count(); row++)
+	{
+		bind_row(*update_stmt_, rows, row);
+		update_stmt_->execute();
+
+		if (update_stmt_->get_changes_count() != 0)
+		{
+			result.updated++;
+			continue;
+		}
+
+		bind_row(*insert_stmt_, rows, row);
+		insert_stmt_->execute();
+		result.inserted++;
+	}
+
+	return result;
+}
+
+
+// PostgreSQL: xmax of row is 0 if it was inserted and not 0 if it was updated
+// by insert ... on conflict do update
+
+std::string get_pg_on_conflict_sql(const UpsertSql &sql)
+{
+	return
+		" on conflict (" + sql.key_columns + ") " +
+		(sql.set_excluded.empty() ? "do nothing" : "do update set " + sql.set_excluded) +
+		" returning cast((xmax = 0) as integer)";
+}
+
+
+/* class PgRowsStrategy */
+
+class PgRowsStrategy : public UpsertStrategy
+{
+public:
+	PgRowsStrategy(Transaction &tran, const std::string &table, const UpsertSql &sql);
+	UpsertCounts write(const ResultSet &rows) override;
+
+private:
+	StatementPtr stmt_;
+};
+
+PgRowsStrategy::PgRowsStrategy(Transaction &tran, const std::string &table, const UpsertSql &sql)
+{
+	stmt_ = tran.create_statement();
+	stmt_->prepare(
+		"insert into " + table + " (" + sql.columns + ") values (" + sql.values + ")" +
+		get_pg_on_conflict_sql(sql)
+	);
+}
+
+UpsertCounts PgRowsStrategy::write(const ResultSet &rows)
+{
+	UpsertCounts result;
+
+	for (size_t row = 0; row < rows.get_rows_count(); row++)
+	{
+		bind_row(*stmt_, rows, row);
+		stmt_->execute();
+
+		// no rows for "do nothing"
+		if (!stmt_->fetch()) continue;
+
+		if (stmt_->get_int32(1) != 0)
+			result.inserted++;
+		else
+			result.updated++;
+	}
+
+	return result;
+}
+
+
+/* class PgStagingStrategy */
+
+class PgStagingStrategy : public UpsertStrategy
+{
+public:
+	PgStagingStrategy(Transaction &tran, const std::string &table, const UpsertSql &sql);
+	UpsertCounts write(const ResultSet &rows) override;
+
+private:
+	PgStatementPtr stmt_;
+	std::string staging_table_;
+	std::string create_staging_sql_;
+	std::string truncate_staging_sql_;
+	std::string copy_sql_;
+	std::string merge_sql_;
+	std::vector<ValueType> types_;
+	PgBuffer buffer_;
+	bool duplicates_are_updated_ = false;
+	bool staging_is_created_ = false;
+};
+
+PgStagingStrategy::PgStagingStrategy(Transaction &tran, const std::string &table, const UpsertSql &sql)
+{
+	stmt_ = std::dynamic_pointer_cast<PgStatement>(tran.create_statement());
+
+	staging_table_ = "dblib_upsert_";
+	for (char chr : table)
+		staging_table_.push_back(isalnum((unsigned char)chr) ? (char)tolower((unsigned char)chr) : '_');
+
+	// dblib_row_num keeps order of rows to take the last one for repeated key
+	create_staging_sql_ =
+		"create temp table if not exists " + staging_table_ +
+		" (like " + table + " including defaults, dblib_row_num bigserial)";
+
+	truncate_staging_sql_ = "truncate " + staging_table_;
+
+	copy_sql_ = "COPY " + staging_table_ + " (" + sql.columns + ") FROM STDIN (format binary)";
+
+	merge_sql_ =
+		"with upserted as ("
+		"insert into " + table + " (" + sql.columns + ") "
+		"select distinct on (" + sql.key_columns + ") " + sql.columns + " from " + staging_table_ +
+		" order by " + sql.key_columns + ", dblib_row_num desc" +
+		get_pg_on_conflict_sql(sql) + " as is_inserted"
+		") "
+		"select sum(is_inserted), count(*) - sum(is_inserted) from upserted";
+
+	// row by row strategy updates row for repeated key
+	duplicates_are_updated_ = !sql.set_excluded.empty();
+
+	// types of destination columns for binary COPY
+	ResultSet columns_info;
+	stmt_->execute("select " + sql.columns + " from " + table + " where 1 = 0");
+	stmt_->fetch_columnar(columns_info, 1);
+	for (size_t i = 1; i <= columns_info.get_columns_count(); i++)
+		types_.push_back(columns_info.get_column(i).get_type());
+}
+
+UpsertCounts PgStagingStrategy::write(const ResultSet &rows)
+{
+	// table may be left by other upserter of the same session
+	if (!staging_is_created_)
+	{
+		stmt_->execute(create_staging_sql_);
+		staging_is_created_ = true;
+	}
+	stmt_->execute(truncate_staging_sql_);
+
+	buffer_.clear();
+	for (size_t row = 0; row < rows.get_rows_count(); row++)
+	{
+		buffer_.begin_tuple();
+		for (size_t col = 1; col <= rows.get_columns_count(); col++)
+			buffer_.write_column_value(rows.get_column(col), row, types_[col - 1]);
+		buffer_.end_tuple();
+	}
+
+	stmt_->execute(copy_sql_);
+	stmt_->put_buffer(buffer_);
+
+	UpsertCounts result;
+	stmt_->execute(merge_sql_);
+	if (stmt_->fetch() && !stmt_->is_null(1))
+	{
+		result.inserted = (size_t)stmt_->get_int64(1);
+		result.updated = (size_t)stmt_->get_int64(2);
+	}
+
+	// only the last row of repeated key is merged
+	if (duplicates_are_updated_)
+		result.updated = rows.get_rows_count() - result.inserted;
+
+	return result;
+}
+
+} // namespace
+
+
+/* class Upserter */
+
+Upserter::Upserter(
+	Transaction                    &tran,
+	std::string_view               table,
+	const std::vector<std::string> &key_columns,
+	const UpsertParams             &params
+) :
+	tran_(tran),
+	table_(table),
+	key_columns_(key_columns),
+	params_(params)
+{
+	if (key_columns_.empty())
+		throw WrongArgumentException("Key columns of upsert are not defined");
+
+	is_postgresql_ = (tran_.get_connection()->get_driver_name() == "postgresql");
+}
+
+Upserter::~Upserter() = default;
+
+void Upserter::init_for_columns(const ResultSet &rows)
+{
+	std::vector<std::string> columns;
+	for (size_t i = 1; i <= rows.get_columns_count(); i++)
+		columns.push_back(rows.get_column(i).get_name());
+
+	if (columns == columns_) return;
+
+	row_strategy_.reset();
+	staging_strategy_.reset();
+	columns_ = columns;
+}
+
+UpsertCounts Upserter::write(const ResultSet &rows)
+{
+	if (rows.get_rows_count() == 0)
+		return {};
+
+	init_for_columns(rows);
+
+	if (is_postgresql_ && (rows.get_rows_count() >= params_.staging_min_rows))
+	{
+		if (!staging_strategy_)
+		{
+			auto sql = build_upsert_sql(columns_, key_columns_);
+			staging_strategy_ = std::make_unique<PgStagingStrategy>(tran_, table_, sql);
+		}
+
+		return staging_strategy_->write(rows);
+	}
+
+	if (!row_strategy_)
+	{
+		auto sql = build_upsert_sql(columns_, key_columns_);
+		if (is_postgresql_)
+			row_strategy_ = std::make_unique<PgRowsStrategy>(tran_, table_, sql);
+		else
+			row_strategy_ = std::make_unique<UpdateInsertStrategy>(tran_, table_, sql);
+	}
+
+	return row_strategy_->write(rows);
+}
+
+} // namespace dblib
@@ -10,18 +10,34 @@
 #include <mutex>
 #include <memory>
 #include <functional>
+#include <thread>
+#include <algorithm>
 
 #include <boost/algorithm/string.hpp>
 #include <boost/test/unit_test.hpp>
 
 #include "../src/dblib_type_cvt.hpp"
 #include "../src/dblib_stmt_tools.hpp"
+#include "dblib_alloc_counter.hpp"
 
 #include "../include/dblib/dblib.hpp"
 #include "../include/dblib/dblib_firebird.hpp"
 #include "../include/dblib/dblib_sqlite.hpp"
 #include "../include/dblib/dblib_postgresql.hpp"
 #include "../include/dblib/dblib_cvt_utils.hpp"
+#include "../include/dblib/dblib_result_set.hpp"
+#include "../include/dblib/dblib_query_cache.hpp"
+#include "../include/dblib/dblib_arrow.hpp"
+#include "../include/dblib/dblib_csv.hpp"
+#include "../include/dblib/dblib_table_copier.hpp"
+#include "../include/dblib/dblib_keyset_scanner.hpp"
+#include "../include/dblib/dblib_upsert.hpp"
+#include "../include/dblib/dblib_sequence.hpp"
+#include "../include/dblib/dblib_schema.hpp"
+#include "../include/dblib/dblib_mock.hpp"
+#include "../include/dblib/dblib_tracer.hpp"
+#include "../include/dblib/dblib_metrics.hpp"
+#include "../include/dblib/dblib_slow_query_log.hpp"
 
 #if defined (DBLIB_WINDOWS)
 	#define NOMINMAX
@@ -400,9 +416,708 @@ BOOST_AUTO_TEST_CASE(timestamp_cvt_test)
 	}
 }
 
-BOOST_AUTO_TEST_SUITE_END()
+BOOST_AUTO_TEST_CASE(result_column_test)
+{
+	ResultColumn column("fld", ValueType::Null);
+
+	// null values before column type is known
+	column.append_null();
+	column.append_null();
+	column.set_type(ValueType::Varchar);
+	column.append_str("abc");
+	column.append_null();
+	column.append_str("");
+
+	BOOST_CHECK(column.get_rows_count() == 5);
+	BOOST_CHECK(column.is_null(0));
+	BOOST_CHECK(column.is_null(1));
+	BOOST_CHECK(!column.is_null(2));
+	BOOST_CHECK(column.is_null(3));
+	BOOST_CHECK(!column.is_null(4));
+	BOOST_CHECK(column.get_str(2) == "abc");
+	BOOST_CHECK(column.get_str(4).empty());
+	BOOST_CHECK(column.get_offsets().size() == 6);
+	BOOST_CHECK_THROW(column.append_int32(1), WrongTypeConvException);
+	BOOST_CHECK_THROW(column.set_type(ValueType::Integer), WrongSeqException);
+
+	ResultColumn int_column("int_fld", ValueType::Short);
+	for (int i = 0; i < 100; i++)
+	{
+		if (i % 3 == 0)
+			int_column.append_null();
+		else
+			int_column.append_int16((int16_t)i);
+	}
 
-///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	BOOST_CHECK(int_column.get_null_bitmap().size() == 2);
+	BOOST_CHECK(int_column.get_values<int16_t>().size() == 100);
+	BOOST_CHECK(int_column.is_null(99));
+	BOOST_CHECK(int_column.get_int64(98) == 98);
+	BOOST_CHECK(int_column.get_double(97) == 97.0);
+	BOOST_CHECK_THROW(int_column.get_str(1), WrongTypeConvException);
+	BOOST_CHECK_THROW(int_column.is_null(100), WrongArgumentException);
+
+	int_column.clear();
+	BOOST_CHECK(int_column.get_rows_count() == 0);
+	BOOST_CHECK(int_column.get_type() == ValueType::Short);
+}
+
+BOOST_AUTO_TEST_CASE(query_cache_sql_parse_test)
+{
+	using Tables = std::vector<std::string>;
+
+	BOOST_CHECK(get_sql_source_tables("select * from t1") == Tables({ "t1" }));
+	BOOST_CHECK(get_sql_source_tables("select * from T1 a, public.t2 as b where a.x=b.x") == Tables({ "t1", "t2" }));
+	BOOST_CHECK(get_sql_source_tables("select * from t1 left join \"T2\" on t1.x = \"T2\".x join t3 using(x)") == Tables({ "t1", "t2", "t3" }));
+	BOOST_CHECK(get_sql_source_tables("select * from (select x from t1) q join t2 on q.x=t2.x") == Tables({ "t1", "t2" }));
+	BOOST_CHECK(get_sql_source_tables("select 'from t3' from t1 -- from t4") == Tables({ "t1" }));
+	BOOST_CHECK(get_sql_source_tables("select * from generate_series(1, 10)").empty());
+
+	BOOST_CHECK(get_sql_target_table("insert into T1(x) values(1)") == "t1");
+	BOOST_CHECK(get_sql_target_table("insert or replace into t1(x) values(1)") == "t1");
+	BOOST_CHECK(get_sql_target_table("update or insert into t1(x) values(1) matching(x)") == "t1");
+	BOOST_CHECK(get_sql_target_table("update public.t1 set x = 1") == "t1");
+	BOOST_CHECK(get_sql_target_table("delete from t1 where x = 1") == "t1");
+	BOOST_CHECK(get_sql_target_table("merge into t1 using t2 on t1.x = t2.x") == "t1");
+	BOOST_CHECK(get_sql_target_table("drop table if exists t1") == "t1");
+	BOOST_CHECK(get_sql_target_table("with q as (select * from t2) delete from t1") == "t1");
+	BOOST_CHECK(get_sql_target_table("with q as (select * from t2) select * from q").empty());
+	BOOST_CHECK(get_sql_target_table("select * from t1").empty());
+}
+
+BOOST_AUTO_TEST_CASE(query_cache_test)
+{
+	auto make_result = [](int value)
+	{
+		auto result = std::make_shared<ResultSet>();
+		result->add_column("x", ValueType::Integer).append_int32(value);
+		return result;
+	};
+
+	QueryCacheParams params;
+	params.ttl = std::chrono::hours(1);
+	QueryCache cache(params);
+
+	const char *sql = "select x from t1 join t2 on t1.id = t2.id where x = ?";
+
+	cache.put(sql, { 1 }, make_result(1));
+	cache.put(sql, { std::string("1") }, make_result(2));
+	cache.put(sql, { std::monostate() }, make_result(3));
+
+	BOOST_CHECK(cache.get_items_count() == 3);
+	BOOST_CHECK(cache.get(sql, { 1 })->get_column(1).get_int32(0) == 1);
+	BOOST_CHECK(cache.get(sql, { std::string("1") })->get_column(1).get_int32(0) == 2);
+	BOOST_CHECK(cache.get(sql, { std::monostate() })->get_column(1).get_int32(0) == 3);
+	BOOST_CHECK(cache.get(sql, { 2 }) == nullptr);
+	BOOST_CHECK(cache.get(sql) == nullptr);
+
+	auto stats = cache.get_stats();
+	BOOST_CHECK(stats.hits == 3);
+	BOOST_CHECK(stats.misses == 2);
+
+	cache.invalidate_by_sql("update t3 set x = 1");
+	BOOST_CHECK(cache.get_items_count() == 3);
+
+	cache.invalidate_by_sql("delete from T2");
+	BOOST_CHECK(cache.get_items_count() == 0);
+	BOOST_CHECK(cache.get_memory_size() == 0);
+
+	// schema is ignored as in sql
+	cache.put(sql, { 1 }, make_result(1));
+	cache.invalidate_table("public.t3");
+	BOOST_CHECK(cache.get_items_count() == 1);
+	cache.invalidate_table("public.\"T1\"");
+	BOOST_CHECK(cache.get_items_count() == 0);
+
+	// TTL
+	params.ttl = std::chrono::milliseconds(0);
+	QueryCache ttl_cache(params);
+	ttl_cache.put(sql, { 1 }, make_result(1));
+	BOOST_CHECK(ttl_cache.get(sql, { 1 }) == nullptr);
+
+	// memory budget
+	params.ttl = std::chrono::hours(1);
+	params.max_memory_size = 0;
+	QueryCache small_cache(params);
+	small_cache.put(sql, { 1 }, make_result(1));
+	BOOST_CHECK(small_cache.get_items_count() == 0);
+
+	QueryCache lru_cache;
+	lru_cache.put(sql, { 1 }, make_result(1));
+	size_t item_size = lru_cache.get_memory_size();
+	params.max_memory_size = 2 * item_size + item_size / 2;
+	QueryCache lru_cache2(params);
+	lru_cache2.put(sql, { 1 }, make_result(1));
+	lru_cache2.put(sql, { 2 }, make_result(2));
+	lru_cache2.get(sql, { 1 });
+	lru_cache2.put(sql, { 3 }, make_result(3));
+	BOOST_CHECK(lru_cache2.get_items_count() == 2);
+	BOOST_CHECK(lru_cache2.get(sql, { 1 }) != nullptr);
+	BOOST_CHECK(lru_cache2.get(sql, { 2 }) == nullptr);
+	BOOST_CHECK(lru_cache2.get_stats().evictions == 1);
+}
+
+BOOST_AUTO_TEST_CASE(arrow_stream_test)
+{
+	std::vector<char> stream;
+	size_t messages_count = 0;
+
+	ArrowStreamWriter writer([&](const char *data, size_t size)
+	{
+		if ((size >= 4) && (memcmp(data, "\xFF\xFF\xFF\xFF", 4) == 0)) messages_count++;
+		stream.insert(stream.end(), data, data + size);
+	});
+
+	ResultSet result;
+	result.add_column("int_fld", ValueType::Integer);
+	result.add_column("str_fld", ValueType::Varchar);
+	result.add_column("null_fld", ValueType::Null);
+
+	for (int i = 0; i < 100; i++)
+	{
+		result.get_column(1).append_int32(i);
+		result.get_column(2).append_str(std::to_string(i));
+		result.get_column(3).append_null();
+	}
+
+	writer.write_batch(result);
+	writer.write_batch(result);
+
+	// schema message, 2 record batches
+	BOOST_CHECK(messages_count == 3);
+	BOOST_CHECK(stream.size() % 8 == 0);
+
+	ResultSet other_result;
+	other_result.add_column("int_fld", ValueType::Double);
+	other_result.add_column("str_fld", ValueType::Varchar);
+	other_result.add_column("null_fld", ValueType::Null);
+	BOOST_CHECK_THROW(writer.write_batch(other_result), WrongArgumentException);
+
+	writer.finish();
+	BOOST_CHECK(messages_count == 4);
+
+	const char end_of_stream[] = { -1, -1, -1, -1, 0, 0, 0, 0 };
+	BOOST_CHECK(memcmp(stream.data() + stream.size() - 8, end_of_stream, 8) == 0);
+
+	BOOST_CHECK_THROW(writer.write_batch(result), WrongSeqException);
+}
+
+BOOST_AUTO_TEST_CASE(csv_test)
+{
+	const std::string text =
+		"\xEF\xBB\xBFid,name,dt\r\n"
+		"1,simple,2021-03-04\r\n"
+		"2,\"with \"\"quotes\"\" and, comma\",\n"
+		"3,\"multi\nline\",2021-03-05\n"
+		"4,\"\",1999-12-31";
+
+	// small chunks to check records which are splitted between buffers
+	auto make_input = [&text](size_t chunk_size)
+	{
+		return [&text, chunk_size, pos = size_t(0)](char *buffer, size_t size) mutable
+		{
+			size_t result = std::min(std::min(size, chunk_size), text.size() - pos);
+			memcpy(buffer, text.data() + pos, result);
+			pos += result;
+			return result;
+		};
+	};
+
+	for (size_t chunk_size : { 1, 3, 1000 })
+	{
+		CsvReader reader(make_input(chunk_size));
+
+		BOOST_CHECK(reader.get_header() == std::vector<std::string>({ "id", "name", "dt" }));
+
+		BOOST_CHECK(reader.read_record());
+		BOOST_CHECK(reader.get_fields_count() == 3);
+		BOOST_CHECK(reader.get_field(1) == "1");
+		BOOST_CHECK(reader.get_field(2) == "simple");
+		BOOST_CHECK(reader.get_field(3) == "2021-03-04");
+
+		BOOST_CHECK(reader.read_record());
+		BOOST_CHECK(reader.get_field(2) == "with \"quotes\" and, comma");
+		BOOST_CHECK(reader.is_null(3));
+
+		BOOST_CHECK(reader.read_record());
+		BOOST_CHECK(reader.get_field(2) == "multi\nline");
+
+		BOOST_CHECK(reader.read_record());
+		BOOST_CHECK(!reader.is_null(2));
+		BOOST_CHECK(reader.get_field(2) == "");
+		BOOST_CHECK(reader.get_field(3) == "1999-12-31");
+		BOOST_CHECK_THROW(reader.get_field(4), ColumnNotFoundException);
+
+		BOOST_CHECK(!reader.read_record());
+	}
+
+	// typed columnar reading
+
+	CsvReader reader(make_input(5));
+	ResultSet result;
+	BOOST_CHECK(reader.read_columnar(result, { ValueType::Integer, ValueType::Varchar, ValueType::Date }) == 4);
+	BOOST_CHECK(result.get_column("id").get_int32(3) == 4);
+	BOOST_CHECK(result.get_column("name").get_str(2) == "multi\nline");
+	BOOST_CHECK(result.get_column("dt").is_null(1));
+	BOOST_CHECK(result.get_column("dt").get_date(3) == Date(1999, 12, 31));
+
+	// unterminated quote
+
+	std::string wrong_text = "1,\"abc";
+	CsvFormat no_header;
+	no_header.header = false;
+	CsvReader wrong_reader([&](char *buffer, size_t size)
+	{
+		size_t result = std::min(size, wrong_text.size());
+		memcpy(buffer, wrong_text.data(), result);
+		wrong_text.erase(0, result);
+		return result;
+	}, no_header);
+	BOOST_CHECK_THROW(wrong_reader.read_record(), WrongArgumentException);
+
+	// date and time parsing
+
+	TimeStamp ts;
+	BOOST_CHECK(parse_csv_timestamp("2020-01-02T03:04:05.123456", ts));
+	BOOST_CHECK(ts == TimeStamp({ 2020, 1, 2 }, { 3, 4, 5, 123, 456 }));
+	BOOST_CHECK(parse_csv_timestamp("2020-01-02", ts));
+	BOOST_CHECK(ts == TimeStamp({ 2020, 1, 2 }, { 0, 0, 0 }));
+	Time time;
+	BOOST_CHECK(parse_csv_time("10:20:30.5", time));
+	BOOST_CHECK(time == Time(10, 20, 30, 500));
+	BOOST_CHECK(!parse_csv_time("10:20", time));
+	Date date;
+	BOOST_CHECK(!parse_csv_date("2020-01-02x", date));
+
+	// writer
+
+	std::string output;
+	CsvFormat format = CsvFormat::tsv();
+	format.null_text = "\\N";
+	CsvWriter writer([&](const char *data, size_t size) { output.append(data, size); }, format);
+
+	writer.write_int64(-42);
+	writer.write_str("a\tb");
+	writer.write_str("\\N");
+	writer.write_null();
+	writer.write_blob("\x01\xAB", 2);
+	writer.write_timestamp(TimeStamp({ 2020, 1, 2 }, { 3, 4, 5, 6 }));
+	writer.end_record();
+	writer.flush();
+
+	BOOST_CHECK(output == "-42\t\"a\tb\"\t\"\\N\"\t\\N\t\\x01ab\t2020-01-02 03:04:05.006000\n");
+}
+
+BOOST_AUTO_TEST_CASE(mock_backend_test)
+{
+	MockResult select_result;
+	select_result.rows = make_mock_rows({ ValueType::Integer, ValueType::Varchar, ValueType::Date, ValueType::Double, ValueType::Blob }, 3);
+	select_result.repeat_count = 2;
+
+	std::vector<ParamValues> sink_params;
+
+	MockConfig config;
+	config.result_fun = [&](std::string_view sql) { return (sql.find("select") == 0) ? &select_result : nullptr; };
+	config.params_sink = [&](std::string_view sql, const ParamValues &params) { sink_params.push_back(params); };
+
+	auto conn = create_mock_connection(config);
+	BOOST_CHECK(conn->get_driver_name() == "mock");
+	BOOST_CHECK_THROW(conn->create_transaction(), WrongSeqException);
+
+	conn->connect();
+	auto tran = conn->create_transaction();
+	auto st = tran->create_statement();
+
+	BOOST_CHECK_THROW(st->execute(), WrongSeqException);
+
+	// parameters
+	st->prepare("insert into tbl values (?1, ?2, @name, @name)");
+	BOOST_CHECK(st->get_params_count() == 3);
+	st->set_int32(1, 10);
+	st->set_wstr(2, L"text");
+	st->set_date("@name", Date(2020, 5, 17));
+	st->execute();
+	BOOST_CHECK(!st->fetch());
+
+	BOOST_REQUIRE(sink_params.size() == 1);
+	BOOST_CHECK(std::get<int32_t>(sink_params[0][0]) == 10);
+	BOOST_CHECK(std::get<std::string>(sink_params[0][1]) == "text");
+	BOOST_CHECK(std::get<Date>(sink_params[0][2]) == Date(2020, 5, 17));
+
+	// rows
+	st->execute("select * from tbl");
+	BOOST_CHECK(st->get_columns_count() == 5);
+	BOOST_CHECK(st->get_column_type("col3") == ValueType::Date);
+
+	size_t rows_count = 0;
+	while (st->fetch())
+	{
+		int row = (int)(rows_count % 3);
+		BOOST_CHECK(st->get_int32(1) == row);
+		BOOST_CHECK(st->get_str_utf8(1) == std::to_string(row));
+		BOOST_CHECK(st->get_int64("col1") == row);
+		BOOST_CHECK(st->get_str_utf8(2) == "value " + std::to_string(row));
+		BOOST_CHECK(st->get_date(3) == julianday_integer_to_date(2451545 + row));
+		BOOST_CHECK(st->get_double(4) == row * 0.25);
+		BOOST_CHECK(st->get_blob_size(5) == 16);
+		BOOST_CHECK_THROW(st->get_date(1), WrongTypeConvException);
+		rows_count++;
+	}
+
+	BOOST_CHECK(rows_count == 6);
+	BOOST_CHECK_THROW(st->get_int32(1), WrongSeqException);
+
+	st->execute("select * from tbl");
+	auto rows = fetch_all_columnar(*st);
+	BOOST_CHECK(rows.get_rows_count() == 6);
+
+	auto &stats = conn->get_stats();
+	BOOST_CHECK(stats.transactions_count == 1);
+	BOOST_CHECK(stats.prepares_count == 3);
+	BOOST_CHECK(stats.executes_count == 3);
+	BOOST_CHECK(stats.fetched_rows_count == 12);
+}
+
+BOOST_AUTO_TEST_CASE(tracer_test)
+{
+	struct RecordingTracer : public Tracer
+	{
+		std::vector<TraceEvent> events;
+		std::vector<std::string> sqls;
+		size_t begins_count = 0;
+
+		void begin(TraceEvent &event) override
+		{
+			begins_count++;
+			event.user_data = this;
+		}
+
+		void end(TraceEvent &event) override
+		{
+			BOOST_CHECK(event.user_data == this);
+			BOOST_CHECK(event.end_time >= event.begin_time);
+			events.push_back(event);
+			sqls.emplace_back(event.sql);
+		}
+	};
+
+	MockResult select_result;
+	select_result.rows = make_mock_rows({ ValueType::Integer, ValueType::Varchar }, 2);
+
+	MockResult update_result;
+	update_result.changes_count = 5;
+
+	MockConfig config;
+	config.result_fun = [&](std::string_view sql) -> const MockResult*
+	{
+		if (sql == "wrong sql") throw WrongArgumentException("wrong sql");
+		return (sql.find("select") == 0) ? &select_result : &update_result;
+	};
+
+	auto conn = create_mock_connection(config);
+	auto tracer = std::make_shared<RecordingTracer>();
+	conn->set_tracer(tracer);
+	BOOST_CHECK(conn->get_tracer() == tracer);
+
+	conn->connect();
+	auto tran = conn->create_transaction();
+	auto st = tran->create_statement();
+
+	st->prepare("update tbl set fld = ?1");
+	st->set_u8str(1, "12345");
+	st->execute();
+
+	st->execute("select * from tbl");
+	while (st->fetch()) {}
+
+	BOOST_CHECK_THROW(st->get_int32(1), WrongSeqException);
+	tran->commit_and_start();
+	tran->rollback();
+
+	BOOST_REQUIRE(tracer->events.size() == 9);
+	BOOST_CHECK(tracer->begins_count == 9);
+
+	auto &ev = tracer->events;
+	BOOST_CHECK(ev[0].operation == TraceOperation::Prepare);
+	BOOST_CHECK(tracer->sqls[0] == "update tbl set fld = ?1");
+	BOOST_CHECK(ev[1].operation == TraceOperation::Execute);
+	BOOST_CHECK(ev[1].rows_count == 5);
+	BOOST_CHECK(ev[1].bytes_count == 5);
+	BOOST_CHECK(ev[2].operation == TraceOperation::Prepare);
+	BOOST_CHECK(ev[3].operation == TraceOperation::Execute);
+	BOOST_CHECK(tracer->sqls[3] == "select * from tbl");
+	BOOST_CHECK(ev[4].operation == TraceOperation::Fetch);
+	BOOST_CHECK(ev[4].rows_count == 1);
+	BOOST_CHECK(ev[4].bytes_count == sizeof(int32_t) + strlen("value 0"));
+	BOOST_CHECK(ev[5].operation == TraceOperation::Fetch);
+	BOOST_CHECK(ev[6].operation == TraceOperation::Fetch);
+	BOOST_CHECK(ev[6].rows_count == 0);
+	BOOST_CHECK(ev[7].operation == TraceOperation::Commit);
+	BOOST_CHECK(ev[8].operation == TraceOperation::Rollback);
+	for (auto &event : ev)
+		BOOST_CHECK(!event.failed);
+
+	// failed operation
+	tracer->events.clear();
+	tran->start();
+	BOOST_CHECK_THROW(st->execute("wrong sql"), WrongArgumentException);
+	BOOST_REQUIRE(tracer->events.size() == 2);
+	BOOST_CHECK(!tracer->events[0].failed);
+	BOOST_CHECK(tracer->events[1].operation == TraceOperation::Execute);
+	BOOST_CHECK(tracer->events[1].failed);
+
+	// spans
+	std::vector<TraceSpan> spans;
+	conn->set_tracer(std::make_shared<SpanTracer>("mock", [&](const TraceSpan &span) { spans.push_back(span); }));
+	st->execute("update tbl set fld = 1");
+	tran->commit();
+	BOOST_REQUIRE(spans.size() == 3);
+	BOOST_CHECK(spans[0].name == "db.prepare");
+	BOOST_CHECK(spans[1].name == "db.execute");
+	BOOST_CHECK(spans[2].name == "db.commit");
+	BOOST_CHECK(spans[1].attributes[0] == std::make_pair(std::string("db.system"), std::string("mock")));
+	BOOST_CHECK(spans[1].attributes[1] == std::make_pair(std::string("db.statement"), std::string("update tbl set fld = 1")));
+	BOOST_CHECK(spans[1].attributes[2] == std::make_pair(std::string("db.rows"), std::string("5")));
+
+	conn->set_tracer(nullptr);
+	spans.clear();
+	st->execute("update tbl set fld = 1");
+	BOOST_CHECK(spans.empty());
+}
+
+BOOST_AUTO_TEST_CASE(metrics_registry_test)
+{
+	BOOST_CHECK(sql_fingerprint("SELECT *  FROM tbl\n WHERE id = 10 and name='it''s' -- comment") == "select * from tbl where id = ? and name=?");
+	BOOST_CHECK(sql_fingerprint("select * from tbl where id in (1, 2,3, 4.5)") == "select * from tbl where id in (?)");
+	BOOST_CHECK(sql_fingerprint("insert into \"Tbl1\" values ($1, ?2, :name, 'text')") == "insert into \"Tbl1\" values ($1, ?2, :name, ?)");
+
+	MockResult select_result;
+	select_result.rows = make_mock_rows({ ValueType::Integer }, 10);
+
+	MockConfig config;
+	config.result_fun = [&](std::string_view sql) -> const MockResult*
+	{
+		if (sql == "wrong sql") throw WrongArgumentException("wrong sql");
+		return &select_result;
+	};
+
+	auto registry = std::make_shared<MetricsRegistry>();
+
+	const size_t ThreadsCount = 4;
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < ThreadsCount; i++)
+	{
+		threads.emplace_back([&, i]
+		{
+			auto conn = create_mock_connection(config);
+			conn->set_tracer(registry);
+			conn->connect();
+			auto tran = conn->create_transaction();
+			auto st = tran->create_statement();
+			for (int j = 0; j < 10; j++)
+			{
+				st->execute("select * from tbl where id = " + std::to_string(i * 100 + j));
+				while (st->fetch()) {}
+			}
+			BOOST_CHECK_THROW(st->execute("wrong sql"), WrongArgumentException);
+			tran->commit();
+		});
+	}
+	for (auto &thread : threads) thread.join();
+
+	auto metrics = registry->snapshot();
+	BOOST_REQUIRE(metrics.size() == 3);
+
+	auto find = [&](std::string_view fingerprint) -> const StatementMetrics*
+	{
+		for (auto &item : metrics)
+			if (item.fingerprint == fingerprint) return &item;
+		return nullptr;
+	};
+
+	auto select = find("select * from tbl where id = ?");
+	BOOST_REQUIRE(select != nullptr);
+	BOOST_CHECK(select->get(TraceOperation::Prepare).count == ThreadsCount * 10);
+	BOOST_CHECK(select->get(TraceOperation::Execute).count == ThreadsCount * 10);
+	BOOST_CHECK(select->get(TraceOperation::Fetch).count == ThreadsCount * 10 * 11);
+	BOOST_CHECK(select->rows_fetched == ThreadsCount * 10 * 10);
+	BOOST_CHECK(select->round_trips == 0);
+	BOOST_CHECK(select->get(TraceOperation::Execute).get_errors_count() == 0);
+
+	auto &fetch = select->get(TraceOperation::Fetch);
+	uint64_t buckets_sum = 0;
+	for (auto value : fetch.buckets) buckets_sum += value;
+	BOOST_CHECK(buckets_sum == fetch.count);
+	BOOST_CHECK(fetch.get_quantile_ns(0.5) <= fetch.get_quantile_ns(0.99));
+	BOOST_CHECK(fetch.get_quantile_ns(1.0) <= fetch.max_ns);
+
+	auto wrong = find("wrong sql");
+	BOOST_REQUIRE(wrong != nullptr);
+	BOOST_CHECK(wrong->get(TraceOperation::Execute).errors[(size_t)ErrorType::Normal] == ThreadsCount);
+
+	auto commit = find("commit");
+	BOOST_REQUIRE(commit != nullptr);
+	BOOST_CHECK(commit->get(TraceOperation::Commit).count == ThreadsCount);
+
+	for (size_t i = 1; i < metrics.size(); i++)
+		BOOST_CHECK(metrics[i-1].get_total_ns() >= metrics[i].get_total_ns());
+
+	auto text = registry->to_prometheus();
+	BOOST_CHECK(text.find("# TYPE dblib_operation_duration_seconds histogram\n") != std::string::npos);
+	BOOST_CHECK(text.find("dblib_operation_duration_seconds_count{fingerprint=\"select * from tbl where id = ?\",operation=\"execute\"} 40\n") != std::string::npos);
+	BOOST_CHECK(text.find("dblib_operation_duration_seconds_bucket{fingerprint=\"select * from tbl where id = ?\",operation=\"fetch\",le=\"+Inf\"} 440\n") != std::string::npos);
+	BOOST_CHECK(text.find("dblib_errors_total{fingerprint=\"wrong sql\",operation=\"execute\",error_type=\"normal\"} 4\n") != std::string::npos);
+	BOOST_CHECK(text.find("dblib_rows_fetched_total{fingerprint=\"select * from tbl where id = ?\"} 400\n") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(slow_query_log_test)
+{
+	MockResult select_result;
+	select_result.rows = make_mock_rows({ ValueType::Integer }, 5);
+
+	MockResult update_result;
+	update_result.changes_count = 2;
+
+	MockConfig config;
+	config.result_fun = [&](std::string_view sql) { return (sql.find("select") == 0) ? &select_result : &update_result; };
+
+	MockResult plan_result;
+	plan_result.rows.add_column("plan", ValueType::Varchar);
+	plan_result.rows.get_column(1).append_str("SCAN tbl");
+
+	MockConfig plan_config;
+	plan_config.result_fun = [&](std::string_view sql) { return (sql.find("EXPLAIN select") == 0) ? &plan_result : nullptr; };
+
+	std::vector<SlowQuery> queries;
+
+	SlowQueryLogParams params;
+	params.threshold = std::chrono::nanoseconds(0);
+	params.plan_connection = create_mock_connection(plan_config);
+	auto log = std::make_shared<SlowQueryLog>([&](const SlowQuery &query) { queries.push_back(query); }, params);
+
+	auto conn = create_mock_connection(config);
+	conn->set_tracer(log);
+	conn->connect();
+	auto tran = conn->create_transaction();
+	auto st = tran->create_statement();
+
+	st->prepare("select * from tbl where id > ?1");
+	st->set_int32(1, 3);
+	st->execute();
+	while (st->fetch()) {}
+
+	st->prepare("update tbl set fld = ?1");
+	st->set_u8str(1, "text");
+	st->execute();
+
+	// not fetched to end. Is finished by next execute
+	st->execute("select * from tbl");
+	st->fetch();
+	st->execute("update tbl set fld = 1");
+
+	log->flush();
+
+	BOOST_REQUIRE(queries.size() == 4);
+	BOOST_CHECK(queries[0].sql == "select * from tbl where id > ?1");
+	BOOST_REQUIRE(queries[0].params.has_value());
+	BOOST_REQUIRE(queries[0].params->size() == 1);
+	BOOST_CHECK(std::get<int32_t>(queries[0].params->at(0)) == 3);
+	BOOST_CHECK(queries[0].rows_count == 5);
+	BOOST_CHECK(queries[0].plan == "SCAN tbl");
+	BOOST_CHECK(!queries[0].failed);
+
+	BOOST_CHECK(queries[1].sql == "update tbl set fld = ?1");
+	BOOST_CHECK(queries[1].rows_count == 2);
+	BOOST_CHECK(std::get<std::string>(queries[1].params->at(0)) == "text");
+	BOOST_CHECK(queries[1].plan.empty());
+
+	BOOST_CHECK(queries[2].sql == "select * from tbl");
+	BOOST_CHECK(queries[2].rows_count == 1);
+	BOOST_CHECK(queries[3].sql == "update tbl set fld = 1");
+
+	// threshold
+	queries.clear();
+	params.threshold = std::chrono::hours(1);
+	conn->set_tracer(std::make_shared<SlowQueryLog>([&](const SlowQuery &query) { queries.push_back(query); }, params));
+	st->execute("select * from tbl");
+	while (st->fetch()) {}
+	conn->set_tracer(nullptr);
+	BOOST_CHECK(queries.empty());
+}
+
+BOOST_AUTO_TEST_CASE(tracer_list_test)
+{
+	// tracer which checks its own user_data
+	struct UserDataTracer : public Tracer
+	{
+		int value = 0;
+		size_t ends_count = 0;
+
+		void begin(TraceEvent &event) override
+		{
+			event.user_data = &value;
+		}
+
+		void end(TraceEvent &event) override
+		{
+			BOOST_CHECK(event.user_data == &value);
+			ends_count++;
+		}
+	};
+
+	MockResult select_result;
+	select_result.rows = make_mock_rows({ ValueType::Integer }, 3);
+
+	MockConfig config;
+	config.result_fun = [&](std::string_view) { return &select_result; };
+
+	auto registry = std::make_shared<MetricsRegistry>();
+
+	std::vector<SlowQuery> queries;
+	SlowQueryLogParams log_params;
+	log_params.threshold = std::chrono::nanoseconds(0);
+	auto log = std::make_shared<SlowQueryLog>([&](const SlowQuery &query) { queries.push_back(query); }, log_params);
+
+	std::vector<TraceSpan> spans;
+	auto span_tracer = std::make_shared<SpanTracer>("mock", [&](const TraceSpan &span) { spans.push_back(span); });
+
+	auto user_data_tracer1 = std::make_shared<UserDataTracer>();
+	auto user_data_tracer2 = std::make_shared<UserDataTracer>();
+
+	auto conn = create_mock_connection(config);
+	conn->set_tracer(std::make_shared<TracerList>(std::vector<TracerPtr>{
+		user_data_tracer1, registry, nullptr, log, span_tracer, user_data_tracer2
+	}));
+	conn->connect();
+	auto tran = conn->create_transaction();
+	auto st = tran->create_statement();
+
+	st->execute("select * from tbl");
+	while (st->fetch()) {}
+	tran->commit();
+
+	log->flush();
+	conn->set_tracer(nullptr);
+
+	// prepare, execute, 4 fetches and commit
+	BOOST_CHECK(user_data_tracer1->ends_count == 7);
+	BOOST_CHECK(user_data_tracer2->ends_count == 7);
+
+	auto metrics = registry->snapshot();
+	BOOST_REQUIRE(metrics.size() == 2);
+	BOOST_CHECK(metrics[0].fingerprint == "select * from tbl" || metrics[1].fingerprint == "select * from tbl");
+
+	BOOST_REQUIRE(queries.size() == 1);
+	BOOST_CHECK(queries[0].sql == "select * from tbl");
+	BOOST_CHECK(queries[0].rows_count == 3);
+
+	BOOST_REQUIRE(spans.size() == 3);
+	BOOST_CHECK(spans[0].name == "db.prepare");
+	BOOST_CHECK(spans[1].name == "db.execute");
+	BOOST_CHECK(spans[2].name == "db.commit");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE(ConnectionTests)
 
@@ -1565,234 +2280,2069 @@ BOOST_AUTO_TEST_CASE(correct_seq_test)
 	});
 }
 
-BOOST_AUTO_TEST_CASE(unicode_test)
+BOOST_AUTO_TEST_CASE(columnar_fetch_test)
 {
 	for_all_connections_do(1, [](const Connections &connections)
 	{
 		auto &connection = *connections[0];
 		connection.connect();
 
-		exec_no_throw(connection, { "drop table unicode_test" });
-		exec(connection, {
-			u8"create table unicode_test (fld varchar(256))",
-			u8"insert into unicode_test(fld) values('Лалала')",
-			u8"insert into unicode_test(fld) values('Гыгыгы')"
-		});
+		exec_no_throw(connection, { "drop table test_columnar" });
+		exec(connection, { "create table test_columnar (int_fld integer, dbl_fld double precision, str_fld varchar(50))" });
 
 		auto tran = connection.create_transaction();
 		auto st = tran->create_statement();
 
-		st->execute(u8"select * from unicode_test where fld like 'Лал%'");
-		BOOST_CHECK(st->fetch());
-		BOOST_CHECK(st->get_str_utf8("fld") == u8"Лалала");
-		BOOST_CHECK(st->get_wstr("fld") == L"Лалала");
-		BOOST_CHECK(!st->fetch());
+		const int RowsCount = 100;
 
-		st->execute(L"select * from unicode_test where fld like 'Гыг%'");
-		BOOST_CHECK(st->fetch());
-		BOOST_CHECK(st->get_str_utf8("fld") == u8"Гыгыгы");
-		BOOST_CHECK(st->get_wstr("fld") == L"Гыгыгы");
-		BOOST_CHECK(!st->fetch());
-	});
-}
+		st->prepare("insert into test_columnar(int_fld, dbl_fld, str_fld) values (?1, ?2, ?3)");
+		for (int i = 0; i < RowsCount; i++)
+		{
+			st->set_int32(1, i);
+			if (i % 5 == 0)
+			{
+				st->set_null(2);
+				st->set_null(3);
+			}
+			else
+			{
+				st->set_double(2, i / 2.0);
+				st->set_u8str(3, "str" + std::to_string(i));
+			}
+			st->execute();
+		}
 
-BOOST_AUTO_TEST_SUITE_END()
+		auto check_rows = [](const ResultSet &result, int first_row)
+		{
+			auto &int_column = result.get_column(1);
+			auto &dbl_column = result.get_column("dbl_fld");
+			auto &str_column = result.get_column("STR_FLD");
 
-///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			for (size_t row = 0; row < result.get_rows_count(); row++)
+			{
+				int i = first_row + (int)row;
+				BOOST_CHECK(int_column.get_int32(row) == i);
+				BOOST_CHECK(dbl_column.is_null(row) == (i % 5 == 0));
+				BOOST_CHECK(str_column.is_null(row) == (i % 5 == 0));
+				if (i % 5 == 0) continue;
+				BOOST_CHECK(dbl_column.get_double(row) == i / 2.0);
+				BOOST_CHECK(str_column.get_str(row) == "str" + std::to_string(i));
+			}
+		};
 
-#if DBLIB_TESTS_FB == 1
+		// fetching by chunks
+		st->execute("select int_fld, dbl_fld, str_fld from test_columnar order by int_fld");
 
-BOOST_AUTO_TEST_SUITE(FirebirdServices)
+		ResultSet result;
+		BOOST_CHECK(st->fetch_columnar(result, 30) == 30);
+		BOOST_CHECK(result.get_columns_count() == 3);
+		BOOST_CHECK(result.get_rows_count() == 30);
+		check_rows(result, 0);
 
-BOOST_AUTO_TEST_CASE(test_fb_services_users)
+		result.clear_rows();
+		BOOST_CHECK(st->fetch_columnar(result) == RowsCount - 30);
+		check_rows(result, 30);
+
+		// fetching all rows
+		st->execute("select int_fld, dbl_fld, str_fld from test_columnar order by int_fld");
+		auto all_rows = fetch_all_columnar(*st);
+		BOOST_CHECK(all_rows.get_rows_count() == RowsCount);
+		check_rows(all_rows, 0);
+
+		// empty result
+		st->execute("select int_fld, dbl_fld, str_fld from test_columnar where int_fld < 0");
+		auto empty = fetch_all_columnar(*st);
+		BOOST_CHECK(empty.get_columns_count() == 3);
+		BOOST_CHECK(empty.get_rows_count() == 0);
+
+		tran->commit();
+	});
+}
+
+BOOST_AUTO_TEST_CASE(query_cache_db_test)
 {
-	FbServicesConnectParams params;
-	params.name = "service_mgr";
-	params.host = "localhost";
-	params.user = "sysdba";
-	params.password = "masterkey";
+	for_all_connections_do(1, [](const Connections &connections)
+	{
+		auto &connection = *connections[0];
+		connection.connect();
 
-	auto services = get_firebird_services();
-	services->attach(params);
+		exec_no_throw(connection, { "drop table test_query_cache" });
+		exec(connection, {
+			"create table test_query_cache (id integer, name varchar(50))",
+			"insert into test_query_cache(id, name) values (1, 'one')",
+			"insert into test_query_cache(id, name) values (2, 'two')"
+		});
 
-	services->add_user("new_user", "password");
-	services->add_user("new_user2", "password", "first name", "middle name", "last name");
+		auto tran = connection.create_transaction();
+		auto st = tran->create_statement();
 
-	std::string new_password = "pass";
-	services->modify_user("new_user", &new_password, nullptr, nullptr, nullptr);
+		QueryCache cache;
 
-	std::string new_middle_name = "mn";
-	services->modify_user("new_user2", nullptr, nullptr, &new_middle_name, nullptr);
+		const char *sql = "select name from test_query_cache where id = ?1";
 
-	services->delete_user("new_user2");
-	services->delete_user("new_user");
-}
+		auto result1 = cache.query(*st, sql, { 1 });
+		BOOST_CHECK(result1->get_rows_count() == 1);
+		BOOST_CHECK(result1->get_column(1).get_str(0) == "one");
 
-BOOST_AUTO_TEST_SUITE_END()
+		auto result2 = cache.query(*st, sql, { 1 });
+		BOOST_CHECK(result1 == result2);
+		BOOST_CHECK(cache.get_stats().hits == 1);
 
-#endif
+		BOOST_CHECK(cache.query(*st, sql, { 2 })->get_column(1).get_str(0) == "two");
 
-///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		cache.execute(*st, "update test_query_cache set name = ?1 where id = ?2", { std::string("ONE"), 1 });
+		BOOST_CHECK(cache.get_items_count() == 0);
 
-#if DBLIB_TESTS_PG == 1
+		auto result3 = cache.query(*st, sql, { 1 });
+		BOOST_CHECK(result3 != result1);
+		BOOST_CHECK(result3->get_column(1).get_str(0) == "ONE");
 
-BOOST_AUTO_TEST_SUITE(PosgreSQLMisc)
+		// not committed data is not cached
+		BOOST_CHECK(cache.get_items_count() == 0);
 
-BOOST_AUTO_TEST_CASE(pg_time)
-{
-	auto check = [&](const Time& time)
-	{
-		auto pg_time_value = dblib_time_to_pg_time(time);
-		auto result_time = pg_time_to_dblib_time(pg_time_value);
-		BOOST_CHECK(time == result_time);
-	};
+		// result put by other transaction before commit is removed by commit
+		cache.put(sql, { 1 }, result1);
+		BOOST_CHECK(cache.get_items_count() == 1);
+		cache.commit(*tran);
+		BOOST_CHECK(cache.get_items_count() == 0);
 
-	check({ 22, 12, 44, 555, 777 });
-	check({ 10, 11, 12,  13,  14 });
-	check({  0,  0,  0,   0,   0 });
-	check({ 23, 59, 59, 999, 999 });
+		tran->start();
+		BOOST_CHECK(cache.query(*st, sql, { 1 })->get_column(1).get_str(0) == "ONE");
+		BOOST_CHECK(cache.get_items_count() == 1);
+		tran->commit();
+	});
 }
 
-BOOST_AUTO_TEST_CASE(pg_date)
+BOOST_AUTO_TEST_CASE(arrow_export_test)
 {
-	auto check = [&](const Date& date)
+	for_all_connections_do(1, [](const Connections &connections)
 	{
-		auto pg_date_value = dblib_date_to_pg_date(date);
-		auto result_date = pg_date_to_dblib_date(pg_date_value);
+		auto &connection = *connections[0];
+		connection.connect();
+
+		exec_no_throw(connection, { "drop table test_arrow" });
+		exec(connection, { "create table test_arrow (int_fld integer, str_fld varchar(50))" });
+
+		auto tran = connection.create_transaction();
+		auto st = tran->create_statement();
+
+		const int RowsCount = 250;
+
+		st->prepare("insert into test_arrow(int_fld, str_fld) values (?1, ?2)");
+		for (int i = 0; i < RowsCount; i++)
+		{
+			st->set_int32(1, i);
+			st->set_u8str(2, std::to_string(i));
+			st->execute();
+		}
+
+		std::vector<char> stream;
+		size_t messages_count = 0;
+
+		ArrowWriterParams params;
+		params.batch_size = 100;
+
+		ArrowStreamWriter writer([&](const char *data, size_t size)
+		{
+			if ((size >= 4) && (memcmp(data, "\xFF\xFF\xFF\xFF", 4) == 0)) messages_count++;
+			stream.insert(stream.end(), data, data + size);
+		}, params);
+
+		st->execute("select int_fld, str_fld from test_arrow");
+		BOOST_CHECK(writer.write(*st) == RowsCount);
+		writer.finish();
+
+		// schema, 3 record batches and end of stream
+		BOOST_CHECK(messages_count == 5);
+		BOOST_CHECK(stream.size() % 8 == 0);
+
+		tran->commit();
+	});
+}
+
+BOOST_AUTO_TEST_CASE(csv_import_export_test)
+{
+	for_all_connections_do(1, [](const Connections &connections)
+	{
+		auto &connection = *connections[0];
+		connection.connect();
+
+		exec_no_throw(connection, { "drop table test_csv" });
+		exec(connection, { "create table test_csv (int_fld integer, dbl_fld double precision, str_fld varchar(50))" });
+
+		auto tran = connection.create_transaction();
+		auto st = tran->create_statement();
+
+		std::string text = "int_fld,dbl_fld,str_fld\n";
+		for (int i = 0; i < 100; i++)
+			text += std::to_string(i) + "," + std::to_string(i) + ".5,\"str, " + std::to_string(i) + "\"\n";
+		text += ",,\n";
+
+		size_t pos = 0;
+		CsvReader reader([&](char *buffer, size_t size)
+		{
+			size_t result = std::min(size, text.size() - pos);
+			memcpy(buffer, text.data() + pos, result);
+			pos += result;
+			return result;
+		});
+
+		st->prepare("insert into test_csv(int_fld, dbl_fld, str_fld) values (?1, ?2, ?3)");
+		size_t imported = import_csv(reader, *st, { ValueType::Integer, ValueType::Double, ValueType::Varchar });
+		BOOST_CHECK(imported == 101);
+
+		std::string output;
+		CsvWriter writer([&](const char *data, size_t size) { output.append(data, size); });
+
+		st->execute("select int_fld, dbl_fld, str_fld from test_csv order by int_fld");
+		BOOST_CHECK(writer.write(*st, 30) == 101);
+
+		// nulls are sorted differently in different DBMS
+		std::string last_line = ",,\n";
+		std::string expected = text;
+		expected.erase(expected.size() - last_line.size());
+		BOOST_CHECK(boost::algorithm::contains(output, expected.substr(expected.find('\n') + 1)));
+		BOOST_CHECK(boost::algorithm::contains(output, "\n" + last_line) || boost::algorithm::contains(output, "str_fld\n" + last_line));
+
+		tran->commit();
+	});
+}
+
+BOOST_AUTO_TEST_CASE(table_copier_test)
+{
+	for_all_connections_do(2, [](const Connections &connections)
+	{
+		auto &src_connection = *connections[0];
+		auto &dst_connection = *connections[1];
+		src_connection.connect();
+		dst_connection.connect();
+
+		// SQLite reader blocks commit of writer in other connection without WAL
+		bool is_sqlite = (src_connection.get_driver_name() == "sqlite");
+		if (is_sqlite) src_connection.direct_execute("pragma journal_mode=wal");
+
+		exec_no_throw(src_connection, { "drop table test_copy_src", "drop table test_copy_dst" });
+		exec(src_connection, {
+			"create table test_copy_src (int_fld integer, dbl_fld double precision, str_fld varchar(50), ts_fld timestamp)",
+			"create table test_copy_dst (int_fld integer, dbl_fld double precision, str_fld varchar(50), ts_fld timestamp)"
+		});
+
+		const int RowsCount = 1000;
+		const TimeStamp ts({ 2021, 5, 6 }, { 7, 8, 9 });
+
+		auto src_tran = src_connection.create_transaction();
+		auto src_st = src_tran->create_statement();
+
+		src_st->prepare("insert into test_copy_src(int_fld, dbl_fld, str_fld, ts_fld) values (?1, ?2, ?3, ?4)");
+		for (int i = 0; i < RowsCount; i++)
+		{
+			src_st->set_int32(1, i);
+			src_st->set_double(2, i + 0.5);
+			if (i % 10 == 0)
+				src_st->set_null(3);
+			else
+				src_st->set_u8str(3, std::to_string(i));
+			src_st->set_timestamp(4, ts);
+			src_st->execute();
+		}
+		src_tran->commit_and_start();
+
+		TableCopierParams params;
+		params.batch_size = 64;
+		params.queue_size = 2;
+		params.commit_rows = 300;
+
+		auto dst_tran = dst_connection.create_transaction();
+
+		src_st->execute("select int_fld, dbl_fld, str_fld, ts_fld from test_copy_src");
+		TableCopier copier(params);
+		auto stats = copier.copy(*src_st, *dst_tran, "test_copy_dst");
+		src_tran->commit();
+
+		BOOST_CHECK(stats.rows_count == RowsCount);
+		BOOST_CHECK(stats.batches_count == (RowsCount + 63) / 64);
+		BOOST_CHECK(stats.commits_count == 4);
+
+		auto check_tran = dst_connection.create_transaction();
+		auto check_st = check_tran->create_statement();
+
+		check_st->execute("select count(*), sum(int_fld), count(str_fld) from test_copy_dst where dbl_fld = int_fld + 0.5");
+		BOOST_CHECK(check_st->fetch());
+		BOOST_CHECK(check_st->get_int64(1) == RowsCount);
+		BOOST_CHECK(check_st->get_int64(2) == RowsCount * (RowsCount - 1) / 2);
+		BOOST_CHECK(check_st->get_int64(3) == RowsCount - RowsCount / 10);
+
+		check_st->execute("select ts_fld from test_copy_dst where int_fld = 42");
+		BOOST_CHECK(check_st->fetch());
+		BOOST_CHECK(check_st->get_timestamp(1) == ts);
+
+		// writer error stops reader
+		src_st->execute("select int_fld, dbl_fld, str_fld, ts_fld from test_copy_src");
+		BOOST_CHECK_THROW(copier.copy(*src_st, *check_tran, "test_copy_wrong_table"), Exception);
+
+		check_st.reset();
+		check_tran.reset();
+		dst_tran.reset();
+		dst_connection.disconnect();
+		src_st.reset();
+		src_tran.reset();
+		if (is_sqlite) src_connection.direct_execute("pragma journal_mode=delete");
+	});
+}
+
+BOOST_AUTO_TEST_CASE(keyset_scanner_test)
+{
+	for_all_connections_do(1, [](const Connections &connections)
+	{
+		auto &connection = *connections[0];
+		connection.connect();
+
+		exec_no_throw(connection, { "drop table test_keyset" });
+		exec(connection, { "create table test_keyset (grp integer not null, id integer not null, str_fld varchar(20), primary key (grp, id))" });
+
+		auto tran = connection.create_transaction();
+		auto st = tran->create_statement();
+
+		const int GroupsCount = 7;
+		const int RowsInGroup = 100;
+
+		st->prepare("insert into test_keyset(grp, id, str_fld) values (?1, ?2, ?3)");
+		for (int grp = 0; grp < GroupsCount; grp++)
+			for (int id = 0; id < RowsInGroup; id++)
+			{
+				st->set_int32(1, grp);
+				st->set_int32(2, id);
+				st->set_u8str(3, std::to_string(grp * RowsInGroup + id));
+				st->execute();
+			}
+
+		for (bool prefetch : { false, true })
+		{
+			KeysetScannerParams params;
+			params.page_size = 64;
+			params.prefetch = prefetch;
+
+			KeysetScanner scanner(*st, "select grp, id, str_fld from test_keyset where grp <> 3", { "grp", "id" }, params);
+
+			int expected = 0;
+			size_t rows_count = 0;
+			while (scanner.fetch())
+			{
+				if (expected / RowsInGroup == 3) expected += RowsInGroup;
+				auto &page = scanner.get_page();
+				BOOST_CHECK(page.get_column("grp").get_int32(scanner.get_row()) == expected / RowsInGroup);
+				BOOST_CHECK(page.get_column("id").get_int32(scanner.get_row()) == expected % RowsInGroup);
+				BOOST_CHECK(page.get_column("str_fld").get_str(scanner.get_row()) == std::to_string(expected));
+				expected++;
+				rows_count++;
+			}
+
+			const size_t ExpectedRowsCount = (GroupsCount - 1) * RowsInGroup;
+			BOOST_CHECK(rows_count == ExpectedRowsCount);
+			BOOST_CHECK(scanner.get_pages_count() == (ExpectedRowsCount + 63) / 64);
+			BOOST_CHECK(!scanner.fetch());
+		}
+
+		tran->commit();
+	});
+}
+
+BOOST_AUTO_TEST_CASE(upsert_test)
+{
+	for_all_connections_do(1, [](const Connections &connections)
+	{
+		auto &connection = *connections[0];
+		connection.connect();
+
+		exec_no_throw(connection, { "drop table test_upsert" });
+		exec(connection, { "create table test_upsert (id integer not null primary key, str_fld varchar(20), dt_fld date)" });
+
+		auto tran = connection.create_transaction();
+
+		auto make_rows = [](int first_id, int count, const std::string &text)
+		{
+			ResultSet rows;
+			rows.add_column("id", ValueType::Integer);
+			rows.add_column("str_fld", ValueType::Varchar);
+			rows.add_column("dt_fld", ValueType::Date);
+			for (int id = first_id; id < first_id + count; id++)
+			{
+				rows.get_column(1).append_int32(id);
+				rows.get_column(2).append_str(text + std::to_string(id));
+				rows.get_column(3).append_date(Date(2020, 1, 1 + id % 28));
+			}
+			return rows;
+		};
+
+		UpsertParams params;
+		params.staging_min_rows = 50;
+
+		Upserter upserter(*tran, "test_upsert", { "id" }, params);
+
+		// small batches (row by row)
+		auto counts = upserter.write(make_rows(0, 20, "a"));
+		BOOST_CHECK(counts.inserted == 20);
+		BOOST_CHECK(counts.updated == 0);
+
+		counts = upserter.write(make_rows(10, 20, "b"));
+		BOOST_CHECK(counts.inserted == 10);
+		BOOST_CHECK(counts.updated == 10);
+
+		// big batch (staging for PostgreSQL)
+		counts = upserter.write(make_rows(25, 100, "c"));
+		BOOST_CHECK(counts.inserted == 95);
+		BOOST_CHECK(counts.updated == 5);
+
+		counts = upserter.write(make_rows(0, 125, "d"));
+		BOOST_CHECK(counts.inserted == 0);
+		BOOST_CHECK(counts.updated == 125);
+
+		auto st = tran->create_statement();
+		st->execute("select count(*) from test_upsert where str_fld like 'd%'");
+		BOOST_CHECK(st->fetch());
+		BOOST_CHECK(st->get_int64(1) == 125);
+
+		st->execute("select str_fld, dt_fld from test_upsert where id = 77");
+		BOOST_CHECK(st->fetch());
+		BOOST_CHECK(st->get_str_utf8(1) == "d77");
+		BOOST_CHECK(st->get_date(2) == Date(2020, 1, 1 + 77 % 28));
+
+		// repeated key in big batch: the last row wins
+		auto rows = make_rows(200, 60, "e");
+		rows.get_column(1).append_int32(200);
+		rows.get_column(2).append_str("last");
+		rows.get_column(3).append_date(Date(2020, 2, 1));
+		counts = upserter.write(rows);
+		BOOST_CHECK(counts.inserted == 60);
+		BOOST_CHECK(counts.updated == 1);
+
+		st->execute("select str_fld from test_upsert where id = 200");
+		BOOST_CHECK(st->fetch());
+		BOOST_CHECK(st->get_str_utf8(1) == "last");
+
+		// staging table left by other upserter is reused and cleared
+		Upserter upserter2(*tran, "test_upsert", { "id" }, params);
+		counts = upserter2.write(make_rows(300, 60, "f"));
+		BOOST_CHECK(counts.inserted == 60);
+		BOOST_CHECK(counts.updated == 0);
+
+		BOOST_CHECK_THROW(Upserter(*tran, "test_upsert", { "wrong_key" }).write(make_rows(0, 1, "e")), WrongArgumentException);
+
+		tran->commit();
+	});
+}
+
+BOOST_AUTO_TEST_CASE(sequence_allocator_test)
+{
+	for_all_connections_do(2, [](const Connections &connections)
+	{
+		auto &connection = *connections[0];
+		connection.connect();
+		connections[1]->connect();
+
+		auto driver_name = connection.get_driver_name();
+		if (driver_name == "postgresql")
+		{
+			exec_no_throw(connection, { "drop sequence test_seq_alloc" });
+			exec(connection, { "create sequence test_seq_alloc" });
+		}
+		else if (driver_name == "firebird")
+		{
+			exec_no_throw(connection, { "drop generator test_seq_alloc" });
+			exec(connection, { "create generator test_seq_alloc" });
+		}
+		else
+			exec_no_throw(connection, { "delete from dblib_sequences where name = 'test_seq_alloc'" });
+
+		SequenceAllocatorParams params;
+		params.block_size = 100;
+
+		SequenceAllocator allocator1(connections[0], "test_seq_alloc", params);
+		SequenceAllocator allocator2(connections[1], "test_seq_alloc", params);
+
+		std::vector<int64_t> values;
+
+		// several threads take values from one allocator
+		const size_t threads_count = 4;
+		const size_t values_per_thread = 1000;
+		std::vector<std::vector<int64_t>> thread_values(threads_count);
+		std::vector<std::thread> threads;
+		for (auto &dst : thread_values)
+			threads.emplace_back([&allocator1, &dst, values_per_thread]
+			{
+				for (size_t i = 0; i < values_per_thread; i++)
+					dst.push_back(allocator1.next());
+			});
+		for (auto &thread : threads)
+			thread.join();
+
+		for (auto &thread_values_item : thread_values)
+		{
+			BOOST_CHECK(std::is_sorted(thread_values_item.begin(), thread_values_item.end()));
+			values.insert(values.end(), thread_values_item.begin(), thread_values_item.end());
+		}
+
+		BOOST_CHECK(allocator1.get_reservations_count() == threads_count * values_per_thread / params.block_size);
+
+		// other connection gets other values
+		for (size_t i = 0; i < 150; i++)
+			values.push_back(allocator2.next());
+		for (size_t i = 0; i < 150; i++)
+			values.push_back(allocator1.next());
+
+		BOOST_CHECK(allocator2.get_reservations_count() == 2);
+
+		std::sort(values.begin(), values.end());
+		BOOST_CHECK(std::adjacent_find(values.begin(), values.end()) == values.end());
+		BOOST_CHECK(values.size() == threads_count * values_per_thread + 300);
+		BOOST_CHECK(values.front() == 1);
+	});
+}
+
+BOOST_AUTO_TEST_CASE(schema_catalog_test)
+{
+	for_all_connections_do(1, [](const Connections &connections)
+	{
+		auto &connection = *connections[0];
+		connection.connect();
+
+		exec_no_throw(connection, { "drop table test_schema" });
+		exec(connection, {
+			"create table test_schema (id integer not null primary key, name varchar(20), dt date, amount double precision, price numeric(10, 2))",
+			"create unique index test_schema_name_idx on test_schema (name, dt)"
+		});
+
+		connection.reset_schema_catalog();
+
+		auto check_catalog = [](const SchemaCatalog &catalog)
+		{
+			auto table = catalog.find_table("TEST_SCHEMA");
+			BOOST_REQUIRE(table != nullptr);
+			BOOST_CHECK(catalog.find_table("test_schema_not_exists") == nullptr);
+
+			BOOST_REQUIRE(table->columns.size() == 5);
+			BOOST_CHECK(boost::iequals(table->columns[0].name, "id"));
+			BOOST_CHECK(table->columns[0].type == ValueType::Integer);
+			BOOST_CHECK(!table->columns[0].nullable);
+			BOOST_CHECK(table->columns[1].type == ValueType::Varchar);
+			BOOST_CHECK(table->columns[1].nullable);
+			BOOST_CHECK(table->columns[2].type == ValueType::Date);
+			BOOST_CHECK(table->columns[3].type == ValueType::Double);
+			BOOST_CHECK(table->find_column("AMOUNT") == &table->columns[3]);
+			BOOST_CHECK(table->columns[4].type == ValueType::Varchar);
+
+			BOOST_REQUIRE(table->primary_key.size() == 1);
+			BOOST_CHECK(boost::iequals(table->primary_key[0], "id"));
+
+			auto index = table->find_index("test_schema_name_idx");
+			BOOST_REQUIRE(index != nullptr);
+			BOOST_CHECK(index->is_unique);
+			BOOST_CHECK(!index->is_primary);
+			BOOST_REQUIRE(index->columns.size() == 2);
+			BOOST_CHECK(boost::iequals(index->columns[0], "name"));
+			BOOST_CHECK(boost::iequals(index->columns[1], "dt"));
+		};
+
+		check_catalog(connection.get_schema_catalog());
+
+#if defined (DBLIB_LINUX)
+		FileName cache_file = "/tmp/dblib_test_schema.txt";
+#elif defined (DBLIB_WINDOWS)
+		FileName cache_file = get_executable_path() + L".schema";
+#endif
+
+		connection.get_schema_catalog().save_to_file(cache_file, "1.0");
+
+		SchemaCatalog loaded;
+		BOOST_CHECK(!loaded.load_from_file(cache_file + FileName(2, '_'), "1.0", connection.get_driver_name()));
+		BOOST_CHECK(!loaded.load_from_file(cache_file, "2.0", connection.get_driver_name()));
+		BOOST_CHECK(!loaded.load_from_file(cache_file, "1.0", "other_driver"));
+		BOOST_CHECK(loaded.load_from_file(cache_file, "1.0", connection.get_driver_name()));
+		check_catalog(loaded);
+		BOOST_CHECK(loaded.get_tables().size() == connection.get_schema_catalog().get_tables().size());
+
+		connection.reset_schema_catalog();
+		check_catalog(connection.get_schema_catalog(cache_file, "1.0"));
+
+#if defined (DBLIB_LINUX)
+		// type of column out of range of ValueType. Catalog is reloaded from database
+		{
+			std::string text;
+			FILE *file = fopen(cache_file.c_str(), "rb");
+			BOOST_REQUIRE(file != nullptr);
+			char buffer[4096];
+			while (size_t size = fread(buffer, 1, sizeof(buffer), file))
+				text.append(buffer, size);
+			fclose(file);
+
+			// C <name> <type name> <type> <nullable>
+			size_t pos = text.find("\nC\t");
+			BOOST_REQUIRE(pos != std::string::npos);
+			for (int i = 0; i < 3; i++)
+				pos = text.find('\t', pos + 1);
+			size_t end = text.find('\t', pos + 1);
+			text.replace(pos + 1, end - pos - 1, "99");
+
+			file = fopen(cache_file.c_str(), "wb");
+			BOOST_REQUIRE(file != nullptr);
+			fwrite(text.data(), 1, text.size(), file);
+			fclose(file);
+
+			BOOST_CHECK(!loaded.load_from_file(cache_file, "1.0", connection.get_driver_name()));
+
+			connection.reset_schema_catalog();
+			check_catalog(connection.get_schema_catalog(cache_file, "1.0"));
+			BOOST_CHECK(loaded.load_from_file(cache_file, "1.0", connection.get_driver_name()));
+		}
+#endif
+
+		// only internal tables of SQLite start with "sqlite_"
+		if (connection.get_driver_name() == "sqlite")
+		{
+			exec_no_throw(connection, { "drop table sqlitex_schema" });
+			exec(connection, { "create table sqlitex_schema (id integer)" });
+			connection.reset_schema_catalog();
+			BOOST_CHECK(connection.get_schema_catalog().find_table("sqlitex_schema") != nullptr);
+			exec(connection, { "drop table sqlitex_schema" });
+		}
+	});
+}
+
+BOOST_AUTO_TEST_CASE(tracer_test)
+{
+	struct CountingTracer : public Tracer
+	{
+		std::map<TraceOperation, size_t> counts;
+		size_t fetched_rows = 0;
+		size_t fetched_bytes = 0;
+		size_t changed_rows = 0;
+		size_t round_trips = 0;
+
+		void begin(TraceEvent &) override {}
+
+		void end(TraceEvent &event) override
+		{
+			counts[event.operation]++;
+			round_trips += event.round_trips;
+			if (event.operation == TraceOperation::Fetch)
+			{
+				fetched_rows += event.rows_count;
+				fetched_bytes += event.bytes_count;
+			}
+			else if (event.operation == TraceOperation::Execute)
+				changed_rows += event.rows_count;
+		}
+	};
+
+	for_all_connections_do(1, [](const Connections &connections)
+	{
+		auto &connection = *connections[0];
+		connection.connect();
+
+		exec_no_throw(connection, { "drop table test_tracer" });
+		exec(connection, { "create table test_tracer (id integer, name varchar(20))" });
+
+		auto tracer = std::make_shared<CountingTracer>();
+		connection.set_tracer(tracer);
+
+		auto tran = connection.create_transaction();
+		auto st = tran->create_statement();
+		st->prepare("insert into test_tracer(id, name) values (:id, :name)");
+		for (int i = 0; i < 3; i++)
+		{
+			st->set_int32(":id", i);
+			st->set_u8str(":name", "name");
+			st->execute();
+		}
+
+		st->prepare("select id, name from test_tracer");
+		st->execute();
+		while (st->fetch()) {}
+		tran->commit();
+
+		connection.set_tracer(nullptr);
+
+		BOOST_CHECK(tracer->counts[TraceOperation::Prepare] == 2);
+		BOOST_CHECK(tracer->counts[TraceOperation::Execute] == 4);
+		BOOST_CHECK(tracer->counts[TraceOperation::Fetch] == 4);
+		BOOST_CHECK(tracer->counts[TraceOperation::Commit] == 1);
+		BOOST_CHECK(tracer->fetched_rows == 3);
+
+		if (connection.get_driver_name() == "sqlite")
+			BOOST_CHECK(tracer->round_trips == 0);
+		else
+			BOOST_CHECK(tracer->round_trips >= 6);
+
+		if (connection.get_driver_name() != "firebird")
+		{
+			BOOST_CHECK(tracer->changed_rows == 3);
+			BOOST_CHECK(tracer->fetched_bytes >= 3 * strlen("name"));
+		}
+
+		exec(connection, { "drop table test_tracer" });
+	});
+}
+
+BOOST_AUTO_TEST_CASE(slow_query_log_test)
+{
+	for_all_connections_do(2, [](const Connections &connections)
+	{
+		auto &connection = *connections[0];
+		connection.connect();
+
+		exec_no_throw(connection, { "drop table test_slow_log" });
+		exec(connection, { "create table test_slow_log (id integer, name varchar(20))" });
+
+		std::vector<SlowQuery> queries;
+
+		SlowQueryLogParams params;
+		params.threshold = std::chrono::nanoseconds(0);
+		params.plan_connection = connections[1];
+		auto log = std::make_shared<SlowQueryLog>([&](const SlowQuery &query) { queries.push_back(query); }, params);
+		connection.set_tracer(log);
+
+		auto tran = connection.create_transaction();
+		auto st = tran->create_statement();
+		st->prepare("select id, name from test_slow_log where id = :id");
+		st->set_int32(":id", 10);
+		st->execute();
+		while (st->fetch()) {}
+		tran->commit();
+
+		connection.set_tracer(nullptr);
+		log->flush();
+
+		BOOST_REQUIRE(queries.size() == 1);
+		BOOST_CHECK(queries[0].rows_count == 0);
+		BOOST_CHECK(!queries[0].plan.empty());
+		BOOST_CHECK(queries[0].plan.find("Plan is not captured") == std::string::npos);
+
+		if (connection.get_driver_name() == "postgresql")
+		{
+			BOOST_REQUIRE(queries[0].params.has_value());
+			BOOST_CHECK(std::get<int32_t>(queries[0].params->at(0)) == 10);
+		}
+
+		exec(connection, { "drop table test_slow_log" });
+	});
+}
+
+BOOST_AUTO_TEST_CASE(connection_stats_test)
+{
+	for_all_connections_do(1, [](const Connections &connections)
+	{
+		auto &connection = *connections[0];
+		connection.connect();
+
+		exec_no_throw(connection, { "drop table test_conn_stats" });
+		exec(connection, { "create table test_conn_stats (id integer, name varchar(20))" });
+
+		auto tran = connection.create_transaction();
+		auto st = tran->create_statement();
+		st->prepare("insert into test_conn_stats(id, name) values (:id, :name)");
+		st->set_int32(":id", 1);
+		st->set_u8str(":name", "name");
+		st->execute();
+
+		connection.reset_connection_stats();
+		auto stats = connection.get_connection_stats();
+		BOOST_CHECK(stats.round_trips == 0);
+		BOOST_CHECK(stats.get_native_calls_total() == 0);
+
+		st->prepare("select id, name from test_conn_stats");
+		st->execute();
+		while (st->fetch()) {}
+		tran->commit();
+
+		stats = connection.get_connection_stats();
+		if (connection.get_driver_name() == "sqlite")
+		{
+			BOOST_CHECK(stats.round_trips == 0);
+			BOOST_CHECK(stats.get_native_calls_total() == 0);
+		}
+		else
+		{
+			BOOST_CHECK(stats.round_trips >= 3);
+			BOOST_CHECK(stats.result_bytes >= strlen("name"));
+			BOOST_CHECK(stats.sent_bytes >= strlen("select id, name from test_conn_stats"));
+			BOOST_CHECK(stats.get_native_calls(NativeCallType::Prepare) > 0);
+			BOOST_CHECK(stats.get_native_calls(NativeCallType::Fetch) > 0);
+			BOOST_CHECK(stats.get_native_calls(NativeCallType::Transaction) > 0);
+			BOOST_CHECK(stats.get_native_calls_total() >= stats.round_trips);
+		}
+
+		connection.reset_connection_stats();
+		stats = connection.get_connection_stats();
+		BOOST_CHECK(stats.round_trips == 0);
+		BOOST_CHECK(stats.sent_bytes == 0);
+		BOOST_CHECK(stats.result_bytes == 0);
+		BOOST_CHECK(stats.get_native_calls_total() == 0);
+
+		exec(connection, { "drop table test_conn_stats" });
+	});
+}
+
+BOOST_AUTO_TEST_CASE(allocations_test)
+{
+	for_all_connections_do(1, [](const Connections &connections)
+	{
+		auto &connection = *connections[0];
+		connection.connect();
+
+		exec_no_throw(connection, { "drop table test_allocations" });
+		exec(connection, { "create table test_allocations (id integer, value double precision, name varchar(20))" });
+
+		const size_t iterations = 100;
+
+		auto tran = connection.create_transaction();
+		auto st = tran->create_statement();
+
+		// steady state loops must not allocate (strings are short enough for SSO)
+		auto check_no_allocations = [&](const char *loop_name, const std::function<void(int32_t)> &fun)
+		{
+			// warming up
+			fun(-1);
+
+			AllocationsCounter counter;
+			for (size_t i = 0; i < iterations; i++)
+				fun((int32_t)i);
+			size_t allocations = counter.get();
+
+			BOOST_TEST_MESSAGE(connection.get_driver_name() << " " << loop_name << " allocations: " << allocations);
+			BOOST_CHECK(allocations == 0);
+		};
+
+		st->prepare("insert into test_allocations(id, value, name) values (:id, :value, :name)");
+		check_no_allocations("insert", [&](int32_t id)
+		{
+			st->set_int32(":id", id);
+			st->set_double(":value", id * 1.5);
+			st->set_u8str(":name", "name");
+			st->execute();
+		});
+
+		st->prepare("select id, value, name from test_allocations where id = :id");
+		check_no_allocations("select", [&](int32_t id)
+		{
+			st->set_int32(":id", id);
+			st->execute();
+			while (st->fetch())
+			{
+				BOOST_CHECK(st->get_int32(1) == id);
+				BOOST_CHECK(st->get_double(2) == id * 1.5);
+				BOOST_CHECK(st->get_str_utf8(3) == "name");
+			}
+		});
+
+		tran->commit();
+
+		exec(connection, { "drop table test_allocations" });
+	});
+}
+
+BOOST_AUTO_TEST_CASE(statements_pool_test)
+{
+	for_all_connections_do(1, [](const Connections &connections)
+	{
+		auto &connection = *connections[0];
+		connection.connect();
+
+		exec_no_throw(connection, { "drop table test_stmt_pool" });
+		exec(connection, { "create table test_stmt_pool (id integer, name varchar(20))" });
+
+		connection.set_statements_pool_size(2);
+
+		{
+			auto tran = connection.create_transaction();
+			auto st = tran->create_statement();
+			st->prepare("insert into test_stmt_pool(id, name) values (:id, :name)");
+			st->set_int32(":id", 1);
+			st->set_u8str(":name", "first");
+			st->execute();
+			st->set_int32(":id", 2);
+			st->set_u8str(":name", "second");
+			st->execute();
+			st.reset();
+			tran->commit();
+		}
+
+		auto stats = connection.get_statements_pool_stats();
+		BOOST_CHECK(stats.max_size == 2);
+		BOOST_CHECK(stats.created == 1);
+		BOOST_CHECK(stats.reused == 0);
+		BOOST_CHECK(stats.size == 1);
+
+		{
+			// statement from pool is not prepared and belongs to new transaction
+			auto tran = connection.create_transaction();
+			auto st = tran->create_statement();
+			BOOST_CHECK(st->get_transaction() == tran);
+			BOOST_CHECK(st->get_last_sql().empty());
+
+			st->prepare("select name from test_stmt_pool where id = :id");
+			st->set_int32(":id", 2);
+			st->execute();
+			BOOST_REQUIRE(st->fetch());
+			BOOST_CHECK(st->get_str_utf8(1) == "second");
+			BOOST_CHECK(!st->fetch());
+
+			// statement is released with not fetched data
+			st->set_int32(":id", 1);
+			st->execute();
+			st.reset();
+
+			// pool is limited by max_size
+			std::vector<StatementPtr> statements;
+			for (int i = 0; i < 3; i++)
+			{
+				statements.push_back(tran->create_statement());
+				statements.back()->execute("select count(*) from test_stmt_pool");
+				BOOST_REQUIRE(statements.back()->fetch());
+				BOOST_CHECK(statements.back()->get_int32(1) == 2);
+			}
+			statements.clear();
+			tran->commit();
+		}
+
+		stats = connection.get_statements_pool_stats();
+		BOOST_CHECK(stats.created == 3);
+		BOOST_CHECK(stats.reused == 2);
+		BOOST_CHECK(stats.size == 2);
+
+		connection.set_statements_pool_size(0);
+		stats = connection.get_statements_pool_stats();
+		BOOST_CHECK(stats.size == 0);
+
+		// statements are not pooled when pool is off
+		connection.create_transaction()->create_statement().reset();
+		BOOST_CHECK(connection.get_statements_pool_stats().created == 3);
+
+		// pooled statement is created and prepared with fewer allocations
+		{
+			auto tran = connection.create_transaction();
+			const char *sql = "select name from test_stmt_pool where id = :id";
+
+			auto create_and_prepare = [&]
+			{
+				AllocationsCounter counter;
+				auto st = tran->create_statement();
+				st->prepare(sql);
+				size_t result = counter.get();
+				st.reset();
+				return result;
+			};
+
+			size_t not_pooled_allocations = create_and_prepare();
+
+			connection.set_statements_pool_size(2);
+			create_and_prepare();
+			size_t pooled_allocations = create_and_prepare();
+
+			BOOST_CHECK(pooled_allocations < not_pooled_allocations);
+
+			tran->commit();
+		}
+
+		exec(connection, { "drop table test_stmt_pool" });
+	});
+}
+
+BOOST_AUTO_TEST_CASE(try_status_test)
+{
+	for_all_connections_do(1, [](const Connections &connections)
+	{
+		auto &connection = *connections[0];
+		connection.connect();
+
+		exec_no_throw(connection, { "drop table test_try_status" });
+		exec(connection, { "create table test_try_status (id integer not null primary key)" });
+
+		{
+			auto tran = connection.create_transaction();
+			auto st = tran->create_statement();
+			st->prepare("insert into test_try_status(id) values (:id)");
+			st->set_int32(":id", 1);
+			BOOST_CHECK(st->try_execute().is_ok());
+			st.reset();
+			BOOST_CHECK(tran->try_commit().is_ok());
+			BOOST_CHECK(tran->get_state() == TransactionState::Commited);
+		}
+
+		{
+			auto tran = connection.create_transaction();
+			auto st = tran->create_statement();
+			st->prepare("select id from test_try_status");
+			BOOST_CHECK(st->try_execute().is_ok());
+			BOOST_CHECK(st->try_fetch().is_ok());
+			BOOST_CHECK(st->get_int32(1) == 1);
+			auto status = st->try_fetch();
+			BOOST_CHECK(status.is_no_data());
+			BOOST_CHECK(!status.is_error());
+			st.reset();
+			tran->commit();
+		}
+
+		{
+			// duplicate of primary key is returned in status
+			auto tran = connection.create_transaction();
+			auto st = tran->create_statement();
+			st->prepare("insert into test_try_status(id) values (:id)");
+			st->set_int32(":id", 1);
+			auto status = st->try_execute();
+			BOOST_CHECK(status.is_error());
+			BOOST_CHECK(!status.is_lock_error());
+			BOOST_CHECK(status.get_message().find("Error during excecution of") == 0);
+			BOOST_CHECK(!status.get_driver_message().empty());
+			BOOST_CHECK_THROW(status.throw_if_error(), ExceptionEx);
+			st.reset();
+			tran->rollback();
+		}
+	});
+}
+
+BOOST_AUTO_TEST_CASE(unicode_test)
+{
+	for_all_connections_do(1, [](const Connections &connections)
+	{
+		auto &connection = *connections[0];
+		connection.connect();
+
+		exec_no_throw(connection, { "drop table unicode_test" });
+		exec(connection, {
+			u8"create table unicode_test (fld varchar(256))",
+			u8"insert into unicode_test(fld) values('Лалала')",
+			u8"insert into unicode_test(fld) values('Гыгыгы')"
+		});
+
+		auto tran = connection.create_transaction();
+		auto st = tran->create_statement();
+
+		st->execute(u8"select * from unicode_test where fld like 'Лал%'");
+		BOOST_CHECK(st->fetch());
+		BOOST_CHECK(st->get_str_utf8("fld") == u8"Лалала");
+		BOOST_CHECK(st->get_wstr("fld") == L"Лалала");
+		BOOST_CHECK(!st->fetch());
+
+		st->execute(L"select * from unicode_test where fld like 'Гыг%'");
+		BOOST_CHECK(st->fetch());
+		BOOST_CHECK(st->get_str_utf8("fld") == u8"Гыгыгы");
+		BOOST_CHECK(st->get_wstr("fld") == L"Гыгыгы");
+		BOOST_CHECK(!st->fetch());
+	});
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if DBLIB_TESTS_FB == 1
+
+BOOST_AUTO_TEST_SUITE(FirebirdServices)
+
+BOOST_AUTO_TEST_CASE(test_fb_services_users)
+{
+	FbServicesConnectParams params;
+	params.name = "service_mgr";
+	params.host = "localhost";
+	params.user = "sysdba";
+	params.password = "masterkey";
+
+	auto services = get_firebird_services();
+	services->attach(params);
+
+	services->add_user("new_user", "password");
+	services->add_user("new_user2", "password", "first name", "middle name", "last name");
+
+	std::string new_password = "pass";
+	services->modify_user("new_user", &new_password, nullptr, nullptr, nullptr);
+
+	std::string new_middle_name = "mn";
+	services->modify_user("new_user2", nullptr, nullptr, &new_middle_name, nullptr);
+
+	services->delete_user("new_user2");
+	services->delete_user("new_user");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if DBLIB_TESTS_PG == 1
+
+BOOST_AUTO_TEST_SUITE(PosgreSQLMisc)
+
+BOOST_AUTO_TEST_CASE(pg_time)
+{
+	auto check = [&](const Time& time)
+	{
+		auto pg_time_value = dblib_time_to_pg_time(time);
+		auto result_time = pg_time_to_dblib_time(pg_time_value);
+		BOOST_CHECK(time == result_time);
+	};
+
+	check({ 22, 12, 44, 555, 777 });
+	check({ 10, 11, 12,  13,  14 });
+	check({  0,  0,  0,   0,   0 });
+	check({ 23, 59, 59, 999, 999 });
+}
+
+BOOST_AUTO_TEST_CASE(pg_date)
+{
+	auto check = [&](const Date& date)
+	{
+		auto pg_date_value = dblib_date_to_pg_date(date);
+		auto result_date = pg_date_to_dblib_date(pg_date_value);
 		BOOST_CHECK(date == result_date);
 	};
 
-	check({   0,   1, 22 });
-	check({ 999,   1, 31 });
-	check({ 1917,  1,  1 });
-	check({ 1954,  1,  1 });
-	check({ 2021, 11, 21 });
-	check({ 2050, 12, 31 });
+	check({   0,   1, 22 });
+	check({ 999,   1, 31 });
+	check({ 1917,  1,  1 });
+	check({ 1954,  1,  1 });
+	check({ 2021, 11, 21 });
+	check({ 2050, 12, 31 });
+}
+
+BOOST_AUTO_TEST_CASE(pg_timestamp)
+{
+	auto check = [&](const Date& date, const Time& time)
+	{
+		TimeStamp ts;
+		ts.date = date;
+		ts.time = time;
+		auto pg_ts_value = dblib_timestamp_to_pg_timestamp(ts);
+		auto result_ts = pg_ts_to_dblib_ts(pg_ts_value);
+		BOOST_CHECK(ts == result_ts);
+	};
+
+	check({    0,  1,  1 }, {  0,  0,  0,   0,   1 });
+	check({  999,  1,  1 }, {  0,  0,  0,   0,   0 });
+	check({ 1917,  1,  1 }, { 13, 12, 44, 555, 777 });
+	check({ 1954,  1,  1 }, { 11,  0,  0,   0,  11 });
+	check({ 2021, 11, 21 }, { 22, 12, 33, 555, 777 });
+	check({ 2055, 12, 31 }, { 22, 12, 33, 555, 777 });
+}
+
+BOOST_AUTO_TEST_CASE(pg_copy)
+{
+	auto conn = get_postgresql_connection();
+	conn->connect();
+
+	exec_no_throw(*conn, { "drop table pg_copy_test" });
+	exec(*conn, {
+		"create table pg_copy_test ("
+		"int_fld integer, "
+		"float_fld real, "
+		"double_fld double precision, "
+		"ts_fld timestamp, "
+		"tm_fld time, "
+		"dt_fld date, "
+		"str_fld varchar(200)"
+		")"
+	});
+
+	auto tran = conn->create_transaction();
+	auto st = tran->create_statement();
+
+	st->execute(
+		"COPY pg_copy_test (int_fld, float_fld, str_fld, double_fld, ts_fld, tm_fld, dt_fld) "
+		"FROM STDIN (format binary)"
+	);
+
+	TimeStamp ts({ 1924, 12, 2 }, { 10, 22, 33, 555 });
+	Time time(10, 34, 33, 555);
+	Date date(1924, 12, 11);
+
+	PgBuffer buffer;
+
+	buffer.begin_tuple();
+	buffer.write_int32_opt(10);
+	buffer.write_float_opt(11.0f);
+	buffer.write_u8str_opt("12");
+	buffer.write_double_opt(42.0);
+	buffer.write_timestamp_opt(ts);
+	buffer.write_time_opt(time);
+	buffer.write_date_opt(date);
+	buffer.end_tuple();
+
+	buffer.begin_tuple();
+	buffer.write_int32_opt(100);
+	buffer.write_float_opt(111.0f);
+	buffer.write_u8str_opt("123");
+	buffer.write_double_opt(142.0);
+	buffer.write_timestamp_opt(ts);
+	buffer.write_time_opt(time);
+	buffer.write_date_opt(date);
+	buffer.end_tuple();
+
+	buffer.begin_tuple();
+	buffer.write_int32_opt({});
+	buffer.write_float_opt({});
+	buffer.write_u8str_opt({});
+	buffer.write_double_opt({});
+	buffer.write_timestamp_opt({});
+	buffer.write_time_opt({});
+	buffer.write_date_opt({});
+	buffer.end_tuple();
+
+	auto pg_st = std::dynamic_pointer_cast<PgStatement>(st);
+
+	pg_st->put_buffer(buffer);
+
+	st->execute(
+		"select int_fld, float_fld, str_fld, double_fld, ts_fld, tm_fld, dt_fld "
+		"from pg_copy_test"
+	);
+
+	BOOST_CHECK(st->fetch());
+	BOOST_CHECK(st->get_int32(1) == 10);
+	BOOST_CHECK(st->get_float(2) == 11.0f);
+	BOOST_CHECK(st->get_str_utf8(3) == "12");
+	BOOST_CHECK(st->get_double(4) == 42.0);
+	BOOST_CHECK(st->get_timestamp(5) == ts);
+	BOOST_CHECK(st->get_time(6) == time);
+	BOOST_CHECK(st->get_date(7) == date);
+
+	BOOST_CHECK(st->fetch());
+	BOOST_CHECK(st->get_int32(1) == 100);
+	BOOST_CHECK(st->get_float(2) == 111.0f);
+	BOOST_CHECK(st->get_str_utf8(3) == "123");
+	BOOST_CHECK(st->get_double(4) == 142.0);
+	BOOST_CHECK(st->get_timestamp(5) == ts);
+	BOOST_CHECK(st->get_time(6) == time);
+	BOOST_CHECK(st->get_date(7) == date);
+
+	BOOST_CHECK(st->fetch());
+	BOOST_CHECK(st->is_null(1));
+	BOOST_CHECK(st->is_null(2));
+	BOOST_CHECK(st->is_null(3));
+	BOOST_CHECK(st->is_null(4));
+	BOOST_CHECK(st->is_null(5));
+	BOOST_CHECK(st->is_null(6));
+	BOOST_CHECK(st->is_null(7));
+
+	BOOST_CHECK(!st->fetch());
+
+	tran->commit();
+};
+
+BOOST_AUTO_TEST_CASE(pg_csv_copy)
+{
+	auto conn = get_postgresql_connection();
+	conn->connect();
+
+	exec_no_throw(*conn, { "drop table pg_csv_copy_test" });
+	exec(*conn, { "create table pg_csv_copy_test (sh_fld smallint, bool_fld boolean, str_fld text, blob_fld bytea, ts_fld timestamp)" });
+
+	auto tran = conn->create_transaction();
+	auto st = tran->create_statement();
+	auto pg_st = std::dynamic_pointer_cast<PgStatement>(st);
+
+	std::string text = "100,false,\"\",\"\",\n"; // empty but not null string and blob
+	for (int i = 0; i < 10; i++)
+		text += std::to_string(i) + ",true,text " + std::to_string(i) + ",\\x0102,2020-01-02 03:04:05\n";
+	text += ",,,,\n";
+
+	CsvFormat format;
+	format.header = false;
+
+	size_t pos = 0;
+	CsvReader reader([&](char *buffer, size_t size)
+	{
+		size_t result = std::min(size, text.size() - pos);
+		memcpy(buffer, text.data() + pos, result);
+		pos += result;
+		return result;
+	}, format);
+
+	size_t imported = import_csv(
+		reader, *pg_st,
+		"COPY pg_csv_copy_test (sh_fld, bool_fld, str_fld, blob_fld, ts_fld) FROM STDIN (format binary)",
+		{ ValueType::Short, ValueType::Boolean, ValueType::Varchar, ValueType::Blob, ValueType::Timestamp },
+		4
+	);
+	BOOST_CHECK(imported == 12);
+
+	st->execute("select count(*) from pg_csv_copy_test where bool_fld and blob_fld = '\\x0102'::bytea and ts_fld = '2020-01-02 03:04:05'");
+	BOOST_CHECK(st->fetch());
+	BOOST_CHECK(st->get_int64(1) == 10);
+
+	st->execute("select sh_fld, str_fld from pg_csv_copy_test where sh_fld = 7");
+	BOOST_CHECK(st->fetch());
+	BOOST_CHECK(st->get_str_utf8(2) == "text 7");
+
+	st->execute("select count(*) from pg_csv_copy_test where sh_fld is null and str_fld is null and blob_fld is null");
+	BOOST_CHECK(st->fetch());
+	BOOST_CHECK(st->get_int64(1) == 1);
+
+	st->execute("select count(*) from pg_csv_copy_test where sh_fld = 100 and str_fld = '' and blob_fld = ''::bytea");
+	BOOST_CHECK(st->fetch());
+	BOOST_CHECK(st->get_int64(1) == 1);
+
+	tran->commit();
+}
+
+BOOST_AUTO_TEST_CASE(pg_cursor)
+{
+	auto conn = get_postgresql_connection();
+	conn->connect();
+
+	exec_no_throw(*conn, { "drop table pg_cursor_test" });
+	exec(*conn, { "create table pg_cursor_test (int_fld integer, str_fld varchar(50), ts_fld timestamp)" });
+
+	auto tran = conn->create_transaction();
+	auto st = tran->create_statement();
+	auto pg_st = std::dynamic_pointer_cast<PgStatement>(st);
+
+	const int RowsCount = 1000;
+	const TimeStamp ts({ 2021, 5, 6 }, { 7, 8, 9 });
+
+	st->prepare("insert into pg_cursor_test (int_fld, str_fld, ts_fld) values (?1, ?2, ?3)");
+	for (int i = 0; i < RowsCount; i++)
+	{
+		st->set_int32(1, i);
+		if (i % 3 == 0) st->set_null(2); else st->set_u8str(2, std::to_string(i));
+		st->set_timestamp(3, ts);
+		st->execute();
+	}
+	tran->commit_and_start();
+
+	PgCursorParams cursor_params;
+	cursor_params.fetch_size = 100;
+	pg_st->set_cursor_mode(cursor_params);
+	BOOST_CHECK(pg_st->is_cursor_mode());
+
+	// direct execute. Row count is multiple of fetch size
+	st->execute("select int_fld, str_fld, ts_fld from pg_cursor_test order by int_fld");
+	BOOST_CHECK(st->get_columns_count() == 3);
+	int rows_count = 0;
+	while (st->fetch())
+	{
+		BOOST_CHECK(st->get_int32("int_fld") == rows_count);
+		BOOST_CHECK(st->is_null(2) == (rows_count % 3 == 0));
+		if (!st->is_null(2)) BOOST_CHECK(st->get_str_utf8(2) == std::to_string(rows_count));
+		BOOST_CHECK(st->get_timestamp(3) == ts);
+		rows_count++;
+	}
+	BOOST_CHECK(rows_count == RowsCount);
+
+	// prepared statement with parameter and columnar fetch
+	st->prepare("select int_fld, str_fld from pg_cursor_test where int_fld >= ?1 order by int_fld");
+	st->set_int32(1, 50);
+	st->execute();
+	ResultSet result;
+	BOOST_CHECK(st->fetch_columnar(result, 120) == 120);
+	BOOST_CHECK(st->fetch_columnar(result, 0) == RowsCount - 50 - 120);
+	BOOST_CHECK(result.get_column(1).get_int32(0) == 50);
+	BOOST_CHECK(result.get_column(1).get_int32(RowsCount - 50 - 1) == RowsCount - 1);
+
+	// re-execution closes previous cursor
+	st->set_int32(1, 990);
+	st->execute();
+	BOOST_CHECK(st->fetch());
+	st->execute();
+	rows_count = 0;
+	while (st->fetch()) rows_count++;
+	BOOST_CHECK(rows_count == 10);
+
+	// cursor with hold is alive after commit
+	cursor_params.with_hold = true;
+	pg_st->set_cursor_mode(cursor_params);
+	st->execute("select int_fld from pg_cursor_test order by int_fld");
+	rows_count = 0;
+	for (; (rows_count < 150) && st->fetch(); rows_count++) {}
+	tran->commit_and_start();
+	while (st->fetch()) rows_count++;
+	BOOST_CHECK(rows_count == RowsCount);
+
+	// not finished cursor is closed by next execute
+	st->execute("select int_fld from pg_cursor_test");
+	BOOST_CHECK(st->fetch());
+	pg_st->reset_cursor_mode();
+	st->execute("select count(*) from pg_cursors where name like 'dblib_cursor%'");
+	BOOST_CHECK(st->fetch());
+	BOOST_CHECK(st->get_int64(1) == 0);
+
+	tran->commit();
+}
+
+BOOST_AUTO_TEST_CASE(pg_statements_pool_cursor)
+{
+	auto conn = get_postgresql_connection();
+	conn->connect();
+	conn->set_statements_pool_size(1);
+
+	auto tran = conn->create_pg_transaction({});
+
+	// statement with open cursor with hold is released into pool
+	PgCursorParams cursor_params;
+	cursor_params.fetch_size = 10;
+	cursor_params.with_hold = true;
+	auto st = tran->create_pg_statement();
+	st->set_cursor_mode(cursor_params);
+	st->execute("select generate_series(1, 100)");
+	BOOST_CHECK(st->fetch());
+	st.reset();
+
+	st = tran->create_pg_statement();
+	BOOST_CHECK(conn->get_statements_pool_stats().reused == 1);
+	BOOST_CHECK(!st->is_cursor_mode());
+	st->execute("select count(*) from pg_cursors where name like 'dblib_cursor%'");
+	BOOST_CHECK(st->fetch());
+	BOOST_CHECK(st->get_int64(1) == 0);
+
+	tran->commit();
+
+	// cursor is closed when first statement of transaction is sent together with BEGIN
+	tran->start();
+	auto cursor_st = tran->create_pg_statement();
+	cursor_st->set_cursor_mode(cursor_params);
+	cursor_st->execute("select generate_series(1, 100)");
+	BOOST_CHECK(cursor_st->fetch());
+	tran->commit();
+
+	tran->start();
+	st = tran->create_pg_statement();
+	st->execute("select 1");
+	while (st->fetch()) {}
+	cursor_st.reset();
+
+	st->execute("select count(*) from pg_cursors where name like 'dblib_cursor%'");
+	BOOST_CHECK(st->fetch());
+	BOOST_CHECK(st->get_int64(1) == 0);
+
+	tran->commit();
+}
+
+BOOST_AUTO_TEST_CASE(pg_try_lock_status)
+{
+	auto conn1 = get_postgresql_connection();
+	auto conn2 = get_postgresql_connection();
+	conn1->connect();
+	conn2->connect();
+
+	exec_no_throw(*conn1, { "drop table pg_try_lock_test" });
+	exec(*conn1, { "create table pg_try_lock_test (id integer)", "insert into pg_try_lock_test values (1)" });
+
+	auto tran1 = conn1->create_transaction();
+	auto st1 = tran1->create_statement();
+	st1->execute("select id from pg_try_lock_test for update");
+
+	auto tran2 = conn2->create_transaction();
+	auto st2 = tran2->create_statement();
+	st2->prepare("select id from pg_try_lock_test for update nowait");
+	auto status = st2->try_execute();
+	BOOST_CHECK(status.is_lock_error());
+	BOOST_CHECK(status.get_sql_state() == "55P03");
+	BOOST_CHECK_THROW(status.throw_if_error(), LockException);
+	st2.reset();
+	tran2->rollback();
+
+	st1.reset();
+	BOOST_CHECK(tran1->try_commit().is_ok());
+}
+
+BOOST_AUTO_TEST_CASE(pg_numeric_and_uuid_conversions)
+{
+	auto check_numeric = [](std::string_view text, std::string_view expected)
+	{
+		std::vector<char> data;
+		BOOST_REQUIRE(str_to_pg_numeric(text, data));
+		BOOST_CHECK(pg_numeric_to_str(data.data(), data.size()) == expected);
+	};
+
+	check_numeric("0", "0");
+	check_numeric("123", "123");
+	check_numeric("-123", "-123");
+	check_numeric("10000", "10000");
+	check_numeric("12345678.9", "12345678.9");
+	check_numeric("0.0001", "0.0001");
+	check_numeric("-0.00012300", "-0.00012300");
+	check_numeric("000100.5", "100.5");
+	check_numeric("+1.", "1");
+	check_numeric(".5", "0.5");
+	check_numeric("NaN", "NaN");
+
+	std::vector<char> data;
+	BOOST_CHECK(!str_to_pg_numeric("", data));
+	BOOST_CHECK(!str_to_pg_numeric("1e10", data));
+	BOOST_CHECK(!str_to_pg_numeric("1.2.3", data));
+
+	PgUuid uuid;
+	BOOST_REQUIRE(str_to_pg_uuid("A0EEBC99-9C0B-4EF8-BB6D-6BB9BD380A11", uuid));
+	BOOST_CHECK(uuid[0] == 0xA0);
+	BOOST_CHECK(uuid[15] == 0x11);
+	BOOST_CHECK(pg_uuid_to_str(uuid) == "a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11");
+	BOOST_REQUIRE(str_to_pg_uuid("a0eebc999c0b4ef8bb6d6bb9bd380a11", uuid));
+	BOOST_CHECK(pg_uuid_to_str(uuid) == "a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11");
+	BOOST_CHECK(!str_to_pg_uuid("a0eebc99", uuid));
+	BOOST_CHECK(!str_to_pg_uuid("x0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11", uuid));
+}
+
+BOOST_AUTO_TEST_CASE(pg_prepare_with_types)
+{
+	auto conn = get_postgresql_connection();
+	conn->connect();
+
+	exec_no_throw(*conn, { "drop table pg_prepare_with_types_test" });
+	exec(*conn, { "create table pg_prepare_with_types_test (id integer, name varchar(100))" });
+
+	auto tran = conn->create_pg_transaction({});
+	auto st = tran->create_pg_statement();
+
+	const Oid Int4Oid = 23;
+	const Oid VarcharOid = 1043;
+
+	st->prepare_with_types("insert into pg_prepare_with_types_test values (:id, :name)", { Int4Oid, VarcharOid });
+	BOOST_CHECK(st->get_params_count() == 2);
+	for (int i = 1; i <= 10; i++)
+	{
+		st->set_int32(":id", i);
+		st->set_u8str(":name", "name" + std::to_string(i));
+		st->execute();
+	}
+
+	// columns are known after execute only
+	st->prepare_with_types("select id, name from pg_prepare_with_types_test where id > ?1 order by id", { Int4Oid });
+	BOOST_CHECK_THROW(st->get_columns_count(), WrongSeqException);
+	BOOST_CHECK_THROW(st->get_column_name(1), WrongSeqException);
+	BOOST_CHECK_THROW(st->get_column_type(1), WrongSeqException);
+	st->set_int32(1, 8);
+	st->execute();
+	BOOST_CHECK(st->get_columns_count() == 2);
+	BOOST_CHECK(st->get_column_name(2) == "name");
+	BOOST_CHECK_THROW(st->get_column_name(3), WrongArgumentException);
+	BOOST_REQUIRE(st->fetch());
+	BOOST_CHECK(st->get_int32(1) == 9);
+	BOOST_CHECK(st->get_str_utf8(2) == "name9");
+	BOOST_REQUIRE(st->fetch());
+	BOOST_CHECK(st->get_int32(1) == 10);
+	BOOST_CHECK(!st->fetch());
+
+	// pipelined prepare and describe
+	st->prepare("select name from pg_prepare_with_types_test where id = :id");
+	BOOST_CHECK(st->get_params_count() == 1);
+	BOOST_CHECK(st->get_columns_count() == 1);
+	BOOST_CHECK(st->get_column_name(1) == "name");
+	st->set_int32(":id", 5);
+	st->execute();
+	BOOST_REQUIRE(st->fetch());
+	BOOST_CHECK(st->get_str_utf8(1) == "name5");
+	tran->commit();
+
+	// error of prepare doesn't break connection
+	tran->start();
+	BOOST_CHECK_THROW(st->prepare("select wrong syntax from"), Exception);
+	tran->rollback();
+
+	tran->start();
+	st->prepare("select count(*) from pg_prepare_with_types_test");
+	st->execute();
+	BOOST_REQUIRE(st->fetch());
+	BOOST_CHECK(st->get_int64(1) == 10);
+	tran->commit();
 }
 
-BOOST_AUTO_TEST_CASE(pg_timestamp)
+BOOST_AUTO_TEST_CASE(pg_prepare_with_value_types)
 {
-	auto check = [&](const Date& date, const Time& time)
+	auto conn = get_postgresql_connection();
+	conn->connect();
+
+	exec_no_throw(*conn, { "drop table pg_prepare_with_value_types_test" });
+	exec(*conn, { "create table pg_prepare_with_value_types_test (id bigint, value double precision, name varchar(100))" });
+
+	auto tran = conn->create_pg_transaction({});
+	const char *insert_sql = "insert into pg_prepare_with_value_types_test values (:id, :value, :name)";
+	const std::vector<ValueType> insert_types = { ValueType::BigInt, ValueType::Double, ValueType::Varchar };
+
 	{
-		TimeStamp ts;
-		ts.date = date;
-		ts.time = time;
-		auto pg_ts_value = dblib_timestamp_to_pg_timestamp(ts);
-		auto result_ts = pg_ts_to_dblib_ts(pg_ts_value);
-		BOOST_CHECK(ts == result_ts);
-	};
+		auto st = tran->create_pg_statement();
+		st->prepare_with_value_types(insert_sql, insert_types);
+		st->set_int64(":id", 1);
+		st->set_double(":value", 1.5);
+		st->set_u8str(":name", "one");
+		st->execute();
 
-	check({    0,  1,  1 }, {  0,  0,  0,   0,   1 });
-	check({  999,  1,  1 }, {  0,  0,  0,   0,   0 });
-	check({ 1917,  1,  1 }, { 13, 12, 44, 555, 777 });
-	check({ 1954,  1,  1 }, { 11,  0,  0,   0,  11 });
-	check({ 2021, 11, 21 }, { 22, 12, 33, 555, 777 });
-	check({ 2055, 12, 31 }, { 22, 12, 33, 555, 777 });
+		// values of other types are converted
+		st->set_int32(":id", 2);
+		st->set_float(":value", 2.5f);
+		st->set_wstr(":name", L"two");
+		st->execute();
+	}
+
+	// statement with the same SQL and types is prepared once for connection
+	conn->reset_connection_stats();
+	{
+		auto st = tran->create_pg_statement();
+		st->prepare_with_value_types(insert_sql, insert_types);
+		BOOST_CHECK(conn->get_connection_stats().round_trips == 0);
+		st->set_int64(":id", 3);
+		st->set_double(":value", 3.5);
+		st->set_u8str(":name", "three");
+		st->execute();
+	}
+
+	// type of parameter declared as Any is inferred by server
+	auto st = tran->create_pg_statement();
+	st->prepare_with_value_types(
+		"select count(*), sum(value) from pg_prepare_with_value_types_test where id >= ?1 and name <> ?2",
+		{ ValueType::BigInt, ValueType::Any }
+	);
+	BOOST_CHECK(st->get_columns_count() == 2);
+	st->set_int64(1, 2);
+	st->set_u8str(2, "three");
+	st->execute();
+	BOOST_REQUIRE(st->fetch());
+	BOOST_CHECK(st->get_int64(1) == 1);
+	BOOST_CHECK(st->get_double(2) == 2.5);
+	tran->commit();
+
+	tran->start();
+	BOOST_CHECK_THROW(st->prepare_with_value_types("select ?1", { ValueType::Null }), WrongArgumentException);
+	BOOST_CHECK_THROW(st->prepare_with_value_types("select wrong syntax from ?1", { ValueType::Integer }), Exception);
+	tran->rollback();
+
+	// cached statement is prepared again after DISCARD ALL
+	conn->direct_execute("DISCARD ALL");
+	tran->start();
+	st->prepare_with_value_types(insert_sql, insert_types);
+	st->set_int64(":id", 4);
+	st->set_double(":value", 4.5);
+	st->set_u8str(":name", "four");
+	st->execute();
+	st->execute("select count(*) from pg_prepare_with_value_types_test");
+	BOOST_REQUIRE(st->fetch());
+	BOOST_CHECK(st->get_int64(1) == 4);
+	tran->commit();
+
+	// number of cached statements is limited
+	tran->start();
+	for (int i = 0; i < 300; i++)
+	{
+		st->prepare_with_value_types("select ?1 + " + std::to_string(i), { ValueType::Integer });
+		st->set_int32(1, 1);
+		st->execute();
+		BOOST_REQUIRE(st->fetch());
+		BOOST_CHECK(st->get_int32(1) == i + 1);
+	}
+	st->execute("select count(*) from pg_prepared_statements");
+	BOOST_REQUIRE(st->fetch());
+	BOOST_CHECK(st->get_int64(1) <= 256);
+	tran->commit();
 }
 
-BOOST_AUTO_TEST_CASE(pg_copy)
+BOOST_AUTO_TEST_CASE(pg_lazy_begin)
 {
 	auto conn = get_postgresql_connection();
 	conn->connect();
 
-	exec_no_throw(*conn, { "drop table pg_copy_test" });
+	exec_no_throw(*conn, { "drop table pg_lazy_begin_test" });
+	exec(*conn, { "create table pg_lazy_begin_test (id integer)" });
+
+	bool pipeline = pg_lib->get_api().supports_pipeline_mode();
+
+	// transaction without statements doesn't access server
+	conn->reset_connection_stats();
+	{
+		TransactionParams params;
+		params.lock_time_out = 1;
+		auto tran = conn->create_pg_transaction(params);
+		tran->commit();
+		tran->start();
+		tran->rollback();
+	}
+	BOOST_CHECK(conn->get_connection_stats().round_trips == 0);
+
+	// BEGIN and SET LOCAL are sent together with first statement
+	conn->reset_connection_stats();
+	{
+		TransactionParams params;
+		params.lock_time_out = 1;
+		auto tran = conn->create_pg_transaction(params);
+		auto st = tran->create_pg_statement();
+		st->execute("insert into pg_lazy_begin_test values (1)");
+		st->execute("select current_setting('lock_timeout')");
+		BOOST_REQUIRE(st->fetch());
+		BOOST_CHECK(st->get_str_utf8(1) == "1s");
+		tran->commit();
+	}
+	if (pipeline) BOOST_CHECK(conn->get_connection_stats().round_trips == 3);
+
+	// prepared statement, cursor and rollback
+	{
+		auto tran = conn->create_pg_transaction({});
+		auto st = tran->create_pg_statement();
+		st->prepare("insert into pg_lazy_begin_test values (:id)");
+		st->set_int32(":id", 2);
+		st->execute();
+		tran->rollback();
+
+		tran->start();
+		st->set_cursor_mode({});
+		st->execute("select count(*) from pg_lazy_begin_test");
+		BOOST_CHECK(st->get_last_sql().find("BEGIN") == std::string::npos);
+		BOOST_REQUIRE(st->fetch());
+		BOOST_CHECK(st->get_int64(1) == 1);
+		tran->commit();
+	}
+
+	// BEGIN doesn't depend on prepared statements of connection
+	for (int i = 0; i < 2; i++)
+	{
+		conn->direct_execute("DISCARD ALL");
+		auto tran = conn->create_pg_transaction({});
+		auto st = tran->create_pg_statement();
+		st->execute("select count(*) from pg_lazy_begin_test");
+		BOOST_REQUIRE(st->fetch());
+		BOOST_CHECK(st->get_int64(1) == 1);
+		tran->commit();
+	}
+
+	// error of first statement aborts transaction
+	{
+		auto tran = conn->create_pg_transaction({});
+		auto st = tran->create_pg_statement();
+		BOOST_CHECK_THROW(st->execute("select * from pg_lazy_begin_wrong_table"), Exception);
+		BOOST_CHECK_THROW(st->execute("select 1"), Exception);
+		tran->rollback();
+
+		tran->start();
+		st->execute("select count(*) from pg_lazy_begin_test");
+		BOOST_REQUIRE(st->fetch());
+		BOOST_CHECK(st->get_int64(1) == 1);
+		tran->commit();
+	}
+}
+
+BOOST_AUTO_TEST_CASE(pg_slow_query_log_cursor)
+{
+	auto conn = get_postgresql_connection();
+	conn->connect();
+
+	exec_no_throw(*conn, { "drop table pg_slow_log_test" });
+	exec(*conn, { "create table pg_slow_log_test (id integer)" });
+
+	std::vector<SlowQuery> queries;
+
+	SlowQueryLogParams params;
+	params.threshold = std::chrono::nanoseconds(0);
+	params.plan_connection = get_postgresql_connection();
+	auto log = std::make_shared<SlowQueryLog>([&](const SlowQuery &query) { queries.push_back(query); }, params);
+	conn->set_tracer(log);
+
+	// statements are wrapped into DECLARE CURSOR and follow deferred BEGIN
+	auto tran = conn->create_pg_transaction({});
+	auto st = tran->create_pg_statement();
+	st->set_cursor_mode({});
+	st->prepare("select id from pg_slow_log_test where id = :id");
+	st->set_int32(":id", 1);
+	st->execute();
+	while (st->fetch()) {}
+	st->execute("select id::text from pg_slow_log_test");
+	while (st->fetch()) {}
+	tran->commit();
+
+	conn->set_tracer(nullptr);
+	log->flush();
+
+	BOOST_REQUIRE(queries.size() == 2);
+	BOOST_CHECK(queries[0].sql == "select id from pg_slow_log_test where id = :id");
+	BOOST_CHECK(!queries[0].native_parameters_syntax);
+	BOOST_CHECK(queries[1].sql == "select id::text from pg_slow_log_test");
+	BOOST_CHECK(queries[1].native_parameters_syntax);
+	for (auto &query : queries)
+	{
+		BOOST_CHECK(!query.plan.empty());
+		BOOST_CHECK(query.plan.find("Plan is not captured") == std::string::npos);
+	}
+
+	exec(*conn, { "drop table pg_slow_log_test" });
+}
+
+BOOST_AUTO_TEST_CASE(pg_binary_types)
+{
+	auto conn = get_postgresql_connection();
+	conn->connect();
+
+	exec_no_throw(*conn, { "drop table pg_binary_types_test" });
 	exec(*conn, {
-		"create table pg_copy_test ("
-		"int_fld integer, "
-		"float_fld real, "
-		"double_fld double precision, "
-		"ts_fld timestamp, "
-		"tm_fld time, "
-		"dt_fld date, "
-		"str_fld varchar(200)"
-		")"
+		"create table pg_binary_types_test ("
+		"id integer, bool_fld boolean, uuid_fld uuid, json_fld json, jsonb_fld jsonb, "
+		"num_fld numeric(20, 4), tstz_fld timestamptz, bytea_fld bytea)"
 	});
 
-	auto tran = conn->create_transaction();
-	auto st = tran->create_statement();
+	auto tran = conn->create_pg_transaction({});
+	auto st = tran->create_pg_statement();
+
+	PgUuid uuid;
+	BOOST_REQUIRE(str_to_pg_uuid("a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11", uuid));
+
+	st->prepare(
+		"insert into pg_binary_types_test values "
+		"(:id, :bool_fld, :uuid_fld, :json_fld, :jsonb_fld, :num_fld, :tstz_fld, :bytea_fld)"
+	);
+	st->set_int32(":id", 1);
+	st->set_bool_opt(":bool_fld", true);
+	st->set_uuid_opt(":uuid_fld", uuid);
+	st->set_json(":json_fld", R"({"a": 1})");
+	st->set_json(":jsonb_fld", R"({"b": [1, 2]})");
+	st->set_u8str(":num_fld", "-12345.6789");
+	st->set_timestamp(":tstz_fld", TimeStamp{ { 2021, 11, 21 }, { 10, 20, 30, 0, 0 } });
+	st->set_blob(":bytea_fld", "\x01\x02", 2);
+	st->execute();
+
+	st->set_int32(":id", 2);
+	st->set_bool_opt(":bool_fld", false);
+	st->set_u8str(":uuid_fld", "b0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11");
+	st->set_double(":num_fld", 0.5);
+	st->set_null(":json_fld");
+	st->set_null(":jsonb_fld");
+	st->set_null(":tstz_fld");
+	st->set_null(":bytea_fld");
+	st->execute();
 
 	st->execute(
-		"COPY pg_copy_test (int_fld, float_fld, str_fld, double_fld, ts_fld, tm_fld, dt_fld) "
-		"FROM STDIN (format binary)"
+		"select bool_fld, uuid_fld, json_fld, jsonb_fld, num_fld, tstz_fld, bytea_fld, "
+		"uuid_fld::text, num_fld::text from pg_binary_types_test order by id"
 	);
 
-	TimeStamp ts({ 1924, 12, 2 }, { 10, 22, 33, 555 });
-	Time time(10, 34, 33, 555);
-	Date date(1924, 12, 11);
+	BOOST_CHECK(st->get_column_type(1) == ValueType::Boolean);
+	BOOST_CHECK(st->get_column_type(2) == ValueType::Varchar);
+	BOOST_CHECK(st->get_column_type(6) == ValueType::Timestamp);
+	BOOST_CHECK(st->get_column_type(7) == ValueType::Blob);
+
+	BOOST_REQUIRE(st->fetch());
+	BOOST_CHECK(st->get_bool_opt(1) == true);
+	BOOST_CHECK(st->get_int32(1) == 1);
+	BOOST_CHECK(st->get_uuid_opt(2) == uuid);
+	BOOST_CHECK(st->get_str_utf8(2) == st->get_str_utf8(8));
+	BOOST_CHECK(st->get_json_view(3) == R"({"a": 1})");
+	BOOST_CHECK(st->get_json_view(4) == R"({"b": [1, 2]})");
+	BOOST_CHECK(st->get_str_utf8(5) == "-12345.6789");
+	BOOST_CHECK(st->get_str_utf8(5) == st->get_str_utf8(9));
+	BOOST_CHECK(st->get_double(5) == -12345.6789);
+	BOOST_CHECK(st->get_timestamp(6) == (TimeStamp{ { 2021, 11, 21 }, { 10, 20, 30, 0, 0 } }));
+	BOOST_CHECK(st->get_blob_size(7) == 2);
+
+	BOOST_REQUIRE(st->fetch());
+	BOOST_CHECK(st->get_bool_opt(1) == false);
+	BOOST_CHECK(st->get_str_utf8(2) == "b0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11");
+	BOOST_CHECK(st->get_json_view(3).empty());
+	BOOST_CHECK(st->get_str_utf8(5) == "0.5000");
+	BOOST_CHECK(!st->get_timestamp_opt(6).has_value());
 
-	PgBuffer buffer;
+	BOOST_CHECK(!st->fetch());
 
-	buffer.begin_tuple();
-	buffer.write_int32_opt(10);
-	buffer.write_float_opt(11.0f);
-	buffer.write_u8str_opt("12");
-	buffer.write_double_opt(42.0);
-	buffer.write_timestamp_opt(ts);
-	buffer.write_time_opt(time);
-	buffer.write_date_opt(date);
-	buffer.end_tuple();
+	st->execute("select bool_fld, uuid_fld, jsonb_fld, num_fld, tstz_fld from pg_binary_types_test order by id");
+	auto result = fetch_all_columnar(*st);
+	BOOST_REQUIRE(result.get_rows_count() == 2);
+	BOOST_CHECK(result.get_column(1).get_int32(0) == 1);
+	BOOST_CHECK(result.get_column(2).get_str(1) == "b0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11");
+	BOOST_CHECK(result.get_column(3).get_str(0) == R"({"b": [1, 2]})");
+	BOOST_CHECK(result.get_column(4).get_str(0) == "-12345.6789");
+	BOOST_CHECK(result.get_column(5).get_timestamp(0).date == (Date{ 2021, 11, 21 }));
 
-	buffer.begin_tuple();
-	buffer.write_int32_opt(100);
-	buffer.write_float_opt(111.0f);
-	buffer.write_u8str_opt("123");
-	buffer.write_double_opt(142.0);
-	buffer.write_timestamp_opt(ts);
-	buffer.write_time_opt(time);
-	buffer.write_date_opt(date);
-	buffer.end_tuple();
+	tran->commit();
+}
 
-	buffer.begin_tuple();
-	buffer.write_int32_opt({});
-	buffer.write_float_opt({});
-	buffer.write_u8str_opt({});
-	buffer.write_double_opt({});
-	buffer.write_timestamp_opt({});
-	buffer.write_time_opt({});
-	buffer.write_date_opt({});
-	buffer.end_tuple();
+BOOST_AUTO_TEST_CASE(pg_notification_listener)
+{
+	auto listener_conn = get_postgresql_connection();
+	auto conn = get_postgresql_connection();
+	listener_conn->connect();
+	conn->connect();
 
-	auto pg_st = std::dynamic_pointer_cast<PgStatement>(st);
+	auto listener = listener_conn->create_notification_listener();
 
-	pg_st->put_buffer(buffer);
+	std::vector<std::string> payloads;
+	listener->listen("dblib Test", [&](const PgNotification &notification)
+	{
+		BOOST_CHECK(notification.channel == "dblib Test");
+		payloads.push_back(notification.payload);
+	});
 
-	st->execute(
-		"select int_fld, float_fld, str_fld, double_fld, ts_fld, tm_fld, dt_fld "
-		"from pg_copy_test"
-	);
+	size_t reconnects_count = 0;
+	listener->set_reconnect_handler([&] { reconnects_count++; });
 
-	BOOST_CHECK(st->fetch());
-	BOOST_CHECK(st->get_int32(1) == 10);
-	BOOST_CHECK(st->get_float(2) == 11.0f);
-	BOOST_CHECK(st->get_str_utf8(3) == "12");
-	BOOST_CHECK(st->get_double(4) == 42.0);
-	BOOST_CHECK(st->get_timestamp(5) == ts);
-	BOOST_CHECK(st->get_time(6) == time);
-	BOOST_CHECK(st->get_date(7) == date);
+	auto notify = [&](std::string_view payload)
+	{
+		auto tran = conn->create_transaction();
+		auto st = tran->create_statement();
+		st->prepare("select pg_notify(:channel, :payload)");
+		st->set_u8str(":channel", "dblib Test");
+		st->set_u8str(":payload", std::string(payload));
+		st->execute();
+		st.reset();
+		tran->commit();
+	};
 
-	BOOST_CHECK(st->fetch());
-	BOOST_CHECK(st->get_int32(1) == 100);
-	BOOST_CHECK(st->get_float(2) == 111.0f);
-	BOOST_CHECK(st->get_str_utf8(3) == "123");
-	BOOST_CHECK(st->get_double(4) == 142.0);
-	BOOST_CHECK(st->get_timestamp(5) == ts);
-	BOOST_CHECK(st->get_time(6) == time);
-	BOOST_CHECK(st->get_date(7) == date);
+	auto wait_for = [&](size_t count)
+	{
+		for (int i = 0; (i < 50) && (payloads.size() < count); i++)
+			listener->wait(100);
+	};
 
-	BOOST_CHECK(st->fetch());
-	BOOST_CHECK(st->is_null(1));
-	BOOST_CHECK(st->is_null(2));
-	BOOST_CHECK(st->is_null(3));
-	BOOST_CHECK(st->is_null(4));
-	BOOST_CHECK(st->is_null(5));
-	BOOST_CHECK(st->is_null(6));
-	BOOST_CHECK(st->is_null(7));
+	BOOST_CHECK(listener->wait(0) == 0);
+
+	notify("first");
+	notify("second");
+	wait_for(2);
+	BOOST_REQUIRE(payloads.size() == 2);
+	BOOST_CHECK(payloads[0] == "first");
+	BOOST_CHECK(payloads[1] == "second");
+
+	// equal notifications received together are dispatched once
+	payloads.clear();
+	notify("same");
+	notify("same");
+	std::this_thread::sleep_for(std::chrono::milliseconds(300));
+	BOOST_CHECK(listener->wait(1000) == 1);
+	BOOST_CHECK(listener->wait(200) == 0);
+	BOOST_CHECK(payloads.size() == 1);
+
+	// listener connects again after its server process is terminated
+	int32_t listener_pid = 0;
+	{
+		payloads.clear();
+		auto tran = listener_conn->create_transaction();
+		auto st = tran->create_statement();
+		st->execute("select pg_backend_pid()");
+		BOOST_REQUIRE(st->fetch());
+		listener_pid = st->get_int32(1);
+		st.reset();
+		tran->commit();
+	}
+	{
+		auto tran = conn->create_transaction();
+		auto st = tran->create_statement();
+		st->prepare("select pg_terminate_backend(:pid)");
+		st->set_int32(":pid", listener_pid);
+		st->execute();
+		st.reset();
+		tran->commit();
+	}
 
-	BOOST_CHECK(!st->fetch());
+	for (int i = 0; (i < 50) && (listener->get_reconnects_count() == 0); i++)
+		listener->wait(100);
+	BOOST_CHECK(listener->get_reconnects_count() == 1);
+	BOOST_CHECK(reconnects_count == 1);
+
+	notify("third");
+	wait_for(1);
+	BOOST_REQUIRE(payloads.size() == 1);
+	BOOST_CHECK(payloads[0] == "third");
+
+	// no notifications after UNLISTEN
+	listener->unlisten("dblib Test");
+	notify("fourth");
+	BOOST_CHECK(listener->wait(100) == 0);
+	BOOST_CHECK(payloads.size() == 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if DBLIB_TESTS_SQLITE == 1
+
+BOOST_AUTO_TEST_SUITE(SQLiteMisc)
+
+BOOST_AUTO_TEST_CASE(sqlite_fast_statement)
+{
+	auto conn = get_sqlite_connection();
+	conn->connect();
+
+	exec_no_throw(*conn, { "drop table test_fast_stmt" });
+	exec(*conn, { "create table test_fast_stmt (id integer, value double precision, name varchar(20), data blob)" });
+
+	auto tran = conn->create_sqlite_transaction({});
+	SqliteFastStatement st(tran);
+
+	const char blob[] = { 1, 0, 2 };
+
+	st.prepare("insert into test_fast_stmt(id, value, name, data) values (?1, ?2, ?3, ?4)");
+	for (int i = 0; i < 3; i++)
+	{
+		st.set_int32(1, i);
+		st.set_double(2, i * 1.5);
+		if (i == 2) st.set_null(3);
+		else st.set_u8str(3, "name");
+		st.set_blob(4, blob, sizeof(blob));
+		st.execute();
+		BOOST_CHECK(st.get_changes_count() == 1);
+	}
+	BOOST_CHECK(st.get_last_row_id() == 3);
+
+	st.prepare("select id, value, name, data from test_fast_stmt order by id");
+	st.execute();
+	BOOST_CHECK(st.get_columns_count() == 4);
+
+	int rows = 0;
+	while (st.fetch())
+	{
+		BOOST_CHECK(st.get_int32(1) == rows);
+		BOOST_CHECK(st.get_int64(1) == rows);
+		BOOST_CHECK(st.get_double(2) == rows * 1.5);
+		BOOST_CHECK(st.is_null(3) == (rows == 2));
+		BOOST_CHECK(st.get_str_utf8(3) == ((rows == 2) ? "" : "name"));
+		BOOST_CHECK(st.get_blob(4) == std::string_view(blob, sizeof(blob)));
+		rows++;
+	}
+	BOOST_CHECK(rows == 3);
+	BOOST_CHECK_THROW(st.fetch(), WrongSeqException);
+
+	// executing again resets statement
+	st.execute();
+	BOOST_CHECK(st.fetch());
+	BOOST_CHECK(st.get_int32(1) == 0);
+
+	BOOST_CHECK_THROW(st.prepare("select wrong_field from test_fast_stmt"), ExceptionEx);
 
 	tran->commit();
-};
+
+	exec(*conn, { "drop table test_fast_stmt" });
+}
+
+BOOST_AUTO_TEST_CASE(sqlite_columnar_mixed_types)
+{
+	auto conn = get_sqlite_connection();
+	conn->connect();
+
+	exec_no_throw(*conn, { "drop table test_columnar_mixed" });
+	exec(*conn, {
+		"create table test_columnar_mixed (id integer, num numeric, any_fld)",
+		"insert into test_columnar_mixed values (1, 1, 1)",
+		"insert into test_columnar_mixed values (2, null, null)",
+		"insert into test_columnar_mixed values (3, 2.5, 'text')"
+	});
+
+	auto tran = conn->create_transaction();
+	auto st = tran->create_statement();
+
+	// real value after integers
+	st->execute("select num from test_columnar_mixed order by id");
+	auto result = fetch_all_columnar(*st);
+	auto &num_column = result.get_column(1);
+	BOOST_REQUIRE(num_column.get_rows_count() == 3);
+	BOOST_CHECK(num_column.get_type() == ValueType::Double);
+	BOOST_CHECK(num_column.get_double(0) == 1.0);
+	BOOST_CHECK(num_column.is_null(1));
+	BOOST_CHECK(num_column.get_double(2) == 2.5);
+
+	// text value after integers
+	st->execute("select any_fld from test_columnar_mixed order by id");
+	BOOST_CHECK_THROW(fetch_all_columnar(*st), WrongTypeConvException);
+
+	st.reset();
+	tran->commit();
+
+	exec(*conn, { "drop table test_columnar_mixed" });
+}
 
 BOOST_AUTO_TEST_SUITE_END()
 
-#endif
\ No newline at end of file
+#endif